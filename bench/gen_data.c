@@ -0,0 +1,467 @@
+// 基准测试数据生成器：按固定种子生成两个基因组的转座子注释（GFF3/BED）和共线性区块
+//
+// 基因组2由基因组1经共线性区块映射得到：区块内的转座子按一定比例保留（坐标随区块平移），
+// 其余位置补充新插入，使独有转座子的比例接近真实的近缘基因组比较。
+// 所有输出按染色体和起点排序，可直接用于--sorted和tabix索引。
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+
+// 染色体长度上限，保证坐标加上平移和转座子长度后仍在int范围内
+#define MAX_CHROM_LENGTH 1500000000LL
+#define OUTPUT_BUFFER_SIZE (1 << 20)
+
+// 超家族及其在注释中使用的类型和典型长度
+typedef struct {
+    const char* name;
+    const char* type;
+    int length;
+} Superfamily;
+
+static const Superfamily superfamilies[] = {
+    { "Gypsy", "LTR_retrotransposon", 6000 },
+    { "Copia", "LTR_retrotransposon", 5000 },
+    { "L1", "LINE", 6000 },
+    { "RTE", "LINE", 3500 },
+    { "Alu", "SINE", 300 },
+    { "hAT", "DNA_transposon", 2500 },
+    { "Tc1-Mariner", "DNA_transposon", 1500 },
+    { "CACTA", "TIR", 4000 },
+    { "Helitron", "helitron", 3000 },
+    { "MITE", "MITE", 400 }
+};
+#define SUPERFAMILY_COUNT ((int)(sizeof(superfamilies) / sizeof(superfamilies[0])))
+
+typedef struct {
+    char* output_prefix;
+    uint64_t seed;
+    long long te_count;         // 每个基因组的转座子数
+    int chrom_count;
+    long long chrom_length;     // 0表示按转座子数自动确定
+    int family_count;
+    double zipf_exponent;       // 家族频率服从Zipf分布
+    long long block_count;      // 0表示每100个转座子一个区块
+    double synteny_coverage;    // 区块覆盖的染色体比例
+    double shared_fraction;     // 区块内基因组1转座子在基因组2中保留的比例
+    double non_te_fraction;     // GFF3中非转座子特征（gene）的比例
+} GeneratorOptions;
+
+// xoshiro256**伪随机数，种子经splitmix64展开，保证各平台输出一致
+typedef struct {
+    uint64_t s[4];
+} Rng;
+
+static uint64_t splitmix64(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static void rng_seed(Rng* rng, uint64_t seed) {
+    for (int i = 0; i < 4; i++) rng->s[i] = splitmix64(&seed);
+}
+
+static uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t rng_next(Rng* rng) {
+    uint64_t* s = rng->s;
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+// [0, n)内的整数
+static long long rng_below(Rng* rng, long long n) {
+    if (n <= 1) return 0;
+    return (long long)(((rng_next(rng) >> 11) * (double)n) / 9007199254740992.0);
+}
+
+// [0, 1)内的浮点数
+static double rng_double(Rng* rng) {
+    return (rng_next(rng) >> 11) / 9007199254740992.0;
+}
+
+// 一条转座子记录，family为家族编号
+typedef struct {
+    int start;
+    int end;
+    int family;
+    long long serial;   // 基因组1中的编号，新插入为-1
+    char strand;
+} GenRecord;
+
+typedef struct {
+    GenRecord* records;
+    long long count;
+    long long capacity;
+} RecordBuffer;
+
+static void buffer_push(RecordBuffer* buffer, GenRecord record) {
+    if (buffer->count == buffer->capacity) {
+        buffer->capacity = buffer->capacity == 0 ? 1024 : buffer->capacity * 2;
+        buffer->records = (GenRecord*)realloc(buffer->records, buffer->capacity * sizeof(GenRecord));
+        if (!buffer->records) {
+            fprintf(stderr, "Error: Out of memory\n");
+            exit(1);
+        }
+    }
+    buffer->records[buffer->count++] = record;
+}
+
+static int compare_records(const void* a, const void* b) {
+    const GenRecord* ra = (const GenRecord*)a;
+    const GenRecord* rb = (const GenRecord*)b;
+    if (ra->start != rb->start) return ra->start < rb->start ? -1 : 1;
+    if (ra->end != rb->end) return ra->end < rb->end ? -1 : 1;
+    return 0;
+}
+
+// 共线性区块：基因组1的[start1, end1]平移offset后对应基因组2
+typedef struct {
+    int start1;
+    int end1;
+    int offset;
+} GenBlock;
+
+// 家族的累积分布，按Zipf权重抽样
+static double* build_family_cdf(int family_count, double exponent) {
+    double* cdf = (double*)malloc(family_count * sizeof(double));
+    if (!cdf) return NULL;
+    
+    double total = 0.0;
+    for (int k = 0; k < family_count; k++) {
+        total += 1.0 / pow(k + 1, exponent);
+        cdf[k] = total;
+    }
+    for (int k = 0; k < family_count; k++) cdf[k] /= total;
+    return cdf;
+}
+
+static int sample_family(Rng* rng, const double* cdf, int family_count) {
+    double u = rng_double(rng);
+    int lo = 0, hi = family_count - 1;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (cdf[mid] < u) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// 家族编号k属于第k % SUPERFAMILY_COUNT个超家族，名称形如Gypsy-3
+static void family_name(int family, char* buffer, size_t size) {
+    snprintf(buffer, size, "%s-%d", superfamilies[family % SUPERFAMILY_COUNT].name,
+             family / SUPERFAMILY_COUNT + 1);
+}
+
+// 长度在超家族典型长度的0.25~1.25倍之间
+static int sample_length(Rng* rng, int family) {
+    int base = superfamilies[family % SUPERFAMILY_COUNT].length;
+    int length = base / 4 + (int)rng_below(rng, base);
+    return length < 50 ? 50 : length;
+}
+
+static FILE* open_output(const char* prefix, const char* suffix, char** buffer) {
+    size_t len = strlen(prefix) + strlen(suffix) + 1;
+    char* filename = (char*)malloc(len);
+    snprintf(filename, len, "%s%s", prefix, suffix);
+    
+    FILE* file = fopen(filename, "w");
+    if (!file) {
+        fprintf(stderr, "Error: Cannot create output file %s\n", filename);
+    } else {
+        *buffer = (char*)malloc(OUTPUT_BUFFER_SIZE);
+        setvbuf(file, *buffer, _IOFBF, OUTPUT_BUFFER_SIZE);
+    }
+    free(filename);
+    return file;
+}
+
+static void print_usage(const char* program_name) {
+    printf("Synthetic TE annotation generator for TEvoX benchmarks\n\n");
+    printf("Usage: %s [options]\n\n", program_name);
+    printf("Writes PREFIX_genome1.gff3, PREFIX_genome2.bed and PREFIX_synteny.txt.\n\n");
+    printf("Options:\n");
+    printf("  -o, --output PREFIX      Output prefix (default: bench_data)\n");
+    printf("  -s, --seed N             Random seed (default: 1)\n");
+    printf("  -n, --tes N              Transposons per genome (default: 1000000)\n");
+    printf("  -c, --chroms N           Chromosome count (default: 12)\n");
+    printf("  -l, --chrom-length N     Chromosome length (default: about 3 kb per TE)\n");
+    printf("  -f, --families N         Family count (default: 200)\n");
+    printf("  -z, --zipf S             Zipf exponent of the family frequencies (default: 1.0)\n");
+    printf("  -b, --blocks N           Synteny block count (default: one per 100 TEs)\n");
+    printf("  --coverage F             Fraction of each chromosome in synteny blocks (default: 0.7)\n");
+    printf("  --shared F               Fraction of genome 1 TEs in blocks kept in genome 2 (default: 0.8)\n");
+    printf("  --non-te F               Fraction of non-TE (gene) features in the GFF3 (default: 0.02)\n");
+    printf("  -h, --help               Show this help message\n");
+}
+
+static bool parse_number(const char* text, double min, double max, double* value) {
+    char* end = NULL;
+    double v = strtod(text, &end);
+    if (!end || end == text || *end != '\0' || v < min || v > max) return false;
+    *value = v;
+    return true;
+}
+
+static int parse_options(int argc, char* argv[], GeneratorOptions* options) {
+    options->output_prefix = "bench_data";
+    options->seed = 1;
+    options->te_count = 1000000;
+    options->chrom_count = 12;
+    options->chrom_length = 0;
+    options->family_count = 200;
+    options->zipf_exponent = 1.0;
+    options->block_count = 0;
+    options->synteny_coverage = 0.7;
+    options->shared_fraction = 0.8;
+    options->non_te_fraction = 0.02;
+    
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        double value = 0.0;
+        if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+            print_usage(argv[0]);
+            exit(0);
+        }
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Error: Unknown option %s\n", arg);
+            return -1;
+        }
+        const char* next = argv[++i];
+        
+        if (strcmp(arg, "-o") == 0 || strcmp(arg, "--output") == 0) {
+            options->output_prefix = (char*)next;
+            continue;
+        }
+        
+        bool valid;
+        if (strcmp(arg, "-s") == 0 || strcmp(arg, "--seed") == 0) {
+            valid = parse_number(next, 0, 1e18, &value);
+            options->seed = (uint64_t)value;
+        } else if (strcmp(arg, "-n") == 0 || strcmp(arg, "--tes") == 0) {
+            valid = parse_number(next, 1, 1e9, &value);
+            options->te_count = (long long)value;
+        } else if (strcmp(arg, "-c") == 0 || strcmp(arg, "--chroms") == 0) {
+            valid = parse_number(next, 1, 100000, &value);
+            options->chrom_count = (int)value;
+        } else if (strcmp(arg, "-l") == 0 || strcmp(arg, "--chrom-length") == 0) {
+            valid = parse_number(next, 10000, (double)MAX_CHROM_LENGTH, &value);
+            options->chrom_length = (long long)value;
+        } else if (strcmp(arg, "-f") == 0 || strcmp(arg, "--families") == 0) {
+            valid = parse_number(next, 1, 1000000, &value);
+            options->family_count = (int)value;
+        } else if (strcmp(arg, "-z") == 0 || strcmp(arg, "--zipf") == 0) {
+            valid = parse_number(next, 0, 10, &value);
+            options->zipf_exponent = value;
+        } else if (strcmp(arg, "-b") == 0 || strcmp(arg, "--blocks") == 0) {
+            valid = parse_number(next, 1, 1e9, &value);
+            options->block_count = (long long)value;
+        } else if (strcmp(arg, "--coverage") == 0) {
+            valid = parse_number(next, 0.01, 1, &value);
+            options->synteny_coverage = value;
+        } else if (strcmp(arg, "--shared") == 0) {
+            valid = parse_number(next, 0, 1, &value);
+            options->shared_fraction = value;
+        } else if (strcmp(arg, "--non-te") == 0) {
+            valid = parse_number(next, 0, 0.9, &value);
+            options->non_te_fraction = value;
+        } else {
+            fprintf(stderr, "Error: Unknown option %s\n", arg);
+            return -1;
+        }
+        
+        if (!valid) {
+            fprintf(stderr, "Error: Invalid value for %s: %s\n", arg, next);
+            return -1;
+        }
+    }
+    
+    if (options->chrom_length == 0) {
+        long long length = options->te_count / options->chrom_count * 3000;
+        if (length < 1000000) length = 1000000;
+        if (length > MAX_CHROM_LENGTH) length = MAX_CHROM_LENGTH;
+        options->chrom_length = length;
+    }
+    if (options->block_count == 0) {
+        options->block_count = options->te_count / 100 > 0 ? options->te_count / 100 : 1;
+    }
+    if (options->block_count < options->chrom_count) {
+        options->block_count = options->chrom_count;
+    }
+    return 0;
+}
+
+// 在染色体上均匀划分区块，每个区块取所在片段中间的一部分，平移量逐块随机漂移
+static long long generate_blocks(Rng* rng, const GeneratorOptions* options, long long block_count,
+                                 GenBlock* blocks) {
+    long long segment = options->chrom_length / block_count;
+    long long offset = 0;
+    long long count = 0;
+    
+    for (long long b = 0; b < block_count; b++) {
+        long long seg_start = b * segment + 1;
+        long long length = (long long)(segment * options->synteny_coverage * (0.8 + 0.4 * rng_double(rng)));
+        if (length >= segment) length = segment - 1;
+        if (length < 1) continue;
+        
+        long long start = seg_start + rng_below(rng, segment - length);
+        offset += rng_below(rng, segment / 10 + 1) - segment / 20;
+        if (start + offset < 1) offset = 1 - start;
+        
+        blocks[count].start1 = (int)start;
+        blocks[count].end1 = (int)(start + length - 1);
+        blocks[count].offset = (int)offset;
+        count++;
+    }
+    return count;
+}
+
+int main(int argc, char* argv[]) {
+    GeneratorOptions options;
+    if (parse_options(argc, argv, &options) != 0) {
+        return 1;
+    }
+    
+    double* family_cdf = build_family_cdf(options.family_count, options.zipf_exponent);
+    char *gff3_buffer = NULL, *bed_buffer = NULL, *synteny_buffer = NULL;
+    FILE* gff3 = open_output(options.output_prefix, "_genome1.gff3", &gff3_buffer);
+    FILE* bed = gff3 ? open_output(options.output_prefix, "_genome2.bed", &bed_buffer) : NULL;
+    FILE* synteny = bed ? open_output(options.output_prefix, "_synteny.txt", &synteny_buffer) : NULL;
+    if (!family_cdf || !synteny) {
+        if (gff3) fclose(gff3);
+        if (bed) fclose(bed);
+        free(gff3_buffer);
+        free(bed_buffer);
+        free(family_cdf);
+        return 1;
+    }
+    
+    fprintf(gff3, "##gff-version 3\n");
+    fprintf(bed, "track name=genome2_te description=\"tevox synthetic benchmark data\"\n");
+    fprintf(synteny, "# chr1\tstart1\tend1\tchr2\tstart2\tend2\tscore\n");
+    
+    Rng rng;
+    rng_seed(&rng, options.seed);
+    
+    long long max_blocks = options.block_count / options.chrom_count + 1;
+    GenBlock* blocks = (GenBlock*)malloc(max_blocks * sizeof(GenBlock));
+    RecordBuffer genome1 = { NULL, 0, 0 };
+    RecordBuffer genome2 = { NULL, 0, 0 };
+    long long serial = 0, genome2_serial = 0, gene_serial = 0;
+    long long total_blocks = 0;
+    char family[64];
+    
+    for (int c = 0; c < options.chrom_count; c++) {
+        char chr[32];
+        snprintf(chr, sizeof(chr), "chr%d", c + 1);
+        
+        long long chrom_tes = options.te_count / options.chrom_count + (c < options.te_count % options.chrom_count);
+        long long chrom_blocks = options.block_count / options.chrom_count +
+                                 (c < options.block_count % options.chrom_count);
+        long long block_count = generate_blocks(&rng, &options, chrom_blocks, blocks);
+        total_blocks += block_count;
+        for (long long b = 0; b < block_count; b++) {
+            fprintf(synteny, "%s\t%d\t%d\t%s\t%lld\t%lld\t%.3f\n", chr, blocks[b].start1, blocks[b].end1, chr,
+                    (long long)blocks[b].start1 + blocks[b].offset, (long long)blocks[b].end1 + blocks[b].offset,
+                    0.5 + 0.5 * rng_double(&rng));
+        }
+        
+        // 基因组1：起点间隔均匀随机，按顺序生成即为有序
+        genome1.count = 0;
+        double spacing = (double)options.chrom_length / (chrom_tes + 1);
+        double position = 1.0;
+        for (long long i = 0; i < chrom_tes; i++) {
+            position += rng_double(&rng) * 2.0 * spacing;
+            if (position >= (double)options.chrom_length) position = (double)options.chrom_length - 1;
+            GenRecord record;
+            record.family = sample_family(&rng, family_cdf, options.family_count);
+            record.start = (int)position;
+            record.end = record.start + sample_length(&rng, record.family) - 1;
+            record.strand = (rng_next(&rng) & 1) ? '+' : '-';
+            record.serial = serial++;
+            buffer_push(&genome1, record);
+        }
+        
+        // 基因组2：保留完全落在区块内的部分转座子，再补充新插入到相同数量
+        genome2.count = 0;
+        long long cursor = 0;
+        for (long long i = 0; i < genome1.count; i++) {
+            GenRecord record = genome1.records[i];
+            while (cursor < block_count && blocks[cursor].end1 < record.start) cursor++;
+            if (cursor >= block_count || blocks[cursor].start1 > record.start ||
+                blocks[cursor].end1 < record.end || rng_double(&rng) >= options.shared_fraction) {
+                continue;
+            }
+            record.start += blocks[cursor].offset;
+            record.end += blocks[cursor].offset;
+            buffer_push(&genome2, record);
+        }
+        long long inserted = chrom_tes - genome2.count;
+        for (long long i = 0; i < inserted; i++) {
+            GenRecord record;
+            record.family = sample_family(&rng, family_cdf, options.family_count);
+            record.start = 1 + (int)rng_below(&rng, options.chrom_length);
+            record.end = record.start + sample_length(&rng, record.family) - 1;
+            record.strand = (rng_next(&rng) & 1) ? '+' : '-';
+            record.serial = -1;
+            buffer_push(&genome2, record);
+        }
+        qsort(genome2.records, genome2.count, sizeof(GenRecord), compare_records);
+        
+        for (long long i = 0; i < genome1.count; i++) {
+            const GenRecord* record = &genome1.records[i];
+            if (rng_double(&rng) < options.non_te_fraction) {
+                fprintf(gff3, "%s\tsynth\tgene\t%d\t%d\t.\t%c\t.\tID=gene%lld\n",
+                        chr, record->start, record->start + 999, record->strand, gene_serial++);
+            }
+            family_name(record->family, family, sizeof(family));
+            fprintf(gff3, "%s\tsynth\t%s\t%d\t%d\t.\t%c\t.\tID=g1te%lld;Name=g1te%lld;family=%s\n",
+                    chr, superfamilies[record->family % SUPERFAMILY_COUNT].type, record->start, record->end,
+                    record->strand, record->serial, record->serial, family);
+        }
+        for (long long i = 0; i < genome2.count; i++) {
+            const GenRecord* record = &genome2.records[i];
+            fprintf(bed, "%s\t%d\t%d\tg2te%lld\t%d\t%c\t%s\n", chr, record->start - 1, record->end,
+                    genome2_serial++, (int)rng_below(&rng, 1001), record->strand,
+                    superfamilies[record->family % SUPERFAMILY_COUNT].type);
+        }
+    }
+    
+    int status = 0;
+    if (fclose(gff3) != 0) status = 1;
+    if (fclose(bed) != 0) status = 1;
+    if (fclose(synteny) != 0) status = 1;
+    if (status != 0) {
+        fprintf(stderr, "Error: Failed to write output files with prefix %s\n", options.output_prefix);
+    } else {
+        printf("Generated %lld + %lld transposons on %d chromosomes and %lld synteny blocks (seed %llu)\n",
+               serial, genome2_serial, options.chrom_count, total_blocks, (unsigned long long)options.seed);
+    }
+    
+    free(genome1.records);
+    free(genome2.records);
+    free(blocks);
+    free(family_cdf);
+    free(gff3_buffer);
+    free(bed_buffer);
+    free(synteny_buffer);
+    return status;
+}
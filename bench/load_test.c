@@ -0,0 +1,256 @@
+// tevox serve的压力测试：多个客户端并发发送查询，输出吞吐量和延迟分位数
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+typedef struct {
+    const char* socket_path;
+    char** queries;
+    int query_count;
+    int requests;       // 每个客户端发送的请求数
+    int batch;          // 每个请求包含的查询数
+    int offset;         // 从查询列表的哪一条开始
+    double* latencies;  // 每个请求的延迟（微秒）
+    long long rows;
+    int errors;
+} ClientTask;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// 读取一行响应，buffer中保留尚未处理的数据
+static int read_line(int fd, char* buffer, size_t* size, char* line, size_t line_size) {
+    for (;;) {
+        char* newline = memchr(buffer, '\n', *size);
+        if (newline) {
+            size_t len = (size_t)(newline - buffer);
+            size_t copy = len < line_size - 1 ? len : line_size - 1;
+            memcpy(line, buffer, copy);
+            line[copy] = '\0';
+            *size -= len + 1;
+            memmove(buffer, newline + 1, *size);
+            return 0;
+        }
+        if (*size == 65536) return -1;
+        ssize_t n = read(fd, buffer + *size, 65536 - *size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        *size += (size_t)n;
+    }
+}
+
+static void* run_client(void* arg) {
+    ClientTask* task = (ClientTask*)arg;
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, task->socket_path, sizeof(addr.sun_path) - 1);
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        perror(task->socket_path);
+        task->errors = task->requests;
+        if (fd >= 0) close(fd);
+        return NULL;
+    }
+    
+    char* buffer = malloc(65536);
+    char line[4096];
+    size_t buffered = 0;
+    size_t request_capacity = 4096;
+    char* request = malloc(request_capacity);
+    int next = task->offset;
+    
+    for (int r = 0; r < task->requests; r++) {
+        // 组装请求
+        size_t len = 0;
+        if (task->batch > 1) len = (size_t)snprintf(request, request_capacity, "BATCH %d\n", task->batch);
+        for (int q = 0; q < task->batch; q++) {
+            const char* query = task->queries[next];
+            next = (next + 1) % task->query_count;
+            size_t qlen = strlen(query);
+            if (len + qlen + 2 > request_capacity) {
+                request_capacity = (len + qlen + 2) * 2;
+                request = realloc(request, request_capacity);
+            }
+            memcpy(request + len, query, qlen);
+            len += qlen;
+            request[len++] = '\n';
+        }
+        
+        double start = now_seconds();
+        if (write_all(fd, request, len) != 0) {
+            task->errors += task->requests - r;
+            break;
+        }
+        bool broken = false;
+        for (int q = 0; q < task->batch && !broken; q++) {
+            if (read_line(fd, buffer, &buffered, line, sizeof(line)) != 0) {
+                broken = true;
+                break;
+            }
+            if (strncmp(line, "OK ", 3) != 0) {
+                task->errors++;
+                continue;
+            }
+            int rows = atoi(line + 3);
+            task->rows += rows;
+            for (int i = 0; i < rows; i++) {
+                if (read_line(fd, buffer, &buffered, line, sizeof(line)) != 0) {
+                    broken = true;
+                    break;
+                }
+            }
+        }
+        if (broken) {
+            task->errors += task->requests - r;
+            break;
+        }
+        task->latencies[r] = (now_seconds() - start) * 1e6;
+    }
+    
+    write_all(fd, "QUIT\n", 5);
+    close(fd);
+    free(buffer);
+    free(request);
+    return NULL;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return x < y ? -1 : (x > y);
+}
+
+static double percentile(const double* sorted, long long n, double p) {
+    if (n == 0) return 0.0;
+    long long i = (long long)(p * (n - 1) + 0.5);
+    return sorted[i];
+}
+
+static void usage(const char* program) {
+    fprintf(stderr, "Usage: %s -q QUERY_FILE [-S SOCKET] [-c CLIENTS] [-n REQUESTS] [-b BATCH]\n", program);
+    fprintf(stderr, "  -q FILE     Queries, one per line, sent round-robin\n");
+    fprintf(stderr, "  -S PATH     Server socket (default: tevox.sock)\n");
+    fprintf(stderr, "  -c N        Concurrent clients (default: 4)\n");
+    fprintf(stderr, "  -n N        Requests per client (default: 10000)\n");
+    fprintf(stderr, "  -b N        Queries per request, sent as BATCH when > 1 (default: 1)\n");
+    fprintf(stderr, "Prints: clients<TAB>batch<TAB>queries/s<TAB>p50_us<TAB>p90_us<TAB>p99_us<TAB>max_us<TAB>errors\n");
+}
+
+int main(int argc, char* argv[]) {
+    const char* socket_path = "tevox.sock";
+    const char* query_file = NULL;
+    int clients = 4;
+    int requests = 10000;
+    int batch = 1;
+    
+    int opt;
+    while ((opt = getopt(argc, argv, "S:q:c:n:b:h")) != -1) {
+        switch (opt) {
+            case 'S': socket_path = optarg; break;
+            case 'q': query_file = optarg; break;
+            case 'c': clients = atoi(optarg); break;
+            case 'n': requests = atoi(optarg); break;
+            case 'b': batch = atoi(optarg); break;
+            default: usage(argv[0]); return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (!query_file || clients <= 0 || requests <= 0 || batch <= 0 || batch > 10000) {
+        usage(argv[0]);
+        return 2;
+    }
+    
+    FILE* fp = fopen(query_file, "r");
+    if (!fp) {
+        perror(query_file);
+        return 2;
+    }
+    char** queries = NULL;
+    int query_count = 0, query_capacity = 0;
+    char* line = NULL;
+    size_t line_capacity = 0;
+    ssize_t len;
+    while ((len = getline(&line, &line_capacity, fp)) >= 0) {
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) line[--len] = '\0';
+        if (len == 0) continue;
+        if (query_count == query_capacity) {
+            query_capacity = query_capacity ? query_capacity * 2 : 1024;
+            queries = realloc(queries, query_capacity * sizeof(char*));
+        }
+        queries[query_count++] = strdup(line);
+    }
+    free(line);
+    fclose(fp);
+    if (query_count == 0) {
+        fprintf(stderr, "No queries in %s\n", query_file);
+        return 2;
+    }
+    
+    ClientTask* tasks = calloc(clients, sizeof(ClientTask));
+    pthread_t* threads = malloc(clients * sizeof(pthread_t));
+    double start = now_seconds();
+    for (int c = 0; c < clients; c++) {
+        tasks[c].socket_path = socket_path;
+        tasks[c].queries = queries;
+        tasks[c].query_count = query_count;
+        tasks[c].requests = requests;
+        tasks[c].batch = batch;
+        tasks[c].offset = (int)((long long)c * query_count / clients);
+        tasks[c].latencies = calloc(requests, sizeof(double));
+        pthread_create(&threads[c], NULL, run_client, &tasks[c]);
+    }
+    for (int c = 0; c < clients; c++) pthread_join(threads[c], NULL);
+    double elapsed = now_seconds() - start;
+    
+    // 汇总所有客户端的请求延迟
+    long long total = (long long)clients * requests;
+    double* all = malloc(total * sizeof(double));
+    long long n = 0;
+    int errors = 0;
+    for (int c = 0; c < clients; c++) {
+        for (int r = 0; r < requests; r++) {
+            if (tasks[c].latencies[r] > 0.0) all[n++] = tasks[c].latencies[r];
+        }
+        errors += tasks[c].errors;
+        free(tasks[c].latencies);
+    }
+    qsort(all, n, sizeof(double), compare_doubles);
+    
+    printf("%d\t%d\t%.0f\t%.1f\t%.1f\t%.1f\t%.1f\t%d\n", clients, batch, n * batch / elapsed,
+           percentile(all, n, 0.50), percentile(all, n, 0.90), percentile(all, n, 0.99),
+           n > 0 ? all[n - 1] : 0.0, errors);
+    
+    free(all);
+    free(tasks);
+    free(threads);
+    for (int i = 0; i < query_count; i++) free(queries[i]);
+    free(queries);
+    return errors > 0 ? 1 : 0;
+}
@@ -0,0 +1,93 @@
+#!/bin/bash
+
+# Load test for tevox serve
+#
+# Generates a seeded data set, starts the query server on it and runs
+# bench/load_test with an increasing number of concurrent clients, once with
+# single queries and once with batches. Prints queries/s and latency
+# percentiles (per request, in microseconds) for each level.
+#
+# Environment:
+#   LOAD_SIZE     TEs per genome (default: 1000000)
+#   LOAD_CLIENTS  Client counts to test (default: "1 4 16")
+#   LOAD_QUERIES  Requests per client (default: 20000)
+#   LOAD_BATCH    Queries per request for the batch runs (default: 100)
+#   LOAD_SEED     Generator seed (default: 1)
+#   LOAD_DATA     Directory for generated data (default: bench/data)
+
+LOAD_SIZE=${LOAD_SIZE:-1000000}
+LOAD_CLIENTS=${LOAD_CLIENTS:-"1 4 16"}
+LOAD_QUERIES=${LOAD_QUERIES:-20000}
+LOAD_BATCH=${LOAD_BATCH:-100}
+LOAD_SEED=${LOAD_SEED:-1}
+LOAD_DATA=${LOAD_DATA:-bench/data}
+
+TEVOX=./tevox
+GEN=bench/gen_data
+LOAD=bench/load_test
+
+echo "=== TE Comparator Query Server Load Test ==="
+echo
+
+for tool in "$TEVOX" "$GEN" "$LOAD"; do
+    if [ ! -x "$tool" ]; then
+        echo "Error: $tool not found. Please run 'make load-test' instead."
+        exit 1
+    fi
+done
+
+mkdir -p "$LOAD_DATA" || exit 1
+prefix="$LOAD_DATA/load_$LOAD_SIZE"
+if [ ! -f "${prefix}_synteny.txt" ]; then
+    echo "Generating $LOAD_SIZE TEs per genome..."
+    "$GEN" -o "$prefix" -n "$LOAD_SIZE" -s "$LOAD_SEED" > /dev/null || exit 1
+fi
+
+# 从两个基因组的注释中取位点和区间，混合POINT、REGION和SYNTENY查询
+queries="$LOAD_DATA/load_$LOAD_SIZE.queries"
+{
+    awk -F'\t' '!/^#/ && NF >= 5 && NR % 50 == 0 {
+        mid = int(($4 + $5) / 2)
+        print "POINT 1 " $1 " " mid
+        print "REGION 1 " $1 " " $4 " " $5 + 20000
+    }' "${prefix}_genome1.gff3"
+    awk -F'\t' 'NF >= 3 && NR % 50 == 0 {
+        print "POINT 2 " $1 " " $2 + 1
+        print "SYNTENY 2 " $1 " " $2 + 1 " " $3
+    }' "${prefix}_genome2.bed"
+} > "$queries"
+echo "Queries: $(wc -l < "$queries") from ${prefix}_*"
+
+socket="$LOAD_DATA/load_test.sock"
+rm -f "$socket"
+"$TEVOX" serve "${prefix}_synteny.txt" "${prefix}_genome1.gff3" "${prefix}_genome2.bed" \
+    --socket "$socket" -t 0 --reload-interval 0 > "$LOAD_DATA/load_test.log" 2>&1 &
+server=$!
+trap 'kill $server 2>/dev/null; wait $server 2>/dev/null' EXIT
+
+# 等待服务加载完成
+for ((i = 0; i < 600; i++)); do
+    [ -S "$socket" ] && break
+    if ! kill -0 $server 2>/dev/null; then
+        echo "Error: server exited, see $LOAD_DATA/load_test.log"
+        exit 1
+    fi
+    sleep 0.5
+done
+if [ ! -S "$socket" ]; then
+    echo "Error: server did not start, see $LOAD_DATA/load_test.log"
+    exit 1
+fi
+
+status=0
+printf "\n%-8s %-6s %12s %10s %10s %10s %10s %7s\n" clients batch "queries/s" "p50 us" "p90 us" "p99 us" "max us" errors
+for batch in 1 "$LOAD_BATCH"; do
+    for clients in $LOAD_CLIENTS; do
+        requests=$LOAD_QUERIES
+        [ "$batch" -gt 1 ] && requests=$(( (LOAD_QUERIES + batch - 1) / batch ))
+        result=$("$LOAD" -S "$socket" -q "$queries" -c "$clients" -n "$requests" -b "$batch") || status=1
+        echo "$result" | awk -F'\t' '{ printf "%-8s %-6s %12s %10s %10s %10s %10s %7s\n", $1, $2, $3, $4, $5, $6, $7, $8 }'
+    done
+done
+
+exit $status
@@ -0,0 +1,68 @@
+// 运行一条命令，输出墙钟时间、子进程峰值内存和退出码（制表符分隔，供run_bench.sh记录）
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+int main(int argc, char* argv[]) {
+    const char* log_file = "/dev/null";
+    int first = 1;
+    if (argc > 2 && strcmp(argv[1], "-l") == 0) {
+        log_file = argv[2];
+        first = 3;
+    }
+    if (first >= argc) {
+        fprintf(stderr, "Usage: %s [-l LOG] command [args...]\n", argv[0]);
+        fprintf(stderr, "Prints: wall_seconds<TAB>peak_rss_kb<TAB>exit_status\n");
+        return 2;
+    }
+    
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return 2;
+    }
+    if (pid == 0) {
+        // 命令的标准输出和标准错误写入日志
+        int fd = open(log_file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0) {
+            dup2(fd, STDOUT_FILENO);
+            dup2(fd, STDERR_FILENO);
+            close(fd);
+        }
+        execvp(argv[first], argv + first);
+        perror(argv[first]);
+        _exit(127);
+    }
+    
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            perror("waitpid");
+            return 2;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    
+    // 只有一个子进程，RUSAGE_CHILDREN的峰值即为该命令的峰值（Linux下单位为KB）
+    struct rusage usage;
+    getrusage(RUSAGE_CHILDREN, &usage);
+    
+    int exit_status = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    double wall = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("%.3f\t%ld\t%d\n", wall, usage.ru_maxrss, exit_status);
+    return exit_status;
+}
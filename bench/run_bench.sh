@@ -0,0 +1,142 @@
+#!/bin/bash
+
+# Benchmark script for TE Comparator
+#
+# Generates seeded synthetic data at several sizes, runs the main workloads
+# and records wall time, throughput and peak RSS in a TSV file. When a
+# baseline file exists, every result is compared against it and the script
+# exits non-zero if any workload got slower or larger than the tolerance.
+#
+# Environment:
+#   BENCH_SIZES      TEs per genome for each run (default: "100000 1000000")
+#   BENCH_REPEAT     Runs per workload, the fastest is kept (default: 3)
+#   BENCH_SEED       Generator seed (default: 1)
+#   BENCH_DATA       Directory for generated data and outputs (default: bench/data)
+#   BENCH_RESULTS    Results file (default: bench/results.tsv)
+#   BENCH_BASELINE   Baseline file (default: bench/baseline.tsv)
+#   BENCH_TOLERANCE  Allowed relative regression (default: 0.20)
+
+BENCH_SIZES=${BENCH_SIZES:-"100000 1000000"}
+BENCH_REPEAT=${BENCH_REPEAT:-3}
+BENCH_SEED=${BENCH_SEED:-1}
+BENCH_DATA=${BENCH_DATA:-bench/data}
+BENCH_RESULTS=${BENCH_RESULTS:-bench/results.tsv}
+BENCH_BASELINE=${BENCH_BASELINE:-bench/baseline.tsv}
+BENCH_TOLERANCE=${BENCH_TOLERANCE:-0.20}
+
+TEVOX=./tevox
+GEN=bench/gen_data
+MEASURE=bench/measure
+
+echo "=== TE Comparator Benchmark ==="
+echo
+
+for tool in "$TEVOX" "$GEN" "$MEASURE"; do
+    if [ ! -x "$tool" ]; then
+        echo "Error: $tool not found. Please run 'make bench' instead."
+        exit 1
+    fi
+done
+
+mkdir -p "$BENCH_DATA" || exit 1
+
+# run_case SIZE NAME RECORDS BYTES COMMAND...
+# 重复运行并保留最快的一次，写出一行结果
+run_case() {
+    local size=$1 name=$2 records=$3 bytes=$4
+    shift 4
+
+    local best_wall="" best_rss=""
+    for ((run = 0; run < BENCH_REPEAT; run++)); do
+        local result
+        result=$("$MEASURE" -l "$BENCH_DATA/$name.$size.log" "$@")
+        local status=$?
+        if [ $status -ne 0 ]; then
+            echo "✗ $name ($size TEs) failed with status $status, see $BENCH_DATA/$name.$size.log"
+            return 1
+        fi
+        local wall rss
+        wall=$(echo "$result" | cut -f1)
+        rss=$(echo "$result" | cut -f2)
+        if [ -z "$best_wall" ] || awk -v a="$wall" -v b="$best_wall" 'BEGIN { exit !(a < b) }'; then
+            best_wall=$wall
+            best_rss=$rss
+        fi
+    done
+
+    awk -v size="$size" -v name="$name" -v records="$records" -v bytes="$bytes" \
+        -v wall="$best_wall" -v rss="$best_rss" 'BEGIN {
+        w = wall > 0 ? wall : 0.001
+        printf "%s\t%s\t%d\t%.1f\t%.3f\t%.0f\t%.1f\t%d\n", size, name, records, bytes / 1048576,
+               wall, records / w, bytes / 1048576 / w, rss
+    }' >> "$BENCH_RESULTS"
+    printf "  %-8s %8.3f s  %8d KB\n" "$name" "$best_wall" "$best_rss"
+}
+
+{
+    echo "# tevox benchmark $(date -u +%Y-%m-%dT%H:%M:%SZ) $(git rev-parse --short HEAD 2>/dev/null || echo unknown) $(nproc 2>/dev/null || echo 1) cpus"
+    printf "size\tworkload\trecords\tinput_mb\twall_s\trecords_per_s\tmb_per_s\tpeak_rss_kb\n"
+} > "$BENCH_RESULTS"
+
+status=0
+for size in $BENCH_SIZES; do
+    prefix="$BENCH_DATA/synth_${size}_s${BENCH_SEED}"
+    if [ ! -f "${prefix}_synteny.txt" ]; then
+        echo "Generating $size TEs per genome..."
+        "$GEN" -o "$prefix" -n "$size" -s "$BENCH_SEED" > /dev/null || exit 1
+    fi
+
+    g1="${prefix}_genome1.gff3"
+    g2="${prefix}_genome2.bed"
+    syn="${prefix}_synteny.txt"
+    records=$((2 * size))
+    bytes=$(($(wc -c < "$g1") + $(wc -c < "$g2")))
+    out="$BENCH_DATA/out_$size"
+
+    echo "Size $size (records: $records):"
+    # 解析、比较并写出结果（单线程和全部CPU）
+    run_case "$size" full "$records" "$bytes" "$TEVOX" "$syn" "$g1" "$g2" -o "$out" || status=1
+    run_case "$size" threads "$records" "$bytes" "$TEVOX" "$syn" "$g1" "$g2" -o "$out" -t 0 || status=1
+    # 有序输入的流式比较
+    run_case "$size" sorted "$records" "$bytes" "$TEVOX" "$syn" "$g1" "$g2" -o "$out" --sorted || status=1
+    # 只解析并写出缓存，然后从缓存运行
+    rm -f "$g1.tevx" "$g2.tevx"
+    run_case "$size" index "$records" "$bytes" "$TEVOX" index "$g1" "$g2" || status=1
+    run_case "$size" cached "$records" "$bytes" "$TEVOX" "$syn" "$g1" "$g2" -o "$out" --cache || status=1
+    rm -f "$g1.tevx" "$g2.tevx" "$out"_genome*_unique.*
+    echo
+done
+
+echo "Results written to: $BENCH_RESULTS"
+
+if [ ! -f "$BENCH_BASELINE" ]; then
+    echo "No baseline at $BENCH_BASELINE (run 'make bench-baseline' to store these results)"
+    exit $status
+fi
+
+echo
+echo "=== Comparison with $BENCH_BASELINE (tolerance $BENCH_TOLERANCE) ==="
+# 时间差小于0.05秒的不算退化，避免小数据上的计时抖动
+awk -F'\t' -v tol="$BENCH_TOLERANCE" '
+    /^#/ || $1 == "size" { next }
+    FNR == NR { base_wall[$1 "\t" $2] = $5; base_rss[$1 "\t" $2] = $8; next }
+    {
+        key = $1 "\t" $2
+        if (!(key in base_wall)) { printf "  %-8s %9s  new\n", $2, $1; next }
+        wall_ratio = base_wall[key] > 0 ? $5 / base_wall[key] : 1
+        rss_ratio = base_rss[key] > 0 ? $8 / base_rss[key] : 1
+        slower = wall_ratio > 1 + tol && $5 - base_wall[key] > 0.05
+        larger = rss_ratio > 1 + tol
+        printf "  %-8s %9s  time %6.2fx  rss %6.2fx%s\n", $2, $1, wall_ratio, rss_ratio,
+               slower || larger ? "  REGRESSION" : ""
+        if (slower || larger) failed = 1
+    }
+    END { exit failed }
+' "$BENCH_BASELINE" "$BENCH_RESULTS"
+
+if [ $? -ne 0 ]; then
+    echo "✗ Benchmark regressions detected"
+    exit 1
+fi
+echo "✓ No regressions against the baseline"
+exit $status
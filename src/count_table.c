@@ -0,0 +1,126 @@
+#include "te_comparator.h"
+
+// 64位整数哈希（splitmix64的混合步骤）
+static uint64_t hash_key(uint64_t key) {
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+    return key;
+}
+
+// 初始化计数表
+void init_count_table(CountTable* table) {
+    if (!table) return;
+    table->entries = NULL;
+    table->count = 0;
+    table->capacity = 0;
+    table->slots = NULL;
+    table->slot_capacity = 0;
+}
+
+// 以new_capacity个哈希槽重建索引
+static void rebuild_slots(CountTable* table, int new_capacity) {
+    int* new_slots = (int*)safe_malloc(new_capacity * sizeof(int));
+    for (int i = 0; i < new_capacity; i++) new_slots[i] = -1;
+    
+    uint64_t mask = (uint64_t)new_capacity - 1;
+    for (int i = 0; i < table->count; i++) {
+        uint64_t slot = hash_key(table->entries[i].key) & mask;
+        while (new_slots[slot] != -1) slot = (slot + 1) & mask;
+        new_slots[slot] = i;
+    }
+    
+    free(table->slots);
+    table->slots = new_slots;
+    table->slot_capacity = new_capacity;
+}
+
+// 给key对应的计数加n，key首次出现时按出现顺序追加新条目
+void count_table_add(CountTable* table, uint64_t key, int n) {
+    if (!table) return;
+    
+    // 负载因子保持在0.5以下
+    if ((table->count + 1) * 2 > table->slot_capacity) {
+        rebuild_slots(table, table->slot_capacity == 0 ? 64 : table->slot_capacity * 2);
+    }
+    
+    uint64_t mask = (uint64_t)table->slot_capacity - 1;
+    uint64_t slot = hash_key(key) & mask;
+    while (table->slots[slot] != -1) {
+        CountEntry* entry = &table->entries[table->slots[slot]];
+        if (entry->key == key) {
+            entry->count += n;
+            return;
+        }
+        slot = (slot + 1) & mask;
+    }
+    
+    if (table->count >= table->capacity) {
+        int new_capacity = table->capacity == 0 ? 64 : table->capacity * 2;
+        table->entries = (CountEntry*)safe_realloc(table->entries, new_capacity * sizeof(CountEntry));
+        table->capacity = new_capacity;
+    }
+    
+    table->entries[table->count].key = key;
+    table->entries[table->count].count = n;
+    table->slots[slot] = table->count;
+    table->count++;
+}
+
+// 查询key的计数，不存在时返回0
+int count_table_get(const CountTable* table, uint64_t key) {
+    if (!table || table->count == 0) return 0;
+    
+    uint64_t mask = (uint64_t)table->slot_capacity - 1;
+    uint64_t slot = hash_key(key) & mask;
+    while (table->slots[slot] != -1) {
+        const CountEntry* entry = &table->entries[table->slots[slot]];
+        if (entry->key == key) return entry->count;
+        slot = (slot + 1) & mask;
+    }
+    return 0;
+}
+
+// 排序用：计数降序，计数相同时保持首次出现顺序
+typedef struct {
+    CountEntry entry;
+    int order;
+} OrderedEntry;
+
+static int compare_by_count(const void* a, const void* b) {
+    const OrderedEntry* ea = (const OrderedEntry*)a;
+    const OrderedEntry* eb = (const OrderedEntry*)b;
+    if (ea->entry.count != eb->entry.count) return ea->entry.count > eb->entry.count ? -1 : 1;
+    return ea->order - eb->order;
+}
+
+// 按计数降序重排条目（排序后哈希槽重建，查询仍然有效）
+void count_table_sort_by_count(CountTable* table) {
+    if (!table || table->count < 2) return;
+    
+    OrderedEntry* ordered = (OrderedEntry*)safe_malloc(table->count * sizeof(OrderedEntry));
+    for (int i = 0; i < table->count; i++) {
+        ordered[i].entry = table->entries[i];
+        ordered[i].order = i;
+    }
+    
+    qsort(ordered, table->count, sizeof(OrderedEntry), compare_by_count);
+    
+    for (int i = 0; i < table->count; i++) {
+        table->entries[i] = ordered[i].entry;
+    }
+    free(ordered);
+    
+    // 条目位置改变，按新顺序重建哈希槽
+    rebuild_slots(table, table->slot_capacity);
+}
+
+// 释放计数表
+void free_count_table(CountTable* table) {
+    if (!table) return;
+    free(table->entries);
+    free(table->slots);
+    init_count_table(table);
+}
@@ -0,0 +1,469 @@
+#include "te_comparator.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// 输出序列每行的碱基数
+#define SEQUENCE_LINE_WIDTH 60
+// 每轮提取的记录数和碱基数上限：每轮按染色体并行提取，再按选择集顺序写出
+#define SEQUENCE_ROUND_RECORDS 65536
+#define SEQUENCE_ROUND_BASES ((int64_t)64 << 20)
+
+// 互补碱基（含IUPAC简并碱基，保留大小写），表中为0的字符原样输出
+static const char complement_bases[256] = {
+    ['A'] = 'T', ['C'] = 'G', ['G'] = 'C', ['T'] = 'A', ['U'] = 'A', ['N'] = 'N',
+    ['R'] = 'Y', ['Y'] = 'R', ['S'] = 'S', ['W'] = 'W', ['K'] = 'M', ['M'] = 'K',
+    ['B'] = 'V', ['V'] = 'B', ['D'] = 'H', ['H'] = 'D',
+    ['a'] = 't', ['c'] = 'g', ['g'] = 'c', ['t'] = 'a', ['u'] = 'a', ['n'] = 'n',
+    ['r'] = 'y', ['y'] = 'r', ['s'] = 's', ['w'] = 'w', ['k'] = 'm', ['m'] = 'k',
+    ['b'] = 'v', ['v'] = 'b', ['d'] = 'h', ['h'] = 'd'
+};
+
+static FaiEntry* add_fai_entry(FastaFile* fasta, const char* name, size_t len) {
+    if (fasta->count >= fasta->capacity) {
+        fasta->capacity = fasta->capacity == 0 ? 64 : fasta->capacity * 2;
+        fasta->entries = (FaiEntry*)safe_realloc(fasta->entries, fasta->capacity * sizeof(FaiEntry));
+    }
+    FaiEntry* entry = &fasta->entries[fasta->count++];
+    memset(entry, 0, sizeof(FaiEntry));
+    entry->name = arena_strndup(&fasta->names, name, len);
+    return entry;
+}
+
+// 序列最后一个碱基之后的文件偏移
+static int64_t fai_entry_end(const FaiEntry* entry) {
+    if (entry->length == 0) return entry->offset;
+    int64_t last = entry->length - 1;
+    return entry->offset + last / entry->line_bases * entry->line_bytes + last % entry->line_bases + 1;
+}
+
+// 读取.fai索引，格式不对或与FASTA文件不符时返回-1
+static int load_fai(FastaFile* fasta, const char* fai_file) {
+    LineReader reader;
+    if (line_reader_open(&reader, fai_file, 1) != 0) return -1;
+    
+    int status = 0;
+    StrSlice line;
+    while (status == 0 && line_reader_next(&reader, &line)) {
+        if (line.len == 0) continue;
+        StrSlice fields[6];
+        if (split_fields(line, '\t', fields, 6) < 5) {
+            status = -1;
+            break;
+        }
+        FaiEntry* entry = add_fai_entry(fasta, fields[0].ptr, fields[0].len);
+        entry->length = slice_to_position(fields[1]);
+        entry->offset = slice_to_position(fields[2]);
+        entry->line_bases = slice_to_position(fields[3]);
+        entry->line_bytes = slice_to_position(fields[4]);
+        if (fields[0].len == 0 || entry->line_bytes < entry->line_bases ||
+            (entry->length > 0 && entry->line_bases <= 0) || fai_entry_end(entry) > (int64_t)fasta->size) {
+            status = -1;
+        }
+    }
+    if (line_reader_failed(&reader)) status = -1;
+    line_reader_close(&reader);
+    return status;
+}
+
+// 扫描FASTA建立索引：每条序列除最后一行外的行长必须相同
+static int build_fai(FastaFile* fasta, const char* filename) {
+    const char* data = fasta->data;
+    size_t size = fasta->size;
+    FaiEntry* current = NULL;
+    bool short_line = false;    // 当前序列已出现较短的行，之后不能再有碱基
+    size_t pos = 0;
+    
+    while (pos < size) {
+        const char* newline = (const char*)memchr(data + pos, '\n', size - pos);
+        size_t end = newline ? (size_t)(newline - data) : size;
+        size_t next = newline ? end + 1 : size;
+        size_t bases = end - pos;
+        if (bases > 0 && data[end - 1] == '\r') bases--;
+        
+        if (bases > 0 && data[pos] == '>') {
+            // 序列名到第一个空白为止
+            size_t name_end = pos + 1;
+            while (name_end < pos + bases && data[name_end] != ' ' && data[name_end] != '\t') name_end++;
+            if (name_end == pos + 1) {
+                fprintf(stderr, "Error: Empty sequence name in %s at byte %zu\n", filename, pos);
+                return -1;
+            }
+            current = add_fai_entry(fasta, data + pos + 1, name_end - pos - 1);
+            current->offset = (int64_t)next;
+            short_line = false;
+        } else if (bases == 0) {
+            short_line = current != NULL;
+        } else if (!current) {
+            fprintf(stderr, "Error: Sequence data before the first header in %s\n", filename);
+            return -1;
+        } else {
+            int64_t line_bytes = (int64_t)(next - pos);
+            if (current->line_bases == 0) {
+                current->line_bases = (int64_t)bases;
+                current->line_bytes = line_bytes;
+            } else if (short_line || (int64_t)bases > current->line_bases ||
+                       ((int64_t)bases == current->line_bases && line_bytes != current->line_bytes && newline)) {
+                fprintf(stderr, "Error: Different line length in sequence %s of %s\n", current->name, filename);
+                return -1;
+            } else if ((int64_t)bases < current->line_bases) {
+                short_line = true;
+            }
+            current->length += (int64_t)bases;
+        }
+        pos = next;
+    }
+    return 0;
+}
+
+// 写出.fai索引（先写临时文件再改名），失败时只在内存中使用
+static void write_fai(const FastaFile* fasta, const char* fai_file) {
+    size_t tmp_len = strlen(fai_file) + 32;
+    char* tmp_file = (char*)safe_malloc(tmp_len);
+    snprintf(tmp_file, tmp_len, "%s.tmp.%ld", fai_file, (long)getpid());
+    
+    FILE* fp = fopen(tmp_file, "w");
+    bool ok = fp != NULL;
+    for (int i = 0; ok && i < fasta->count; i++) {
+        const FaiEntry* entry = &fasta->entries[i];
+        ok = fprintf(fp, "%s\t%lld\t%lld\t%lld\t%lld\n", entry->name, (long long)entry->length,
+                     (long long)entry->offset, (long long)entry->line_bases, (long long)entry->line_bytes) > 0;
+    }
+    if (fp && fclose(fp) != 0) ok = false;
+    if (ok && rename(tmp_file, fai_file) == 0) {
+        printf("Wrote FASTA index %s (%d sequences)\n", fai_file, fasta->count);
+    } else {
+        if (fp) unlink(tmp_file);
+        fprintf(stderr, "Warning: Cannot write FASTA index %s; using it in memory only\n", fai_file);
+    }
+    free(tmp_file);
+}
+
+// 打开FASTA文件：<filename>.fai存在且不比FASTA旧时直接读取，否则扫描文件重建并写出
+int fasta_open(FastaFile* fasta, const char* filename) {
+    memset(fasta, 0, sizeof(FastaFile));
+    init_arena(&fasta->names);
+    
+    int fd = open(filename, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        fprintf(stderr, "Error: Cannot open genome file %s\n", filename);
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    
+    fasta->size = (size_t)st.st_size;
+    if (fasta->size > 0) {
+        void* map = mmap(NULL, fasta->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            fprintf(stderr, "Error: Cannot map genome file %s: %s\n", filename, strerror(errno));
+            close(fd);
+            return -1;
+        }
+        fasta->data = (const char*)map;
+    }
+    close(fd);
+    
+    if (is_gzip_magic((const unsigned char*)fasta->data, fasta->size)) {
+        fprintf(stderr, "Error: Genome file %s is compressed; sequence extraction needs an uncompressed FASTA\n",
+                filename);
+        fasta_close(fasta);
+        return -1;
+    }
+    
+    size_t fai_len = strlen(filename) + 5;
+    char* fai_file = (char*)safe_malloc(fai_len);
+    snprintf(fai_file, fai_len, "%s.fai", filename);
+    
+    struct stat fai_st;
+    bool fresh = stat(fai_file, &fai_st) == 0 && fai_st.st_mtime >= st.st_mtime;
+    if (fresh && load_fai(fasta, fai_file) != 0) {
+        fprintf(stderr, "Warning: Ignoring invalid FASTA index %s\n", fai_file);
+        fasta->count = 0;
+        fresh = false;
+    }
+    
+    int status = 0;
+    if (!fresh) {
+        // 建索引时顺序读取整个文件
+        if (fasta->size > 0) madvise((void*)fasta->data, fasta->size, MADV_SEQUENTIAL);
+        status = build_fai(fasta, filename);
+        if (status == 0) write_fai(fasta, fai_file);
+    }
+    free(fai_file);
+    if (status != 0) {
+        fasta_close(fasta);
+        return -1;
+    }
+    
+    // 之后按转座子位置随机读取，不做预读
+    if (fasta->size > 0) madvise((void*)fasta->data, fasta->size, MADV_RANDOM);
+    return 0;
+}
+
+// 取出第entry条序列[start, end]（1-based闭区间，超出序列的部分截去）的碱基，返回碱基数
+int64_t fasta_fetch(const FastaFile* fasta, int entry, int64_t start, int64_t end, char* out) {
+    const FaiEntry* seq = &fasta->entries[entry];
+    if (start < 1) start = 1;
+    if (end > seq->length) end = seq->length;
+    if (start > end) return 0;
+    
+    int64_t base = start - 1;
+    int64_t remaining = end - start + 1;
+    int64_t n = 0;
+    while (remaining > 0) {
+        int64_t column = base % seq->line_bases;
+        int64_t take = seq->line_bases - column < remaining ? seq->line_bases - column : remaining;
+        memcpy(out + n, fasta->data + seq->offset + base / seq->line_bases * seq->line_bytes + column,
+               (size_t)take);
+        n += take;
+        base += take;
+        remaining -= take;
+    }
+    return n;
+}
+
+// 染色体ID -> FASTA序列下标（不在FASTA中的为-1），数组大小为字符串表的条目数（至少为1）
+int* fasta_chr_entries(const FastaFile* fasta, const StringTable* strings) {
+    int chr_count = strings->count > 0 ? strings->count : 1;
+    int* entry_of_chr = (int*)safe_malloc(chr_count * sizeof(int));
+    for (int c = 0; c < chr_count; c++) entry_of_chr[c] = -1;
+    for (int e = 0; e < fasta->count; e++) {
+        int id = string_table_find(strings, fasta->entries[e].name);
+        if (id != STR_NONE && entry_of_chr[id] < 0) entry_of_chr[id] = e;
+    }
+    return entry_of_chr;
+}
+
+void fasta_close(FastaFile* fasta) {
+    if (!fasta) return;
+    
+    if (fasta->data) munmap((void*)fasta->data, fasta->size);
+    free(fasta->entries);
+    free_arena(&fasta->names);
+    memset(fasta, 0, sizeof(FastaFile));
+}
+
+// 一轮中一条染色体的提取任务，结果按记录依次写在buffer中
+typedef struct {
+    int* records;           // 属于该染色体的记录（相对本轮起点的下标，按选择集顺序）
+    int count;
+    char* buffer;
+    size_t size;
+    size_t capacity;
+} SequenceTask;
+
+typedef struct {
+    const TESelection* selection;
+    const FastaFile* fasta;
+    const int* entries;     // 记录对应的FASTA序列下标（相对本轮起点）
+    int begin;
+    SequenceTask* tasks;
+    size_t* offsets;        // 记录在其任务buffer中的起始位置
+    size_t* lengths;        // 记录的输出长度
+} SequenceJob;
+
+static void reserve_task_buffer(SequenceTask* task, size_t extra) {
+    if (task->size + extra <= task->capacity) return;
+    
+    size_t capacity = task->capacity ? task->capacity * 2 : 1 << 16;
+    while (capacity < task->size + extra) capacity *= 2;
+    task->buffer = (char*)safe_realloc(task->buffer, capacity);
+    task->capacity = capacity;
+}
+
+// 提取一条染色体上的记录（只读访问映射和列表，各任务写各自的缓冲区，可并发执行）
+static void run_sequence_task(void* ctx, int task_index) {
+    SequenceJob* job = (SequenceJob*)ctx;
+    SequenceTask* task = &job->tasks[task_index];
+    const TEList* list = job->selection->source;
+    char* bases = NULL;
+    size_t bases_capacity = 0;
+    
+    for (int r = 0; r < task->count; r++) {
+        int k = task->records[r];
+        int index = job->selection->indices[job->begin + k];
+        int64_t length = list->ends[index] - list->starts[index] + 1;
+        if ((size_t)length > bases_capacity) {
+            bases_capacity = (size_t)length;
+            free(bases);
+            bases = (char*)safe_malloc(bases_capacity);
+        }
+        int64_t n = fasta_fetch(job->fasta, job->entries[k], list->starts[index], list->ends[index], bases);
+        
+        // 负链转座子输出反向互补序列
+        const char* strand = string_table_get(list->strings, list->strands[index]);
+        if (strand && strcmp(strand, "-") == 0) {
+            for (int64_t i = 0, j = n - 1; i <= j; i++, j--) {
+                char left = bases[i];
+                char right = bases[j];
+                bases[i] = complement_bases[(unsigned char)right] ? complement_bases[(unsigned char)right] : right;
+                bases[j] = complement_bases[(unsigned char)left] ? complement_bases[(unsigned char)left] : left;
+            }
+        }
+        
+        // 标题行：>ID chr:start-end(strand)，各字段的长度都计入，链列的内容不做检查
+        const char* id = list->ids[index] ? list->ids[index] : list->names[index];
+        const char* chr = string_table_get(list->strings, list->chrs[index]);
+        if (!id) id = "N/A";
+        if (!strand) strand = ".";
+        size_t header_size = strlen(id) + strlen(chr) + strlen(strand) + 64;
+        reserve_task_buffer(task, header_size + (size_t)n + (size_t)n / SEQUENCE_LINE_WIDTH + 1);
+        job->offsets[k] = task->size;
+        int written = snprintf(task->buffer + task->size, header_size, ">%s %s:%lld-%lld(%s)\n", id, chr,
+                               (long long)list->starts[index], (long long)list->ends[index], strand);
+        if (written > 0) task->size += (size_t)written < header_size ? (size_t)written : header_size - 1;
+        for (int64_t i = 0; i < n; i += SEQUENCE_LINE_WIDTH) {
+            size_t take = (size_t)(n - i < SEQUENCE_LINE_WIDTH ? n - i : SEQUENCE_LINE_WIDTH);
+            memcpy(task->buffer + task->size, bases + i, take);
+            task->size += take;
+            task->buffer[task->size++] = '\n';
+        }
+        job->lengths[k] = task->size - job->offsets[k];
+    }
+    free(bases);
+}
+
+// 把选择集中转座子的序列写到filename（"-"为标准输出），顺序与选择集相同。
+// 染色体不在FASTA中或超出序列末端的转座子跳过并给出警告，返回写出的序列数，失败时返回-1
+int write_unique_sequences(const TESelection* selection, const FastaFile* fasta, const char* filename,
+                           int num_threads) {
+    if (!selection || !selection->source || !fasta || !filename) return -1;
+    
+    const TEList* list = selection->source;
+    const StringTable* strings = list->strings;
+    
+    int chr_count = strings->count > 0 ? strings->count : 1;
+    int* entry_of_chr = fasta_chr_entries(fasta, strings);
+    int* task_of_chr = (int*)safe_malloc(chr_count * sizeof(int));
+    for (int c = 0; c < chr_count; c++) task_of_chr[c] = -1;
+    
+    OutputWriter writer;
+    if (output_writer_open(&writer, filename) != 0) {
+        fprintf(stderr, "Error: Cannot create output file %s\n", filename);
+        free(entry_of_chr);
+        free(task_of_chr);
+        return -1;
+    }
+    
+    int round_size = selection->count < SEQUENCE_ROUND_RECORDS ? selection->count : SEQUENCE_ROUND_RECORDS;
+    if (round_size < 1) round_size = 1;
+    int* entries = (int*)safe_malloc(round_size * sizeof(int));
+    int* records = (int*)safe_malloc(round_size * sizeof(int));
+    size_t* offsets = (size_t*)safe_malloc(round_size * sizeof(size_t));
+    size_t* lengths = (size_t*)safe_malloc(round_size * sizeof(size_t));
+    int* record_task = (int*)safe_malloc(round_size * sizeof(int));
+    SequenceTask* tasks = (SequenceTask*)safe_malloc(round_size * sizeof(SequenceTask));
+    int written = 0;
+    int skipped = 0;
+    
+    for (int begin = 0; begin < selection->count; ) {
+        // 本轮的记录范围[begin, end)，并按染色体分组
+        int end = begin;
+        int task_count = 0;
+        int64_t round_bases = 0;
+        while (end < selection->count && end - begin < round_size && round_bases < SEQUENCE_ROUND_BASES) {
+            int k = end - begin;
+            int index = selection->indices[end++];
+            int chr = list->chrs[index];
+            int entry = chr >= 0 && chr < chr_count ? entry_of_chr[chr] : -1;
+            lengths[k] = 0;
+            record_task[k] = -1;
+            if (entry < 0 || list->starts[index] < 1 || list->starts[index] > list->ends[index] ||
+                list->ends[index] > fasta->entries[entry].length) {
+                continue;
+            }
+            entries[k] = entry;
+            if (task_of_chr[chr] < 0) {
+                task_of_chr[chr] = task_count;
+                memset(&tasks[task_count], 0, sizeof(SequenceTask));
+                task_count++;
+            }
+            record_task[k] = task_of_chr[chr];
+            tasks[record_task[k]].count++;
+            round_bases += list->ends[index] - list->starts[index] + 1;
+        }
+        
+        // 各任务的记录下标在records中连续存放
+        int position = 0;
+        for (int t = 0; t < task_count; t++) {
+            tasks[t].records = records + position;
+            position += tasks[t].count;
+            tasks[t].count = 0;
+        }
+        for (int k = 0; k < end - begin; k++) {
+            if (record_task[k] >= 0) {
+                SequenceTask* task = &tasks[record_task[k]];
+                task->records[task->count++] = k;
+            }
+        }
+        
+        SequenceJob job = { selection, fasta, entries, begin, tasks, offsets, lengths };
+        parallel_for(task_count, num_threads, run_sequence_task, &job);
+        
+        // 按选择集顺序写出
+        for (int k = 0; k < end - begin; k++) {
+            if (record_task[k] < 0) {
+                skipped++;
+                continue;
+            }
+            output_writer_write(&writer, tasks[record_task[k]].buffer + offsets[k], lengths[k]);
+            written++;
+        }
+        for (int t = 0; t < task_count; t++) free(tasks[t].buffer);
+        for (int k = 0; k < end - begin; k++) {
+            int chr = list->chrs[selection->indices[begin + k]];
+            if (chr >= 0 && chr < chr_count) task_of_chr[chr] = -1;
+        }
+        begin = end;
+    }
+    
+    free(entry_of_chr);
+    free(task_of_chr);
+    free(entries);
+    free(records);
+    free(offsets);
+    free(lengths);
+    free(record_task);
+    free(tasks);
+    
+    if (output_writer_close(&writer) != 0) {
+        fprintf(stderr, "Error: Failed to write output file %s\n", filename);
+        return -1;
+    }
+    if (skipped > 0) {
+        fprintf(stderr, "Warning: %d TEs skipped in %s: chromosome missing from the genome file "
+                        "or TE beyond its end\n", skipped, filename);
+    }
+    return written;
+}
+
+// 为给出了基因组FASTA的基因组写出<prefix>_genomeN_unique.fa
+int write_unique_sequence_files(const TESelection* unique_te1, const TESelection* unique_te2,
+                                const char* genome1_file, const char* genome2_file,
+                                const char* output_prefix, int num_threads) {
+    const TESelection* selections[2] = { unique_te1, unique_te2 };
+    const char* genome_files[2] = { genome1_file, genome2_file };
+    
+    for (int g = 0; g < 2; g++) {
+        if (!genome_files[g]) continue;
+        
+        FastaFile fasta;
+        if (fasta_open(&fasta, genome_files[g]) != 0) return -1;
+        
+        char filename[512];
+        if (strcmp(output_prefix, "-") == 0) {
+            snprintf(filename, sizeof(filename), "-");
+        } else {
+            snprintf(filename, sizeof(filename), "%s_genome%d_unique.fa", output_prefix, g + 1);
+        }
+        int written = write_unique_sequences(selections[g], &fasta, filename, num_threads);
+        fasta_close(&fasta);
+        if (written < 0) return -1;
+        printf("Genome %d unique TE sequences (%d) written to: %s\n", g + 1, written,
+               strcmp(filename, "-") == 0 ? "standard output" : filename);
+    }
+    return 0;
+}
@@ -0,0 +1,410 @@
+#include "te_comparator.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// 流式读取时每次read的字节数
+#define READER_CHUNK_SIZE (1 << 20)
+// 同时暂存的已预读输入数
+#define PENDING_READERS 4
+
+// 管道、标准输入等只能读一次的输入在检测格式时预读的内容：line_reader_unread把读取器
+// 连同缓冲区暂存在这里，之后对同一文件名的line_reader_open直接接管，从第一行重新读起
+typedef struct {
+    char* filename;
+    LineReader reader;
+} PendingReader;
+
+static PendingReader pending_readers[PENDING_READERS];
+static pthread_mutex_t pending_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// 取出文件名对应的暂存读取器
+static bool take_pending_reader(const char* filename, LineReader* reader) {
+    bool found = false;
+    pthread_mutex_lock(&pending_lock);
+    for (int i = 0; i < PENDING_READERS && !found; i++) {
+        if (pending_readers[i].filename && strcmp(pending_readers[i].filename, filename) == 0) {
+            *reader = pending_readers[i].reader;
+            free(pending_readers[i].filename);
+            pending_readers[i].filename = NULL;
+            found = true;
+        }
+    }
+    pthread_mutex_unlock(&pending_lock);
+    return found;
+}
+
+// 识别已打开的fd：普通文件使用mmap，压缩输入交给num_threads个线程的解压流，其余流式读取
+static int attach_input(LineReader* reader, int num_threads) {
+    struct stat st;
+    bool regular = fstat(reader->fd, &st) == 0 && S_ISREG(st.st_mode);
+    
+    // 普通文件通过pread检查魔数，不移动读取位置
+    unsigned char magic[2];
+    if (regular && pread(reader->fd, magic, 2, 0) == 2 && is_gzip_magic(magic, 2)) {
+        reader->inflate = inflate_stream_open(reader->fd, NULL, 0, num_threads);
+        if (!reader->inflate) {
+            line_reader_close(reader);
+            return -1;
+        }
+        regular = false;
+    }
+    
+    if (regular) {
+        reader->size = (size_t)st.st_size;
+        if (reader->size == 0) {
+            reader->mapped = true;
+            reader->data = "";
+            return 0;
+        }
+        
+        void* map = mmap(NULL, reader->size, PROT_READ, MAP_PRIVATE, reader->fd, 0);
+        if (map != MAP_FAILED) {
+            madvise(map, reader->size, MADV_SEQUENTIAL);
+            reader->mapped = true;
+            reader->owns_mapping = true;
+            reader->data = (const char*)map;
+            return 0;
+        }
+    }
+    
+    // 流式读取
+    reader->mapped = false;
+    reader->size = 0;
+    reader->buffer_capacity = READER_CHUNK_SIZE;
+    reader->buffer = (char*)safe_malloc(reader->buffer_capacity);
+    reader->data = reader->buffer;
+    
+    // 管道无法回退，先读出开头的数据检查魔数，压缩时把已读数据交给解压流
+    if (!reader->inflate) {
+        while (reader->size < 2) {
+            ssize_t n = read(reader->fd, reader->buffer + reader->size, 
+                             reader->buffer_capacity - reader->size);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                reader->eof = true;
+                break;
+            }
+            reader->size += (size_t)n;
+            reader->bytes_read += (size_t)n;
+        }
+        
+        if (is_gzip_magic((const unsigned char*)reader->buffer, reader->size)) {
+            reader->inflate = inflate_stream_open(reader->fd, (const unsigned char*)reader->buffer, 
+                                                  reader->size, num_threads);
+            reader->size = 0;
+            reader->bytes_read = 0;
+            if (!reader->inflate) {
+                line_reader_close(reader);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+// 打开输入文件：普通文件使用mmap，管道等不可映射的输入退化为流式读取；"-"表示标准输入。
+// 以gzip魔数开头的输入（包括BGZF）自动解压，解压在后台线程中与解析重叠进行，
+// BGZF块用num_threads个线程并行解压（0表示全部CPU）
+int line_reader_open(LineReader* reader, const char* filename, int num_threads) {
+    if (!reader || !filename) return -1;
+    
+    memset(reader, 0, sizeof(LineReader));
+    reader->fd = -1;
+    if (take_pending_reader(filename, reader)) return 0;
+    
+    if (strcmp(filename, "-") == 0) {
+        reader->fd = STDIN_FILENO;
+    } else {
+        reader->fd = open(filename, O_RDONLY);
+        if (reader->fd < 0) return -1;
+    }
+    if (!oom_trap_active()) return attach_input(reader, num_threads);
+    
+    // 库调用在打开过程中内存不足时关闭已打开的文件和解压流，再跳回调用方的陷阱
+    jmp_buf trap;
+    jmp_buf* previous = set_oom_trap(&trap);
+    if (setjmp(trap)) {
+        set_oom_trap(previous);
+        line_reader_close(reader);
+        out_of_memory(0);
+    }
+    int result = attach_input(reader, num_threads);
+    set_oom_trap(previous);
+    return result;
+}
+
+// 打开输入用于预读（例如检测格式）：流式输入保留读过的行，读完后用line_reader_unread交还
+int line_reader_open_peek(LineReader* reader, const char* filename, int num_threads) {
+    if (line_reader_open(reader, filename, num_threads) != 0) return -1;
+    reader->keep_all = true;
+    return 0;
+}
+
+// 结束预读：可以重新打开的输入（普通文件）直接关闭；标准输入和管道回到第一行后暂存，
+// 下一次以同一文件名打开时接管，不会丢失已经从管道读出的数据
+void line_reader_unread(LineReader* reader, const char* filename) {
+    if (!reader) return;
+    struct stat st;
+    bool reopenable = reader->mapped || 
+                      (strcmp(filename ? filename : "-", "-") != 0 && 
+                       fstat(reader->fd, &st) == 0 && S_ISREG(st.st_mode));
+    if (reopenable || !reader->keep_all || !filename) {
+        line_reader_close(reader);
+        return;
+    }
+    
+    reader->keep_all = false;
+    reader->pos = 0;
+    reader->scan = 0;
+    reader->line_num = 0;
+    
+    pthread_mutex_lock(&pending_lock);
+    int slot = -1;
+    for (int i = 0; i < PENDING_READERS && slot < 0; i++) {
+        if (!pending_readers[i].filename) slot = i;
+    }
+    if (slot >= 0) {
+        pending_readers[slot].filename = strdup_safe(filename);
+        pending_readers[slot].reader = *reader;
+    }
+    pthread_mutex_unlock(&pending_lock);
+    
+    if (slot < 0) {
+        line_reader_close(reader);
+    } else {
+        memset(reader, 0, sizeof(LineReader));
+        reader->fd = -1;
+    }
+}
+
+// 在已有的内存缓冲区上逐行读取（不复制、不接管data），用于分块并行解析
+void line_reader_init_buffer(LineReader* reader, const char* data, size_t size) {
+    if (!reader) return;
+    
+    memset(reader, 0, sizeof(LineReader));
+    reader->fd = -1;
+    reader->mapped = true;
+    reader->data = data;
+    reader->size = size;
+}
+
+// 流式模式下补充数据，返回读取到的字节数（0表示文件结束）
+static size_t fill_buffer(LineReader* reader) {
+    // 把未处理的数据移到缓冲区开头（预读时保留全部数据）
+    if (reader->pos > 0 && !reader->keep_all) {
+        memmove(reader->buffer, reader->buffer + reader->pos, reader->size - reader->pos);
+        reader->size -= reader->pos;
+        reader->scan -= reader->pos;
+        reader->pos = 0;
+    }
+    
+    // 单行超过缓冲区时扩容
+    if (reader->buffer_capacity - reader->size < READER_CHUNK_SIZE / 2) {
+        reader->buffer_capacity *= 2;
+        reader->buffer = (char*)safe_realloc(reader->buffer, reader->buffer_capacity);
+    }
+    reader->data = reader->buffer;
+    
+    ssize_t n;
+    if (reader->inflate) {
+        n = (ssize_t)inflate_stream_read(reader->inflate, reader->buffer + reader->size, 
+                                         reader->buffer_capacity - reader->size);
+    } else {
+        do {
+            n = read(reader->fd, reader->buffer + reader->size, reader->buffer_capacity - reader->size);
+        } while (n < 0 && errno == EINTR);
+    }
+    
+    if (n <= 0) {
+        reader->eof = true;
+        return 0;
+    }
+    
+    reader->size += (size_t)n;
+    reader->bytes_read += (size_t)n;
+    return (size_t)n;
+}
+
+// 读取下一行，line指向内部缓冲区（不含换行符），在下一次调用前有效
+bool line_reader_next(LineReader* reader, StrSlice* line) {
+    if (!reader || !line) return false;
+    
+    for (;;) {
+        const char* start = reader->data + reader->pos;
+        const char* newline = NULL;
+        if (reader->scan < reader->size) {
+            newline = (const char*)memchr(reader->data + reader->scan, '\n', 
+                                          reader->size - reader->scan);
+        }
+        
+        size_t end;
+        if (newline) {
+            end = (size_t)(newline - reader->data);
+        } else if (reader->mapped || reader->eof) {
+            // 最后一行没有换行符
+            if (reader->pos >= reader->size) return false;
+            end = reader->size;
+        } else {
+            reader->scan = reader->size;
+            fill_buffer(reader);
+            continue;
+        }
+        
+        // 与原fgets处理一致：行在第一个'\r'处截断
+        size_t len = end - reader->pos;
+        const char* cr = (const char*)memchr(start, '\r', len);
+        line->ptr = start;
+        line->len = cr ? (size_t)(cr - start) : len;
+        
+        reader->pos = end < reader->size ? end + 1 : end;
+        reader->scan = reader->pos;
+        reader->line_num++;
+        return true;
+    }
+}
+
+// 关闭输入文件
+void line_reader_close(LineReader* reader) {
+    if (!reader) return;
+    
+    inflate_stream_close(reader->inflate);
+    if (reader->owns_mapping) {
+        munmap((void*)reader->data, reader->size);
+    }
+    free(reader->buffer);
+    if (reader->fd >= 0 && reader->fd != STDIN_FILENO) {
+        close(reader->fd);
+    }
+    memset(reader, 0, sizeof(LineReader));
+    reader->fd = -1;
+}
+
+// 读取过程中是否出错（目前只有压缩数据损坏或被截断）
+bool line_reader_failed(LineReader* reader) {
+    return reader && reader->inflate && inflate_stream_failed(reader->inflate);
+}
+
+// 一次find_bytes调用最多返回的分隔符个数
+#define SPLIT_BATCH 64
+
+// 按分隔符切分字段，与strtok一致：连续分隔符视为一个，首尾分隔符忽略。
+// 分隔符位置由find_bytes按块批量查找
+int split_fields(StrSlice line, char sep, StrSlice* fields, int max_fields) {
+    uint32_t positions[SPLIT_BATCH];
+    int count = 0;
+    size_t field_start = 0;
+    size_t scanned = 0;
+    
+    if (max_fields <= 0) return 0;
+    for (;;) {
+        int found = find_bytes(line.ptr + scanned, line.len - scanned, sep, sep, positions, SPLIT_BATCH);
+        for (int i = 0; i < found; i++) {
+            size_t stop = scanned + positions[i];
+            if (stop > field_start) {
+                fields[count].ptr = line.ptr + field_start;
+                fields[count].len = stop - field_start;
+                if (++count == max_fields) return count;
+            }
+            field_start = stop + 1;
+        }
+        if (found < SPLIT_BATCH) break;
+        scanned = field_start;
+    }
+    
+    if (line.len > field_start) {
+        fields[count].ptr = line.ptr + field_start;
+        fields[count].len = line.len - field_start;
+        count++;
+    }
+    return count;
+}
+
+// 按空白（空格或制表符）切分字段，最多填充max_fields个，返回实际字段总数
+int split_whitespace(StrSlice line, StrSlice* fields, int max_fields) {
+    int count = 0;
+    size_t i = 0;
+    while (i < line.len) {
+        while (i < line.len && isspace((unsigned char)line.ptr[i])) i++;
+        if (i >= line.len) break;
+        size_t start = i;
+        while (i < line.len && !isspace((unsigned char)line.ptr[i])) i++;
+        if (count < max_fields) {
+            fields[count].ptr = line.ptr + start;
+            fields[count].len = i - start;
+        }
+        count++;
+    }
+    return count;
+}
+
+// 与atoi一致地解析整数：跳过前导空白，读取可选符号和数字
+int slice_to_int(StrSlice slice) {
+    const char* p = slice.ptr;
+    const char* end = slice.ptr + slice.len;
+    
+    while (p < end && isspace((unsigned char)*p)) p++;
+    
+    bool negative = false;
+    if (p < end && (*p == '+' || *p == '-')) {
+        negative = *p == '-';
+        p++;
+    }
+    
+    long long value = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        value = value * 10 + (*p - '0');
+        if (value > 2147483648LL) value = 2147483648LL;
+        p++;
+    }
+    
+    if (negative) value = -value;
+    if (value > 2147483647LL) value = 2147483647LL;
+    return (int)value;
+}
+
+// 解析坐标：与slice_to_int相同的规则，结果为64位并限制在±MAX_POSITION内
+int64_t slice_to_position(StrSlice slice) {
+    const char* p = slice.ptr;
+    const char* end = slice.ptr + slice.len;
+    
+    while (p < end && isspace((unsigned char)*p)) p++;
+    
+    bool negative = false;
+    if (p < end && (*p == '+' || *p == '-')) {
+        negative = *p == '-';
+        p++;
+    }
+    
+    int64_t value = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        value = value < MAX_POSITION / 10 ? value * 10 + (*p - '0') : MAX_POSITION;
+        if (value > MAX_POSITION) value = MAX_POSITION;
+        p++;
+    }
+    
+    return negative ? -value : value;
+}
+
+// 与atof一致地解析浮点数
+double slice_to_double(StrSlice slice) {
+    char buffer[64];
+    size_t len = slice.len < sizeof(buffer) - 1 ? slice.len : sizeof(buffer) - 1;
+    memcpy(buffer, slice.ptr, len);
+    buffer[len] = '\0';
+    return atof(buffer);
+}
+
+// 判断切片是否等于C字符串
+bool slice_equals(StrSlice slice, const char* str) {
+    size_t len = strlen(str);
+    return slice.len == len && memcmp(slice.ptr, str, len) == 0;
+}
+
+// 判断切片中是否包含子串
+bool slice_contains(StrSlice slice, const char* str) {
+    return memmem(slice.ptr, slice.len, str, strlen(str)) != NULL;
+}
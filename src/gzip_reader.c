@@ -0,0 +1,680 @@
+#include "te_comparator.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <zlib.h>
+
+// 普通gzip每次输出的块大小
+#define INFLATE_OUT_SIZE (1 << 20)
+// 压缩输入缓冲区大小
+#define INFLATE_IN_SIZE (1 << 20)
+// 输出队列长度：后台线程最多领先消费者这么多块
+#define INFLATE_QUEUE_SIZE 4
+// BGZF每批每个线程解压的块数
+#define BGZF_BLOCKS_PER_THREAD 16
+// BGZF块的最大压缩长度
+#define BGZF_MAX_BLOCK_SIZE 65536
+
+// 解压后的一段数据
+typedef struct {
+    char* data;
+    size_t size;
+} InflateChunk;
+
+// BGZF批处理中的单个块
+typedef struct {
+    const unsigned char* cdata;  // deflate数据
+    size_t csize;
+    char* out;                   // 解压目标位置
+    size_t isize;                // 解压后长度（取自块尾部）
+    uint32_t crc;
+    bool ok;
+} BgzfBlock;
+
+struct InflateStream {
+    int fd;
+    bool bgzf;
+    int num_threads;
+    
+    // 压缩输入
+    unsigned char* in_buf;
+    size_t in_size;
+    size_t in_pos;
+    bool in_eof;
+    
+    // 后台线程与输出队列
+    pthread_t thread;
+    bool thread_started;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    InflateChunk queue[INFLATE_QUEUE_SIZE];
+    int queue_head;
+    int queue_count;
+    bool done;
+    bool failed;
+    bool stop;
+    bool trap_oom;               // 打开流的线程设置了内存不足陷阱
+    bool oom;                    // 解压线程内存不足，消费者读完后转交给自己的陷阱
+    
+    // 解压线程的工作状态，放在流中以便内存不足跳出时统一释放
+    z_stream zs;
+    bool zs_ready;
+    char* work_out;
+    BgzfBlock* work_blocks;
+    unsigned char* work_cbuf;
+    
+    // 消费端正在读取的数据块
+    InflateChunk current;
+    size_t current_pos;
+};
+
+// 判断数据是否以gzip魔数开头
+bool is_gzip_magic(const unsigned char* data, size_t size) {
+    return size >= 2 && data[0] == 0x1f && data[1] == 0x8b;
+}
+
+// 判断数据是否为BGZF块头（gzip头带FEXTRA，子字段为'BC'）
+static bool is_bgzf_header(const unsigned char* data, size_t size) {
+    return size >= 18 && is_gzip_magic(data, size) && data[2] == 8 && (data[3] & 4) &&
+           data[12] == 'B' && data[13] == 'C' && data[14] == 2 && data[15] == 0;
+}
+
+// 补充压缩输入，把未消费的数据移到开头；返回缓冲区中可用的字节数
+static size_t refill_input(InflateStream* stream) {
+    if (stream->in_pos > 0) {
+        memmove(stream->in_buf, stream->in_buf + stream->in_pos, stream->in_size - stream->in_pos);
+        stream->in_size -= stream->in_pos;
+        stream->in_pos = 0;
+    }
+    
+    while (!stream->in_eof && stream->in_size < INFLATE_IN_SIZE) {
+        ssize_t n = read(stream->fd, stream->in_buf + stream->in_size, INFLATE_IN_SIZE - stream->in_size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            stream->in_eof = true;
+            break;
+        }
+        stream->in_size += (size_t)n;
+    }
+    
+    return stream->in_size;
+}
+
+// 把解压结果放入队列，队列满时等待；消费者已关闭时返回false
+static bool push_chunk(InflateStream* stream, char* data, size_t size) {
+    pthread_mutex_lock(&stream->lock);
+    while (stream->queue_count == INFLATE_QUEUE_SIZE && !stream->stop) {
+        pthread_cond_wait(&stream->not_full, &stream->lock);
+    }
+    
+    if (stream->stop) {
+        pthread_mutex_unlock(&stream->lock);
+        free(data);
+        return false;
+    }
+    
+    int tail = (stream->queue_head + stream->queue_count) % INFLATE_QUEUE_SIZE;
+    stream->queue[tail].data = data;
+    stream->queue[tail].size = size;
+    stream->queue_count++;
+    pthread_cond_signal(&stream->not_empty);
+    pthread_mutex_unlock(&stream->lock);
+    return true;
+}
+
+// 普通gzip：单线程顺序解压，支持多个gzip成员首尾相接
+static void inflate_gzip(InflateStream* stream) {
+    z_stream* zs = &stream->zs;
+    if (inflateInit2(zs, 16 + MAX_WBITS) != Z_OK) {
+        stream->failed = true;
+        return;
+    }
+    stream->zs_ready = true;
+    
+    stream->work_out = (char*)safe_malloc(INFLATE_OUT_SIZE);
+    size_t out_size = 0;
+    bool member_open = true;
+    
+    for (;;) {
+        if (stream->in_pos >= stream->in_size) {
+            if (refill_input(stream) == 0) {
+                // 输入结束时gzip成员尚未结束，说明文件被截断
+                if (member_open) stream->failed = true;
+                break;
+            }
+        }
+        
+        zs->next_in = stream->in_buf + stream->in_pos;
+        zs->avail_in = (uInt)(stream->in_size - stream->in_pos);
+        zs->next_out = (Bytef*)stream->work_out + out_size;
+        zs->avail_out = (uInt)(INFLATE_OUT_SIZE - out_size);
+        
+        int ret = inflate(zs, Z_NO_FLUSH);
+        stream->in_pos = stream->in_size - zs->avail_in;
+        out_size = INFLATE_OUT_SIZE - zs->avail_out;
+        
+        if (ret == Z_STREAM_END) {
+            // 下一个gzip成员（若有）
+            member_open = false;
+            if (stream->in_pos >= stream->in_size) refill_input(stream);
+            if (stream->in_size - stream->in_pos == 0) break;
+            inflateReset(zs);
+            member_open = true;
+        } else if (ret != Z_OK && ret != Z_BUF_ERROR) {
+            stream->failed = true;
+            break;
+        }
+        
+        if (out_size == INFLATE_OUT_SIZE) {
+            char* out = stream->work_out;
+            stream->work_out = NULL;
+            if (!push_chunk(stream, out, out_size)) break;
+            stream->work_out = (char*)safe_malloc(INFLATE_OUT_SIZE);
+            out_size = 0;
+        }
+    }
+    
+    if (stream->work_out && out_size > 0) {
+        char* out = stream->work_out;
+        stream->work_out = NULL;
+        push_chunk(stream, out, out_size);
+    }
+}
+
+// 解压单个BGZF块（原始deflate数据），并校验CRC和长度
+static void inflate_bgzf_block(void* ctx, int task) {
+    BgzfBlock* block = &((BgzfBlock*)ctx)[task];
+    block->ok = false;
+    
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (inflateInit2(&zs, -MAX_WBITS) != Z_OK) return;
+    
+    zs.next_in = (Bytef*)block->cdata;
+    zs.avail_in = (uInt)block->csize;
+    zs.next_out = (Bytef*)block->out;
+    zs.avail_out = (uInt)block->isize;
+    
+    int ret = inflate(&zs, Z_FINISH);
+    bool complete = ret == Z_STREAM_END && zs.avail_out == 0;
+    inflateEnd(&zs);
+    
+    if (complete || (block->isize == 0 && ret == Z_STREAM_END)) {
+        block->ok = crc32(0L, (const Bytef*)block->out, (uInt)block->isize) == block->crc;
+    }
+}
+
+// 读取一个完整BGZF块到输入缓冲区，返回块长度（0表示结束，-1表示格式错误）
+static long next_bgzf_block(InflateStream* stream) {
+    if (stream->in_size - stream->in_pos < 18) {
+        refill_input(stream);
+        if (stream->in_size - stream->in_pos == 0) return 0;
+    }
+    
+    const unsigned char* header = stream->in_buf + stream->in_pos;
+    if (!is_bgzf_header(header, stream->in_size - stream->in_pos)) return -1;
+    
+    long block_size = (long)(header[16] | (header[17] << 8)) + 1;
+    if (stream->in_size - stream->in_pos < (size_t)block_size) {
+        refill_input(stream);
+        if (stream->in_size - stream->in_pos < (size_t)block_size) return -1;
+    }
+    return block_size;
+}
+
+// BGZF：按批读取多个块，用线程池并行解压，每批整体放入队列
+static void inflate_bgzf(InflateStream* stream) {
+    int batch_capacity = stream->num_threads * BGZF_BLOCKS_PER_THREAD;
+    stream->work_blocks = (BgzfBlock*)safe_malloc(batch_capacity * sizeof(BgzfBlock));
+    stream->work_cbuf = (unsigned char*)safe_malloc((size_t)batch_capacity * BGZF_MAX_BLOCK_SIZE);
+    BgzfBlock* blocks = stream->work_blocks;
+    unsigned char* cbuf = stream->work_cbuf;
+    
+    bool finished = false;
+    while (!finished) {
+        // 收集一批块，压缩数据复制到cbuf以便继续读取输入
+        int count = 0;
+        size_t cbuf_used = 0;
+        size_t out_total = 0;
+        while (count < batch_capacity) {
+            long block_size = next_bgzf_block(stream);
+            if (block_size == 0) {
+                finished = true;
+                break;
+            }
+            if (block_size < 0 || block_size < 26) {
+                stream->failed = true;
+                finished = true;
+                break;
+            }
+            
+            const unsigned char* raw = stream->in_buf + stream->in_pos;
+            size_t xlen = (size_t)(raw[10] | (raw[11] << 8));
+            size_t data_offset = 12 + xlen;
+            if (data_offset + 8 > (size_t)block_size) {
+                stream->failed = true;
+                finished = true;
+                break;
+            }
+            
+            memcpy(cbuf + cbuf_used, raw, (size_t)block_size);
+            const unsigned char* trailer = cbuf + cbuf_used + block_size - 8;
+            
+            BgzfBlock* block = &blocks[count++];
+            block->cdata = cbuf + cbuf_used + data_offset;
+            block->csize = (size_t)block_size - data_offset - 8;
+            block->crc = (uint32_t)trailer[0] | ((uint32_t)trailer[1] << 8) |
+                         ((uint32_t)trailer[2] << 16) | ((uint32_t)trailer[3] << 24);
+            block->isize = (size_t)trailer[4] | ((size_t)trailer[5] << 8) |
+                           ((size_t)trailer[6] << 16) | ((size_t)trailer[7] << 24);
+            // 解压长度取自文件，超过BGZF块上限说明数据损坏，不能据此分配输出
+            if (block->isize > BGZF_MAX_BLOCK_SIZE) {
+                stream->failed = true;
+                finished = true;
+                break;
+            }
+            out_total += block->isize;
+            
+            cbuf_used += (size_t)block_size;
+            stream->in_pos += (size_t)block_size;
+        }
+        
+        if (count == 0 || stream->failed) break;
+        
+        // 每个块的解压长度已知，直接解压到输出中的对应位置，无需重排
+        stream->work_out = (char*)safe_malloc(out_total > 0 ? out_total : 1);
+        char* out = stream->work_out;
+        size_t offset = 0;
+        for (int i = 0; i < count; i++) {
+            blocks[i].out = out + offset;
+            offset += blocks[i].isize;
+        }
+        
+        parallel_for(count, stream->num_threads, inflate_bgzf_block, blocks);
+        
+        for (int i = 0; i < count; i++) {
+            if (!blocks[i].ok) stream->failed = true;
+        }
+        if (stream->failed) break;
+        
+        stream->work_out = NULL;
+        if (out_total == 0) {
+            free(out);
+        } else if (!push_chunk(stream, out, out_total)) {
+            break;
+        }
+    }
+}
+
+// 释放解压线程的工作状态（正常结束和内存不足跳出时都会调用）
+static void release_work_state(InflateStream* stream) {
+    if (stream->zs_ready) inflateEnd(&stream->zs);
+    stream->zs_ready = false;
+    free(stream->work_out);
+    free(stream->work_blocks);
+    free(stream->work_cbuf);
+    stream->work_out = NULL;
+    stream->work_blocks = NULL;
+    stream->work_cbuf = NULL;
+}
+
+// 后台解压线程
+static void* inflate_thread_main(void* arg) {
+    InflateStream* stream = (InflateStream*)arg;
+    
+    // 打开流的线程设置了陷阱（库接口）时，内存不足只结束解压并标记失败，
+    // 由消费者在读完已解压的数据后在自己的线程中按内存不足处理
+    jmp_buf trap;
+    if (stream->trap_oom) {
+        set_oom_trap(&trap);
+        if (setjmp(trap)) {
+            set_oom_trap(NULL);
+            release_work_state(stream);
+            pthread_mutex_lock(&stream->lock);
+            stream->failed = true;
+            stream->oom = true;
+            stream->done = true;
+            pthread_cond_broadcast(&stream->not_empty);
+            pthread_mutex_unlock(&stream->lock);
+            return NULL;
+        }
+    }
+    
+    if (stream->bgzf) {
+        inflate_bgzf(stream);
+    } else {
+        inflate_gzip(stream);
+    }
+    release_work_state(stream);
+    if (stream->trap_oom) set_oom_trap(NULL);
+    
+    pthread_mutex_lock(&stream->lock);
+    stream->done = true;
+    pthread_cond_broadcast(&stream->not_empty);
+    pthread_mutex_unlock(&stream->lock);
+    return NULL;
+}
+
+// 在fd上打开解压流，prefix为调用方已经从fd中读出的开头数据；
+// 解压在后台线程进行，BGZF块使用num_threads个线程并行解压
+InflateStream* inflate_stream_open(int fd, const unsigned char* prefix, size_t prefix_size,
+                                   int num_threads) {
+    // 先分配输入缓冲区：结构体分配失败时它是唯一需要归还的内存
+    unsigned char* in_buf = (unsigned char*)safe_malloc(INFLATE_IN_SIZE);
+    InflateStream* stream = (InflateStream*)malloc(sizeof(InflateStream));
+    if (!stream) {
+        free(in_buf);
+        out_of_memory(sizeof(InflateStream));
+    }
+    memset(stream, 0, sizeof(InflateStream));
+    
+    stream->fd = fd;
+    stream->num_threads = resolve_thread_count(num_threads);
+    stream->trap_oom = oom_trap_active();
+    stream->in_buf = in_buf;
+    if (prefix_size > 0) {
+        memcpy(stream->in_buf, prefix, prefix_size);
+        stream->in_size = prefix_size;
+    }
+    
+    refill_input(stream);
+    if (!is_gzip_magic(stream->in_buf, stream->in_size)) {
+        free(stream->in_buf);
+        free(stream);
+        return NULL;
+    }
+    stream->bgzf = is_bgzf_header(stream->in_buf, stream->in_size);
+    
+    pthread_mutex_init(&stream->lock, NULL);
+    pthread_cond_init(&stream->not_empty, NULL);
+    pthread_cond_init(&stream->not_full, NULL);
+    
+    if (pthread_create(&stream->thread, NULL, inflate_thread_main, stream) == 0) {
+        stream->thread_started = true;
+    } else {
+        // 无法创建解压线程时没有数据可读，按解压失败报告
+        stream->failed = true;
+        stream->done = true;
+    }
+    
+    return stream;
+}
+
+// 读取最多max字节的解压数据，返回0表示结束（结束后用inflate_stream_failed检查是否出错）
+size_t inflate_stream_read(InflateStream* stream, char* dest, size_t max) {
+    if (!stream) return 0;
+    
+    size_t total = 0;
+    while (total < max) {
+        if (stream->current_pos >= stream->current.size) {
+            free(stream->current.data);
+            stream->current.data = NULL;
+            stream->current.size = 0;
+            stream->current_pos = 0;
+            
+            // 已经读到数据时不再等待，先交给调用方处理
+            if (total > 0) {
+                pthread_mutex_lock(&stream->lock);
+                bool ready = stream->queue_count > 0;
+                pthread_mutex_unlock(&stream->lock);
+                if (!ready) break;
+            }
+            
+            pthread_mutex_lock(&stream->lock);
+            while (stream->queue_count == 0 && !stream->done) {
+                pthread_cond_wait(&stream->not_empty, &stream->lock);
+            }
+            if (stream->queue_count == 0) {
+                bool oom = stream->oom;
+                pthread_mutex_unlock(&stream->lock);
+                // 解压线程内存不足：按当前线程内存不足处理（跳回调用方的陷阱）
+                if (oom) out_of_memory(0);
+                break;
+            }
+            stream->current = stream->queue[stream->queue_head];
+            stream->queue_head = (stream->queue_head + 1) % INFLATE_QUEUE_SIZE;
+            stream->queue_count--;
+            pthread_cond_signal(&stream->not_full);
+            pthread_mutex_unlock(&stream->lock);
+        }
+        
+        size_t available = stream->current.size - stream->current_pos;
+        size_t n = available < max - total ? available : max - total;
+        memcpy(dest + total, stream->current.data + stream->current_pos, n);
+        stream->current_pos += n;
+        total += n;
+    }
+    
+    return total;
+}
+
+// 解压是否出错（数据损坏或被截断）
+bool inflate_stream_failed(InflateStream* stream) {
+    if (!stream) return false;
+    
+    pthread_mutex_lock(&stream->lock);
+    bool failed = stream->failed;
+    pthread_mutex_unlock(&stream->lock);
+    return failed;
+}
+
+// 关闭解压流（不关闭fd）
+void inflate_stream_close(InflateStream* stream) {
+    if (!stream) return;
+    
+    pthread_mutex_lock(&stream->lock);
+    stream->stop = true;
+    pthread_cond_broadcast(&stream->not_full);
+    pthread_mutex_unlock(&stream->lock);
+    
+    if (stream->thread_started) {
+        pthread_join(stream->thread, NULL);
+    }
+    
+    for (int i = 0; i < stream->queue_count; i++) {
+        free(stream->queue[(stream->queue_head + i) % INFLATE_QUEUE_SIZE].data);
+    }
+    free(stream->current.data);
+    free(stream->in_buf);
+    
+    pthread_mutex_destroy(&stream->lock);
+    pthread_cond_destroy(&stream->not_empty);
+    pthread_cond_destroy(&stream->not_full);
+    free(stream);
+}
+
+// 可随机访问的BGZF读取器：按虚拟偏移（块偏移<<16 | 块内偏移）定位后逐行读取
+struct BgzfReader {
+    int fd;
+    uint64_t block_offset;       // 当前块在文件中的偏移
+    size_t block_csize;          // 当前块的压缩长度，0表示尚未加载
+    unsigned char* cbuf;
+    char* block;                 // 当前块解压后的数据
+    size_t block_size;
+    size_t block_pos;
+    char* line;                  // 跨块的行在此拼接
+    size_t line_capacity;
+    bool eof;
+    bool failed;
+    long long newlines;          // bgzf_reader_lines_before：当前位置之前的换行符个数
+};
+
+// 打开BGZF文件，不是BGZF格式时返回NULL
+BgzfReader* bgzf_reader_open(const char* filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return NULL;
+    
+    unsigned char header[18];
+    if (pread(fd, header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        !is_bgzf_header(header, sizeof(header))) {
+        close(fd);
+        return NULL;
+    }
+    
+    BgzfReader* reader = (BgzfReader*)safe_malloc(sizeof(BgzfReader));
+    memset(reader, 0, sizeof(BgzfReader));
+    reader->fd = fd;
+    reader->cbuf = (unsigned char*)safe_malloc(BGZF_MAX_BLOCK_SIZE);
+    reader->block = (char*)safe_malloc(BGZF_MAX_BLOCK_SIZE);
+    reader->line_capacity = BGZF_MAX_BLOCK_SIZE;
+    reader->line = (char*)safe_malloc(reader->line_capacity);
+    return reader;
+}
+
+// 加载offset处的块；文件结束时置eof，格式错误时置failed
+static bool bgzf_reader_load(BgzfReader* reader, uint64_t offset) {
+    reader->block_offset = offset;
+    reader->block_csize = 0;
+    reader->block_size = 0;
+    reader->block_pos = 0;
+    
+    ssize_t n = pread(reader->fd, reader->cbuf, 18, (off_t)offset);
+    if (n == 0) {
+        reader->eof = true;
+        return false;
+    }
+    if (n != 18 || !is_bgzf_header(reader->cbuf, 18)) {
+        reader->failed = true;
+        return false;
+    }
+    
+    size_t block_size = (size_t)(reader->cbuf[16] | (reader->cbuf[17] << 8)) + 1;
+    size_t data_offset = 12 + (size_t)(reader->cbuf[10] | (reader->cbuf[11] << 8));
+    if (block_size < 26 || data_offset + 8 > block_size ||
+        pread(reader->fd, reader->cbuf, block_size, (off_t)offset) != (ssize_t)block_size) {
+        reader->failed = true;
+        return false;
+    }
+    
+    const unsigned char* trailer = reader->cbuf + block_size - 8;
+    BgzfBlock block;
+    block.cdata = reader->cbuf + data_offset;
+    block.csize = block_size - data_offset - 8;
+    block.out = reader->block;
+    block.crc = (uint32_t)trailer[0] | ((uint32_t)trailer[1] << 8) |
+                ((uint32_t)trailer[2] << 16) | ((uint32_t)trailer[3] << 24);
+    block.isize = (size_t)trailer[4] | ((size_t)trailer[5] << 8) |
+                  ((size_t)trailer[6] << 16) | ((size_t)trailer[7] << 24);
+    if (block.isize > BGZF_MAX_BLOCK_SIZE) {
+        reader->failed = true;
+        return false;
+    }
+    
+    inflate_bgzf_block(&block, 0);
+    if (!block.ok) {
+        reader->failed = true;
+        return false;
+    }
+    
+    reader->block_csize = block_size;
+    reader->block_size = block.isize;
+    return true;
+}
+
+// 定位到虚拟偏移
+bool bgzf_reader_seek(BgzfReader* reader, uint64_t voffset) {
+    if (!reader || reader->failed) return false;
+    
+    reader->eof = false;
+    if (!bgzf_reader_load(reader, voffset >> 16)) return false;
+    if ((voffset & 0xffff) > reader->block_size) {
+        reader->failed = true;
+        return false;
+    }
+    reader->block_pos = (size_t)(voffset & 0xffff);
+    return true;
+}
+
+// 当前块读完时切换到下一个非空块
+static bool bgzf_reader_advance(BgzfReader* reader) {
+    while (reader->block_pos >= reader->block_size) {
+        if (reader->eof || reader->failed || reader->block_csize == 0) return false;
+        if (!bgzf_reader_load(reader, reader->block_offset + reader->block_csize)) return false;
+    }
+    return true;
+}
+
+// 读取下一行（不含换行符，截断在第一个'\r'处），voffset返回行首的虚拟偏移
+bool bgzf_reader_next_line(BgzfReader* reader, StrSlice* line, uint64_t* voffset) {
+    if (!reader || !bgzf_reader_advance(reader)) return false;
+    
+    if (voffset) *voffset = (reader->block_offset << 16) | reader->block_pos;
+    
+    size_t len = 0;
+    while (bgzf_reader_advance(reader)) {
+        const char* start = reader->block + reader->block_pos;
+        size_t available = reader->block_size - reader->block_pos;
+        const char* newline = (const char*)memchr(start, '\n', available);
+        size_t n = newline ? (size_t)(newline - start) : available;
+        
+        if (len + n > reader->line_capacity) {
+            while (len + n > reader->line_capacity) reader->line_capacity *= 2;
+            reader->line = (char*)safe_realloc(reader->line, reader->line_capacity);
+        }
+        memcpy(reader->line + len, start, n);
+        len += n;
+        reader->block_pos += n;
+        
+        if (newline) {
+            reader->block_pos++;
+            break;
+        }
+    }
+    if (reader->failed) return false;
+    
+    const char* cr = (const char*)memchr(reader->line, '\r', len);
+    line->ptr = reader->line;
+    line->len = cr ? (size_t)(cr - reader->line) : len;
+    return true;
+}
+
+// 返回虚拟偏移voffset（行首）之前的行数，即该行的行号减1。只解压、不切分行：
+// 从当前位置向前数换行符，voffset在当前位置之前时从文件开头重新数。出错时返回-1。
+// 用于按索引读取的记录得到与顺序读取一致的行号，读取器不能再同时用于按行读取
+long long bgzf_reader_lines_before(BgzfReader* reader, uint64_t voffset) {
+    if (!reader || reader->failed) return -1;
+    
+    uint64_t current = (reader->block_offset << 16) | reader->block_pos;
+    if (reader->block_csize == 0 || voffset < current) {
+        reader->newlines = 0;
+        if (!bgzf_reader_seek(reader, 0)) return -1;
+    }
+    
+    uint64_t target_block = voffset >> 16;
+    size_t target_pos = (size_t)(voffset & 0xffff);
+    for (;;) {
+        size_t end = reader->block_offset == target_block ? target_pos : reader->block_size;
+        if (end > reader->block_size) {
+            reader->failed = true;
+            return -1;
+        }
+        for (size_t i = reader->block_pos; i < end; i++) {
+            reader->newlines += reader->block[i] == '\n';
+        }
+        reader->block_pos = end;
+        
+        if (reader->block_offset == target_block) return reader->newlines;
+        if (reader->block_offset > target_block || 
+            !bgzf_reader_load(reader, reader->block_offset + reader->block_csize)) {
+            reader->failed = true;
+            return -1;
+        }
+    }
+}
+
+// 读取是否出错
+bool bgzf_reader_failed(BgzfReader* reader) {
+    return reader && reader->failed;
+}
+
+void bgzf_reader_close(BgzfReader* reader) {
+    if (!reader) return;
+    
+    close(reader->fd);
+    free(reader->cbuf);
+    free(reader->block);
+    free(reader->line);
+    free(reader);
+}
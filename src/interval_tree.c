@@ -0,0 +1,176 @@
+#include "te_comparator.h"
+
+// 隐式区间树（与cgranges相同的布局）：区间按起点排序存放在数组中，下标i所在的层数是i二进制
+// 末尾连续1的个数，第k层节点i的左右孩子为i -/+ 2^(k-1)。每个节点记录子树的最大终点，
+// 查询时跳过最大终点小于查询起点的子树。坐标为闭区间
+
+// 自底向上计算每个节点的子树最大终点，返回根所在的层
+static int index_tree_levels(IntervalTree* tree) {
+    int n = tree->count;
+    if (n == 0) return -1;
+    
+    int64_t last = 0;
+    int last_i = 0;
+    for (int i = 0; i < n; i += 2) {
+        last_i = i;
+        last = tree->max_ends[i] = tree->ends[i];
+    }
+    
+    int k;
+    for (k = 1; (1LL << k) <= n; k++) {
+        long long x = 1LL << (k - 1);
+        long long step = x << 2;
+        for (long long i = (x << 1) - 1; i < n; i += step) {
+            int64_t left = tree->max_ends[i - x];
+            int64_t right = i + x < n ? tree->max_ends[i + x] : last;
+            int64_t e = tree->ends[i];
+            if (left > e) e = left;
+            if (right > e) e = right;
+            tree->max_ends[i] = e;
+        }
+        // 最右侧不完整子树的最大终点
+        last_i = (last_i >> k & 1) ? (int)(last_i - x) : (int)(last_i + x);
+        if (last_i < n && tree->max_ends[last_i] > last) last = tree->max_ends[last_i];
+    }
+    return k - 1;
+}
+
+// 按染色体分组构建区间树；chrs/starts/ends为n条记录的染色体ID和闭区间坐标，ids为记录下标
+void build_interval_trees(IntervalTrees* trees, const int* chrs, const int64_t* starts, const int64_t* ends,
+                          int n) {
+    trees->trees = NULL;
+    trees->chrom_count = 0;
+    
+    int max_chr = STR_NONE;
+    for (int i = 0; i < n; i++) {
+        if (chrs[i] > max_chr) max_chr = chrs[i];
+    }
+    if (max_chr == STR_NONE) return;
+    
+    trees->chrom_count = max_chr + 1;
+    trees->trees = (IntervalTree*)safe_malloc(trees->chrom_count * sizeof(IntervalTree));
+    memset(trees->trees, 0, trees->chrom_count * sizeof(IntervalTree));
+    
+    // 先统计每条染色体的记录数，再一次性分配
+    for (int i = 0; i < n; i++) {
+        if (chrs[i] != STR_NONE) trees->trees[chrs[i]].count++;
+    }
+    for (int c = 0; c < trees->chrom_count; c++) {
+        IntervalTree* tree = &trees->trees[c];
+        tree->max_level = -1;
+        if (tree->count == 0) continue;
+        tree->starts = (int64_t*)safe_malloc(tree->count * sizeof(int64_t));
+        tree->ends = (int64_t*)safe_malloc(tree->count * sizeof(int64_t));
+        tree->max_ends = (int64_t*)safe_malloc(tree->count * sizeof(int64_t));
+        tree->ids = (int*)safe_malloc(tree->count * sizeof(int));
+        tree->count = 0;
+    }
+    
+    // 起点不大于终点的坐标，按(染色体, 起点, 终点)基数排序后依次放入各染色体的树，
+    // 相同的区间保持记录下标的顺序
+    int64_t* lows = (int64_t*)safe_malloc((n > 0 ? n : 1) * sizeof(int64_t));
+    int64_t* highs = (int64_t*)safe_malloc((n > 0 ? n : 1) * sizeof(int64_t));
+    for (int i = 0; i < n; i++) {
+        lows[i] = starts[i] <= ends[i] ? starts[i] : ends[i];
+        highs[i] = starts[i] <= ends[i] ? ends[i] : starts[i];
+    }
+    int* order = sort_order_by_position(chrs, lows, highs, n, 1);
+    for (int k = 0; k < n; k++) {
+        int i = order[k];
+        if (chrs[i] == STR_NONE) continue;
+        IntervalTree* tree = &trees->trees[chrs[i]];
+        tree->starts[tree->count] = lows[i];
+        tree->ends[tree->count] = highs[i];
+        tree->ids[tree->count] = i;
+        tree->count++;
+    }
+    free(order);
+    free(lows);
+    free(highs);
+    
+    for (int c = 0; c < trees->chrom_count; c++) {
+        if (trees->trees[c].count > 0) trees->trees[c].max_level = index_tree_levels(&trees->trees[c]);
+    }
+}
+
+// 按起止坐标为转座子列表构建区间树，记录下标即转座子在列表中的下标（直接读取列，不复制）
+void build_te_interval_trees(IntervalTrees* trees, const TEList* te_list) {
+    build_interval_trees(trees, te_list->chrs, te_list->starts, te_list->ends, te_list->count);
+}
+
+// 查询与[start, end]重叠的区间，把记录下标写入*results（按需扩容），返回个数
+int interval_tree_query(const IntervalTrees* trees, int chr, int64_t start, int64_t end,
+                        int** results, int* capacity) {
+    if (chr < 0 || chr >= trees->chrom_count || trees->trees[chr].count == 0) return 0;
+    
+    const IntervalTree* tree = &trees->trees[chr];
+    long long n = tree->count;
+    int found = 0;
+    
+    // 显式栈：k为层，x为节点下标，w表示左子树是否已处理
+    struct { int k; int w; long long x; } stack[64];
+    int top = 0;
+    stack[top].k = tree->max_level;
+    stack[top].x = (1LL << tree->max_level) - 1;
+    stack[top++].w = 0;
+    
+    while (top > 0) {
+        int k = stack[--top].k;
+        int w = stack[top].w;
+        long long x = stack[top].x;
+        
+        if (k <= 3) {
+            // 小子树直接线性扫描
+            long long i0 = x >> k << k;
+            long long i1 = i0 + (1LL << (k + 1)) - 1;
+            if (i1 > n) i1 = n;
+            for (long long i = i0; i < i1 && tree->starts[i] <= end; i++) {
+                if (tree->ends[i] >= start) {
+                    if (found == *capacity) {
+                        *capacity = *capacity == 0 ? 16 : *capacity * 2;
+                        *results = (int*)safe_realloc(*results, *capacity * sizeof(int));
+                    }
+                    (*results)[found++] = tree->ids[i];
+                }
+            }
+        } else if (w == 0) {
+            // 先处理左子树，子树最大终点小于查询起点时跳过
+            long long y = x - (1LL << (k - 1));
+            stack[top].k = k;
+            stack[top].x = x;
+            stack[top++].w = 1;
+            if (y >= n || tree->max_ends[y] >= start) {
+                stack[top].k = k - 1;
+                stack[top].x = y;
+                stack[top++].w = 0;
+            }
+        } else if (x < n && tree->starts[x] <= end) {
+            if (tree->ends[x] >= start) {
+                if (found == *capacity) {
+                    *capacity = *capacity == 0 ? 16 : *capacity * 2;
+                    *results = (int*)safe_realloc(*results, *capacity * sizeof(int));
+                }
+                (*results)[found++] = tree->ids[x];
+            }
+            stack[top].k = k - 1;
+            stack[top].x = x + (1LL << (k - 1));
+            stack[top++].w = 0;
+        }
+    }
+    
+    return found;
+}
+
+void free_interval_trees(IntervalTrees* trees) {
+    if (!trees) return;
+    
+    for (int c = 0; c < trees->chrom_count; c++) {
+        free(trees->trees[c].starts);
+        free(trees->trees[c].ends);
+        free(trees->trees[c].max_ends);
+        free(trees->trees[c].ids);
+    }
+    free(trees->trees);
+    trees->trees = NULL;
+    trees->chrom_count = 0;
+}
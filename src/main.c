@@ -1,23 +1,69 @@
 #include "te_comparator.h"
+#include <unistd.h>
 
 // 程序使用说明
 void print_usage(const char* program_name) {
     printf("TE Comparator - Compare transposon differences between two genomes\n\n");
-    printf("Usage: %s <synteny_file> <te_file1> <te_file2> [genome1_file] [genome2_file] [options]\n\n", program_name);
+    printf("Usage: %s <synteny_file> <te_file1> <te_file2> [genome1_file] [genome2_file] [options]\n", program_name);
+    printf("       %s index <te_file>... [-t N] [--verify]\n", program_name);
+    printf("       %s multi <manifest> [-o PREFIX] [-t N] [--out-format FORMAT] [--min-overlap F]\n", program_name);
+    printf("             [--reciprocal] [--tolerance BP]\n");
+    printf("       %s serve <synteny_file> <te_file1> <te_file2> [--socket PATH] [-t N]\n", program_name);
+    printf("             [--min-overlap F] [--reciprocal] [--reload-interval S]\n");
+    printf("       %s query [--socket PATH] [QUERY...]\n\n", program_name);
     printf("Required arguments:\n");
     printf("  synteny_file    File containing synteny blocks between two genomes\n");
     printf("  te_file1        Transposon annotation file for genome 1 (GFF3 or BED format)\n");
     printf("  te_file2        Transposon annotation file for genome 2 (GFF3 or BED format)\n\n");
     printf("Optional arguments:\n");
-    printf("  genome1_file    Genome sequence file for genome 1 (for future use)\n");
-    printf("  genome2_file    Genome sequence file for genome 2 (for future use)\n\n");
+    printf("  genome1_file    Genome FASTA for genome 1; the sequences of its unique TEs\n");
+    printf("                  are written to <prefix>_genome1_unique.fa\n");
+    printf("  genome2_file    Genome FASTA for genome 2 (as genome1_file)\n\n");
     printf("Options:\n");
-    printf("  -o, --output PREFIX    Output file prefix (default: te_comparison)\n");
+    printf("  -o, --output PREFIX    Output file prefix (default: te_comparison, '-' writes\n");
+    printf("                         the unique TEs to standard output)\n");
+    printf("  --out-format FORMAT    Unique TE output format: tsv (default), bed or gff3\n");
+    printf("  -t, --threads N        Worker threads for parsing and comparison\n");
+    printf("                         (default: 1, 0 = all CPUs)\n");
     printf("  -v, --verbose          Enable verbose output\n");
+    printf("  --min-overlap F        Count a TE as syntenic only if at least fraction F of it\n");
+    printf("                         is covered by synteny blocks (0 < F <= 1); adds a\n");
+    printf("                         coverage column to the output\n");
+    printf("  --reciprocal           With --min-overlap, also require the TE to cover\n");
+    printf("                         fraction F of the merged blocks it touches\n");
+    printf("  --orthology            Classify TEs as shared, presence/absence or outside\n");
+    printf("                         synteny by mapping them through the synteny blocks\n");
+    printf("  --tolerance BP         Breakpoint tolerance for --orthology (default: 100)\n");
+    printf("  --group-by FIELDS      Print full-annotation counts grouped by a comma list\n");
+    printf("                         of type, family, chr, strand (e.g. type,family)\n");
+    printf("  --region REGIONS       Only compare genome 1 TEs overlapping chr:start-end\n");
+    printf("                         (comma list; uses a .tbi/.csi index when present)\n");
+    printf("  --region2 REGIONS      Genome 2 regions with --region: 'synteny' (default,\n");
+    printf("                         mapped through the synteny blocks), 'all' or a list\n");
+    printf("  --cache                Load TE files from <te_file>.tevx caches when they are\n");
+    printf("                         up to date, and (re)build missing or stale caches\n");
+    printf("  --sort                 Sort both annotations by chromosome, start and end after\n");
+    printf("                         parsing; output files list TEs in that order\n");
+    printf("  --input-order          With --sort, restore the input order of the records\n");
+    printf("                         before writing the output files\n");
+    printf("  --cluster              Cluster the unique TEs of both genomes by minimizer\n");
+    printf("                         sketches of their sequences (needs both genome files)\n");
+    printf("  --min-jaccard F        Minimum Jaccard similarity of a --cluster match (default: 0)\n");
+    printf("  --min-containment F    Minimum containment of the smaller TE (default: 0.5)\n");
+    printf("  --sorted               Stream inputs sorted by chromosome and start without\n");
+    printf("                         loading the TE annotations into memory\n");
+    printf("  --profile              Print wall/CPU time, throughput and peak RSS per phase\n");
+    printf("  --profile-json FILE    Also write the profile as JSON (implies --profile)\n");
     printf("  -h, --help             Show this help message\n\n");
     printf("Examples:\n");
     printf("  %s synteny.txt genome1.te.gff3 genome2.te.bed\n", program_name);
     printf("  %s synteny.txt genome1.te.gff3 genome2.te.bed -o my_comparison\n", program_name);
+    printf("  %s synteny.txt genome1.te.gff3.gz genome2.te.bed.gz --region chr1:1-500000\n", program_name);
+    printf("  %s index genome1.te.gff3 && %s synteny.txt genome1.te.gff3 genome2.te.bed --cache\n",
+           program_name, program_name);
+    printf("  %s multi accessions.manifest -o pangenome -t 0\n", program_name);
+    printf("  %s serve synteny.txt genome1.te.gff3 genome2.te.bed &\n", program_name);
+    printf("  %s query 'REGION 1 chr1 10000 20000'\n", program_name);
     printf("\n");
 }
 
@@ -29,6 +75,27 @@ typedef struct {
     char* genome1_file;
     char* genome2_file;
     char* output_prefix;
+    OutputFormat output_format;
+    int group_fields;
+    int num_threads;
+    double min_overlap;
+    bool reciprocal;
+    bool orthology;
+    int tolerance;          // --orthology的断点容差，-1表示未指定
+    char* region_spec;
+    char* region2_spec;
+    RegionList regions1;    // --region，为空时解析完整注释
+    RegionList regions2;    // --region2给出的区间列表
+    bool region2_all;       // --region2 all：基因组2不做区间限制
+    bool use_cache;
+    bool sort;              // --sort：解析后按位置排序
+    bool input_order;       // --input-order：排序后比较，但按输入顺序输出
+    bool sorted;
+    bool cluster;           // --cluster：按序列相似度聚类两个基因组的独有转座子
+    double min_jaccard;     // --cluster的阈值，-1表示未指定
+    double min_containment;
+    bool profile;
+    char* profile_json;
     bool verbose;
     bool show_help;
 } ProgramArgs;
@@ -40,12 +107,35 @@ void init_args(ProgramArgs* args) {
     args->genome1_file = NULL;
     args->genome2_file = NULL;
     args->output_prefix = strdup_safe("te_comparison");
+    args->output_format = OUTPUT_TSV;
+    args->group_fields = 0;
+    args->num_threads = 1;
+    args->min_overlap = 0.0;
+    args->reciprocal = false;
+    args->orthology = false;
+    args->tolerance = -1;
+    args->region_spec = NULL;
+    args->region2_spec = NULL;
+    init_region_list(&args->regions1);
+    init_region_list(&args->regions2);
+    args->region2_all = false;
+    args->use_cache = false;
+    args->sort = false;
+    args->input_order = false;
+    args->sorted = false;
+    args->cluster = false;
+    args->min_jaccard = -1.0;
+    args->min_containment = -1.0;
+    args->profile = false;
+    args->profile_json = NULL;
     args->verbose = false;
     args->show_help = false;
 }
 
 void free_args(ProgramArgs* args) {
     free(args->output_prefix);
+    free_region_list(&args->regions1);
+    free_region_list(&args->regions2);
 }
 int parse_arguments(int argc, char* argv[], ProgramArgs* args) {
     // 首先检查帮助选项
@@ -87,24 +177,147 @@ int parse_arguments(int argc, char* argv[], ProgramArgs* args) {
         } else if ((strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "--output") == 0) && i + 1 < argc) {
             free(args->output_prefix);
             args->output_prefix = strdup_safe(argv[++i]);
+        } else if (strcmp(argv[i], "--out-format") == 0 && i + 1 < argc) {
+            int format = parse_output_format(argv[++i]);
+            if (format < 0) {
+                fprintf(stderr, "Error: Invalid output format: %s\n", argv[i]);
+                return -1;
+            }
+            args->output_format = (OutputFormat)format;
+        } else if ((strcmp(argv[i], "-t") == 0 || strcmp(argv[i], "--threads") == 0) && i + 1 < argc) {
+            char* end = NULL;
+            long threads = strtol(argv[++i], &end, 10);
+            if (!end || *end != '\0' || threads < 0 || threads > 1024) {
+                fprintf(stderr, "Error: Invalid thread count: %s\n", argv[i]);
+                return -1;
+            }
+            args->num_threads = (int)threads;
+        } else if (strcmp(argv[i], "--min-overlap") == 0 && i + 1 < argc) {
+            char* end = NULL;
+            double fraction = strtod(argv[++i], &end);
+            if (!end || end == argv[i] || *end != '\0' || !(fraction > 0.0 && fraction <= 1.0)) {
+                fprintf(stderr, "Error: Invalid overlap fraction: %s\n", argv[i]);
+                return -1;
+            }
+            args->min_overlap = fraction;
+        } else if (strcmp(argv[i], "--reciprocal") == 0) {
+            args->reciprocal = true;
+        } else if (strcmp(argv[i], "--orthology") == 0) {
+            args->orthology = true;
+        } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            char* end = NULL;
+            long tolerance = strtol(argv[++i], &end, 10);
+            if (!end || end == argv[i] || *end != '\0' || tolerance < 0 || tolerance > 100000000) {
+                fprintf(stderr, "Error: Invalid tolerance: %s\n", argv[i]);
+                return -1;
+            }
+            args->tolerance = (int)tolerance;
+        } else if (strcmp(argv[i], "--group-by") == 0 && i + 1 < argc) {
+            args->group_fields = parse_group_fields(argv[++i]);
+            if (args->group_fields < 0) {
+                fprintf(stderr, "Error: Invalid --group-by fields: %s\n", argv[i]);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--sort") == 0) {
+            args->sort = true;
+        } else if (strcmp(argv[i], "--input-order") == 0) {
+            args->input_order = true;
+        } else if (strcmp(argv[i], "--sorted") == 0) {
+            args->sorted = true;
+        } else if (strcmp(argv[i], "--cluster") == 0) {
+            args->cluster = true;
+        } else if ((strcmp(argv[i], "--min-jaccard") == 0 || strcmp(argv[i], "--min-containment") == 0) &&
+                   i + 1 < argc) {
+            bool jaccard = strcmp(argv[i], "--min-jaccard") == 0;
+            char* end = NULL;
+            double fraction = strtod(argv[++i], &end);
+            if (!end || end == argv[i] || *end != '\0' || !(fraction >= 0.0 && fraction <= 1.0)) {
+                fprintf(stderr, "Error: Invalid similarity threshold: %s\n", argv[i]);
+                return -1;
+            }
+            if (jaccard) {
+                args->min_jaccard = fraction;
+            } else {
+                args->min_containment = fraction;
+            }
+        } else if (strcmp(argv[i], "--cache") == 0) {
+            args->use_cache = true;
+        } else if (strcmp(argv[i], "--profile") == 0) {
+            args->profile = true;
+        } else if (strcmp(argv[i], "--profile-json") == 0 && i + 1 < argc) {
+            args->profile = true;
+            args->profile_json = argv[++i];
+        } else if (strcmp(argv[i], "--region") == 0 && i + 1 < argc) {
+            args->region_spec = argv[++i];
+            free_region_list(&args->regions1);
+            if (parse_region_list(args->region_spec, &args->regions1) < 0) {
+                fprintf(stderr, "Error: Invalid region: %s\n", argv[i]);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--region2") == 0 && i + 1 < argc) {
+            args->region2_spec = argv[++i];
+            free_region_list(&args->regions2);
+            args->region2_all = strcmp(args->region2_spec, "all") == 0;
+            if (!args->region2_all && strcmp(args->region2_spec, "synteny") != 0 &&
+                parse_region_list(args->region2_spec, &args->regions2) < 0) {
+                fprintf(stderr, "Error: Invalid region: %s\n", argv[i]);
+                return -1;
+            }
         } else {
             fprintf(stderr, "Error: Unknown option %s\n", argv[i]);
             return -1;
         }
     }
     
+    if (args->reciprocal && args->min_overlap <= 0.0) {
+        fprintf(stderr, "Error: --reciprocal requires --min-overlap\n");
+        return -1;
+    }
+    
+    if (args->tolerance >= 0 && !args->orthology) {
+        fprintf(stderr, "Error: --tolerance requires --orthology\n");
+        return -1;
+    }
+    if (args->tolerance < 0) args->tolerance = 100;
+    
+    if ((args->min_jaccard >= 0.0 || args->min_containment >= 0.0) && !args->cluster) {
+        fprintf(stderr, "Error: --min-jaccard and --min-containment require --cluster\n");
+        return -1;
+    }
+    if (args->cluster && (!args->genome1_file || !args->genome2_file)) {
+        fprintf(stderr, "Error: --cluster requires genome files for both genomes\n");
+        return -1;
+    }
+    if (args->min_jaccard < 0.0) args->min_jaccard = 0.0;
+    if (args->min_containment < 0.0) args->min_containment = 0.5;
+    
+    // 区域模式只解析区域内的记录，缓存保存的是完整注释
+    if (args->use_cache && (args->region_spec || args->region2_spec)) {
+        fprintf(stderr, "Error: --cache cannot be combined with --region or --region2\n");
+        return -1;
+    }
+    
+    if (args->input_order && !args->sort) {
+        fprintf(stderr, "Error: --input-order requires --sort\n");
+        return -1;
+    }
+    
+    // 流式模式不保存转座子列表，不能与需要完整列表的选项同时使用
+    if (args->sorted && (args->region_spec || args->region2_spec || args->use_cache || args->group_fields > 0 ||
+                         args->orthology || args->sort || args->genome1_file || args->genome2_file)) {
+        fprintf(stderr, "Error: --sorted cannot be combined with --region, --region2, --cache, --group-by, "
+                        "--orthology, --sort or genome files\n");
+        return -1;
+    }
+    
     return 0;
 }
 
-// 检查文件是否存在
+// 检查文件是否存在且可读；"-"表示标准输入。不打开文件，避免命名管道在检查时被阻塞或读走数据
 bool file_exists(const char* filename) {
     if (!filename) return false;
-    FILE* file = fopen(filename, "r");
-    if (file) {
-        fclose(file);
-        return true;
-    }
-    return false;
+    if (strcmp(filename, "-") == 0) return true;
+    return access(filename, R_OK) == 0;
 }
 
 // 验证输入参数
@@ -130,19 +343,314 @@ int validate_arguments(ProgramArgs* args) {
         return -1;
     }
     
-    // 检查可选文件
+    // 检查基因组序列文件
     if (args->genome1_file && !file_exists(args->genome1_file)) {
-        fprintf(stderr, "Warning: Genome 1 file not found: %s\n", args->genome1_file);
+        fprintf(stderr, "Error: Genome 1 file not found: %s\n", args->genome1_file);
+        return -1;
     }
     
     if (args->genome2_file && !file_exists(args->genome2_file)) {
-        fprintf(stderr, "Warning: Genome 2 file not found: %s\n", args->genome2_file);
+        fprintf(stderr, "Error: Genome 2 file not found: %s\n", args->genome2_file);
+        return -1;
     }
     
     return 0;
 }
 
+// tevox index：解析注释文件并写出<te_file>.tevx缓存；--verify只完整检查已有的缓存
+int run_index_command(int argc, char* argv[], const char* program_name) {
+    int num_threads = 1;
+    int file_count = 0;
+    bool verify = false;
+    
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_usage(program_name);
+            return 0;
+        } else if (strcmp(argv[i], "--verify") == 0) {
+            verify = true;
+        } else if ((strcmp(argv[i], "-t") == 0 || strcmp(argv[i], "--threads") == 0) && i + 1 < argc) {
+            char* end = NULL;
+            long threads = strtol(argv[++i], &end, 10);
+            if (!end || *end != '\0' || threads < 0 || threads > 1024) {
+                fprintf(stderr, "Error: Invalid thread count: %s\n", argv[i]);
+                return 1;
+            }
+            num_threads = (int)threads;
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            fprintf(stderr, "Error: Unknown option %s\n", argv[i]);
+            return 1;
+        } else {
+            file_count++;
+        }
+    }
+    
+    if (file_count == 0) {
+        fprintf(stderr, "Error: Missing TE files to index\n");
+        return 1;
+    }
+    
+    // 缓存同时保存GFF3原始属性，供--out-format gff3使用
+    set_keep_gff3_attributes(true);
+    
+    int status = 0;
+    for (int i = 0; i < argc && status == 0; i++) {
+        if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            if (strcmp(argv[i], "-t") == 0 || strcmp(argv[i], "--threads") == 0) i++;
+            continue;
+        }
+        
+        FileType type = detect_file_type(argv[i], num_threads);
+        if (type != FILE_GFF3 && type != FILE_BED) {
+            fprintf(stderr, "Error: Unsupported file format for TE file: %s\n", argv[i]);
+            status = 1;
+            break;
+        }
+        
+        if (verify) {
+            char* cache_file = te_cache_path(argv[i]);
+            int count = verify_te_cache(cache_file, argv[i], type);
+            if (count < 0) {
+                status = 1;
+            } else {
+                printf("Cache %s is valid (%d transposons)\n", cache_file, count);
+            }
+            free(cache_file);
+            continue;
+        }
+        
+        TEList te_list;
+        if (parse_te_file_mt(argv[i], type, &te_list, num_threads) < 0) {
+            status = 1;
+            break;
+        }
+        
+        char* cache_file = te_cache_path(argv[i]);
+        if (write_te_cache(cache_file, argv[i], type, &te_list) < 0) {
+            status = 1;
+        } else {
+            printf("Wrote cache %s (%d transposons)\n", cache_file, te_list.count);
+        }
+        free(cache_file);
+        free_te_list(&te_list);
+    }
+    
+    free_default_string_table();
+    return status;
+}
+
+// tevox multi：manifest中的每个注释只解析一次，所有基因组对在线程池中比较
+int run_multi_command(int argc, char* argv[], const char* program_name) {
+    const char* manifest_file = NULL;
+    const char* output_prefix = "te_comparison";
+    OutputFormat format = OUTPUT_TSV;
+    int tolerance = 100;
+    CompareOptions options;
+    init_compare_options(&options);
+    
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_usage(program_name);
+            return 0;
+        } else if ((strcmp(argv[i], "-o") == 0 || strcmp(argv[i], "--output") == 0) && i + 1 < argc) {
+            output_prefix = argv[++i];
+        } else if (strcmp(argv[i], "--out-format") == 0 && i + 1 < argc) {
+            int parsed = parse_output_format(argv[++i]);
+            if (parsed < 0) {
+                fprintf(stderr, "Error: Invalid output format: %s\n", argv[i]);
+                return 1;
+            }
+            format = (OutputFormat)parsed;
+        } else if ((strcmp(argv[i], "-t") == 0 || strcmp(argv[i], "--threads") == 0) && i + 1 < argc) {
+            char* end = NULL;
+            long threads = strtol(argv[++i], &end, 10);
+            if (!end || *end != '\0' || threads < 0 || threads > 1024) {
+                fprintf(stderr, "Error: Invalid thread count: %s\n", argv[i]);
+                return 1;
+            }
+            options.num_threads = (int)threads;
+        } else if (strcmp(argv[i], "--min-overlap") == 0 && i + 1 < argc) {
+            char* end = NULL;
+            double fraction = strtod(argv[++i], &end);
+            if (!end || end == argv[i] || *end != '\0' || !(fraction > 0.0 && fraction <= 1.0)) {
+                fprintf(stderr, "Error: Invalid overlap fraction: %s\n", argv[i]);
+                return 1;
+            }
+            options.min_overlap = fraction;
+        } else if (strcmp(argv[i], "--reciprocal") == 0) {
+            options.reciprocal = true;
+        } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            char* end = NULL;
+            long value = strtol(argv[++i], &end, 10);
+            if (!end || end == argv[i] || *end != '\0' || value < 0 || value > 100000000) {
+                fprintf(stderr, "Error: Invalid tolerance: %s\n", argv[i]);
+                return 1;
+            }
+            tolerance = (int)value;
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            fprintf(stderr, "Error: Unknown option %s\n", argv[i]);
+            return 1;
+        } else if (!manifest_file) {
+            manifest_file = argv[i];
+        } else {
+            fprintf(stderr, "Error: Unexpected argument %s\n", argv[i]);
+            return 1;
+        }
+    }
+    
+    if (!manifest_file) {
+        fprintf(stderr, "Error: Missing manifest file\n");
+        return 1;
+    }
+    if (options.reciprocal && options.min_overlap <= 0.0) {
+        fprintf(stderr, "Error: --reciprocal requires --min-overlap\n");
+        return 1;
+    }
+    // 每对基因组各写两个文件，不能都写到标准输出
+    if (strcmp(output_prefix, "-") == 0) {
+        fprintf(stderr, "Error: multi needs an output prefix, '-' is not supported\n");
+        return 1;
+    }
+    
+    set_keep_gff3_attributes(format == OUTPUT_GFF3);
+    
+    Manifest manifest;
+    if (parse_manifest(manifest_file, &manifest) != 0) {
+        free_default_string_table();
+        return 1;
+    }
+    
+    printf("=== TE Comparator (multi-genome) ===\n");
+    printf("Manifest: %s (%d genomes, %d pairs)\n", manifest_file, manifest.genome_count, manifest.pair_count);
+    printf("Output prefix: %s\n", output_prefix);
+    printf("Threads: %d\n", resolve_thread_count(options.num_threads));
+    printf("\n");
+    
+    int status = load_manifest(&manifest, options.num_threads);
+    if (status == 0) {
+        status = compare_multi_genomes(&manifest, output_prefix, format, tolerance, &options);
+    }
+    
+    free_manifest(&manifest);
+    free_default_string_table();
+    return status == 0 ? 0 : 1;
+}
+
+// tevox serve：加载一次输入，通过Unix域套接字回答查询
+int run_serve_command(int argc, char* argv[], const char* program_name) {
+    const char* files[3] = { NULL, NULL, NULL };
+    int file_count = 0;
+    ServeConfig config;
+    memset(&config, 0, sizeof(config));
+    config.socket_path = "tevox.sock";
+    config.num_threads = 1;
+    config.reload_interval = 2;
+    init_compare_options(&config.options);
+    
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_usage(program_name);
+            return 0;
+        } else if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            config.socket_path = argv[++i];
+        } else if ((strcmp(argv[i], "-t") == 0 || strcmp(argv[i], "--threads") == 0) && i + 1 < argc) {
+            char* end = NULL;
+            long threads = strtol(argv[++i], &end, 10);
+            if (!end || *end != '\0' || threads < 0 || threads > 1024) {
+                fprintf(stderr, "Error: Invalid thread count: %s\n", argv[i]);
+                return 1;
+            }
+            config.num_threads = (int)threads;
+            config.options.num_threads = (int)threads;
+        } else if (strcmp(argv[i], "--min-overlap") == 0 && i + 1 < argc) {
+            char* end = NULL;
+            double fraction = strtod(argv[++i], &end);
+            if (!end || end == argv[i] || *end != '\0' || !(fraction > 0.0 && fraction <= 1.0)) {
+                fprintf(stderr, "Error: Invalid overlap fraction: %s\n", argv[i]);
+                return 1;
+            }
+            config.options.min_overlap = fraction;
+        } else if (strcmp(argv[i], "--reciprocal") == 0) {
+            config.options.reciprocal = true;
+        } else if (strcmp(argv[i], "--reload-interval") == 0 && i + 1 < argc) {
+            char* end = NULL;
+            long seconds = strtol(argv[++i], &end, 10);
+            if (!end || end == argv[i] || *end != '\0' || seconds < 0 || seconds > 86400) {
+                fprintf(stderr, "Error: Invalid reload interval: %s\n", argv[i]);
+                return 1;
+            }
+            config.reload_interval = (int)seconds;
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            fprintf(stderr, "Error: Unknown option %s\n", argv[i]);
+            return 1;
+        } else if (file_count < 3) {
+            files[file_count++] = argv[i];
+        } else {
+            fprintf(stderr, "Error: Unexpected argument %s\n", argv[i]);
+            return 1;
+        }
+    }
+    
+    if (file_count < 3) {
+        fprintf(stderr, "Error: serve needs a synteny file and two TE files\n");
+        return 1;
+    }
+    if (config.options.reciprocal && config.options.min_overlap <= 0.0) {
+        fprintf(stderr, "Error: --reciprocal requires --min-overlap\n");
+        return 1;
+    }
+    for (int i = 0; i < 3; i++) {
+        if (!file_exists(files[i])) {
+            fprintf(stderr, "Error: File not found: %s\n", files[i]);
+            return 1;
+        }
+    }
+    config.synteny_file = files[0];
+    config.te_file1 = files[1];
+    config.te_file2 = files[2];
+    
+    int status = run_query_server(&config);
+    free_default_string_table();
+    return status == 0 ? 0 : 1;
+}
+
+// tevox query：把查询发送给正在运行的tevox serve并打印响应
+int run_query_command(int argc, char* argv[], const char* program_name) {
+    const char* socket_path = "tevox.sock";
+    char** queries = (char**)safe_malloc((argc > 0 ? argc : 1) * sizeof(char*));
+    int query_count = 0;
+    
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            print_usage(program_name);
+            free(queries);
+            return 0;
+        } else if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else {
+            queries[query_count++] = argv[i];
+        }
+    }
+    
+    int status = run_query_client(socket_path, queries, query_count);
+    free(queries);
+    return status == 0 ? 0 : 1;
+}
+
 int main(int argc, char* argv[]) {
+    if (argc > 1 && strcmp(argv[1], "index") == 0) {
+        return run_index_command(argc - 2, argv + 2, argv[0]);
+    }
+    if (argc > 1 && strcmp(argv[1], "multi") == 0) {
+        return run_multi_command(argc - 2, argv + 2, argv[0]);
+    }
+    if (argc > 1 && strcmp(argv[1], "serve") == 0) {
+        return run_serve_command(argc - 2, argv + 2, argv[0]);
+    }
+    if (argc > 1 && strcmp(argv[1], "query") == 0) {
+        return run_query_command(argc - 2, argv + 2, argv[0]);
+    }
+    
     ProgramArgs args;
     init_args(&args);
     
@@ -159,6 +667,15 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
+    // 结果写到标准输出时，运行信息改写到标准错误
+    if (strcmp(args.output_prefix, "-") == 0) {
+        redirect_stdout_for_output();
+    }
+    set_keep_gff3_attributes(args.output_format == OUTPUT_GFF3 || args.use_cache);
+    if (args.profile) {
+        profile_enable();
+    }
+    
     printf("=== TE Comparator ===\n");
     printf("Synteny file: %s\n", args.synteny_file);
     printf("TE file 1: %s\n", args.te_file1);
@@ -166,30 +683,87 @@ int main(int argc, char* argv[]) {
     if (args.genome1_file) printf("Genome 1 file: %s\n", args.genome1_file);
     if (args.genome2_file) printf("Genome 2 file: %s\n", args.genome2_file);
     printf("Output prefix: %s\n", args.output_prefix);
+    if (args.output_format != OUTPUT_TSV) printf("Output format: %s\n", output_format_extension(args.output_format));
+    printf("Threads: %d\n", resolve_thread_count(args.num_threads));
+    if (args.region_spec) printf("Region: %s\n", args.region_spec);
+    if (args.region2_spec) printf("Region 2: %s\n", args.region2_spec);
+    if (args.min_overlap > 0.0) {
+        printf("Minimum overlap: %g%s\n", args.min_overlap, args.reciprocal ? " (reciprocal)" : "");
+    }
+    if (args.orthology) printf("Orthology tolerance: %d bp\n", args.tolerance);
+    if (args.cluster) {
+        printf("Cluster thresholds: Jaccard >= %g, containment >= %g\n", args.min_jaccard, args.min_containment);
+    }
     printf("Verbose mode: %s\n", args.verbose ? "ON" : "OFF");
     printf("\n");
     
     // 解析共线性文件
     SyntenyList synteny_list;
+    int phase = profile_begin("synteny");
     if (parse_synteny(args.synteny_file, &synteny_list) < 0) {
         fprintf(stderr, "Error: Failed to parse synteny file\n");
         free_args(&args);
         return 1;
     }
+    profile_end(phase, synteny_list.count, profile_file_size(args.synteny_file));
     
     if (args.verbose) {
         print_synteny_list(&synteny_list, "Synteny Blocks");
     }
     
+    CompareOptions compare_options;
+    init_compare_options(&compare_options);
+    compare_options.num_threads = args.num_threads;
+    compare_options.min_overlap = args.min_overlap;
+    compare_options.reciprocal = args.reciprocal;
+    
+    // 有序输入：流式比较，不构建转座子列表
+    if (args.sorted) {
+        phase = profile_begin("sorted sweep");
+        FileType sorted_type1 = detect_file_type(args.te_file1, args.num_threads);
+        FileType sorted_type2 = detect_file_type(args.te_file2, args.num_threads);
+        int total_unique = -1;
+        if ((sorted_type1 == FILE_GFF3 || sorted_type1 == FILE_BED) &&
+            (sorted_type2 == FILE_GFF3 || sorted_type2 == FILE_BED)) {
+            total_unique = compare_sorted_streaming(args.te_file1, sorted_type1, args.te_file2, sorted_type2,
+                                                    &synteny_list, args.output_prefix, args.output_format,
+                                                    &compare_options);
+        } else {
+            fprintf(stderr, "Error: Unsupported file format for TE file %d: %s\n",
+                    sorted_type1 == FILE_GFF3 || sorted_type1 == FILE_BED ? 2 : 1,
+                    sorted_type1 == FILE_GFF3 || sorted_type1 == FILE_BED ? args.te_file2 : args.te_file1);
+        }
+        
+        profile_end(phase, -1, profile_file_size(args.te_file1) + profile_file_size(args.te_file2));
+        
+        if (total_unique >= 0) {
+            printf("\n=== Analysis Complete ===\n");
+            printf("Total unique transposons identified: %d\n", total_unique);
+            printf("Results written to files with prefix: %s\n", args.output_prefix);
+            profile_print_summary();
+            if (args.profile_json && profile_write_json(args.profile_json) != 0) total_unique = -1;
+        }
+        
+        free_args(&args);
+        free_synteny_list(&synteny_list);
+        free_default_string_table();
+        return total_unique >= 0 ? 0 : 1;
+    }
+    
     // 解析TE文件1
     TEList te_list1;
-    FileType type1 = detect_file_type(args.te_file1);
+    phase = profile_begin("parse genome 1");
+    FileType type1 = detect_file_type(args.te_file1, args.num_threads);
     int result1 = 0;
     
-    if (type1 == FILE_GFF3) {
-        result1 = parse_gff3(args.te_file1, &te_list1);
-    } else if (type1 == FILE_BED) {
-        result1 = parse_bed(args.te_file1, &te_list1);
+    if (type1 == FILE_GFF3 || type1 == FILE_BED) {
+        if (args.region_spec) {
+            result1 = parse_te_file_regions(args.te_file1, type1, &args.regions1, &te_list1, args.num_threads);
+        } else if (args.use_cache) {
+            result1 = parse_te_file_cached(args.te_file1, type1, &te_list1, args.num_threads, true);
+        } else {
+            result1 = parse_te_file_mt(args.te_file1, type1, &te_list1, args.num_threads);
+        }
     } else {
         fprintf(stderr, "Error: Unsupported file format for TE file 1: %s\n", args.te_file1);
         free_args(&args);
@@ -204,19 +778,40 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
+    profile_end(phase, result1, profile_file_size(args.te_file1));
+    
     if (args.verbose) {
         print_te_list(&te_list1, "Genome 1 Transposons");
     }
     
+    // 基因组2的区间：显式列表，或由基因组1的区间经共线性区块映射得到
+    bool restrict2 = args.regions2.count > 0 || (args.region_spec && !args.region2_all);
+    if (restrict2 && args.regions2.count == 0) {
+        project_regions_through_synteny(&args.regions1, &synteny_list, 1, &args.regions2);
+        if (args.verbose) {
+            printf("Genome 2 regions mapped through synteny: %d\n", args.regions2.count);
+            for (int i = 0; i < args.regions2.count; i++) {
+                printf("  %s:%lld-%lld\n", args.regions2.regions[i].chr,
+                       (long long)args.regions2.regions[i].start, (long long)args.regions2.regions[i].end);
+            }
+        }
+    }
+    
     // 解析TE文件2
     TEList te_list2;
-    FileType type2 = detect_file_type(args.te_file2);
+    phase = profile_begin("parse genome 2");
+    FileType type2 = detect_file_type(args.te_file2, args.num_threads);
     int result2 = 0;
     
-    if (type2 == FILE_GFF3) {
-        result2 = parse_gff3(args.te_file2, &te_list2);
-    } else if (type2 == FILE_BED) {
-        result2 = parse_bed(args.te_file2, &te_list2);
+    if (type2 == FILE_GFF3 || type2 == FILE_BED) {
+        if (restrict2) {
+            result2 = parse_te_file_regions(args.te_file2, type2, &args.regions2, &te_list2,
+                                            args.num_threads);
+        } else if (args.use_cache) {
+            result2 = parse_te_file_cached(args.te_file2, type2, &te_list2, args.num_threads, true);
+        } else {
+            result2 = parse_te_file_mt(args.te_file2, type2, &te_list2, args.num_threads);
+        }
     } else {
         fprintf(stderr, "Error: Unsupported file format for TE file 2: %s\n", args.te_file2);
         free_args(&args);
@@ -233,33 +828,108 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
+    profile_end(phase, result2, profile_file_size(args.te_file2));
+    
     if (args.verbose) {
         print_te_list(&te_list2, "Genome 2 Transposons");
     }
     
+    // 对完整注释按字段分组统计
+    if (args.group_fields > 0) {
+        TESelection all_te1, all_te2;
+        te_selection_select_all(&all_te1, &te_list1);
+        te_selection_select_all(&all_te2, &te_list2);
+        print_te_group_counts(&all_te1, args.group_fields, "Genome 1 TE Breakdown");
+        print_te_group_counts(&all_te2, args.group_fields, "Genome 2 TE Breakdown");
+        free_te_selection(&all_te1);
+        free_te_selection(&all_te2);
+    }
+    
+    // 按(染色体, 起点, 终点)排序，之后的比较、输出和直系同源分类都按排序后的顺序进行
+    if (args.sort) {
+        phase = profile_begin("sort");
+        sort_synteny_list(&synteny_list, args.num_threads);
+        sort_te_list(&te_list1, args.num_threads);
+        sort_te_list(&te_list2, args.num_threads);
+        profile_end(phase, (long long)te_list1.count + te_list2.count + synteny_list.count, -1);
+    }
+    
     // 比较TE差异
-    TEList unique_te1, unique_te2;
-    int total_unique = compare_te_differences(&te_list1, &te_list2, &synteny_list, &unique_te1, &unique_te2);
+    TESelection unique_te1, unique_te2;
+    phase = profile_begin("compare");
+    int total_unique = compare_te_differences(&te_list1, &te_list2, &synteny_list, 
+                                              &unique_te1, &unique_te2, &compare_options);
+    profile_end(phase, (long long)te_list1.count + te_list2.count, -1);
+    
+    // 比较在排序后的列表上完成，输出前换回输入顺序（直系同源分类的取舍按输入位置，结果不变）
+    if (args.input_order) {
+        restore_synteny_list_order(&synteny_list);
+        restore_te_list_order(&te_list1, &unique_te1, args.num_threads);
+        restore_te_list_order(&te_list2, &unique_te2, args.num_threads);
+    }
     
     if (args.verbose) {
-        print_te_list(&unique_te1, "Genome 1 Unique Transposons");
-        print_te_list(&unique_te2, "Genome 2 Unique Transposons");
+        print_te_selection(&unique_te1, "Genome 1 Unique Transposons");
+        print_te_selection(&unique_te2, "Genome 2 Unique Transposons");
     }
     
     // 写入结果文件
-    write_results_to_file(&unique_te1, &unique_te2, args.output_prefix);
+    phase = profile_begin("write");
+    int write_status = write_results_to_file(&unique_te1, &unique_te2, args.output_prefix, args.output_format,
+                                             args.min_overlap > 0.0 ? &synteny_list : NULL);
     
-    printf("\n=== Analysis Complete ===\n");
-    printf("Total unique transposons identified: %d\n", total_unique);
-    printf("Results written to files with prefix: %s\n", args.output_prefix);
+    profile_end(phase, (long long)unique_te1.count + unique_te2.count, -1);
+    
+    // 从基因组FASTA中提取独有转座子的序列
+    if (write_status == 0 && (args.genome1_file || args.genome2_file)) {
+        phase = profile_begin("sequences");
+        write_status = write_unique_sequence_files(&unique_te1, &unique_te2, args.genome1_file, args.genome2_file,
+                                                   args.output_prefix, args.num_threads);
+        profile_end(phase, (long long)(args.genome1_file ? unique_te1.count : 0) +
+                           (args.genome2_file ? unique_te2.count : 0), -1);
+    }
+    
+    // 用最小化子草图找出两个基因组之间序列相似的独有转座子
+    if (write_status == 0 && args.cluster) {
+        phase = profile_begin("cluster");
+        write_status = cluster_unique_sequences(&unique_te1, &unique_te2, args.genome1_file, args.genome2_file,
+                                                args.min_jaccard, args.min_containment, args.output_prefix,
+                                                args.num_threads);
+        profile_end(phase, (long long)unique_te1.count + unique_te2.count, -1);
+    }
+    
+    // 经共线性区块映射后按位置和家族查找对应转座子
+    if (write_status == 0 && args.orthology) {
+        OrthologyResult orthology1, orthology2;
+        phase = profile_begin("orthology");
+        write_status = classify_orthology(&te_list1, &te_list2, &synteny_list, args.tolerance,
+                                          &compare_options, &orthology1, &orthology2);
+        if (write_status == 0) {
+            print_orthology_summary(&orthology1, &orthology2, args.tolerance);
+            write_status = write_orthology_results(&te_list1, &te_list2, &orthology1, &orthology2,
+                                                   args.output_prefix);
+            free_orthology_result(&orthology1);
+            free_orthology_result(&orthology2);
+        }
+        profile_end(phase, (long long)te_list1.count + te_list2.count, -1);
+    }
+    
+    if (write_status == 0) {
+        printf("\n=== Analysis Complete ===\n");
+        printf("Total unique transposons identified: %d\n", total_unique);
+        printf("Results written to files with prefix: %s\n", args.output_prefix);
+        profile_print_summary();
+        if (args.profile_json && profile_write_json(args.profile_json) != 0) write_status = -1;
+    }
     
     // 清理内存
     free_args(&args);
     free_synteny_list(&synteny_list);
     free_te_list(&te_list1);
     free_te_list(&te_list2);
-    free_te_list(&unique_te1);
-    free_te_list(&unique_te2);
+    free_te_selection(&unique_te1);
+    free_te_selection(&unique_te2);
+    free_default_string_table();
     
-    return 0;
+    return write_status == 0 ? 0 : 1;
 }
\ No newline at end of file
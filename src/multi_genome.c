@@ -0,0 +1,441 @@
+#include "te_comparator.h"
+#include <pthread.h>
+
+// 存在/缺失矩阵用64位掩码记录每个位点出现在哪些基因组中
+#define MULTI_MAX_GENOMES 64
+
+// 每对基因组的比较结果
+typedef struct {
+    int unique1;
+    int unique2;
+    int shared1;
+    int shared2;
+    int status;
+} PairSummary;
+
+// 多基因组比较的共享状态。转座子列表和共线性列表在所有任务间只读共享，
+// 并查集和共线性掩码在任务结束时加锁合并
+typedef struct {
+    Manifest* manifest;
+    const char* output_prefix;
+    OutputFormat format;
+    int tolerance;
+    CompareOptions options;     // 每对比较内部使用的选项
+    PairSummary* summaries;
+    pthread_mutex_t lock;
+    int* offsets;               // 各基因组转座子在全局编号中的起点
+    int* parent;                // 并查集：同一位点的转座子属于同一集合
+    uint64_t* syntenic;         // 转座子与哪些基因组之间处于共线性区域
+} MultiJob;
+
+void init_manifest(Manifest* manifest) {
+    manifest->genomes = NULL;
+    manifest->genome_count = 0;
+    manifest->genome_capacity = 0;
+    manifest->pairs = NULL;
+    manifest->pair_count = 0;
+    manifest->pair_capacity = 0;
+}
+
+void free_manifest(Manifest* manifest) {
+    if (!manifest) return;
+    
+    for (int i = 0; i < manifest->genome_count; i++) {
+        free(manifest->genomes[i].name);
+        free(manifest->genomes[i].te_file);
+        if (manifest->genomes[i].loaded) free_te_list(&manifest->genomes[i].te_list);
+    }
+    for (int i = 0; i < manifest->pair_count; i++) {
+        free(manifest->pairs[i].synteny_file);
+        if (manifest->pairs[i].loaded) free_synteny_list(&manifest->pairs[i].synteny);
+    }
+    free(manifest->genomes);
+    free(manifest->pairs);
+    init_manifest(manifest);
+}
+
+static int find_manifest_genome(const Manifest* manifest, const char* name, size_t len) {
+    for (int i = 0; i < manifest->genome_count; i++) {
+        if (strlen(manifest->genomes[i].name) == len && memcmp(manifest->genomes[i].name, name, len) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// 相对路径按manifest所在目录解析
+static char* manifest_path(const char* manifest_file, StrSlice path) {
+    const char* slash = strrchr(manifest_file, '/');
+    size_t dir_len = path.ptr[0] == '/' || !slash ? 0 : (size_t)(slash - manifest_file + 1);
+    char* result = (char*)safe_malloc(dir_len + path.len + 1);
+    memcpy(result, manifest_file, dir_len);
+    memcpy(result + dir_len, path.ptr, path.len);
+    result[dir_len + path.len] = '\0';
+    return result;
+}
+
+// 解析manifest：每行为"genome <名称> <注释文件>"或"synteny <名称1> <名称2> <共线性文件>"，
+// 共线性文件的chr1一侧对应名称1；'#'开头的行为注释
+int parse_manifest(const char* filename, Manifest* manifest) {
+    init_manifest(manifest);
+    
+    LineReader reader;
+    if (line_reader_open(&reader, filename, 1) != 0) {
+        fprintf(stderr, "Error: Cannot open manifest file %s\n", filename);
+        return -1;
+    }
+    
+    int status = 0;
+    StrSlice line;
+    while (status == 0 && line_reader_next(&reader, &line)) {
+        StrSlice fields[4];
+        int count = split_whitespace(line, fields, 4);
+        if (count == 0 || fields[0].ptr[0] == '#') continue;
+        
+        if (slice_equals(fields[0], "genome") && count == 3) {
+            if (find_manifest_genome(manifest, fields[1].ptr, fields[1].len) >= 0) {
+                fprintf(stderr, "Error: Duplicate genome name '%.*s' in %s line %d\n",
+                        (int)fields[1].len, fields[1].ptr, filename, reader.line_num);
+                status = -1;
+            } else if (manifest->genome_count >= MULTI_MAX_GENOMES) {
+                fprintf(stderr, "Error: Too many genomes in %s (maximum %d)\n", filename, MULTI_MAX_GENOMES);
+                status = -1;
+            } else {
+                if (manifest->genome_count == manifest->genome_capacity) {
+                    manifest->genome_capacity = manifest->genome_capacity ? manifest->genome_capacity * 2 : 8;
+                    manifest->genomes = (ManifestGenome*)safe_realloc(manifest->genomes,
+                                            manifest->genome_capacity * sizeof(ManifestGenome));
+                }
+                ManifestGenome* genome = &manifest->genomes[manifest->genome_count++];
+                genome->name = (char*)safe_malloc(fields[1].len + 1);
+                memcpy(genome->name, fields[1].ptr, fields[1].len);
+                genome->name[fields[1].len] = '\0';
+                genome->te_file = manifest_path(filename, fields[2]);
+                genome->loaded = false;
+            }
+        } else if (slice_equals(fields[0], "synteny") && count == 4) {
+            int g1 = find_manifest_genome(manifest, fields[1].ptr, fields[1].len);
+            int g2 = find_manifest_genome(manifest, fields[2].ptr, fields[2].len);
+            bool duplicate = false;
+            for (int i = 0; i < manifest->pair_count; i++) {
+                const ManifestPair* pair = &manifest->pairs[i];
+                if ((pair->genome1 == g1 && pair->genome2 == g2) || (pair->genome1 == g2 && pair->genome2 == g1)) {
+                    duplicate = true;
+                }
+            }
+            if (g1 < 0 || g2 < 0 || g1 == g2 || duplicate) {
+                fprintf(stderr, "Error: Invalid synteny pair in %s line %d (genomes must be declared "
+                        "before use, distinct, and paired only once)\n", filename, reader.line_num);
+                status = -1;
+            } else {
+                if (manifest->pair_count == manifest->pair_capacity) {
+                    manifest->pair_capacity = manifest->pair_capacity ? manifest->pair_capacity * 2 : 16;
+                    manifest->pairs = (ManifestPair*)safe_realloc(manifest->pairs,
+                                          manifest->pair_capacity * sizeof(ManifestPair));
+                }
+                ManifestPair* pair = &manifest->pairs[manifest->pair_count++];
+                pair->genome1 = g1;
+                pair->genome2 = g2;
+                pair->synteny_file = manifest_path(filename, fields[3]);
+                pair->loaded = false;
+            }
+        } else {
+            fprintf(stderr, "Error: Invalid manifest line %d in %s\n", reader.line_num, filename);
+            status = -1;
+        }
+    }
+    
+    if (status == 0 && line_reader_failed(&reader)) {
+        fprintf(stderr, "Error: Corrupt or truncated compressed manifest file %s\n", filename);
+        status = -1;
+    }
+    line_reader_close(&reader);
+    
+    if (status == 0 && (manifest->genome_count < 2 || manifest->pair_count == 0)) {
+        fprintf(stderr, "Error: Manifest %s needs at least two genomes and one synteny pair\n", filename);
+        status = -1;
+    }
+    if (status != 0) free_manifest(manifest);
+    return status;
+}
+
+// 每个注释文件和共线性文件只解析一次
+int load_manifest(Manifest* manifest, int num_threads) {
+    for (int i = 0; i < manifest->genome_count; i++) {
+        ManifestGenome* genome = &manifest->genomes[i];
+        FileType type = detect_file_type(genome->te_file, num_threads);
+        if (type != FILE_GFF3 && type != FILE_BED) {
+            fprintf(stderr, "Error: Unsupported file format for genome %s: %s\n", genome->name, genome->te_file);
+            return -1;
+        }
+        if (parse_te_file_mt(genome->te_file, type, &genome->te_list, num_threads) < 0) {
+            fprintf(stderr, "Error: Failed to parse TE file for genome %s\n", genome->name);
+            return -1;
+        }
+        genome->loaded = true;
+    }
+    
+    for (int i = 0; i < manifest->pair_count; i++) {
+        ManifestPair* pair = &manifest->pairs[i];
+        if (parse_synteny(pair->synteny_file, &pair->synteny) < 0) {
+            fprintf(stderr, "Error: Failed to parse synteny file %s\n", pair->synteny_file);
+            return -1;
+        }
+        pair->loaded = true;
+    }
+    return 0;
+}
+
+static int find_root(int* parent, int x) {
+    while (parent[x] != x) {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+    return x;
+}
+
+// 比较一对基因组：写出两侧的独有转座子，并把直系同源对应关系合并到位点中
+static void run_pair_task(void* ctx, int task) {
+    MultiJob* job = (MultiJob*)ctx;
+    ManifestPair* pair = &job->manifest->pairs[task];
+    ManifestGenome* genome1 = &job->manifest->genomes[pair->genome1];
+    ManifestGenome* genome2 = &job->manifest->genomes[pair->genome2];
+    PairSummary* summary = &job->summaries[task];
+    summary->status = -1;
+    
+    // 每对的结果文件：<prefix>_<名称1>_<名称2>_genomeN_unique.<扩展名>
+    char pair_prefix[512];
+    int prefix_len = snprintf(pair_prefix, sizeof(pair_prefix), "%s_%s_%s", job->output_prefix,
+                              genome1->name, genome2->name);
+    if (prefix_len < 0 || (size_t)prefix_len >= sizeof(pair_prefix)) {
+        fprintf(stderr, "Error: Output prefix too long: %s_%s_%s\n", job->output_prefix,
+                genome1->name, genome2->name);
+        return;
+    }
+    
+    TESelection unique1, unique2;
+    if (collect_unique_transposons(&genome1->te_list, &genome2->te_list, &pair->synteny,
+                                   &unique1, &unique2, &job->options) < 0) {
+        return;
+    }
+    summary->unique1 = unique1.count;
+    summary->unique2 = unique2.count;
+    
+    const SyntenyList* coverage_synteny = job->options.min_overlap > 0.0 ? &pair->synteny : NULL;
+    TESelection* selections[2] = { &unique1, &unique2 };
+    int write_status = 0;
+    for (int g = 0; g < 2 && write_status == 0; g++) {
+        char filename[600];
+        output_file_name(filename, sizeof(filename), pair_prefix, g + 1, job->format);
+        write_status = write_unique_file(selections[g], filename, job->format, g + 1, coverage_synteny);
+    }
+    free_te_selection(&unique1);
+    free_te_selection(&unique2);
+    if (write_status != 0) return;
+    
+    OrthologyResult result1, result2;
+    if (classify_orthology(&genome1->te_list, &genome2->te_list, &pair->synteny, job->tolerance,
+                           &job->options, &result1, &result2) < 0) {
+        return;
+    }
+    summary->shared1 = result1.class_counts[ORTHOLOGY_SHARED];
+    summary->shared2 = result2.class_counts[ORTHOLOGY_SHARED];
+    
+    int offset1 = job->offsets[pair->genome1];
+    int offset2 = job->offsets[pair->genome2];
+    uint64_t bit1 = (uint64_t)1 << pair->genome1;
+    uint64_t bit2 = (uint64_t)1 << pair->genome2;
+    
+    pthread_mutex_lock(&job->lock);
+    for (int i = 0; i < result1.count; i++) {
+        if (result1.classes[i] != ORTHOLOGY_OUTSIDE) job->syntenic[offset1 + i] |= bit2;
+        if (result1.partners[i] >= 0) {
+            int a = find_root(job->parent, offset1 + i);
+            int b = find_root(job->parent, offset2 + result1.partners[i]);
+            if (a != b) job->parent[a > b ? a : b] = a < b ? a : b;
+        }
+    }
+    for (int i = 0; i < result2.count; i++) {
+        if (result2.classes[i] != ORTHOLOGY_OUTSIDE) job->syntenic[offset2 + i] |= bit1;
+    }
+    pthread_mutex_unlock(&job->lock);
+    
+    free_orthology_result(&result1);
+    free_orthology_result(&result2);
+    summary->status = 0;
+}
+
+// 写出存在/缺失矩阵：每个位点一行，以编号最小的成员为代表；
+// 1为存在，0为位点在该基因组的共线性区域内但没有对应转座子，NA为无法判断
+static int write_presence_matrix(MultiJob* job, const char* filename, int total, int* loci, int* core) {
+    const Manifest* manifest = job->manifest;
+    int* first = (int*)safe_malloc((total > 0 ? total : 1) * sizeof(int));
+    uint64_t* present = (uint64_t*)safe_malloc((total > 0 ? total : 1) * sizeof(uint64_t));
+    for (int i = 0; i < total; i++) {
+        first[i] = -1;
+        present[i] = 0;
+    }
+    
+    // 按全局编号顺序汇总到各集合的根
+    int g = 0;
+    for (int i = 0; i < total; i++) {
+        while (i >= job->offsets[g + 1]) g++;
+        int root = find_root(job->parent, i);
+        if (first[root] < 0) first[root] = i;
+        present[root] |= (uint64_t)1 << g;
+        job->syntenic[root] |= job->syntenic[i];
+    }
+    
+    OutputWriter writer;
+    if (output_writer_open(&writer, filename) != 0) {
+        fprintf(stderr, "Error: Cannot create output file %s\n", filename);
+        free(first);
+        free(present);
+        return -1;
+    }
+    
+    output_writer_puts(&writer, "# Locus\tGenome\tID\tChr\tStart\tEnd\tType\tFamily");
+    for (int k = 0; k < manifest->genome_count; k++) {
+        output_writer_putc(&writer, '\t');
+        output_writer_puts(&writer, manifest->genomes[k].name);
+    }
+    output_writer_putc(&writer, '\n');
+    
+    uint64_t all = manifest->genome_count == 64 ? ~(uint64_t)0 : ((uint64_t)1 << manifest->genome_count) - 1;
+    *loci = 0;
+    *core = 0;
+    g = 0;
+    for (int i = 0; i < total; i++) {
+        while (i >= job->offsets[g + 1]) g++;
+        int root = find_root(job->parent, i);
+        if (first[root] != i) continue;
+        
+        const TEList* list = &manifest->genomes[g].te_list;
+        int k = i - job->offsets[g];
+        const char* id = list->ids[k];
+        const char* chr = string_table_get(list->strings, list->chrs[k]);
+        const char* type = string_table_get(list->strings, list->types[k]);
+        const char* family = string_table_get(list->strings, list->families[k]);
+        
+        (*loci)++;
+        if (present[root] == all) (*core)++;
+        output_writer_putc(&writer, 'L');
+        output_writer_put_int(&writer, *loci);
+        output_writer_putc(&writer, '\t');
+        output_writer_puts(&writer, manifest->genomes[g].name);
+        output_writer_putc(&writer, '\t');
+        output_writer_puts(&writer, id ? id : "N/A");
+        output_writer_putc(&writer, '\t');
+        output_writer_puts(&writer, chr ? chr : "N/A");
+        output_writer_putc(&writer, '\t');
+        output_writer_put_int(&writer, list->starts[k]);
+        output_writer_putc(&writer, '\t');
+        output_writer_put_int(&writer, list->ends[k]);
+        output_writer_putc(&writer, '\t');
+        output_writer_puts(&writer, type ? type : "N/A");
+        output_writer_putc(&writer, '\t');
+        output_writer_puts(&writer, family ? family : "N/A");
+        for (int k = 0; k < manifest->genome_count; k++) {
+            uint64_t bit = (uint64_t)1 << k;
+            output_writer_puts(&writer, (present[root] & bit) ? "\t1" : (job->syntenic[root] & bit) ? "\t0" : "\tNA");
+        }
+        output_writer_putc(&writer, '\n');
+    }
+    
+    free(first);
+    free(present);
+    if (output_writer_close(&writer) != 0) {
+        fprintf(stderr, "Error: Failed to write output file %s\n", filename);
+        return -1;
+    }
+    return 0;
+}
+
+// 多基因组比较：所有基因组对在线程池中并行比较，转座子列表和共线性列表只读共享。
+// 每对写出独有转座子，直系同源对应关系经并查集合并为跨基因组的位点，最后写出存在/缺失矩阵
+int compare_multi_genomes(Manifest* manifest, const char* output_prefix, OutputFormat format,
+                          int tolerance, const CompareOptions* options) {
+    if (!manifest || !output_prefix || !options) {
+        fprintf(stderr, "Error: Invalid parameters for compare_multi_genomes\n");
+        return -1;
+    }
+    
+    MultiJob job;
+    job.manifest = manifest;
+    job.output_prefix = output_prefix;
+    job.format = format;
+    job.tolerance = tolerance;
+    job.options = *options;
+    job.summaries = (PairSummary*)safe_malloc(manifest->pair_count * sizeof(PairSummary));
+    memset(job.summaries, 0, manifest->pair_count * sizeof(PairSummary));
+    pthread_mutex_init(&job.lock, NULL);
+    
+    job.offsets = (int*)safe_malloc((manifest->genome_count + 1) * sizeof(int));
+    long long total = 0;
+    for (int i = 0; i < manifest->genome_count; i++) {
+        job.offsets[i] = (int)total;
+        total += manifest->genomes[i].te_list.count;
+    }
+    if (total > 0x7fffffff) {
+        fprintf(stderr, "Error: Too many transposons across the manifest genomes\n");
+        free(job.summaries);
+        free(job.offsets);
+        pthread_mutex_destroy(&job.lock);
+        return -1;
+    }
+    job.offsets[manifest->genome_count] = (int)total;
+    job.parent = (int*)safe_malloc((total > 0 ? total : 1) * sizeof(int));
+    job.syntenic = (uint64_t*)safe_malloc((total > 0 ? total : 1) * sizeof(uint64_t));
+    for (int i = 0; i < (int)total; i++) {
+        job.parent[i] = i;
+        job.syntenic[i] = 0;
+    }
+    
+    // 基因组对多于线程时每对单线程执行，否则把剩余的线程分给每对内部
+    int threads = resolve_thread_count(options->num_threads);
+    job.options.num_threads = threads > manifest->pair_count ? threads / manifest->pair_count : 1;
+    printf("Comparing %d genome pairs...\n", manifest->pair_count);
+    parallel_for(manifest->pair_count, threads, run_pair_task, &job);
+    
+    int status = 0;
+    printf("\n=== Multi-Genome Comparison ===\n");
+    printf("%-16s %-16s %10s %10s %10s %10s\n", "Genome 1", "Genome 2", "Unique 1", "Unique 2",
+           "Shared 1", "Shared 2");
+    for (int i = 0; i < manifest->pair_count; i++) {
+        const ManifestPair* pair = &manifest->pairs[i];
+        const PairSummary* summary = &job.summaries[i];
+        if (summary->status != 0) {
+            fprintf(stderr, "Error: Comparison of %s and %s failed\n",
+                    manifest->genomes[pair->genome1].name, manifest->genomes[pair->genome2].name);
+            status = -1;
+            continue;
+        }
+        printf("%-16s %-16s %10d %10d %10d %10d\n", manifest->genomes[pair->genome1].name,
+               manifest->genomes[pair->genome2].name, summary->unique1, summary->unique2,
+               summary->shared1, summary->shared2);
+    }
+    
+    if (status == 0) {
+        char filename[512];
+        int len = snprintf(filename, sizeof(filename), "%s_pav_matrix.txt", output_prefix);
+        int loci = 0, core = 0;
+        if (len < 0 || (size_t)len >= sizeof(filename)) {
+            fprintf(stderr, "Error: Output prefix too long: %s\n", output_prefix);
+            status = -1;
+        } else {
+            status = write_presence_matrix(&job, filename, (int)total, &loci, &core);
+        }
+        if (status == 0) {
+            printf("\nTE loci: %d (%d present in all %d genomes)\n", loci, core, manifest->genome_count);
+            printf("Per-pair unique TEs written to files with prefix: %s_<genome1>_<genome2>\n", output_prefix);
+            printf("Presence/absence matrix written to: %s\n", filename);
+        }
+    }
+    
+    free(job.summaries);
+    free(job.offsets);
+    free(job.parent);
+    free(job.syntenic);
+    pthread_mutex_destroy(&job.lock);
+    return status;
+}
@@ -0,0 +1,330 @@
+#include "te_comparator.h"
+
+// 每个分类任务处理的转座子数
+#define ORTHOLOGY_CHUNK_SIZE 16384
+
+static const char* orthology_class_names[ORTHOLOGY_CLASS_COUNT] = { "shared", "PAV", "outside" };
+
+typedef struct {
+    TEList* te_list;                // 待分类的基因组
+    TEList* target;                 // 另一基因组，NULL时只做映射不查找对应转座子
+    int genome_id;
+    SyntenyList* synteny;
+    const CompareOptions* options;
+    const IntervalTrees* blocks;    // 本基因组一侧的共线性区块
+    const IntervalTrees* targets;   // 另一基因组的转座子
+    int tolerance;
+    OrthologyResult* result;
+} OrthologyJob;
+
+const char* orthology_class_name(OrthologyClass cls) {
+    return cls >= 0 && cls < ORTHOLOGY_CLASS_COUNT ? orthology_class_names[cls] : "N/A";
+}
+
+static void init_orthology_result(OrthologyResult* result, int count) {
+    int n = count > 0 ? count : 1;
+    result->classes = (unsigned char*)safe_malloc(n);
+    result->partners = (int*)safe_malloc(n * sizeof(int));
+    result->mapped_chr = (int*)safe_malloc(n * sizeof(int));
+    result->mapped_start = (int64_t*)safe_malloc(n * sizeof(int64_t));
+    result->mapped_end = (int64_t*)safe_malloc(n * sizeof(int64_t));
+    result->count = count;
+    memset(result->class_counts, 0, sizeof(result->class_counts));
+}
+
+void free_orthology_result(OrthologyResult* result) {
+    if (!result) return;
+    free(result->classes);
+    free(result->partners);
+    free(result->mapped_chr);
+    free(result->mapped_start);
+    free(result->mapped_end);
+    memset(result, 0, sizeof(OrthologyResult));
+}
+
+// 家族都已知时比较家族，否则比较类型，两者都缺失时只看位置（a的第i条与b的第j条）
+static bool same_te_class(const TEList* a, int i, const TEList* b, int j) {
+    if (a->families[i] != STR_NONE && b->families[j] != STR_NONE) return a->families[i] == b->families[j];
+    if (a->types[i] != STR_NONE && b->types[j] != STR_NONE) return a->types[i] == b->types[j];
+    return true;
+}
+
+// 记录在原输入中的下标：--sort之后按原下标比较，使排序不改变相同候选中的选择
+static int input_rank(const int* input_order, int index) {
+    return input_order ? input_order[index] : index;
+}
+
+// 与区间[te_start, te_end]重叠碱基最多的共线性区块（相同时取原下标小者），没有重叠时返回-1
+static int best_synteny_block(const OrthologyJob* job, int chr, int64_t te_start, int64_t te_end,
+                              int** hits, int* capacity) {
+    int found = interval_tree_query(job->blocks, chr, te_start, te_end, hits, capacity);
+    int best = -1;
+    long long best_overlap = -1;
+    for (int h = 0; h < found; h++) {
+        const SyntenyBlock* block = &job->synteny->blocks[(*hits)[h]];
+        int64_t start = job->genome_id == 1 ? block->start1 : block->start2;
+        int64_t end = job->genome_id == 1 ? block->end1 : block->end2;
+        if (start > end) {
+            int64_t tmp = start;
+            start = end;
+            end = tmp;
+        }
+        long long overlap = (te_end < end ? te_end : end) - (te_start > start ? te_start : start);
+        if (overlap > best_overlap || (overlap == best_overlap &&
+                                       input_rank(job->synteny->input_order, (*hits)[h]) <
+                                       input_rank(job->synteny->input_order, best))) {
+            best = (*hits)[h];
+            best_overlap = overlap;
+        }
+    }
+    return best;
+}
+
+// 在另一基因组的[start - tolerance, end + tolerance]内查找两端都在容差内、与第index个转座子
+// 同家族的转座子，取两端偏差较大者最小的一个（相同时取原下标小者）
+static int find_partner(const OrthologyJob* job, int index, int chr, int64_t start, int64_t end,
+                        int** hits, int* capacity) {
+    int found = interval_tree_query(job->targets, chr, start - job->tolerance, end + job->tolerance,
+                                    hits, capacity);
+    const TEList* target = job->target;
+    int best = -1;
+    long long best_distance = 0;
+    for (int h = 0; h < found; h++) {
+        int other = (*hits)[h];
+        long long d_start = llabs((long long)(target->starts[other] - start));
+        long long d_end = llabs((long long)(target->ends[other] - end));
+        long long distance = d_start > d_end ? d_start : d_end;
+        if (distance > job->tolerance || !same_te_class(job->te_list, index, target, other)) continue;
+        if (best < 0 || distance < best_distance ||
+            (distance == best_distance && input_rank(target->input_order, other) < input_rank(target->input_order, best))) {
+            best = (*hits)[h];
+            best_distance = distance;
+        }
+    }
+    return best;
+}
+
+// 分类一段转座子（只读访问共享数据，各任务写入结果的不同下标，可并发执行）
+static void run_orthology_task(void* ctx, int task) {
+    OrthologyJob* job = (OrthologyJob*)ctx;
+    OrthologyResult* result = job->result;
+    int begin = task * ORTHOLOGY_CHUNK_SIZE;
+    int end = begin + ORTHOLOGY_CHUNK_SIZE < job->te_list->count ? begin + ORTHOLOGY_CHUNK_SIZE
+                                                                 : job->te_list->count;
+    int* hits = NULL;
+    int capacity = 0;
+    const int* chrs = job->te_list->chrs;
+    const int64_t* starts = job->te_list->starts;
+    const int64_t* ends = job->te_list->ends;
+    
+    for (int i = begin; i < end; i++) {
+        result->partners[i] = -1;
+        result->mapped_chr[i] = STR_NONE;
+        result->mapped_start[i] = 0;
+        result->mapped_end[i] = 0;
+        result->classes[i] = ORTHOLOGY_OUTSIDE;
+        
+        if (job->synteny->count == 0 ||
+            !is_syntenic(chrs[i], starts[i], ends[i], job->synteny, job->genome_id, job->options, NULL)) {
+            continue;
+        }
+        int block_index = best_synteny_block(job, chrs[i], starts[i], ends[i], &hits, &capacity);
+        if (block_index < 0) continue;
+        
+        // 按区块的线性插值映射两端，超出区块的部分按同一比例外推
+        const SyntenyBlock* block = &job->synteny->blocks[block_index];
+        int64_t a = map_through_synteny_block(block, job->genome_id, starts[i]);
+        int64_t b = map_through_synteny_block(block, job->genome_id, ends[i]);
+        result->mapped_chr[i] = job->genome_id == 1 ? block->chr2 : block->chr1;
+        result->mapped_start[i] = a < b ? a : b;
+        result->mapped_end[i] = a < b ? b : a;
+        result->classes[i] = ORTHOLOGY_PAV;
+        
+        if (job->targets) {
+            result->partners[i] = find_partner(job, i, result->mapped_chr[i], result->mapped_start[i],
+                                               result->mapped_end[i], &hits, &capacity);
+            if (result->partners[i] >= 0) result->classes[i] = ORTHOLOGY_SHARED;
+        }
+    }
+    free(hits);
+}
+
+// 按genome_id一侧的坐标为共线性区块构建区间树
+static void build_block_trees(IntervalTrees* trees, const SyntenyList* synteny, int genome_id) {
+    int n = synteny->count > 0 ? synteny->count : 1;
+    int* chrs = (int*)safe_malloc(n * sizeof(int));
+    int64_t* starts = (int64_t*)safe_malloc(n * sizeof(int64_t));
+    int64_t* ends = (int64_t*)safe_malloc(n * sizeof(int64_t));
+    for (int i = 0; i < synteny->count; i++) {
+        const SyntenyBlock* block = &synteny->blocks[i];
+        chrs[i] = genome_id == 1 ? block->chr1 : block->chr2;
+        starts[i] = genome_id == 1 ? block->start1 : block->start2;
+        ends[i] = genome_id == 1 ? block->end1 : block->end2;
+    }
+    build_interval_trees(trees, chrs, starts, ends, synteny->count);
+    free(chrs);
+    free(starts);
+    free(ends);
+}
+
+static void run_orthology_job(OrthologyJob* job, int num_threads) {
+    int tasks = (job->te_list->count + ORTHOLOGY_CHUNK_SIZE - 1) / ORTHOLOGY_CHUNK_SIZE;
+    parallel_for(tasks, num_threads, run_orthology_task, job);
+}
+
+// 直系同源分类：基因组1的每个转座子经重叠最多的共线性区块映射到基因组2，在映射位置的容差内
+// 查找同家族转座子。找到时为shared，在共线性区域内但没找到时为PAV（存在/缺失多态），
+// 不在共线性区域内时为outside。基因组2的转座子被基因组1的某个转座子选中时为shared
+//（对应原下标最小的那个），否则按是否在共线性区域内分为PAV或outside。
+// 区块和基因组2的转座子都建区间树，总复杂度O((N + M) log M)
+int classify_orthology(TEList* te1, TEList* te2, SyntenyList* synteny, int tolerance,
+                       const CompareOptions* options, OrthologyResult* result1, OrthologyResult* result2) {
+    if (!te1 || !te2 || !synteny || !result1 || !result2 || tolerance < 0) {
+        fprintf(stderr, "Error: Invalid parameters for classify_orthology\n");
+        return -1;
+    }
+    
+    if (te1->strings != synteny->strings || te2->strings != synteny->strings) {
+        fprintf(stderr, "Error: TE lists and synteny list must share a string table\n");
+        return -1;
+    }
+    
+    CompareOptions default_options;
+    if (!options) {
+        init_compare_options(&default_options);
+        options = &default_options;
+    }
+    if (synteny->count > 0 && !synteny->index && options->min_overlap > 0.0) {
+        build_synteny_index(synteny);
+    }
+    
+    init_orthology_result(result1, te1->count);
+    init_orthology_result(result2, te2->count);
+    
+    IntervalTrees blocks1, blocks2, targets;
+    build_block_trees(&blocks1, synteny, 1);
+    build_block_trees(&blocks2, synteny, 2);
+    build_te_interval_trees(&targets, te2);
+    
+    OrthologyJob job1 = { te1, te2, 1, synteny, options, &blocks1, &targets, tolerance, result1 };
+    OrthologyJob job2 = { te2, NULL, 2, synteny, options, &blocks2, NULL, tolerance, result2 };
+    run_orthology_job(&job1, options->num_threads);
+    run_orthology_job(&job2, options->num_threads);
+    
+    // 按基因组1的原始顺序回填基因组2的对应关系，结果与线程数以及是否排序无关
+    int* by_input = NULL;
+    if (te1->input_order) {
+        by_input = (int*)safe_malloc((te1->count > 0 ? te1->count : 1) * sizeof(int));
+        for (int i = 0; i < te1->count; i++) by_input[te1->input_order[i]] = i;
+    }
+    for (int r = 0; r < te1->count; r++) {
+        int i = by_input ? by_input[r] : r;
+        int partner = result1->partners[i];
+        if (partner >= 0 && result2->partners[partner] < 0) {
+            result2->partners[partner] = i;
+            result2->classes[partner] = ORTHOLOGY_SHARED;
+        }
+    }
+    free(by_input);
+    for (int i = 0; i < te1->count; i++) result1->class_counts[result1->classes[i]]++;
+    for (int i = 0; i < te2->count; i++) result2->class_counts[result2->classes[i]]++;
+    
+    free_interval_trees(&blocks1);
+    free_interval_trees(&blocks2);
+    free_interval_trees(&targets);
+    return 0;
+}
+
+void print_orthology_summary(const OrthologyResult* result1, const OrthologyResult* result2, int tolerance) {
+    static const char* labels[ORTHOLOGY_CLASS_COUNT] = { "Shared", "Presence/absence", "Outside synteny" };
+    const OrthologyResult* results[2] = { result1, result2 };
+    
+    printf("\n=== TE Orthology Analysis ===\n");
+    printf("Tolerance: %d bp\n", tolerance);
+    for (int g = 0; g < 2; g++) {
+        printf("Genome %d:\n", g + 1);
+        for (int c = 0; c < ORTHOLOGY_CLASS_COUNT; c++) {
+            int n = results[g]->class_counts[c];
+            printf("  %s: %d (%.1f%%)\n", labels[c], n,
+                   results[g]->count > 0 ? 100.0 * n / results[g]->count : 0.0);
+        }
+    }
+}
+
+// 写出<prefix>_genomeN_orthology.txt，前缀为"-"时写到标准输出
+int write_orthology_results(const TEList* te1, const TEList* te2, const OrthologyResult* result1,
+                            const OrthologyResult* result2, const char* output_prefix) {
+    if (!te1 || !te2 || !result1 || !result2 || !output_prefix) return -1;
+    
+    const TEList* lists[2] = { te1, te2 };
+    const OrthologyResult* results[2] = { result1, result2 };
+    for (int g = 0; g < 2; g++) {
+        char filename[512];
+        if (strcmp(output_prefix, "-") == 0) {
+            snprintf(filename, sizeof(filename), "-");
+        } else {
+            snprintf(filename, sizeof(filename), "%s_genome%d_orthology.txt", output_prefix, g + 1);
+        }
+        
+        OutputWriter writer;
+        if (output_writer_open(&writer, filename) != 0) {
+            fprintf(stderr, "Error: Cannot create output file %s\n", filename);
+            return -1;
+        }
+        
+        const TEList* list = lists[g];
+        const TEList* other = lists[1 - g];
+        const OrthologyResult* result = results[g];
+        output_writer_puts(&writer, "# TE orthology in Genome ");
+        output_writer_put_int(&writer, g + 1);
+        output_writer_puts(&writer, "\n# ID\tChr\tStart\tEnd\tStrand\tType\tFamily\tName\tClass\t"
+                                    "MappedChr\tMappedStart\tMappedEnd\tPartner\n");
+        for (int i = 0; i < list->count; i++) {
+            const char* fields[4] = {
+                string_table_get(list->strings, list->strands[i]), string_table_get(list->strings, list->types[i]),
+                string_table_get(list->strings, list->families[i]), list->names[i]
+            };
+            const char* chr = string_table_get(list->strings, list->chrs[i]);
+            output_writer_puts(&writer, list->ids[i] ? list->ids[i] : "N/A");
+            output_writer_putc(&writer, '\t');
+            output_writer_puts(&writer, chr ? chr : "N/A");
+            output_writer_putc(&writer, '\t');
+            output_writer_put_int(&writer, list->starts[i]);
+            output_writer_putc(&writer, '\t');
+            output_writer_put_int(&writer, list->ends[i]);
+            for (int f = 0; f < 4; f++) {
+                output_writer_putc(&writer, '\t');
+                output_writer_puts(&writer, fields[f] ? fields[f] : (f == 0 ? "." : "N/A"));
+            }
+            output_writer_putc(&writer, '\t');
+            output_writer_puts(&writer, orthology_class_name((OrthologyClass)result->classes[i]));
+            output_writer_putc(&writer, '\t');
+            if (result->mapped_chr[i] != STR_NONE) {
+                const char* mapped_chr = string_table_get(list->strings, result->mapped_chr[i]);
+                output_writer_puts(&writer, mapped_chr ? mapped_chr : "N/A");
+                output_writer_putc(&writer, '\t');
+                output_writer_put_int(&writer, result->mapped_start[i]);
+                output_writer_putc(&writer, '\t');
+                output_writer_put_int(&writer, result->mapped_end[i]);
+            } else {
+                output_writer_puts(&writer, ".\t.\t.");
+            }
+            output_writer_putc(&writer, '\t');
+            if (result->partners[i] >= 0) {
+                const char* id = other->ids[result->partners[i]];
+                output_writer_puts(&writer, id ? id : "N/A");
+            } else {
+                output_writer_putc(&writer, '.');
+            }
+            output_writer_putc(&writer, '\n');
+        }
+        
+        if (output_writer_close(&writer) != 0) {
+            fprintf(stderr, "Error: Failed to write output file %s\n", filename);
+            return -1;
+        }
+        printf("Genome %d orthology written to: %s\n", g + 1,
+               strcmp(filename, "-") == 0 ? "standard output" : filename);
+    }
+    return 0;
+}
@@ -0,0 +1,287 @@
+#include "te_comparator.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// 输出缓冲区大小
+#define OUTPUT_BUFFER_SIZE (1 << 20)
+
+// 结果写到标准输出时使用的描述符（redirect_stdout_for_output之后不再是1）
+static int g_output_stdout_fd = STDOUT_FILENO;
+
+// 两位数字查表，整数转文本时每次处理两位
+static const char digit_pairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// 打开输出文件，"-"表示标准输出
+int output_writer_open(OutputWriter* writer, const char* filename) {
+    if (!writer || !filename) return -1;
+    
+    memset(writer, 0, sizeof(OutputWriter));
+    if (strcmp(filename, "-") == 0) {
+        writer->fd = g_output_stdout_fd;
+        writer->owns_fd = false;
+    } else {
+        writer->fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (writer->fd < 0) return -1;
+        writer->owns_fd = true;
+    }
+    
+    writer->capacity = OUTPUT_BUFFER_SIZE;
+    writer->buffer = (char*)safe_malloc(writer->capacity);
+    return 0;
+}
+
+// 写到已打开的描述符（如套接字），关闭时不关闭fd
+void output_writer_open_fd(OutputWriter* writer, int fd, size_t capacity) {
+    memset(writer, 0, sizeof(OutputWriter));
+    writer->fd = fd;
+    writer->owns_fd = false;
+    writer->capacity = capacity > 0 ? capacity : OUTPUT_BUFFER_SIZE;
+    writer->buffer = (char*)safe_malloc(writer->capacity);
+}
+
+// 写出缓冲区中的全部数据
+bool output_writer_flush(OutputWriter* writer) {
+    size_t done = 0;
+    while (done < writer->size && !writer->failed) {
+        ssize_t n = write(writer->fd, writer->buffer + done, writer->size - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            writer->failed = true;
+            break;
+        }
+        done += (size_t)n;
+    }
+    writer->size = 0;
+    return !writer->failed;
+}
+
+void output_writer_write(OutputWriter* writer, const char* data, size_t len) {
+    if (writer->capacity - writer->size < len) {
+        output_writer_flush(writer);
+        
+        // 超过缓冲区的数据直接写出
+        if (len >= writer->capacity) {
+            while (len > 0 && !writer->failed) {
+                ssize_t n = write(writer->fd, data, len);
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) {
+                    writer->failed = true;
+                    break;
+                }
+                data += n;
+                len -= (size_t)n;
+            }
+            return;
+        }
+    }
+    
+    memcpy(writer->buffer + writer->size, data, len);
+    writer->size += len;
+}
+
+void output_writer_puts(OutputWriter* writer, const char* str) {
+    output_writer_write(writer, str, strlen(str));
+}
+
+void output_writer_putc(OutputWriter* writer, char c) {
+    if (writer->size == writer->capacity) output_writer_flush(writer);
+    writer->buffer[writer->size++] = c;
+}
+
+// 写出十进制整数，从低位起每次转换两位
+void output_writer_put_int(OutputWriter* writer, long long value) {
+    char digits[24];
+    char* p = digits + sizeof(digits);
+    unsigned long long v = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+    
+    while (v >= 100) {
+        unsigned int pair = (unsigned int)(v % 100) * 2;
+        v /= 100;
+        *--p = digit_pairs[pair + 1];
+        *--p = digit_pairs[pair];
+    }
+    if (v >= 10) {
+        unsigned int pair = (unsigned int)v * 2;
+        *--p = digit_pairs[pair + 1];
+        *--p = digit_pairs[pair];
+    } else {
+        *--p = (char)('0' + v);
+    }
+    if (value < 0) *--p = '-';
+    
+    output_writer_write(writer, p, (size_t)(digits + sizeof(digits) - p));
+}
+
+// 写出剩余数据并关闭，任何一次写入失败都返回-1
+int output_writer_close(OutputWriter* writer) {
+    if (!writer) return -1;
+    
+    output_writer_flush(writer);
+    if (writer->owns_fd && close(writer->fd) != 0) writer->failed = true;
+    free(writer->buffer);
+    writer->buffer = NULL;
+    return writer->failed ? -1 : 0;
+}
+
+// 结果写到标准输出时，把程序自身的提示信息改到标准错误，避免混入结果数据
+void redirect_stdout_for_output(void) {
+    fflush(stdout);
+    int fd = dup(STDOUT_FILENO);
+    if (fd < 0) return;
+    
+    if (dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+        close(fd);
+        return;
+    }
+    g_output_stdout_fd = fd;
+}
+
+// 解析--out-format的取值，非法时返回-1
+int parse_output_format(const char* name) {
+    if (!name) return -1;
+    if (strcmp(name, "tsv") == 0) return OUTPUT_TSV;
+    if (strcmp(name, "bed") == 0) return OUTPUT_BED;
+    if (strcmp(name, "gff3") == 0) return OUTPUT_GFF3;
+    return -1;
+}
+
+const char* output_format_extension(OutputFormat format) {
+    switch (format) {
+        case OUTPUT_BED: return "bed";
+        case OUTPUT_GFF3: return "gff3";
+        default: return "txt";
+    }
+}
+
+// 结果文件名：<prefix>_genomeN_unique.<扩展名>，前缀为"-"时为标准输出
+void output_file_name(char* buffer, size_t size, const char* output_prefix, int genome_id,
+                      OutputFormat format) {
+    if (strcmp(output_prefix, "-") == 0) {
+        snprintf(buffer, size, "-");
+    } else {
+        snprintf(buffer, size, "%s_genome%d_unique.%s", output_prefix, genome_id,
+                 output_format_extension(format));
+    }
+}
+
+// 写出文件头（注释行），with_coverage时TSV表头带Coverage列
+void write_unique_header(OutputWriter* writer, OutputFormat format, int genome_id, bool with_coverage) {
+    if (format == OUTPUT_GFF3) {
+        output_writer_puts(writer, "##gff-version 3\n");
+    }
+    output_writer_puts(writer, "# Unique transposons in Genome ");
+    output_writer_put_int(writer, genome_id);
+    output_writer_putc(writer, '\n');
+    if (format == OUTPUT_TSV) {
+        output_writer_puts(writer, with_coverage ? "# ID\tChr\tStart\tEnd\tStrand\tType\tFamily\tName\tCoverage\n"
+                                                 : "# ID\tChr\tStart\tEnd\tStrand\tType\tFamily\tName\n");
+    }
+}
+
+// 写出GFF3属性值，按规范转义';' '=' '&' ',' 和控制字符
+static void put_gff3_value(OutputWriter* writer, const char* value) {
+    static const char hex[] = "0123456789ABCDEF";
+    for (const char* p = value; *p; p++) {
+        unsigned char c = (unsigned char)*p;
+        if (c == ';' || c == '=' || c == '&' || c == ',' || c == '%' || c < 0x20 || c == 0x7f) {
+            output_writer_putc(writer, '%');
+            output_writer_putc(writer, hex[c >> 4]);
+            output_writer_putc(writer, hex[c & 15]);
+        } else {
+            output_writer_putc(writer, (char)c);
+        }
+    }
+}
+
+static void put_field(OutputWriter* writer, const char* value, const char* fallback) {
+    output_writer_puts(writer, value ? value : fallback);
+    output_writer_putc(writer, '\t');
+}
+
+// 写出覆盖比例（保留4位小数）
+static void put_fraction(OutputWriter* writer, double value) {
+    char text[32];
+    int len = snprintf(text, sizeof(text), "%.4f", value);
+    output_writer_write(writer, text, (size_t)len);
+}
+
+// 按格式写出一条转座子记录；coverage >= 0时附带共线性覆盖比例
+//（TSV和BED为最后一列，GFF3为synteny_coverage属性）
+void write_te_record(OutputWriter* writer, OutputFormat format, const StringTable* strings,
+                     const Transposon* te, double coverage) {
+    const char* chr = string_table_get(strings, te->chr);
+    const char* strand = string_table_get(strings, te->strand);
+    const char* type = string_table_get(strings, te->type);
+    const char* family = string_table_get(strings, te->family);
+    
+    if (format == OUTPUT_BED) {
+        // BED为0-based半开区间
+        put_field(writer, chr, "N/A");
+        output_writer_put_int(writer, (long long)te->start - 1);
+        output_writer_putc(writer, '\t');
+        output_writer_put_int(writer, te->end);
+        output_writer_putc(writer, '\t');
+        put_field(writer, te->name ? te->name : te->id, ".");
+        output_writer_puts(writer, "0\t");
+        put_field(writer, strand, ".");
+        put_field(writer, type, ".");
+        output_writer_puts(writer, family ? family : ".");
+        if (coverage >= 0.0) {
+            output_writer_putc(writer, '\t');
+            put_fraction(writer, coverage);
+        }
+        output_writer_putc(writer, '\n');
+    } else if (format == OUTPUT_GFF3) {
+        const char* source = string_table_get(strings, te->source);
+        put_field(writer, chr, "N/A");
+        put_field(writer, source, "tevox");
+        put_field(writer, type, "transposable_element");
+        output_writer_put_int(writer, te->start);
+        output_writer_putc(writer, '\t');
+        output_writer_put_int(writer, te->end);
+        output_writer_puts(writer, "\t.\t");
+        put_field(writer, strand, ".");
+        output_writer_puts(writer, ".\t");
+        
+        // 保留原始属性；来自BED的记录由ID、名称和家族生成
+        if (te->attributes) {
+            output_writer_puts(writer, te->attributes);
+        } else {
+            output_writer_puts(writer, "ID=");
+            put_gff3_value(writer, te->id ? te->id : "N/A");
+            if (te->name && te->name != te->id) {
+                output_writer_puts(writer, ";Name=");
+                put_gff3_value(writer, te->name);
+            }
+            if (family) {
+                output_writer_puts(writer, ";family=");
+                put_gff3_value(writer, family);
+            }
+        }
+        if (coverage >= 0.0) {
+            output_writer_puts(writer, ";synteny_coverage=");
+            put_fraction(writer, coverage);
+        }
+        output_writer_putc(writer, '\n');
+    } else {
+        put_field(writer, te->id, "N/A");
+        put_field(writer, chr, "N/A");
+        output_writer_put_int(writer, te->start);
+        output_writer_putc(writer, '\t');
+        output_writer_put_int(writer, te->end);
+        output_writer_putc(writer, '\t');
+        put_field(writer, strand, ".");
+        put_field(writer, type, "N/A");
+        put_field(writer, family, "N/A");
+        output_writer_puts(writer, te->name ? te->name : "N/A");
+        if (coverage >= 0.0) {
+            output_writer_putc(writer, '\t');
+            put_fraction(writer, coverage);
+        }
+        output_writer_putc(writer, '\n');
+    }
+}
@@ -0,0 +1,211 @@
+#include "te_comparator.h"
+
+// 每个分块的最小字节数，小文件不值得并行
+#define MIN_CHUNK_SIZE (256 * 1024)
+
+// 单个工作线程负责的分块
+typedef struct {
+    const char* data;       // 分块起点（行首）
+    size_t size;
+    FileType type;
+    int first_line;         // 分块第一行在文件中的行号减一
+    int newline_count;      // 分块中的换行符数量
+    StringTable strings;    // 线程私有字符串表，合并时重新映射
+    TEList te_list;
+} ParseChunk;
+
+// 第一阶段：统计分块中的换行符，用于推算每个分块的起始行号
+static void count_lines_worker(void* ctx, int task) {
+    ParseChunk* chunk = &((ParseChunk*)ctx)[task];
+    const char* p = chunk->data;
+    const char* end = chunk->data + chunk->size;
+    
+    int count = 0;
+    while (p < end && (p = (const char*)memchr(p, '\n', (size_t)(end - p))) != NULL) {
+        count++;
+        p++;
+    }
+    chunk->newline_count = count;
+}
+
+// 第二阶段：把分块解析到线程私有的TEList
+static void parse_chunk_worker(void* ctx, int task) {
+    ParseChunk* chunk = &((ParseChunk*)ctx)[task];
+    
+    init_string_table(&chunk->strings);
+    init_te_list(&chunk->te_list);
+    chunk->te_list.strings = &chunk->strings;
+    
+    LineReader reader;
+    line_reader_init_buffer(&reader, chunk->data, chunk->size);
+    
+    StrSlice line;
+    while (line_reader_next(&reader, &line)) {
+        int line_num = chunk->first_line + reader.line_num;
+        if (chunk->type == FILE_GFF3) {
+            parse_gff3_line(line, line_num, &chunk->te_list);
+        } else {
+            parse_bed_line(line, line_num, &chunk->te_list);
+        }
+    }
+}
+
+// 释放分块及其私有结果（内存不足时使用，未开始或已合并的分块也可安全释放）
+static void free_parse_chunks(ParseChunk* chunks, int count) {
+    if (!chunks) return;
+    for (int i = 0; i < count; i++) {
+        free_te_list(&chunks[i].te_list);
+        free_string_table(&chunks[i].strings);
+    }
+    free(chunks);
+}
+
+// 把分块结果按顺序并入te_list：字符串ID重新映射到目标表，id/name所在内存池整体转移
+static void merge_chunk(TEList* te_list, ParseChunk* chunk) {
+    TEList* part = &chunk->te_list;
+    
+    int* id_map = NULL;
+    if (chunk->strings.count > 0) {
+        id_map = (int*)safe_malloc(chunk->strings.count * sizeof(int));
+        for (int i = 0; i < chunk->strings.count; i++) {
+            id_map[i] = string_table_intern_len(te_list->strings, chunk->strings.strings[i], 
+                                                chunk->strings.lengths[i]);
+        }
+    }
+    
+    if (te_list->count + part->count > te_list->capacity) {
+        int new_capacity = te_list->capacity == 0 ? 100 : te_list->capacity;
+        while (new_capacity < te_list->count + part->count) new_capacity *= 2;
+        te_list_reserve(te_list, new_capacity);
+    }
+    
+    // 坐标和字符串指针整列复制，字符串ID列逐项重新映射
+    if (part->count > 0) {
+        int base = te_list->count;
+        size_t n = (size_t)part->count;
+        memcpy(te_list->starts + base, part->starts, n * sizeof(int64_t));
+        memcpy(te_list->ends + base, part->ends, n * sizeof(int64_t));
+        memcpy(te_list->ids + base, part->ids, n * sizeof(char*));
+        memcpy(te_list->names + base, part->names, n * sizeof(char*));
+        memcpy(te_list->attributes + base, part->attributes, n * sizeof(char*));
+        
+        const int* from[5] = { part->chrs, part->strands, part->types, part->families, part->sources };
+        int* to[5] = { te_list->chrs + base, te_list->strands + base, te_list->types + base,
+                       te_list->families + base, te_list->sources + base };
+        for (int c = 0; c < 5; c++) {
+            for (int i = 0; i < part->count; i++) {
+                to[c][i] = from[c][i] != STR_NONE ? id_map[from[c][i]] : STR_NONE;
+            }
+        }
+        te_list->count += part->count;
+    }
+    
+    arena_adopt(&te_list->arena, &part->arena);
+    
+    free(id_map);
+    free_te_list(part);
+    free_string_table(&chunk->strings);
+}
+
+// 多线程解析GFF3/BED文件：按换行符对齐切分字节范围，各线程解析后按顺序合并，
+// 结果（包括生成的TE_<行号>_<起点>_<终点> ID）与串行解析完全一致
+int parse_te_file_mt(const char* filename, FileType type, TEList* te_list, int num_threads) {
+    ParseOptions options = { NULL, num_threads, false };
+    return parse_te_file_ex(filename, type, te_list, &options);
+}
+
+// 按选项解析GFF3/BED文件：字符串写入options->strings，quiet时不打印进度
+int parse_te_file_ex(const char* filename, FileType type, TEList* te_list, const ParseOptions* options) {
+    if (!filename || !te_list || !options || (type != FILE_GFF3 && type != FILE_BED)) {
+        fprintf(stderr, "Error: Invalid parameters for parse_te_file_mt\n");
+        return -1;
+    }
+    
+    const char* format = type == FILE_GFF3 ? "GFF3" : "BED";
+    int num_threads = resolve_thread_count(options->num_threads);
+    
+    // 只有mmap的输入可以按字节范围切分，管道等仍走串行路径（交还已读出的数据）
+    LineReader reader;
+    int chunk_count = 0;
+    if (num_threads > 1 && line_reader_open_peek(&reader, filename, num_threads) == 0) {
+        chunk_count = (int)(reader.size / MIN_CHUNK_SIZE);
+        if (chunk_count > num_threads) chunk_count = num_threads;
+        if (!reader.mapped || chunk_count <= 1) {
+            line_reader_unread(&reader, filename);
+            chunk_count = 0;
+        }
+    }
+    if (chunk_count == 0) {
+        if (parse_te_file_serial(filename, type, te_list, options->strings, num_threads) < 0) return -1;
+        if (!options->quiet) {
+            printf("Parsed %d transposons from %s file %s\n", te_list->count, format, filename);
+        }
+        return te_list->count;
+    }
+    
+    init_te_list(te_list);
+    if (options->strings) te_list->strings = options->strings;
+    
+    // 库调用内存不足时释放分块和已合并的记录、解除映射，再跳回调用方的陷阱
+    ParseChunk* volatile chunks = NULL;
+    jmp_buf trap;
+    jmp_buf* previous = NULL;
+    bool trapped = oom_trap_active();
+    if (trapped) {
+        previous = set_oom_trap(&trap);
+        if (setjmp(trap)) {
+            set_oom_trap(previous);
+            free_parse_chunks(chunks, chunk_count);
+            free_te_list(te_list);
+            line_reader_close(&reader);
+            out_of_memory(0);
+        }
+    }
+    
+    // 切分：每个分块的起点移到上一个换行符之后
+    chunks = (ParseChunk*)safe_malloc(chunk_count * sizeof(ParseChunk));
+    memset(chunks, 0, chunk_count * sizeof(ParseChunk));
+    
+    size_t begin = 0;
+    int actual_count = 0;
+    for (int i = 0; i < chunk_count && begin < reader.size; i++) {
+        size_t end = reader.size;
+        if (i < chunk_count - 1) {
+            end = reader.size / chunk_count * (size_t)(i + 1);
+            if (end < begin) end = begin;
+            const char* newline = (const char*)memchr(reader.data + end, '\n', reader.size - end);
+            end = newline ? (size_t)(newline - reader.data) + 1 : reader.size;
+        }
+        
+        chunks[actual_count].data = reader.data + begin;
+        chunks[actual_count].size = end - begin;
+        chunks[actual_count].type = type;
+        actual_count++;
+        begin = end;
+    }
+    
+    parallel_for(actual_count, actual_count, count_lines_worker, chunks);
+    
+    int lines_before = 0;
+    for (int i = 0; i < actual_count; i++) {
+        chunks[i].first_line = lines_before;
+        lines_before += chunks[i].newline_count;
+    }
+    
+    parallel_for(actual_count, actual_count, parse_chunk_worker, chunks);
+    
+    // 按分块顺序合并，保证结果确定
+    for (int i = 0; i < actual_count; i++) {
+        merge_chunk(te_list, &chunks[i]);
+    }
+    if (trapped) set_oom_trap(previous);
+    
+    free(chunks);
+    line_reader_close(&reader);
+    
+    if (!options->quiet) {
+        printf("Parsed %d transposons from %s file %s (%d threads)\n", te_list->count, format, filename,
+               actual_count);
+    }
+    return te_list->count;
+}
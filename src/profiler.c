@@ -0,0 +1,160 @@
+#include "te_comparator.h"
+#include <time.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+// 最多记录的阶段数
+#define PROFILE_MAX_PHASES 32
+
+typedef struct {
+    const char* name;
+    double wall_start;
+    double cpu_start;
+    double wall;            // 秒
+    double cpu;             // 进程CPU时间（所有线程之和），秒
+    long long records;      // 小于0表示不适用
+    long long bytes;        // 输入字节数，小于0表示不适用
+    long peak_rss_kb;       // 阶段结束时的进程峰值内存
+    bool finished;
+} ProfilePhase;
+
+// 未启用时各函数只检查一次标志，不读时钟
+static bool profile_on = false;
+static double profile_wall_origin = 0.0;
+static double profile_cpu_origin = 0.0;
+static ProfilePhase profile_phases[PROFILE_MAX_PHASES];
+static int profile_phase_count = 0;
+
+static double clock_seconds(clockid_t clock) {
+    struct timespec ts;
+    if (clock_gettime(clock, &ts) != 0) return 0.0;
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static long peak_rss_kb(void) {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+    return usage.ru_maxrss;
+}
+
+void profile_enable(void) {
+    profile_on = true;
+    profile_phase_count = 0;
+    profile_wall_origin = clock_seconds(CLOCK_MONOTONIC);
+    profile_cpu_origin = clock_seconds(CLOCK_PROCESS_CPUTIME_ID);
+}
+
+bool profile_enabled(void) {
+    return profile_on;
+}
+
+// 开始一个阶段，返回阶段编号；未启用或阶段过多时返回-1
+int profile_begin(const char* name) {
+    if (!profile_on || profile_phase_count >= PROFILE_MAX_PHASES) return -1;
+    
+    ProfilePhase* phase = &profile_phases[profile_phase_count];
+    memset(phase, 0, sizeof(ProfilePhase));
+    phase->name = name;
+    phase->records = -1;
+    phase->bytes = -1;
+    phase->cpu_start = clock_seconds(CLOCK_PROCESS_CPUTIME_ID);
+    phase->wall_start = clock_seconds(CLOCK_MONOTONIC);
+    return profile_phase_count++;
+}
+
+// 结束阶段，记录处理的记录数和输入字节数（不适用时传-1）
+void profile_end(int phase_id, long long records, long long bytes) {
+    if (phase_id < 0 || phase_id >= profile_phase_count) return;
+    
+    ProfilePhase* phase = &profile_phases[phase_id];
+    phase->wall = clock_seconds(CLOCK_MONOTONIC) - phase->wall_start;
+    phase->cpu = clock_seconds(CLOCK_PROCESS_CPUTIME_ID) - phase->cpu_start;
+    phase->records = records;
+    phase->bytes = bytes;
+    phase->peak_rss_kb = peak_rss_kb();
+    phase->finished = true;
+}
+
+// 文件大小，用于计算字节吞吐；无法获取时返回-1
+long long profile_file_size(const char* filename) {
+    struct stat st;
+    if (!filename || stat(filename, &st) != 0) return -1;
+    return (long long)st.st_size;
+}
+
+static double per_second(long long amount, double seconds) {
+    return seconds > 0.0 ? amount / seconds : 0.0;
+}
+
+void profile_print_summary(void) {
+    if (!profile_on) return;
+    
+    printf("\n=== Profile ===\n");
+    printf("%-18s %9s %9s %11s %12s %9s %13s\n",
+           "Phase", "Wall(s)", "CPU(s)", "Records", "Records/s", "MB/s", "Peak RSS(MB)");
+    for (int i = 0; i < profile_phase_count; i++) {
+        const ProfilePhase* phase = &profile_phases[i];
+        if (!phase->finished) continue;
+        
+        printf("%-18s %9.3f %9.3f ", phase->name, phase->wall, phase->cpu);
+        if (phase->records >= 0) {
+            printf("%11lld %12.0f ", phase->records, per_second(phase->records, phase->wall));
+        } else {
+            printf("%11s %12s ", "-", "-");
+        }
+        if (phase->bytes >= 0) {
+            printf("%9.1f ", per_second(phase->bytes, phase->wall) / 1048576.0);
+        } else {
+            printf("%9s ", "-");
+        }
+        printf("%13.1f\n", phase->peak_rss_kb / 1024.0);
+    }
+    printf("%-18s %9.3f %9.3f %11s %12s %9s %13.1f\n", "total",
+           clock_seconds(CLOCK_MONOTONIC) - profile_wall_origin,
+           clock_seconds(CLOCK_PROCESS_CPUTIME_ID) - profile_cpu_origin,
+           "", "", "", peak_rss_kb() / 1024.0);
+    printf("Field scanner: %s\n", simd_scan_level());
+}
+
+// 写出JSON格式的阶段统计
+int profile_write_json(const char* filename) {
+    if (!profile_on || !filename) return -1;
+    
+    FILE* file = fopen(filename, "w");
+    if (!file) {
+        fprintf(stderr, "Error: Cannot create profile file %s\n", filename);
+        return -1;
+    }
+    
+    fprintf(file, "{\n  \"phases\": [");
+    bool first = true;
+    for (int i = 0; i < profile_phase_count; i++) {
+        const ProfilePhase* phase = &profile_phases[i];
+        if (!phase->finished) continue;
+        
+        // 阶段名称为程序内的固定字符串，不含需要转义的字符
+        fprintf(file, "%s\n    {\"name\": \"%s\", \"wall_seconds\": %.6f, \"cpu_seconds\": %.6f",
+                first ? "" : ",", phase->name, phase->wall, phase->cpu);
+        if (phase->records >= 0) {
+            fprintf(file, ", \"records\": %lld, \"records_per_second\": %.1f",
+                    phase->records, per_second(phase->records, phase->wall));
+        }
+        if (phase->bytes >= 0) {
+            fprintf(file, ", \"bytes\": %lld, \"bytes_per_second\": %.1f",
+                    phase->bytes, per_second(phase->bytes, phase->wall));
+        }
+        fprintf(file, ", \"peak_rss_kb\": %ld}", phase->peak_rss_kb);
+        first = false;
+    }
+    fprintf(file, "\n  ],\n  \"field_scanner\": \"%s\",", simd_scan_level());
+    fprintf(file, "\n  \"total\": {\"wall_seconds\": %.6f, \"cpu_seconds\": %.6f, \"peak_rss_kb\": %ld}\n}\n",
+            clock_seconds(CLOCK_MONOTONIC) - profile_wall_origin,
+            clock_seconds(CLOCK_PROCESS_CPUTIME_ID) - profile_cpu_origin, peak_rss_kb());
+    
+    if (fclose(file) != 0) {
+        fprintf(stderr, "Error: Failed to write profile file %s\n", filename);
+        return -1;
+    }
+    printf("Profile written to: %s\n", filename);
+    return 0;
+}
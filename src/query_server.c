@@ -0,0 +1,718 @@
+#include "te_comparator.h"
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+// 同时连接的客户端上限
+#define SERVE_MAX_CLIENTS 256
+// 单行请求的最大长度
+#define SERVE_MAX_LINE 4096
+// 一个BATCH请求最多包含的查询数；整批先读入内存，每个连接最多缓存约40 MB
+#define SERVE_MAX_BATCH 10000
+// 每个连接的输出缓冲区大小
+#define SERVE_WRITE_BUFFER (64 * 1024)
+// 客户端长时间不读取响应时放弃该连接，避免阻塞重新加载（秒）
+#define SERVE_SEND_TIMEOUT 10
+// 客户端每个BATCH发送的查询数
+#define CLIENT_BATCH_SIZE 1000
+
+// 一代加载好的数据，重新加载时整体替换；每代有自己的字符串表，可以在不持锁时解析
+typedef struct {
+    StringTable strings;
+    SyntenyList synteny;
+    TEList te[2];
+    IntervalTrees trees[2];
+    unsigned char* unique[2];   // 转座子是否为独有（不在共线性区域内）
+    int loaded;                 // 已解析的转座子文件数，用于出错时释放
+    int generation;
+} ServeData;
+
+// 输入文件的状态，用于检测变化
+typedef struct {
+    bool exists;
+    off_t size;
+    ino_t inode;
+    time_t mtime;
+    long mtime_nsec;
+} FileStamp;
+
+typedef struct {
+    const ServeConfig* config;
+    ServeData* data;
+    pthread_rwlock_t data_lock;     // 查询持有读锁，重新加载只在替换data指针时持有写锁
+    pthread_mutex_t clients_lock;
+    pthread_cond_t clients_done;
+    int client_fds[SERVE_MAX_CLIENTS];
+    int client_count;
+    FileStamp stamps[3];
+} ServeState;
+
+typedef struct {
+    ServeState* state;
+    int fd;
+} ClientArgs;
+
+// 按行读取套接字，返回的行在下一次读取前有效
+typedef struct {
+    int fd;
+    size_t start;
+    size_t end;
+    char buffer[SERVE_MAX_LINE];
+} SocketReader;
+
+static volatile sig_atomic_t serve_stop = 0;
+
+static void handle_stop_signal(int sig) {
+    (void)sig;
+    serve_stop = 1;
+}
+
+// 读取一行（去掉行尾的\r\n），返回1；连接关闭时返回0，出错时返回-1，行过长时返回-2
+static int socket_reader_next(SocketReader* reader, StrSlice* line) {
+    for (;;) {
+        char* newline = (char*)memchr(reader->buffer + reader->start, '\n', reader->end - reader->start);
+        if (newline) {
+            line->ptr = reader->buffer + reader->start;
+            line->len = (size_t)(newline - line->ptr);
+            if (line->len > 0 && line->ptr[line->len - 1] == '\r') line->len--;
+            reader->start = (size_t)(newline - reader->buffer) + 1;
+            return 1;
+        }
+        
+        if (reader->start > 0) {
+            memmove(reader->buffer, reader->buffer + reader->start, reader->end - reader->start);
+            reader->end -= reader->start;
+            reader->start = 0;
+        }
+        if (reader->end == sizeof(reader->buffer)) return -2;
+        
+        ssize_t n = read(reader->fd, reader->buffer + reader->end, sizeof(reader->buffer) - reader->end);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return -1;
+        if (n == 0) {
+            // 最后一行没有换行符
+            if (reader->end == 0) return 0;
+            line->ptr = reader->buffer;
+            line->len = reader->end;
+            reader->start = reader->end;
+            return 1;
+        }
+        reader->end += (size_t)n;
+    }
+}
+
+// 解析非负整数坐标
+static bool parse_position(StrSlice slice, int64_t* value) {
+    if (slice.len == 0 || slice.len > 18) return false;
+    
+    int64_t v = 0;
+    for (size_t i = 0; i < slice.len; i++) {
+        if (slice.ptr[i] < '0' || slice.ptr[i] > '9') return false;
+        v = v * 10 + (slice.ptr[i] - '0');
+    }
+    if (v > MAX_POSITION) return false;
+    *value = v;
+    return true;
+}
+
+static int compare_ints(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return x < y ? -1 : (x > y);
+}
+
+static void free_serve_data(ServeData* data) {
+    if (!data) return;
+    for (int g = 0; g < data->loaded; g++) {
+        free_te_list(&data->te[g]);
+        free_interval_trees(&data->trees[g]);
+        free(data->unique[g]);
+    }
+    free_synteny_list(&data->synteny);
+    free_string_table(&data->strings);
+    free(data);
+}
+
+// 解析全部输入，构建区间树并预先计算每个转座子是否为独有
+static ServeData* load_serve_data(const ServeConfig* config, int generation) {
+    ServeData* data = (ServeData*)safe_malloc(sizeof(ServeData));
+    memset(data, 0, sizeof(ServeData));
+    data->generation = generation;
+    init_string_table(&data->strings);
+    
+    // 所有字符串写入本代私有的表，不触碰正在服务的上一代
+    ParseOptions parse_options = { &data->strings, config->num_threads, false };
+    if (parse_synteny_ex(config->synteny_file, &data->synteny, &parse_options) < 0) {
+        fprintf(stderr, "Error: Failed to parse synteny file\n");
+        free_serve_data(data);
+        return NULL;
+    }
+    
+    const char* files[2] = { config->te_file1, config->te_file2 };
+    for (int g = 0; g < 2; g++) {
+        FileType type = detect_file_type(files[g], config->num_threads);
+        if (type != FILE_GFF3 && type != FILE_BED) {
+            fprintf(stderr, "Error: Unsupported file format for TE file %d: %s\n", g + 1, files[g]);
+            free_serve_data(data);
+            return NULL;
+        }
+        if (parse_te_file_ex(files[g], type, &data->te[g], &parse_options) < 0) {
+            fprintf(stderr, "Error: Failed to parse TE file %d\n", g + 1);
+            free_serve_data(data);
+            return NULL;
+        }
+        build_te_interval_trees(&data->trees[g], &data->te[g]);
+        data->unique[g] = (unsigned char*)safe_malloc(data->te[g].count > 0 ? data->te[g].count : 1);
+        memset(data->unique[g], 0, data->te[g].count > 0 ? data->te[g].count : 1);
+        data->loaded++;
+    }
+    
+    TESelection unique[2];
+    if (collect_unique_transposons(&data->te[0], &data->te[1], &data->synteny, &unique[0], &unique[1],
+                                   &config->options) < 0) {
+        free_serve_data(data);
+        return NULL;
+    }
+    for (int g = 0; g < 2; g++) {
+        for (int i = 0; i < unique[g].count; i++) data->unique[g][unique[g].indices[i]] = 1;
+        free_te_selection(&unique[g]);
+    }
+    return data;
+}
+
+static void take_file_stamps(const ServeConfig* config, FileStamp stamps[3]) {
+    const char* files[3] = { config->synteny_file, config->te_file1, config->te_file2 };
+    for (int i = 0; i < 3; i++) {
+        struct stat st;
+        memset(&stamps[i], 0, sizeof(FileStamp));
+        if (stat(files[i], &st) != 0) continue;
+        stamps[i].exists = true;
+        stamps[i].size = st.st_size;
+        stamps[i].inode = st.st_ino;
+        stamps[i].mtime = st.st_mtim.tv_sec;
+        stamps[i].mtime_nsec = st.st_mtim.tv_nsec;
+    }
+}
+
+static bool same_file_stamps(const FileStamp a[3], const FileStamp b[3]) {
+    for (int i = 0; i < 3; i++) {
+        if (a[i].exists != b[i].exists || a[i].size != b[i].size || a[i].inode != b[i].inode ||
+            a[i].mtime != b[i].mtime || a[i].mtime_nsec != b[i].mtime_nsec) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 定期检查输入文件，变化后（连续两次检查状态相同，避免读到写了一半的文件）重新加载。
+// 新一代在不持锁时解析（使用自己的字符串表），只在替换指针时短暂持有写锁，
+// 上一代在没有查询引用后释放
+static void* watch_inputs(void* arg) {
+    ServeState* state = (ServeState*)arg;
+    FileStamp pending[3];
+    bool has_pending = false;
+    int elapsed_ms = 0;
+    
+    while (!serve_stop) {
+        struct timespec pause = { 0, 100 * 1000000L };
+        nanosleep(&pause, NULL);
+        elapsed_ms += 100;
+        if (elapsed_ms < state->config->reload_interval * 1000) continue;
+        elapsed_ms = 0;
+        
+        FileStamp now[3];
+        take_file_stamps(state->config, now);
+        if (same_file_stamps(now, state->stamps)) {
+            has_pending = false;
+            continue;
+        }
+        if (!has_pending || !same_file_stamps(now, pending)) {
+            memcpy(pending, now, sizeof(pending));
+            has_pending = true;
+            continue;
+        }
+        
+        printf("Input files changed, reloading...\n");
+        fflush(stdout);
+        // 只有本线程修改state->data，这里不加锁读取
+        ServeData* fresh = load_serve_data(state->config, state->data->generation + 1);
+        ServeData* retired = NULL;
+        if (fresh) {
+            pthread_rwlock_wrlock(&state->data_lock);
+            retired = state->data;
+            state->data = fresh;
+            pthread_rwlock_unlock(&state->data_lock);
+        }
+        // 写锁已经等到所有读锁释放，不再有查询引用上一代
+        free_serve_data(retired);
+        int generation = state->data->generation;
+        
+        if (fresh) {
+            printf("Reloaded inputs (generation %d)\n", generation);
+        } else {
+            fprintf(stderr, "Error: Reload failed, still serving generation %d\n", generation);
+        }
+        fflush(stdout);
+        memcpy(state->stamps, now, sizeof(now));
+        has_pending = false;
+    }
+    return NULL;
+}
+
+static void reply_error(OutputWriter* out, const char* message) {
+    output_writer_puts(out, "ERR ");
+    output_writer_puts(out, message);
+    output_writer_putc(out, '\n');
+}
+
+static void put_fraction(OutputWriter* out, double value) {
+    char text[32];
+    int len = snprintf(text, sizeof(text), "%.4f", value);
+    output_writer_write(out, text, (size_t)len);
+}
+
+// 回答一条查询（调用方持有读锁）：
+//   POINT <genome> <chr> <pos>            覆盖该位置的转座子
+//   REGION <genome> <chr> <start> <end>   与区间重叠的转座子
+//   SYNTENY <genome> <chr> <start> <end>  任意区间是否在共线性区域内
+//   STATS / PING
+// 成功时先写"OK <行数>"，再写各行结果；失败时写一行"ERR <原因>"
+static void answer_query(const ServeData* data, const CompareOptions* options, OutputWriter* out,
+                         StrSlice line, int** hits, int* capacity) {
+    StrSlice fields[6];
+    int count = split_whitespace(line, fields, 6);
+    if (count == 0) {
+        reply_error(out, "empty query");
+        return;
+    }
+    
+    if (count == 1 && slice_equals(fields[0], "PING")) {
+        output_writer_puts(out, "OK 0\n");
+        return;
+    }
+    if (count == 1 && slice_equals(fields[0], "STATS")) {
+        output_writer_puts(out, "OK 1\n");
+        output_writer_put_int(out, data->generation);
+        output_writer_putc(out, '\t');
+        output_writer_put_int(out, data->te[0].count);
+        output_writer_putc(out, '\t');
+        output_writer_put_int(out, data->te[1].count);
+        output_writer_putc(out, '\t');
+        output_writer_put_int(out, data->synteny.count);
+        output_writer_putc(out, '\n');
+        return;
+    }
+    
+    bool point = slice_equals(fields[0], "POINT");
+    bool region = slice_equals(fields[0], "REGION");
+    bool locus = slice_equals(fields[0], "SYNTENY");
+    if (!(point && count == 4) && !((region || locus) && count == 5)) {
+        reply_error(out, "unknown or malformed query");
+        return;
+    }
+    
+    int64_t genome = 0, start = 0, end = 0;
+    if (!parse_position(fields[1], &genome) || (genome != 1 && genome != 2)) {
+        reply_error(out, "genome must be 1 or 2");
+        return;
+    }
+    if (!parse_position(fields[3], &start) || !parse_position(fields[count - 1], &end) || start > end) {
+        reply_error(out, "invalid coordinates");
+        return;
+    }
+    
+    char chr_name[SERVE_MAX_LINE];
+    memcpy(chr_name, fields[2].ptr, fields[2].len);
+    chr_name[fields[2].len] = '\0';
+    int chr = string_table_find(data->synteny.strings, chr_name);
+    
+    if (locus) {
+        bool syntenic = is_syntenic(chr, start, end, &data->synteny, (int)genome, options, NULL);
+        output_writer_puts(out, "OK 1\n");
+        output_writer_puts(out, chr_name);
+        output_writer_putc(out, '\t');
+        output_writer_put_int(out, start);
+        output_writer_putc(out, '\t');
+        output_writer_put_int(out, end);
+        output_writer_puts(out, syntenic ? "\tsyntenic\t" : "\tunique\t");
+        put_fraction(out, synteny_coverage(chr, start, end, &data->synteny, (int)genome, NULL));
+        output_writer_putc(out, '\n');
+        return;
+    }
+    
+    // 结果按转座子在注释中的顺序输出
+    int g = (int)genome - 1;
+    int found = interval_tree_query(&data->trees[g], chr, start, end, hits, capacity);
+    if (found > 1) qsort(*hits, found, sizeof(int), compare_ints);
+    output_writer_puts(out, "OK ");
+    output_writer_put_int(out, found);
+    output_writer_putc(out, '\n');
+    for (int i = 0; i < found; i++) {
+        Transposon te;
+        te_list_get(&data->te[g], (*hits)[i], &te);
+        output_writer_puts(out, data->unique[g][(*hits)[i]] ? "unique\t" : "syntenic\t");
+        put_fraction(out, synteny_coverage(te.chr, te.start, te.end, &data->synteny, (int)genome, NULL));
+        output_writer_putc(out, '\t');
+        write_te_record(out, OUTPUT_TSV, data->te[g].strings, &te, -1.0);
+    }
+}
+
+static void remove_client(ServeState* state, int fd) {
+    pthread_mutex_lock(&state->clients_lock);
+    for (int i = 0; i < state->client_count; i++) {
+        if (state->client_fds[i] == fd) {
+            state->client_fds[i] = state->client_fds[--state->client_count];
+            break;
+        }
+    }
+    close(fd);
+    pthread_cond_broadcast(&state->clients_done);
+    pthread_mutex_unlock(&state->clients_lock);
+}
+
+// 每个客户端一个线程，顺序处理该连接上的请求。BATCH <n>之后的n行先全部读入，
+// 再在同一次读锁内依次回答，保证一个批次看到的是同一代数据
+static void* serve_client(void* arg) {
+    ClientArgs* args = (ClientArgs*)arg;
+    ServeState* state = args->state;
+    int fd = args->fd;
+    free(args);
+    
+    SocketReader* reader = (SocketReader*)safe_malloc(sizeof(SocketReader));
+    reader->fd = fd;
+    reader->start = 0;
+    reader->end = 0;
+    OutputWriter out;
+    output_writer_open_fd(&out, fd, SERVE_WRITE_BUFFER);
+    
+    int* hits = NULL;
+    int capacity = 0;
+    char* batch = NULL;
+    size_t batch_capacity = 0;
+    size_t* line_ends = NULL;
+    int line_capacity = 0;
+    
+    StrSlice line;
+    int status = 0;
+    while (!out.failed && (status = socket_reader_next(reader, &line)) > 0) {
+        StrSlice fields[3];
+        int count = split_whitespace(line, fields, 3);
+        if (count == 1 && slice_equals(fields[0], "QUIT")) break;
+        
+        if (count >= 1 && slice_equals(fields[0], "BATCH")) {
+            int64_t size = 0;
+            if (count != 2 || !parse_position(fields[1], &size) || size > SERVE_MAX_BATCH) {
+                reply_error(&out, "invalid batch size");
+                output_writer_flush(&out);
+                continue;
+            }
+            int n = (int)size;
+            
+            if (n > line_capacity) {
+                line_capacity = n;
+                line_ends = (size_t*)safe_realloc(line_ends, line_capacity * sizeof(size_t));
+            }
+            size_t batch_size = 0;
+            int received = 0;
+            while (received < n && (status = socket_reader_next(reader, &line)) > 0) {
+                if (batch_size + line.len > batch_capacity) {
+                    batch_capacity = (batch_size + line.len) * 2;
+                    batch = (char*)safe_realloc(batch, batch_capacity);
+                }
+                memcpy(batch + batch_size, line.ptr, line.len);
+                batch_size += line.len;
+                line_ends[received++] = batch_size;
+            }
+            if (received < n) break;
+            
+            pthread_rwlock_rdlock(&state->data_lock);
+            size_t begin = 0;
+            for (int i = 0; i < n; i++) {
+                StrSlice query = { batch + begin, line_ends[i] - begin };
+                answer_query(state->data, &state->config->options, &out, query, &hits, &capacity);
+                begin = line_ends[i];
+            }
+            pthread_rwlock_unlock(&state->data_lock);
+        } else {
+            pthread_rwlock_rdlock(&state->data_lock);
+            answer_query(state->data, &state->config->options, &out, line, &hits, &capacity);
+            pthread_rwlock_unlock(&state->data_lock);
+        }
+        output_writer_flush(&out);
+    }
+    // 过长的行无法再找到下一行的开头，报错后关闭连接
+    if (!out.failed && status == -2) reply_error(&out, "line too long");
+    
+    output_writer_close(&out);
+    free(reader);
+    free(hits);
+    free(batch);
+    free(line_ends);
+    remove_client(state, fd);
+    return NULL;
+}
+
+static bool fill_socket_address(struct sockaddr_un* addr, const char* path) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr->sun_path)) {
+        fprintf(stderr, "Error: Socket path too long: %s\n", path);
+        return false;
+    }
+    strcpy(addr->sun_path, path);
+    return true;
+}
+
+// 创建监听套接字。已存在的套接字文件有服务在监听时报错，否则视为上次异常退出遗留的文件
+static int open_listen_socket(const char* path) {
+    struct sockaddr_un addr;
+    if (!fill_socket_address(&addr, path)) return -1;
+    
+    struct stat st;
+    if (stat(path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            fprintf(stderr, "Error: %s exists and is not a socket\n", path);
+            return -1;
+        }
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (probe >= 0 && connect(probe, (struct sockaddr*)&addr, sizeof(addr)) == 0) {
+            close(probe);
+            fprintf(stderr, "Error: A server is already listening on %s\n", path);
+            return -1;
+        }
+        if (probe >= 0) close(probe);
+        unlink(path);
+    }
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 128) != 0) {
+        fprintf(stderr, "Error: Cannot listen on %s: %s\n", path, strerror(errno));
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 接受一个连接并为其启动线程
+static void accept_client(ServeState* state, int listen_fd) {
+    int fd = accept(listen_fd, NULL, NULL);
+    if (fd < 0) return;
+    
+    pthread_mutex_lock(&state->clients_lock);
+    bool full = state->client_count >= SERVE_MAX_CLIENTS;
+    if (!full) state->client_fds[state->client_count++] = fd;
+    pthread_mutex_unlock(&state->clients_lock);
+    if (full) {
+        static const char message[] = "ERR too many clients\n";
+        ssize_t ignored = write(fd, message, sizeof(message) - 1);
+        (void)ignored;
+        close(fd);
+        return;
+    }
+    
+    struct timeval timeout = { SERVE_SEND_TIMEOUT, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    
+    ClientArgs* args = (ClientArgs*)safe_malloc(sizeof(ClientArgs));
+    args->state = state;
+    args->fd = fd;
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, serve_client, args) != 0) {
+        free(args);
+        remove_client(state, fd);
+        return;
+    }
+    pthread_detach(thread);
+}
+
+// tevox serve：加载一次输入，在Unix域套接字上回答查询，直到收到SIGINT或SIGTERM
+int run_query_server(const ServeConfig* config) {
+    if (!config || !config->socket_path) return -1;
+    
+    ServeState state;
+    memset(&state, 0, sizeof(state));
+    state.config = config;
+    take_file_stamps(config, state.stamps);
+    state.data = load_serve_data(config, 1);
+    if (!state.data) return -1;
+    
+    int listen_fd = open_listen_socket(config->socket_path);
+    if (listen_fd < 0) {
+        free_serve_data(state.data);
+        return -1;
+    }
+    
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handle_stop_signal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+    
+    // 写者优先，持续的查询不会让重新加载一直等待
+    pthread_rwlockattr_t lock_attr;
+    pthread_rwlockattr_init(&lock_attr);
+    pthread_rwlockattr_setkind_np(&lock_attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+    pthread_rwlock_init(&state.data_lock, &lock_attr);
+    pthread_rwlockattr_destroy(&lock_attr);
+    pthread_mutex_init(&state.clients_lock, NULL);
+    pthread_cond_init(&state.clients_done, NULL);
+    
+    pthread_t watcher;
+    bool watching = config->reload_interval > 0 && pthread_create(&watcher, NULL, watch_inputs, &state) == 0;
+    
+    printf("Serving %d + %d transposons and %d synteny blocks on %s\n", state.data->te[0].count,
+           state.data->te[1].count, state.data->synteny.count, config->socket_path);
+    fflush(stdout);
+    
+    while (!serve_stop) {
+        struct pollfd pfd = { listen_fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 200) > 0 && (pfd.revents & POLLIN)) {
+            accept_client(&state, listen_fd);
+        }
+    }
+    
+    // 停止接受新连接，断开现有连接并等待客户端线程退出
+    close(listen_fd);
+    unlink(config->socket_path);
+    if (watching) pthread_join(watcher, NULL);
+    pthread_mutex_lock(&state.clients_lock);
+    for (int i = 0; i < state.client_count; i++) shutdown(state.client_fds[i], SHUT_RDWR);
+    while (state.client_count > 0) pthread_cond_wait(&state.clients_done, &state.clients_lock);
+    pthread_mutex_unlock(&state.clients_lock);
+    
+    free_serve_data(state.data);
+    pthread_rwlock_destroy(&state.data_lock);
+    pthread_mutex_destroy(&state.clients_lock);
+    pthread_cond_destroy(&state.clients_done);
+    printf("Server stopped\n");
+    return 0;
+}
+
+// 发送一批查询并把响应原样写到标准输出，返回出错的查询数，连接中断时返回-1
+static int send_query_batch(int fd, SocketReader* reader, OutputWriter* output, char** queries, int count) {
+    OutputWriter request;
+    output_writer_open_fd(&request, fd, SERVE_WRITE_BUFFER);
+    if (count > 1) {
+        output_writer_puts(&request, "BATCH ");
+        output_writer_put_int(&request, count);
+        output_writer_putc(&request, '\n');
+    }
+    for (int i = 0; i < count; i++) {
+        output_writer_puts(&request, queries[i]);
+        output_writer_putc(&request, '\n');
+    }
+    if (output_writer_close(&request) != 0) return -1;
+    
+    int errors = 0;
+    for (int i = 0; i < count; i++) {
+        StrSlice line;
+        if (socket_reader_next(reader, &line) <= 0) return -1;
+        output_writer_write(output, line.ptr, line.len);
+        output_writer_putc(output, '\n');
+        
+        int rows = 0;
+        if (line.len > 3 && memcmp(line.ptr, "OK ", 3) == 0) {
+            StrSlice number = { line.ptr + 3, line.len - 3 };
+            rows = slice_to_int(number);
+        } else {
+            errors++;
+        }
+        for (int r = 0; r < rows; r++) {
+            if (socket_reader_next(reader, &line) <= 0) return -1;
+            output_writer_write(output, line.ptr, line.len);
+            output_writer_putc(output, '\n');
+        }
+    }
+    return errors;
+}
+
+// tevox query：查询来自参数，没有参数时从标准输入逐行读取；按批发送，响应原样输出
+int run_query_client(const char* socket_path, char** queries, int query_count) {
+    struct sockaddr_un addr;
+    if (!fill_socket_address(&addr, socket_path)) return -1;
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "Error: Cannot connect to %s (is 'tevox serve' running?)\n", socket_path);
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    
+    SocketReader* reader = (SocketReader*)safe_malloc(sizeof(SocketReader));
+    reader->fd = fd;
+    reader->start = 0;
+    reader->end = 0;
+    OutputWriter output;
+    output_writer_open(&output, "-");
+    
+    char** batch = (char**)safe_malloc(CLIENT_BATCH_SIZE * sizeof(char*));
+    int batch_count = 0;
+    int errors = 0;
+    bool broken = false;
+    char* line = NULL;
+    size_t line_capacity = 0;
+    int next = 0;
+    
+    for (;;) {
+        // 取下一条查询，跳过空行
+        char* query = NULL;
+        if (query_count > 0) {
+            if (next < query_count) query = strdup_safe(queries[next++]);
+        } else {
+            ssize_t len;
+            while (!query && (len = getline(&line, &line_capacity, stdin)) >= 0) {
+                while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) line[--len] = '\0';
+                if (len > 0) query = strdup_safe(line);
+            }
+        }
+        
+        if (query) {
+            StrSlice fields[2];
+            StrSlice text = { query, strlen(query) };
+            int count = split_whitespace(text, fields, 2);
+            if (count == 0 || slice_equals(fields[0], "BATCH") || slice_equals(fields[0], "QUIT") ||
+                strlen(query) >= SERVE_MAX_LINE) {
+                fprintf(stderr, "Error: Invalid query: %s\n", query);
+                free(query);
+                errors++;
+                continue;
+            }
+            batch[batch_count++] = query;
+            if (batch_count < CLIENT_BATCH_SIZE) continue;
+        }
+        if (batch_count == 0) break;
+        
+        int failed = send_query_batch(fd, reader, &output, batch, batch_count);
+        for (int i = 0; i < batch_count; i++) free(batch[i]);
+        batch_count = 0;
+        if (failed < 0) {
+            fprintf(stderr, "Error: Connection to %s lost\n", socket_path);
+            broken = true;
+            break;
+        }
+        errors += failed;
+        if (!query) break;
+    }
+    
+    if (!broken) {
+        static const char quit[] = "QUIT\n";
+        ssize_t ignored = write(fd, quit, sizeof(quit) - 1);
+        (void)ignored;
+    }
+    for (int i = 0; i < batch_count; i++) free(batch[i]);
+    free(batch);
+    free(line);
+    free(reader);
+    close(fd);
+    if (output_writer_close(&output) != 0) broken = true;
+    return broken || errors > 0 ? -1 : 0;
+}
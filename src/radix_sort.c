@@ -0,0 +1,479 @@
+#include "te_comparator.h"
+
+// 按(染色体ID, 起点, 终点)排序：三个字段减去各自的最小值后按位宽拼成64位键，
+// 用基数排序（每轮11位）对(键, 下标)稳定排序：键多时先按最高的11位分桶，桶内在缓存中
+// 做LSD。全部键相同的位不参与排序，
+// 超过64位时拆成多个键，从低位字段开始依次排序。结果是一个排列，不移动记录本身
+
+#define RADIX_BITS 11
+#define RADIX_SIZE (1 << RADIX_BITS)
+// 每个线程至少处理的键数，太少时线程开销超过收益
+#define RADIX_MIN_PART 65536
+// 单线程在缓存中直接做LSD的区段上限
+#define RADIX_LOCAL 65536
+
+// 一轮基数排序的共享状态：每个线程负责输入中连续的一段
+typedef struct {
+    const uint64_t* keys;
+    const int* values;
+    uint64_t* keys_out;
+    int* values_out;
+    int n;
+    int parts;
+    int shift;
+    size_t* counts;         // counts[part * RADIX_SIZE + digit]，计数后改为写入位置
+} RadixPass;
+
+// 参与排序的字段，value为减去最小值后的值
+typedef struct {
+    const int* ints;
+    const int64_t* int64s;
+    const int64_t* minus;   // 非NULL时字段值为int64s[i] - minus[i]（区间长度）
+    int64_t min;
+    int bits;
+} KeyField;
+
+static void part_range(const RadixPass* pass, int part, int* begin, int* end) {
+    *begin = (int)((long long)pass->n * part / pass->parts);
+    *end = (int)((long long)pass->n * (part + 1) / pass->parts);
+}
+
+static void radix_count(void* ctx, int part) {
+    RadixPass* pass = (RadixPass*)ctx;
+    size_t* counts = pass->counts + (size_t)part * RADIX_SIZE;
+    int begin, end;
+    part_range(pass, part, &begin, &end);
+    
+    memset(counts, 0, RADIX_SIZE * sizeof(size_t));
+    for (int i = begin; i < end; i++) {
+        counts[(pass->keys[i] >> pass->shift) & (RADIX_SIZE - 1)]++;
+    }
+}
+
+// 各线程按输入顺序写入自己的位置区间，因此排序是稳定的
+static void radix_scatter(void* ctx, int part) {
+    RadixPass* pass = (RadixPass*)ctx;
+    size_t* offsets = pass->counts + (size_t)part * RADIX_SIZE;
+    int begin, end;
+    part_range(pass, part, &begin, &end);
+    
+    for (int i = begin; i < end; i++) {
+        size_t pos = offsets[(pass->keys[i] >> pass->shift) & (RADIX_SIZE - 1)]++;
+        pass->keys_out[pos] = pass->keys[i];
+        pass->values_out[pos] = pass->values[i];
+    }
+}
+
+// 单线程对一段键做LSD排序，只看[low, high)中的位。返回true表示结果在key_tmp/value_tmp中
+static bool sort_range_lsd(uint64_t* keys, int* values, uint64_t* key_tmp, int* value_tmp, int n,
+                           int low, int high) {
+    size_t counts[RADIX_SIZE];
+    uint64_t* key_in = keys;
+    int* value_in = values;
+    uint64_t* key_out = key_tmp;
+    int* value_out = value_tmp;
+    for (int shift = low; shift < high; shift += RADIX_BITS) {
+        memset(counts, 0, sizeof(counts));
+        for (int i = 0; i < n; i++) counts[(key_in[i] >> shift) & (RADIX_SIZE - 1)]++;
+        
+        // 这一段位全部相同时跳过
+        size_t offset = 0;
+        bool single = false;
+        for (int d = 0; d < RADIX_SIZE; d++) {
+            size_t count = counts[d];
+            if (count == (size_t)n) single = true;
+            counts[d] = offset;
+            offset += count;
+        }
+        if (single) continue;
+        
+        for (int i = 0; i < n; i++) {
+            size_t pos = counts[(key_in[i] >> shift) & (RADIX_SIZE - 1)]++;
+            key_out[pos] = key_in[i];
+            value_out[pos] = value_in[i];
+        }
+        uint64_t* key_swap = key_in;
+        key_in = key_out;
+        key_out = key_swap;
+        int* value_swap = value_in;
+        value_in = value_out;
+        value_out = value_swap;
+    }
+    return key_in != keys;
+}
+
+// 单线程排序一段键：大的区段先按最高一段位稳定分桶，直到每个桶能放进缓存，
+// 桶内再做LSD。这样大数组只需一两次经过内存，其余各轮都在缓存中完成。
+// 返回true表示结果在key_tmp/value_tmp中
+static bool sort_range(uint64_t* keys, int* values, uint64_t* key_tmp, int* value_tmp, int n,
+                       int low, int high) {
+    if (n < 2 || high <= low) return false;
+    if (n <= RADIX_LOCAL || high - low <= 2 * RADIX_BITS) {
+        return sort_range_lsd(keys, values, key_tmp, value_tmp, n, low, high);
+    }
+    
+    int shift = high - RADIX_BITS;
+    size_t starts[RADIX_SIZE + 1];
+    size_t offsets[RADIX_SIZE];
+    memset(offsets, 0, sizeof(offsets));
+    for (int i = 0; i < n; i++) offsets[(keys[i] >> shift) & (RADIX_SIZE - 1)]++;
+    size_t offset = 0;
+    for (int d = 0; d < RADIX_SIZE; d++) {
+        starts[d] = offset;
+        offset += offsets[d];
+        offsets[d] = starts[d];
+    }
+    starts[RADIX_SIZE] = offset;
+    
+    for (int i = 0; i < n; i++) {
+        size_t pos = offsets[(keys[i] >> shift) & (RADIX_SIZE - 1)]++;
+        key_tmp[pos] = keys[i];
+        value_tmp[pos] = values[i];
+    }
+    
+    // 分桶结果在临时区，桶排好后不在keys中的复制回来，此时数据仍在缓存中
+    for (int d = 0; d < RADIX_SIZE; d++) {
+        size_t begin = starts[d];
+        int count = (int)(starts[d + 1] - begin);
+        if (count > 0 && !sort_range(key_tmp + begin, value_tmp + begin, keys + begin, values + begin,
+                                     count, low, shift)) {
+            memcpy(keys + begin, key_tmp + begin, (size_t)count * sizeof(uint64_t));
+            memcpy(values + begin, value_tmp + begin, (size_t)count * sizeof(int));
+        }
+    }
+    return false;
+}
+
+// 按最高一段位分桶之后，各桶作为独立任务排序
+typedef struct {
+    uint64_t* keys;
+    int* values;
+    uint64_t* key_tmp;
+    int* value_tmp;
+    const size_t* starts;   // 各桶在分桶结果中的起点，共RADIX_SIZE+1项
+    int low;
+    int high;
+} RadixBuckets;
+
+static void radix_sort_bucket(void* ctx, int bucket) {
+    RadixBuckets* job = (RadixBuckets*)ctx;
+    size_t begin = job->starts[bucket];
+    int count = (int)(job->starts[bucket + 1] - begin);
+    if (count == 0) return;
+    
+    // 分桶结果在key_tmp中，原数组的对应区段作为临时区
+    if (!sort_range(job->key_tmp + begin, job->value_tmp + begin, job->keys + begin, job->values + begin,
+                    count, job->low, job->high)) {
+        memcpy(job->keys + begin, job->key_tmp + begin, (size_t)count * sizeof(uint64_t));
+        memcpy(job->values + begin, job->value_tmp + begin, (size_t)count * sizeof(int));
+    }
+}
+
+// 对keys[0..n)稳定排序，values随键移动。键多且变化的位多时先多线程按最高一段位分桶，
+// 各桶再并行地在缓存中排序；否则整体做多线程LSD
+void radix_sort_pairs(uint64_t* keys, int* values, int n, int num_threads) {
+    if (n < 2) return;
+    
+    // 所有键都相同的位无需排序
+    uint64_t varying = 0;
+    for (int i = 1; i < n; i++) varying |= keys[i] ^ keys[0];
+    if (varying == 0) return;
+    int low = __builtin_ctzll(varying);
+    int high = 64 - __builtin_clzll(varying);
+    
+    int parts = resolve_thread_count(num_threads);
+    if (parts > n / RADIX_MIN_PART) parts = n / RADIX_MIN_PART;
+    if (parts < 1) parts = 1;
+    
+    RadixPass pass;
+    pass.n = n;
+    pass.parts = parts;
+    pass.counts = (size_t*)safe_malloc((size_t)parts * RADIX_SIZE * sizeof(size_t));
+    uint64_t* key_buffer = (uint64_t*)safe_malloc((size_t)n * sizeof(uint64_t));
+    int* value_buffer = (int*)safe_malloc((size_t)n * sizeof(int));
+    
+    uint64_t* key_in = keys;
+    int* value_in = values;
+    uint64_t* key_out = key_buffer;
+    int* value_out = value_buffer;
+    bool buckets = n > RADIX_LOCAL && high - low > 2 * RADIX_BITS;
+    size_t starts[RADIX_SIZE + 1];
+    for (int shift = buckets ? high - RADIX_BITS : 0; shift < 64; shift += RADIX_BITS) {
+        if (((varying >> shift) & (RADIX_SIZE - 1)) == 0) continue;
+        
+        pass.keys = key_in;
+        pass.values = value_in;
+        pass.keys_out = key_out;
+        pass.values_out = value_out;
+        pass.shift = shift;
+        parallel_for(parts, parts, radix_count, &pass);
+        
+        // 把计数换算成每个(数字, 线程)的起始位置：数字优先，同一数字内按线程顺序
+        size_t offset = 0;
+        for (int d = 0; d < RADIX_SIZE; d++) {
+            starts[d] = offset;
+            for (int p = 0; p < parts; p++) {
+                size_t count = pass.counts[(size_t)p * RADIX_SIZE + d];
+                pass.counts[(size_t)p * RADIX_SIZE + d] = offset;
+                offset += count;
+            }
+        }
+        parallel_for(parts, parts, radix_scatter, &pass);
+        
+        
+        if (buckets) {
+            starts[RADIX_SIZE] = (size_t)n;
+            RadixBuckets job = { keys, values, key_buffer, value_buffer, starts, low, shift };
+            parallel_for(RADIX_SIZE, parts, radix_sort_bucket, &job);
+            break;
+        }
+        
+        uint64_t* key_swap = key_in;
+        key_in = key_out;
+        key_out = key_swap;
+        int* value_swap = value_in;
+        value_in = value_out;
+        value_out = value_swap;
+    }
+    
+    // 结果在临时缓冲区时复制回去
+    if (key_in != keys) {
+        memcpy(keys, key_in, (size_t)n * sizeof(uint64_t));
+        memcpy(values, value_in, (size_t)n * sizeof(int));
+    }
+    free(key_buffer);
+    free(value_buffer);
+    free(pass.counts);
+}
+
+static int64_t field_value(const KeyField* field, int i) {
+    if (field->ints) return field->ints[i];
+    return field->minus ? field->int64s[i] - field->minus[i] : field->int64s[i];
+}
+
+// 统计字段的最小值和表示范围所需的位数
+static void measure_field(KeyField* field, int n) {
+    int64_t min = n > 0 ? field_value(field, 0) : 0;
+    int64_t max = min;
+    for (int i = 1; i < n; i++) {
+        int64_t value = field_value(field, i);
+        if (value < min) min = value;
+        if (value > max) max = value;
+    }
+    uint64_t range = (uint64_t)max - (uint64_t)min;
+    field->min = min;
+    field->bits = range ? 64 - __builtin_clzll(range) : 0;
+}
+
+// 判断记录是否已按(染色体ID, 起点, 终点)升序排列
+bool is_sorted_by_position(const int* chrs, const int64_t* starts, const int64_t* ends, int n) {
+    for (int i = 1; i < n; i++) {
+        if (chrs[i] != chrs[i - 1]) {
+            if (chrs[i] < chrs[i - 1]) return false;
+        } else if (starts[i] != starts[i - 1]) {
+            if (starts[i] < starts[i - 1]) return false;
+        } else if (ends[i] < ends[i - 1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 返回按(染色体ID, 起点, 终点)升序排列后各位置对应的原下标，相同的记录保持原顺序。
+// 起点相同时按区间长度比较与按终点比较等价，而长度通常只需要很少的位
+int* sort_order_by_position(const int* chrs, const int64_t* starts, const int64_t* ends, int n,
+                            int num_threads) {
+    int* order = (int*)safe_malloc((n > 0 ? n : 1) * sizeof(int));
+    for (int i = 0; i < n; i++) order[i] = i;
+    if (n < 2 || is_sorted_by_position(chrs, starts, ends, n)) return order;
+    
+    // 从最高位到最低位的字段
+    KeyField fields[3] = {
+        { chrs, NULL, NULL, 0, 0 },
+        { NULL, starts, NULL, 0, 0 },
+        { NULL, ends, starts, 0, 0 }
+    };
+    for (int f = 0; f < 3; f++) measure_field(&fields[f], n);
+    
+    // 从最低位字段开始，把尽量多的相邻字段拼成一个64位键，每个键做一次稳定排序
+    uint64_t* keys = (uint64_t*)safe_malloc((size_t)n * sizeof(uint64_t));
+    int last = 2;
+    while (last >= 0) {
+        int first = last;
+        int bits = fields[last].bits;
+        while (first > 0 && bits + fields[first - 1].bits <= 64) {
+            first--;
+            bits += fields[first].bits;
+        }
+        
+        for (int k = 0; k < n; k++) {
+            uint64_t key = 0;
+            for (int f = first; f <= last; f++) {
+                uint64_t value = (uint64_t)field_value(&fields[f], order[k]) - (uint64_t)fields[f].min;
+                key = fields[f].bits < 64 ? (key << fields[f].bits) | value : value;
+            }
+            keys[k] = key;
+        }
+        radix_sort_pairs(keys, order, n, num_threads);
+        last = first - 1;
+    }
+    
+    free(keys);
+    return order;
+}
+
+// 按排列移动一列：out[k] = in[order[k]]
+typedef struct {
+    void** column;
+    size_t size;
+} PermuteColumn;
+
+typedef struct {
+    const TEList* te_list;      // 列所属的列表，位于其缓存映射中的旧列不释放
+    PermuteColumn* columns;
+    const int* order;
+    int n;
+} PermuteJob;
+
+static void run_permute_task(void* ctx, int task) {
+    PermuteJob* job = (PermuteJob*)ctx;
+    PermuteColumn* column = &job->columns[task];
+    if (!*column->column) return;
+    
+    const char* in = (const char*)*column->column;
+    char* out = (char*)safe_malloc((job->n > 0 ? job->n : 1) * column->size);
+    const int* order = job->order;
+    
+    // 元素大小为常量时memcpy编译为一次读写
+    if (column->size == 8) {
+        for (int k = 0; k < job->n; k++) memcpy(out + (size_t)k * 8, in + (size_t)order[k] * 8, 8);
+    } else {
+        for (int k = 0; k < job->n; k++) memcpy(out + (size_t)k * 4, in + (size_t)order[k] * 4, 4);
+    }
+    if (!te_list_column_mapped(job->te_list, in)) free(*column->column);
+    *column->column = out;
+}
+
+// 各列互不相关，每列一个并行任务
+static void permute_columns(const TEList* te_list, PermuteColumn* columns, int column_count, const int* order,
+                            int n, int num_threads) {
+    PermuteJob job = { te_list, columns, order, n };
+    parallel_for(column_count, num_threads, run_permute_task, &job);
+}
+
+static int te_list_columns(TEList* te_list, PermuteColumn* columns) {
+    PermuteColumn list[] = {
+        { (void**)&te_list->chrs, sizeof(int) },
+        { (void**)&te_list->starts, sizeof(int64_t) },
+        { (void**)&te_list->ends, sizeof(int64_t) },
+        { (void**)&te_list->strands, sizeof(int) },
+        { (void**)&te_list->types, sizeof(int) },
+        { (void**)&te_list->families, sizeof(int) },
+        { (void**)&te_list->sources, sizeof(int) },
+        { (void**)&te_list->ids, sizeof(char*) },
+        { (void**)&te_list->names, sizeof(char*) },
+        { (void**)&te_list->attributes, sizeof(char*) },
+        { (void**)&te_list->input_order, sizeof(int) }
+    };
+    int count = (int)(sizeof(list) / sizeof(list[0]));
+    memcpy(columns, list, sizeof(list));
+    return count;
+}
+
+// 按(染色体ID, 起点, 终点)重排转座子列表的所有列。input_order记录每条记录在原注释中的
+// 下标，restore_te_list_order据此恢复原顺序
+void sort_te_list(TEList* te_list, int num_threads) {
+    if (!te_list) return;
+    
+    int n = te_list->count;
+    if (!te_list->input_order) {
+        te_list->input_order = (int*)safe_malloc((te_list->capacity > 0 ? te_list->capacity : 1) * sizeof(int));
+        for (int i = 0; i < n; i++) te_list->input_order[i] = i;
+    }
+    if (is_sorted_by_position(te_list->chrs, te_list->starts, te_list->ends, n)) return;
+    
+    int* order = sort_order_by_position(te_list->chrs, te_list->starts, te_list->ends, n, num_threads);
+    PermuteColumn columns[16];
+    int column_count = te_list_columns(te_list, columns);
+    permute_columns(te_list, columns, column_count, order, n, num_threads);
+    te_list->capacity = n;
+    free(order);
+}
+
+// 恢复sort_te_list之前的记录顺序。selection非NULL时其下标（指向本列表）一起换算，
+// 仍保持升序，因此排序后得到的比较结果可以按输入顺序输出
+void restore_te_list_order(TEList* te_list, TESelection* selection, int num_threads) {
+    if (!te_list || !te_list->input_order) return;
+    
+    int n = te_list->count;
+    int* input_order = te_list->input_order;
+    te_list->input_order = NULL;
+    
+    // input_order的逆排列：原第i条记录现在的位置
+    int* order = (int*)safe_malloc((n > 0 ? n : 1) * sizeof(int));
+    for (int k = 0; k < n; k++) order[input_order[k]] = k;
+    
+    PermuteColumn columns[16];
+    int column_count = te_list_columns(te_list, columns) - 1;
+    permute_columns(te_list, columns, column_count, order, n, num_threads);
+    te_list->capacity = n;
+    free(order);
+    
+    if (selection && selection->source == te_list && selection->count > 0) {
+        bool* selected = (bool*)safe_malloc(n * sizeof(bool));
+        memset(selected, 0, n * sizeof(bool));
+        for (int j = 0; j < selection->count; j++) selected[input_order[selection->indices[j]]] = true;
+        int count = 0;
+        for (int i = 0; i < n; i++) {
+            if (selected[i]) selection->indices[count++] = i;
+        }
+        free(selected);
+    }
+    free(input_order);
+}
+
+// 按chr1侧的(染色体ID, 起点, 终点)重排共线性区块，input_order记录原顺序
+void sort_synteny_list(SyntenyList* synteny_list, int num_threads) {
+    if (!synteny_list) return;
+    
+    int n = synteny_list->count;
+    int* chrs = (int*)safe_malloc((n > 0 ? n : 1) * sizeof(int));
+    int64_t* starts = (int64_t*)safe_malloc((n > 0 ? n : 1) * sizeof(int64_t));
+    int64_t* ends = (int64_t*)safe_malloc((n > 0 ? n : 1) * sizeof(int64_t));
+    for (int i = 0; i < n; i++) {
+        chrs[i] = synteny_list->blocks[i].chr1;
+        starts[i] = synteny_list->blocks[i].start1;
+        ends[i] = synteny_list->blocks[i].end1;
+    }
+    int* order = sort_order_by_position(chrs, starts, ends, n, num_threads);
+    free(chrs);
+    free(starts);
+    free(ends);
+    
+    SyntenyBlock* blocks = (SyntenyBlock*)safe_malloc((n > 0 ? n : 1) * sizeof(SyntenyBlock));
+    int* input_order = (int*)safe_malloc((n > 0 ? n : 1) * sizeof(int));
+    for (int k = 0; k < n; k++) {
+        blocks[k] = synteny_list->blocks[order[k]];
+        input_order[k] = synteny_list->input_order ? synteny_list->input_order[order[k]] : order[k];
+    }
+    free(order);
+    free(synteny_list->blocks);
+    free(synteny_list->input_order);
+    synteny_list->blocks = blocks;
+    synteny_list->input_order = input_order;
+    synteny_list->capacity = n > 0 ? n : 1;
+}
+
+// 恢复sort_synteny_list之前的区块顺序（查询索引只含合并后的区间，与区块顺序无关）
+void restore_synteny_list_order(SyntenyList* synteny_list) {
+    if (!synteny_list || !synteny_list->input_order) return;
+    
+    int n = synteny_list->count;
+    SyntenyBlock* blocks = (SyntenyBlock*)safe_malloc((n > 0 ? n : 1) * sizeof(SyntenyBlock));
+    for (int k = 0; k < n; k++) blocks[synteny_list->input_order[k]] = synteny_list->blocks[k];
+    free(synteny_list->blocks);
+    free(synteny_list->input_order);
+    synteny_list->blocks = blocks;
+    synteny_list->input_order = NULL;
+    synteny_list->capacity = n > 0 ? n : 1;
+}
@@ -0,0 +1,701 @@
+#include "te_comparator.h"
+#include <fcntl.h>
+#include <unistd.h>
+
+// tabix索引的默认分箱参数（CSI在文件头中给出）
+#define TBI_MIN_SHIFT 14
+#define TBI_DEPTH 5
+
+// 索引中的一段数据：[begin, end)两个BGZF虚拟偏移
+typedef struct {
+    uint64_t begin;
+    uint64_t end;
+} IndexChunk;
+
+typedef struct {
+    uint32_t bin;
+    uint64_t loffset;        // CSI：分箱内第一条记录的虚拟偏移
+    IndexChunk* chunks;
+    int chunk_count;
+} IndexBin;
+
+// 单条序列的索引：分箱按编号排序，tabix另有16kb窗口的线性索引
+typedef struct {
+    IndexBin* bins;
+    int bin_count;
+    uint64_t* linear;
+    int linear_count;
+} IndexRef;
+
+typedef struct {
+    bool csi;
+    int min_shift;
+    int depth;
+    int ref_count;
+    const char** names;      // 指向data中以'\0'分隔的序列名
+    IndexRef* refs;
+    unsigned char* data;     // 解压后的索引文件
+} TabixIndex;
+
+// 小端字节流读取，越界时置error
+typedef struct {
+    const unsigned char* data;
+    size_t size;
+    size_t pos;
+    bool error;
+} ByteCursor;
+
+static const unsigned char* cursor_take(ByteCursor* cursor, size_t n) {
+    if (cursor->error || cursor->size - cursor->pos < n) {
+        cursor->error = true;
+        return NULL;
+    }
+    const unsigned char* p = cursor->data + cursor->pos;
+    cursor->pos += n;
+    return p;
+}
+
+static uint32_t cursor_u32(ByteCursor* cursor) {
+    const unsigned char* p = cursor_take(cursor, 4);
+    if (!p) return 0;
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t cursor_u64(ByteCursor* cursor) {
+    uint64_t low = cursor_u32(cursor);
+    uint64_t high = cursor_u32(cursor);
+    return low | (high << 32);
+}
+
+// 读取非负计数，超出剩余数据所能容纳的数量时视为损坏
+static int cursor_count(ByteCursor* cursor, size_t item_size) {
+    int32_t n = (int32_t)cursor_u32(cursor);
+    if (n < 0 || (size_t)n > (cursor->size - cursor->pos) / item_size) {
+        cursor->error = true;
+        return 0;
+    }
+    return n;
+}
+
+// 初始化区间列表
+void init_region_list(RegionList* list) {
+    list->regions = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+// 添加区间（复制染色体名）
+void add_region(RegionList* list, const char* chr, int64_t start, int64_t end) {
+    if (list->count >= list->capacity) {
+        list->capacity = list->capacity == 0 ? 8 : list->capacity * 2;
+        list->regions = (GenomicRegion*)safe_realloc(list->regions,
+                                                     list->capacity * sizeof(GenomicRegion));
+    }
+    
+    GenomicRegion* region = &list->regions[list->count++];
+    region->chr = strdup_safe(chr);
+    region->start = start;
+    region->end = end;
+    region->strand = NULL;
+}
+
+// 解析单个区间：chr、chr:start或chr:start-end（1-based闭区间）
+static int parse_region(const char* spec, size_t len, RegionList* list) {
+    if (len == 0) return -1;
+    
+    char* text = (char*)safe_malloc(len + 1);
+    memcpy(text, spec, len);
+    text[len] = '\0';
+    
+    int64_t start = 1;
+    int64_t end = MAX_POSITION;
+    
+    // 最后一个':'之后是坐标；不是数字时整体作为染色体名
+    char* colon = strrchr(text, ':');
+    if (colon && colon != text) {
+        char* p = colon + 1;
+        char* stop = NULL;
+        long long value = strtoll(p, &stop, 10);
+        if (stop != p) {
+            if (value < 1 || value > MAX_POSITION) {
+                free(text);
+                return -1;
+            }
+            start = value;
+            
+            if (*stop == '-') {
+                p = stop + 1;
+                value = strtoll(p, &stop, 10);
+                if (stop == p || value < start || value > MAX_POSITION) {
+                    free(text);
+                    return -1;
+                }
+                end = value;
+            }
+            if (*stop != '\0') {
+                free(text);
+                return -1;
+            }
+            *colon = '\0';
+        }
+    }
+    
+    add_region(list, text, start, end);
+    free(text);
+    return 0;
+}
+
+// 解析以逗号分隔的区间列表，结果已规范化
+int parse_region_list(const char* spec, RegionList* list) {
+    init_region_list(list);
+    if (!spec) return -1;
+    
+    const char* p = spec;
+    while (true) {
+        const char* comma = strchr(p, ',');
+        size_t len = comma ? (size_t)(comma - p) : strlen(p);
+        if (parse_region(p, len, list) != 0) {
+            free_region_list(list);
+            return -1;
+        }
+        if (!comma) break;
+        p = comma + 1;
+    }
+    
+    normalize_region_list(list);
+    return list->count;
+}
+
+static int compare_regions(const void* a, const void* b) {
+    const GenomicRegion* ra = (const GenomicRegion*)a;
+    const GenomicRegion* rb = (const GenomicRegion*)b;
+    int c = strcmp(ra->chr, rb->chr);
+    if (c != 0) return c;
+    if (ra->start != rb->start) return ra->start < rb->start ? -1 : 1;
+    return 0;
+}
+
+// 按染色体名和起点排序，合并重叠或相邻的区间
+void normalize_region_list(RegionList* list) {
+    if (list->count <= 1) return;
+    
+    qsort(list->regions, list->count, sizeof(GenomicRegion), compare_regions);
+    
+    int merged = 0;
+    for (int i = 1; i < list->count; i++) {
+        GenomicRegion* last = &list->regions[merged];
+        GenomicRegion* current = &list->regions[i];
+        if (strcmp(last->chr, current->chr) == 0 &&
+            current->start <= last->end + 1) {
+            if (current->end > last->end) last->end = current->end;
+            free(current->chr);
+        } else {
+            list->regions[++merged] = *current;
+        }
+    }
+    list->count = merged + 1;
+}
+
+// 在规范化的列表中查找与[start, end]重叠的第一个区间，返回下标，没有时返回-1
+int region_list_find(const RegionList* list, const char* chr, int64_t start, int64_t end) {
+    if (!list || !chr) return -1;
+    
+    // 二分查找第一个(染色体, 终点)不小于(chr, start)的区间
+    int lo = 0, hi = list->count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        const GenomicRegion* region = &list->regions[mid];
+        int c = strcmp(region->chr, chr);
+        if (c < 0 || (c == 0 && region->end < start)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    
+    if (lo < list->count && strcmp(list->regions[lo].chr, chr) == 0 &&
+        list->regions[lo].start <= end) {
+        return lo;
+    }
+    return -1;
+}
+
+// 把一侧基因组上的区间经共线性区块线性映射到另一侧。
+// 每个区间在每条目标染色体上取所有映射结果的外包区间，以便包含区块之间的插入
+int project_regions_through_synteny(const RegionList* regions, SyntenyList* synteny,
+                                    int genome_id, RegionList* projected) {
+    init_region_list(projected);
+    if (!regions || !synteny) return -1;
+    
+    for (int r = 0; r < regions->count; r++) {
+        const GenomicRegion* region = &regions->regions[r];
+        int chr = string_table_find(synteny->strings, region->chr);
+        if (chr == STR_NONE) continue;
+        
+        RegionList pieces;
+        init_region_list(&pieces);
+        
+        for (int i = 0; i < synteny->count; i++) {
+            SyntenyBlock* block = &synteny->blocks[i];
+            int from_chr = genome_id == 1 ? block->chr1 : block->chr2;
+            int64_t from_start = genome_id == 1 ? block->start1 : block->start2;
+            int64_t from_end = genome_id == 1 ? block->end1 : block->end2;
+            int to_chr = genome_id == 1 ? block->chr2 : block->chr1;
+            
+            if (from_chr != chr || from_end < region->start || from_start > region->end) continue;
+            
+            int64_t a = region->start > from_start ? region->start : from_start;
+            int64_t b = region->end < from_end ? region->end : from_end;
+            
+            // 区块内线性插值
+            int64_t mapped_start = genome_id == 1 ? block->start2 : block->start1;
+            int64_t mapped_end = genome_id == 1 ? block->end2 : block->end1;
+            if (from_end > from_start) {
+                mapped_start = map_through_synteny_block(block, genome_id, a);
+                mapped_end = map_through_synteny_block(block, genome_id, b);
+            }
+            
+            add_region(&pieces, string_table_get(synteny->strings, to_chr), mapped_start, mapped_end);
+        }
+        
+        normalize_region_list(&pieces);
+        for (int i = 0; i < pieces.count; ) {
+            int j = i;
+            int64_t end = pieces.regions[i].end;
+            while (j + 1 < pieces.count && strcmp(pieces.regions[j + 1].chr, pieces.regions[i].chr) == 0) {
+                j++;
+                if (pieces.regions[j].end > end) end = pieces.regions[j].end;
+            }
+            add_region(projected, pieces.regions[i].chr, pieces.regions[i].start, end);
+            i = j + 1;
+        }
+        free_region_list(&pieces);
+    }
+    
+    normalize_region_list(projected);
+    return projected->count;
+}
+
+// 释放区间列表
+void free_region_list(RegionList* list) {
+    if (!list) return;
+    
+    for (int i = 0; i < list->count; i++) {
+        free(list->regions[i].chr);
+    }
+    free(list->regions);
+    init_region_list(list);
+}
+
+static int compare_bins(const void* a, const void* b) {
+    uint32_t x = ((const IndexBin*)a)->bin;
+    uint32_t y = ((const IndexBin*)b)->bin;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static void free_tabix_index(TabixIndex* index) {
+    for (int i = 0; index->refs && i < index->ref_count; i++) {
+        IndexRef* ref = &index->refs[i];
+        for (int j = 0; j < ref->bin_count; j++) {
+            free(ref->bins[j].chunks);
+        }
+        free(ref->bins);
+        free(ref->linear);
+    }
+    free(index->refs);
+    free(index->names);
+    free(index->data);
+    memset(index, 0, sizeof(TabixIndex));
+}
+
+// 读取整个BGZF压缩的索引文件
+static unsigned char* read_index_file(const char* filename, size_t* size) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return NULL;
+    
+    InflateStream* stream = inflate_stream_open(fd, NULL, 0, 1);
+    if (!stream) {
+        close(fd);
+        return NULL;
+    }
+    
+    size_t capacity = 1 << 16;
+    size_t used = 0;
+    unsigned char* data = (unsigned char*)safe_malloc(capacity);
+    while (true) {
+        if (capacity - used < (1 << 15)) {
+            capacity *= 2;
+            data = (unsigned char*)safe_realloc(data, capacity);
+        }
+        size_t n = inflate_stream_read(stream, (char*)data + used, capacity - used);
+        if (n == 0) break;
+        used += n;
+    }
+    
+    bool failed = inflate_stream_failed(stream);
+    inflate_stream_close(stream);
+    close(fd);
+    
+    if (failed) {
+        free(data);
+        return NULL;
+    }
+    *size = used;
+    return data;
+}
+
+// 解析以'\0'分隔的序列名
+static bool parse_index_names(TabixIndex* index, ByteCursor* cursor, int name_bytes) {
+    const char* names = (const char*)cursor_take(cursor, (size_t)name_bytes);
+    if (!names) return false;
+    
+    index->names = (const char**)safe_malloc((index->ref_count > 0 ? index->ref_count : 1) * sizeof(char*));
+    const char* p = names;
+    const char* end = names + name_bytes;
+    for (int i = 0; i < index->ref_count; i++) {
+        const char* nul = (const char*)memchr(p, '\0', (size_t)(end - p));
+        if (!nul) return false;
+        index->names[i] = p;
+        p = nul + 1;
+    }
+    return true;
+}
+
+// 加载.tbi或.csi索引，成功返回0
+static int load_tabix_index(const char* filename, bool csi, TabixIndex* index) {
+    memset(index, 0, sizeof(TabixIndex));
+    index->csi = csi;
+    
+    size_t size = 0;
+    index->data = read_index_file(filename, &size);
+    if (!index->data) return -1;
+    
+    ByteCursor cursor = { index->data, size, 0, false };
+    const unsigned char* magic = cursor_take(&cursor, 4);
+    if (!magic || memcmp(magic, csi ? "CSI\1" : "TBI\1", 4) != 0) {
+        free_tabix_index(index);
+        return -1;
+    }
+    
+    int name_bytes = 0;
+    if (csi) {
+        index->min_shift = (int32_t)cursor_u32(&cursor);
+        index->depth = (int32_t)cursor_u32(&cursor);
+        int aux_bytes = cursor_count(&cursor, 1);
+        
+        // tabix生成的CSI在附加数据中保存与.tbi相同的头部和序列名
+        ByteCursor aux = { cursor_take(&cursor, (size_t)aux_bytes), (size_t)aux_bytes, 0, false };
+        if (aux_bytes < 28) {
+            free_tabix_index(index);
+            return -1;
+        }
+        aux.pos = 24;
+        name_bytes = cursor_count(&aux, 1);
+        index->ref_count = cursor_count(&cursor, 4);
+        if (aux.error || !parse_index_names(index, &aux, name_bytes)) {
+            free_tabix_index(index);
+            return -1;
+        }
+    } else {
+        index->min_shift = TBI_MIN_SHIFT;
+        index->depth = TBI_DEPTH;
+        index->ref_count = cursor_count(&cursor, 4);
+        cursor_take(&cursor, 24);   // format, col_seq, col_beg, col_end, meta, skip
+        name_bytes = cursor_count(&cursor, 1);
+        if (!parse_index_names(index, &cursor, name_bytes)) {
+            free_tabix_index(index);
+            return -1;
+        }
+    }
+    
+    if (index->min_shift <= 0 || index->min_shift > 30 || index->depth <= 0 ||
+        index->min_shift + index->depth * 3 > 62) {
+        free_tabix_index(index);
+        return -1;
+    }
+    
+    index->refs = (IndexRef*)safe_malloc((index->ref_count > 0 ? index->ref_count : 1) * sizeof(IndexRef));
+    memset(index->refs, 0, (index->ref_count > 0 ? index->ref_count : 1) * sizeof(IndexRef));
+    
+    for (int i = 0; i < index->ref_count && !cursor.error; i++) {
+        IndexRef* ref = &index->refs[i];
+        ref->bin_count = cursor_count(&cursor, 8);
+        ref->bins = (IndexBin*)safe_malloc((ref->bin_count > 0 ? ref->bin_count : 1) * sizeof(IndexBin));
+        memset(ref->bins, 0, (ref->bin_count > 0 ? ref->bin_count : 1) * sizeof(IndexBin));
+        
+        for (int j = 0; j < ref->bin_count && !cursor.error; j++) {
+            IndexBin* bin = &ref->bins[j];
+            bin->bin = cursor_u32(&cursor);
+            if (csi) bin->loffset = cursor_u64(&cursor);
+            bin->chunk_count = cursor_count(&cursor, 16);
+            bin->chunks = (IndexChunk*)safe_malloc((bin->chunk_count > 0 ? bin->chunk_count : 1) *
+                                                   sizeof(IndexChunk));
+            for (int k = 0; k < bin->chunk_count; k++) {
+                bin->chunks[k].begin = cursor_u64(&cursor);
+                bin->chunks[k].end = cursor_u64(&cursor);
+            }
+        }
+        qsort(ref->bins, ref->bin_count, sizeof(IndexBin), compare_bins);
+        
+        if (!csi) {
+            ref->linear_count = cursor_count(&cursor, 8);
+            ref->linear = (uint64_t*)safe_malloc((ref->linear_count > 0 ? ref->linear_count : 1) *
+                                                 sizeof(uint64_t));
+            for (int k = 0; k < ref->linear_count; k++) {
+                ref->linear[k] = cursor_u64(&cursor);
+            }
+        }
+    }
+    
+    if (cursor.error) {
+        free_tabix_index(index);
+        return -1;
+    }
+    return 0;
+}
+
+static const IndexBin* find_bin(const IndexRef* ref, uint32_t bin) {
+    IndexBin key;
+    key.bin = bin;
+    return (const IndexBin*)bsearch(&key, ref->bins, ref->bin_count, sizeof(IndexBin), compare_bins);
+}
+
+static int compare_chunks(const void* a, const void* b) {
+    uint64_t x = ((const IndexChunk*)a)->begin;
+    uint64_t y = ((const IndexChunk*)b)->begin;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+// 查询0-based半开区间[beg, end)可能涉及的数据段，按偏移排序并合并，返回段数
+static int query_tabix_index(const TabixIndex* index, int tid, int64_t beg, int64_t end,
+                             IndexChunk** result) {
+    *result = NULL;
+    const IndexRef* ref = &index->refs[tid];
+    int64_t max_pos = (int64_t)1 << (index->min_shift + index->depth * 3);
+    if (end > max_pos) end = max_pos;
+    if (beg >= end || ref->bin_count == 0) return 0;
+    
+    // 区间之前的记录不可能重叠，起始偏移之前的数据段可以跳过
+    uint64_t min_offset = 0;
+    int64_t window = beg >> index->min_shift;
+    if (!index->csi && ref->linear_count > 0) {
+        min_offset = ref->linear[window < ref->linear_count ? window : ref->linear_count - 1];
+    } else if (index->csi) {
+        uint32_t bin = (uint32_t)((((int64_t)1 << (index->depth * 3)) - 1) / 7 + window);
+        while (true) {
+            const IndexBin* found = find_bin(ref, bin);
+            if (found) {
+                min_offset = found->loffset;
+                break;
+            }
+            if (bin == 0) break;
+            bin = (bin - 1) >> 3;
+        }
+    }
+    
+    int count = 0;
+    int capacity = 16;
+    IndexChunk* chunks = (IndexChunk*)safe_malloc(capacity * sizeof(IndexChunk));
+    
+    // 逐层枚举与区间相交的分箱
+    int shift = index->min_shift + index->depth * 3;
+    int64_t level_start = 0;
+    end--;
+    for (int level = 0; level <= index->depth; level++) {
+        for (int64_t b = level_start + (beg >> shift); b <= level_start + (end >> shift); b++) {
+            const IndexBin* bin = find_bin(ref, (uint32_t)b);
+            if (!bin) continue;
+            for (int k = 0; k < bin->chunk_count; k++) {
+                if (bin->chunks[k].end <= min_offset) continue;
+                if (count >= capacity) {
+                    capacity *= 2;
+                    chunks = (IndexChunk*)safe_realloc(chunks, capacity * sizeof(IndexChunk));
+                }
+                chunks[count++] = bin->chunks[k];
+            }
+        }
+        level_start += (int64_t)1 << (level * 3);
+        shift -= 3;
+    }
+    
+    if (count == 0) {
+        free(chunks);
+        return 0;
+    }
+    
+    qsort(chunks, count, sizeof(IndexChunk), compare_chunks);
+    int merged = 0;
+    for (int i = 1; i < count; i++) {
+        if (chunks[i].begin <= chunks[merged].end) {
+            if (chunks[i].end > chunks[merged].end) chunks[merged].end = chunks[i].end;
+        } else {
+            chunks[++merged] = chunks[i];
+        }
+    }
+    
+    *result = chunks;
+    return merged + 1;
+}
+
+// 解析一行并按区间过滤；记录不属于want_region（-1表示任意区间）时撤销追加，
+// 连同它在内存池中的字符串。line_num是该行在整个文件中的行号，生成的ID和警告与完整解析一致。
+// 返回追加的记录数，记录起点超过区间终点时返回-1（仅用于有序文件的提前结束）
+static int parse_region_line(StrSlice line, int line_num, FileType type, const RegionList* regions,
+                             int want_region, TEList* te_list) {
+    ArenaMark mark = arena_mark(&te_list->arena);
+    int added = type == FILE_GFF3 ? parse_gff3_line(line, line_num, te_list)
+                                  : parse_bed_line(line, line_num, te_list);
+    if (!added) return 0;
+    
+    int last = te_list->count - 1;
+    const char* chr = string_table_get(te_list->strings, te_list->chrs[last]);
+    int found = region_list_find(regions, chr, te_list->starts[last], te_list->ends[last]);
+    if (found >= 0 && (want_region < 0 || found == want_region)) return 1;
+    
+    te_list->count--;
+    arena_reset(&te_list->arena, &mark);
+    if (want_region >= 0 && chr && strcmp(chr, regions->regions[want_region].chr) == 0 &&
+        te_list->starts[last] > regions->regions[want_region].end) {
+        return -1;
+    }
+    return 0;
+}
+
+// 按区间顺序读取：每个区间只读取索引给出的数据段
+static int parse_indexed_regions(const char* filename, FileType type, const TabixIndex* index,
+                                 const RegionList* regions, TEList* te_list) {
+    BgzfReader* reader = bgzf_reader_open(filename);
+    if (!reader) return -1;
+    // 第二个读取器只数换行符，得到每个数据段第一行在文件中的行号
+    BgzfReader* counter = bgzf_reader_open(filename);
+    if (!counter) {
+        bgzf_reader_close(reader);
+        return -1;
+    }
+    
+    // 按序列在索引中的顺序处理区间，使结果与文件顺序一致
+    int* order = (int*)safe_malloc((regions->count > 0 ? regions->count : 1) * sizeof(int));
+    int* tids = (int*)safe_malloc((regions->count > 0 ? regions->count : 1) * sizeof(int));
+    int order_count = 0;
+    for (int tid = 0; tid < index->ref_count; tid++) {
+        for (int r = 0; r < regions->count; r++) {
+            if (strcmp(regions->regions[r].chr, index->names[tid]) == 0) {
+                order[order_count] = r;
+                tids[order_count++] = tid;
+            }
+        }
+    }
+    
+    int result = 0;
+    for (int i = 0; i < order_count && result == 0; i++) {
+        const GenomicRegion* region = &regions->regions[order[i]];
+        IndexChunk* chunks = NULL;
+        int chunk_count = query_tabix_index(index, tids[i], region->start - 1, region->end, &chunks);
+        
+        bool past_region = false;
+        for (int c = 0; c < chunk_count && !past_region && result == 0; c++) {
+            if (!bgzf_reader_seek(reader, chunks[c].begin)) {
+                result = -1;
+                break;
+            }
+            
+            StrSlice line;
+            uint64_t voffset;
+            long long line_num = -1;
+            while (bgzf_reader_next_line(reader, &line, &voffset) && voffset < chunks[c].end) {
+                if (line_num < 0) {
+                    line_num = bgzf_reader_lines_before(counter, voffset);
+                    if (line_num < 0) {
+                        result = -1;
+                        break;
+                    }
+                }
+                line_num++;
+                if (parse_region_line(line, (int)line_num, type, regions, order[i], te_list) < 0) {
+                    past_region = true;
+                    break;
+                }
+            }
+            if (bgzf_reader_failed(reader)) result = -1;
+        }
+        free(chunks);
+    }
+    
+    free(order);
+    free(tids);
+    bgzf_reader_close(reader);
+    bgzf_reader_close(counter);
+    return result;
+}
+
+// 只解析与区间列表重叠的转座子。bgzip压缩且旁边有.tbi/.csi索引时直接定位到相关的块，
+// 否则读取整个文件再过滤
+int parse_te_file_regions(const char* filename, FileType type, const RegionList* regions,
+                          TEList* te_list, int num_threads) {
+    if (!filename || !regions || !te_list || (type != FILE_GFF3 && type != FILE_BED)) {
+        fprintf(stderr, "Error: Invalid parameters for parse_te_file_regions\n");
+        return -1;
+    }
+    
+    const char* format = type == FILE_GFF3 ? "GFF3" : "BED";
+    init_te_list(te_list);
+    
+    if (regions->count == 0) {
+        printf("Parsed 0 transposons from %s file %s (0 regions)\n", format, filename);
+        return 0;
+    }
+    
+    // 查找索引文件
+    size_t name_len = strlen(filename);
+    char* index_file = (char*)safe_malloc(name_len + 5);
+    TabixIndex index;
+    bool indexed = false;
+    const char* suffixes[] = { ".tbi", ".csi" };
+    for (int i = 0; i < 2 && !indexed; i++) {
+        memcpy(index_file, filename, name_len);
+        memcpy(index_file + name_len, suffixes[i], 5);
+        if (access(index_file, R_OK) != 0) continue;
+        
+        if (load_tabix_index(index_file, i == 1, &index) == 0) {
+            indexed = true;
+        } else {
+            fprintf(stderr, "Warning: Ignoring invalid index file %s\n", index_file);
+        }
+    }
+    free(index_file);
+    
+    if (indexed) {
+        int result = parse_indexed_regions(filename, type, &index, regions, te_list);
+        free_tabix_index(&index);
+        if (result < 0) {
+            fprintf(stderr, "Error: Corrupt or non-BGZF %s file %s\n", format, filename);
+            free_te_list(te_list);
+            return -1;
+        }
+    } else {
+        fprintf(stderr, "Warning: No tabix/CSI index for %s, scanning the whole file\n", filename);
+        
+        LineReader reader;
+        if (line_reader_open(&reader, filename, num_threads) != 0) {
+            fprintf(stderr, "Error: Cannot open %s file %s\n", format, filename);
+            return -1;
+        }
+        
+        StrSlice line;
+        while (line_reader_next(&reader, &line)) {
+            parse_region_line(line, reader.line_num, type, regions, -1, te_list);
+        }
+        
+        if (line_reader_failed(&reader)) {
+            fprintf(stderr, "Error: Corrupt or truncated compressed %s file %s\n", format, filename);
+            line_reader_close(&reader);
+            free_te_list(te_list);
+            return -1;
+        }
+        line_reader_close(&reader);
+    }
+    
+    printf("Parsed %d transposons from %s file %s (%d regions%s)\n", te_list->count, format,
+           filename, regions->count, indexed ? ", indexed" : "");
+    return te_list->count;
+}
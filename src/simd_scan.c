@@ -0,0 +1,238 @@
+#include "te_comparator.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_SCAN_X86 1
+#endif
+
+// 按64字节分块查找分隔符：每块得到一个位图，第i位表示data[i]是否等于a或b。
+// 位图的实现在启动时按CPU选择（AVX2、SSE2或标量），环境变量TEVOX_SIMD可以强制
+// 指定scalar、sse2或avx2，用于比较不同实现的结果
+
+typedef uint64_t (*MatchBlockFn)(const char* data, char a, char b);
+
+// k-mer编码的低30位为k-mer（k <= 15），第30位置1表示该位置没有有效的k-mer。
+// 哈希与minimap2的hash64相同，每步都只保留低30位，因此用32位整数计算的结果与64位相同，
+// 并且在30位内可逆；无效标记原样保留，所有值都小于2^31
+#define KMER_HASH_MASK 0x3FFFFFFFu
+
+typedef void (*HashCodesFn)(uint32_t* codes, int n);
+typedef void (*WindowMinimaFn)(const uint32_t* values, int n, int w, uint32_t* minima);
+
+static uint64_t match_block_scalar(const char* data, char a, char b) {
+    uint64_t mask = 0;
+    for (int i = 0; i < 64; i++) {
+        if (data[i] == a || data[i] == b) mask |= 1ULL << i;
+    }
+    return mask;
+}
+
+#ifdef SIMD_SCAN_X86
+// SSE2是所有x86-64 CPU的基线指令集；两个字符的集合用比较加movemask比SSE4.2的
+// pcmpestrm更快
+__attribute__((target("sse2")))
+static uint64_t match_block_sse2(const char* data, char a, char b) {
+    __m128i va = _mm_set1_epi8(a);
+    __m128i vb = _mm_set1_epi8(b);
+    uint64_t mask = 0;
+    for (int i = 0; i < 4; i++) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(data + i * 16));
+        __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, va), _mm_cmpeq_epi8(chunk, vb));
+        mask |= (uint64_t)(uint32_t)_mm_movemask_epi8(hits) << (i * 16);
+    }
+    return mask;
+}
+
+__attribute__((target("avx2")))
+static uint64_t match_block_avx2(const char* data, char a, char b) {
+    __m256i va = _mm256_set1_epi8(a);
+    __m256i vb = _mm256_set1_epi8(b);
+    __m256i lo = _mm256_loadu_si256((const __m256i*)data);
+    __m256i hi = _mm256_loadu_si256((const __m256i*)(data + 32));
+    __m256i hits_lo = _mm256_or_si256(_mm256_cmpeq_epi8(lo, va), _mm256_cmpeq_epi8(lo, vb));
+    __m256i hits_hi = _mm256_or_si256(_mm256_cmpeq_epi8(hi, va), _mm256_cmpeq_epi8(hi, vb));
+    return (uint64_t)(uint32_t)_mm256_movemask_epi8(hits_lo) |
+           (uint64_t)(uint32_t)_mm256_movemask_epi8(hits_hi) << 32;
+}
+#endif
+
+static inline uint32_t hash_kmer_code(uint32_t code) {
+    uint32_t flag = code & ~KMER_HASH_MASK;
+    uint32_t key = code & KMER_HASH_MASK;
+    key = (~key + (key << 21)) & KMER_HASH_MASK;
+    key ^= key >> 24;
+    key = (key + (key << 3) + (key << 8)) & KMER_HASH_MASK;
+    key ^= key >> 14;
+    key = (key + (key << 2) + (key << 4)) & KMER_HASH_MASK;
+    key ^= key >> 28;
+    return key | flag;
+}
+
+static void hash_codes_scalar(uint32_t* codes, int n) {
+    for (int i = 0; i < n; i++) codes[i] = hash_kmer_code(codes[i]);
+}
+
+// minima[i] = min(values[i..i+w))，共n-w+1个窗口
+static void window_minima_scalar(const uint32_t* values, int n, int w, uint32_t* minima) {
+    for (int i = 0; i + w <= n; i++) {
+        uint32_t m = values[i];
+        for (int j = 1; j < w; j++) {
+            if (values[i + j] < m) m = values[i + j];
+        }
+        minima[i] = m;
+    }
+}
+
+#ifdef SIMD_SCAN_X86
+__attribute__((target("sse2")))
+static void hash_codes_sse2(uint32_t* codes, int n) {
+    const __m128i mask = _mm_set1_epi32((int)KMER_HASH_MASK);
+    const __m128i ones = _mm_set1_epi32(-1);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i code = _mm_loadu_si128((const __m128i*)(codes + i));
+        __m128i flag = _mm_andnot_si128(mask, code);
+        __m128i key = _mm_and_si128(code, mask);
+        key = _mm_and_si128(_mm_add_epi32(_mm_xor_si128(key, ones), _mm_slli_epi32(key, 21)), mask);
+        key = _mm_xor_si128(key, _mm_srli_epi32(key, 24));
+        key = _mm_and_si128(_mm_add_epi32(_mm_add_epi32(key, _mm_slli_epi32(key, 3)), _mm_slli_epi32(key, 8)), mask);
+        key = _mm_xor_si128(key, _mm_srli_epi32(key, 14));
+        key = _mm_and_si128(_mm_add_epi32(_mm_add_epi32(key, _mm_slli_epi32(key, 2)), _mm_slli_epi32(key, 4)), mask);
+        key = _mm_xor_si128(key, _mm_srli_epi32(key, 28));
+        _mm_storeu_si128((__m128i*)(codes + i), _mm_or_si128(key, flag));
+    }
+    for (; i < n; i++) codes[i] = hash_kmer_code(codes[i]);
+}
+
+// SSE2没有32位无符号min，取值都小于2^31，用有符号比较代替
+__attribute__((target("sse2")))
+static void window_minima_sse2(const uint32_t* values, int n, int w, uint32_t* minima) {
+    int i = 0;
+    for (; i + 4 + w - 1 <= n; i += 4) {
+        __m128i m = _mm_loadu_si128((const __m128i*)(values + i));
+        for (int j = 1; j < w; j++) {
+            __m128i v = _mm_loadu_si128((const __m128i*)(values + i + j));
+            __m128i greater = _mm_cmpgt_epi32(m, v);
+            m = _mm_or_si128(_mm_and_si128(greater, v), _mm_andnot_si128(greater, m));
+        }
+        _mm_storeu_si128((__m128i*)(minima + i), m);
+    }
+    if (i + w <= n) window_minima_scalar(values + i, n - i, w, minima + i);
+}
+
+__attribute__((target("avx2")))
+static void hash_codes_avx2(uint32_t* codes, int n) {
+    const __m256i mask = _mm256_set1_epi32((int)KMER_HASH_MASK);
+    const __m256i ones = _mm256_set1_epi32(-1);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i code = _mm256_loadu_si256((const __m256i*)(codes + i));
+        __m256i flag = _mm256_andnot_si256(mask, code);
+        __m256i key = _mm256_and_si256(code, mask);
+        key = _mm256_and_si256(_mm256_add_epi32(_mm256_xor_si256(key, ones), _mm256_slli_epi32(key, 21)), mask);
+        key = _mm256_xor_si256(key, _mm256_srli_epi32(key, 24));
+        key = _mm256_and_si256(_mm256_add_epi32(_mm256_add_epi32(key, _mm256_slli_epi32(key, 3)),
+                                                _mm256_slli_epi32(key, 8)), mask);
+        key = _mm256_xor_si256(key, _mm256_srli_epi32(key, 14));
+        key = _mm256_and_si256(_mm256_add_epi32(_mm256_add_epi32(key, _mm256_slli_epi32(key, 2)),
+                                                _mm256_slli_epi32(key, 4)), mask);
+        key = _mm256_xor_si256(key, _mm256_srli_epi32(key, 28));
+        _mm256_storeu_si256((__m256i*)(codes + i), _mm256_or_si256(key, flag));
+    }
+    for (; i < n; i++) codes[i] = hash_kmer_code(codes[i]);
+}
+
+__attribute__((target("avx2")))
+static void window_minima_avx2(const uint32_t* values, int n, int w, uint32_t* minima) {
+    int i = 0;
+    for (; i + 8 + w - 1 <= n; i += 8) {
+        __m256i m = _mm256_loadu_si256((const __m256i*)(values + i));
+        for (int j = 1; j < w; j++) {
+            m = _mm256_min_epu32(m, _mm256_loadu_si256((const __m256i*)(values + i + j)));
+        }
+        _mm256_storeu_si256((__m256i*)(minima + i), m);
+    }
+    if (i + w <= n) window_minima_scalar(values + i, n - i, w, minima + i);
+}
+#endif
+
+static MatchBlockFn match_block = match_block_scalar;
+static HashCodesFn hash_codes = hash_codes_scalar;
+static WindowMinimaFn window_minima_fn = window_minima_scalar;
+static const char* match_block_level = "scalar";
+
+// 在main之前（或共享库加载时）选择实现，之后只读，多线程使用无需加锁
+__attribute__((constructor))
+static void select_match_block(void) {
+    const char* forced = getenv("TEVOX_SIMD");
+
+#ifdef SIMD_SCAN_X86
+    __builtin_cpu_init();
+    bool avx2 = __builtin_cpu_supports("avx2");
+    bool sse2 = __builtin_cpu_supports("sse2");
+    if (forced && strcmp(forced, "scalar") == 0) {
+        avx2 = sse2 = false;
+    } else if (forced && strcmp(forced, "sse2") == 0) {
+        avx2 = false;
+    }
+    
+    if (avx2) {
+        match_block = match_block_avx2;
+        hash_codes = hash_codes_avx2;
+        window_minima_fn = window_minima_avx2;
+        match_block_level = "avx2";
+    } else if (sse2) {
+        match_block = match_block_sse2;
+        hash_codes = hash_codes_sse2;
+        window_minima_fn = window_minima_sse2;
+        match_block_level = "sse2";
+    }
+#else
+    (void)forced;
+#endif
+}
+
+// 当前使用的实现名称
+const char* simd_scan_level(void) {
+    return match_block_level;
+}
+
+// 查找data[0..len)中等于a或b的字节，把偏移依次写入positions，最多max_positions个，
+// 返回找到的个数；返回值等于max_positions时调用方应从最后一个位置之后继续查找
+int find_bytes(const char* data, size_t len, char a, char b, uint32_t* positions, int max_positions) {
+    int count = 0;
+    size_t offset = 0;
+    
+    while (offset < len && count < max_positions) {
+        uint64_t mask;
+        size_t block = len - offset;
+        if (block >= 64) {
+            mask = match_block(data + offset, a, b);
+            block = 64;
+        } else {
+            // 不足64字节的尾部复制到对齐缓冲区，避免读越过输入的末尾
+            char tail[64];
+            memcpy(tail, data + offset, block);
+            memset(tail + block, 0, 64 - block);
+            mask = match_block(tail, a, b) & ((1ULL << block) - 1);
+        }
+        
+        while (mask && count < max_positions) {
+            positions[count++] = (uint32_t)(offset + (size_t)__builtin_ctzll(mask));
+            mask &= mask - 1;
+        }
+        offset += block;
+    }
+    
+    return count;
+}
+
+// 原地计算codes[0..n)的k-mer哈希
+void hash_kmer_codes(uint32_t* codes, int n) {
+    hash_codes(codes, n);
+}
+
+// 长度为w的滑动窗口最小值：minima[i] = min(values[i..i+w))，n >= w时写出n-w+1个值
+void window_minima(const uint32_t* values, int n, int w, uint32_t* minima) {
+    window_minima_fn(values, n, w, minima);
+}
@@ -0,0 +1,574 @@
+#include "te_comparator.h"
+#include <limits.h>
+
+// 最小化子草图：k-mer长度和窗口大小（与minimap2的默认值相同）
+#define SKETCH_K 15
+#define SKETCH_W 10
+#define KMER_CODE_MASK ((1u << (2 * SKETCH_K)) - 1)
+// 无效k-mer的标记（含N等非ACGT碱基），哈希后仍不小于2^30
+#define KMER_INVALID (1u << 30)
+// 每个并行任务草图化的转座子数和比较的基因组1转座子数
+#define SKETCH_TASK_SIZE 64
+#define MATCH_TASK_SIZE 256
+// 出现在超过这么多个转座子中的最小化子（低复杂度序列等）不参与比较
+#define SKETCH_MAX_OCCURRENCE 2000
+// 一对转座子至少共有的最小化子数
+#define SKETCH_MIN_SHARED 3
+
+// 碱基编码加1（A=1, C=2, G=3, T=4），其他字符为0
+static const unsigned char base_codes[256] = {
+    ['A'] = 1, ['C'] = 2, ['G'] = 3, ['T'] = 4,
+    ['a'] = 1, ['c'] = 2, ['g'] = 3, ['t'] = 4
+};
+
+// 一个任务的草图，按转座子依次存放
+typedef struct {
+    uint32_t* hashes;
+    size_t count;
+    size_t capacity;
+} SketchTask;
+
+// 两个基因组的独有转座子统一编号：基因组1为[0, n1)，基因组2为[n1, n1 + n2)
+typedef struct {
+    const TESelection* selections[2];
+    const FastaFile* fastas[2];
+    int* chr_entries[2];
+    int n1;
+    int total;
+    int* sizes;             // 每个转座子草图中不同最小化子的个数，序列无法提取时为-1
+    SketchTask* tasks;
+} SketchJob;
+
+// 所有草图合并后的倒排索引：第u个不同的哈希出现在nodes[starts[u]..starts[u+1])这些转座子中
+//（编号升序且不重复）。slots[e]为第e个草图条目的哈希下标，查询时不需要查找哈希；
+// 同一转座子中重复的条目只保留第一个，其余为-1
+typedef struct {
+    int* starts;
+    int* nodes;
+    int* slots;
+    int count;
+} SketchIndex;
+
+typedef struct {
+    int node1;
+    int node2;
+    int shared;
+    double jaccard;
+    double containment;
+} SketchMatch;
+
+typedef struct {
+    SketchMatch* matches;
+    int count;
+    int capacity;
+} MatchTask;
+
+typedef struct {
+    const SketchIndex* index;
+    const size_t* offsets;
+    const int* sizes;       // 去掉被屏蔽的最小化子后的草图大小
+    int n1;
+    int n2;
+    double min_jaccard;
+    double min_containment;
+    MatchTask* tasks;
+} MatchJob;
+
+// 计算一条序列的草图：正反链中较小的k-mer编码（与方向无关）经哈希后，取每w个相邻k-mer
+// 的最小值写入out，返回个数。只去掉连续的重复值，其余重复在建立索引时去掉。
+// codes和minima至少能容纳n个值
+static int sketch_sequence(const char* bases, int64_t n, uint32_t* codes, uint32_t* minima, uint32_t* out) {
+    int64_t kmers = n - SKETCH_K + 1;
+    if (kmers <= 0) return 0;
+    
+    uint32_t forward = 0;
+    uint32_t reverse = 0;
+    int valid = 0;
+    for (int64_t i = 0; i < n; i++) {
+        int c = base_codes[(unsigned char)bases[i]] - 1;
+        if (c < 0) {
+            valid = 0;
+        } else {
+            forward = ((forward << 2) | (uint32_t)c) & KMER_CODE_MASK;
+            reverse = (reverse >> 2) | ((uint32_t)(3 - c) << (2 * SKETCH_K - 2));
+            valid++;
+        }
+        if (i >= SKETCH_K - 1) {
+            codes[i - SKETCH_K + 1] = valid >= SKETCH_K ? (forward < reverse ? forward : reverse) : KMER_INVALID;
+        }
+    }
+    hash_kmer_codes(codes, (int)kmers);
+    
+    // 比一个窗口短的序列取整条序列的最小值
+    int64_t windows = 1;
+    if (kmers >= SKETCH_W) {
+        window_minima(codes, (int)kmers, SKETCH_W, minima);
+        windows = kmers - SKETCH_W + 1;
+    } else {
+        minima[0] = codes[0];
+        for (int64_t i = 1; i < kmers; i++) {
+            if (codes[i] < minima[0]) minima[0] = codes[i];
+        }
+    }
+    
+    int count = 0;
+    for (int64_t i = 0; i < windows; i++) {
+        if (minima[i] >= KMER_INVALID) continue;
+        if (count == 0 || out[count - 1] != minima[i]) out[count++] = minima[i];
+    }
+    return count;
+}
+
+// 草图化一段转座子（只读访问FASTA和选择集，各任务写各自的缓冲区，可并发执行）
+static void run_sketch_task(void* ctx, int task_index) {
+    SketchJob* job = (SketchJob*)ctx;
+    SketchTask* task = &job->tasks[task_index];
+    int begin = task_index * SKETCH_TASK_SIZE;
+    int end = begin + SKETCH_TASK_SIZE < job->total ? begin + SKETCH_TASK_SIZE : job->total;
+    
+    char* bases = NULL;
+    uint32_t* codes = NULL;
+    uint32_t* minima = NULL;
+    size_t capacity = 0;
+    
+    for (int node = begin; node < end; node++) {
+        int g = node < job->n1 ? 0 : 1;
+        const TESelection* selection = job->selections[g];
+        const TEList* list = selection->source;
+        const FastaFile* fasta = job->fastas[g];
+        int index = selection->indices[g == 0 ? node : node - job->n1];
+        int chr = list->chrs[index];
+        int chr_count = list->strings->count > 0 ? list->strings->count : 1;
+        int entry = chr >= 0 && chr < chr_count ? job->chr_entries[g][chr] : -1;
+        
+        job->sizes[node] = -1;
+        if (entry < 0 || list->starts[index] < 1 || list->starts[index] > list->ends[index] ||
+            list->ends[index] > fasta->entries[entry].length || list->ends[index] - list->starts[index] >= INT_MAX) {
+            continue;
+        }
+        
+        int64_t length = list->ends[index] - list->starts[index] + 1;
+        if ((size_t)length > capacity) {
+            capacity = (size_t)length;
+            free(bases);
+            free(codes);
+            free(minima);
+            bases = (char*)safe_malloc(capacity);
+            codes = (uint32_t*)safe_malloc(capacity * sizeof(uint32_t));
+            minima = (uint32_t*)safe_malloc(capacity * sizeof(uint32_t));
+        }
+        int64_t n = fasta_fetch(fasta, entry, list->starts[index], list->ends[index], bases);
+        
+        if (task->count + (size_t)n > task->capacity) {
+            size_t new_capacity = task->capacity ? task->capacity * 2 : 1 << 16;
+            while (new_capacity < task->count + (size_t)n) new_capacity *= 2;
+            task->hashes = (uint32_t*)safe_realloc(task->hashes, new_capacity * sizeof(uint32_t));
+            task->capacity = new_capacity;
+        }
+        int count = sketch_sequence(bases, n, codes, minima, task->hashes + task->count);
+        task->count += (size_t)count;
+        job->sizes[node] = count;
+    }
+    
+    free(bases);
+    free(codes);
+    free(minima);
+}
+
+// 按哈希对所有草图条目排序，建立倒排索引；基数排序是稳定的，同一哈希的条目保持编号升序，
+// 同一转座子的重复条目相邻，去掉时从sizes中扣除
+static int build_sketch_index(SketchIndex* index, const uint32_t* sketches, const size_t* offsets, int* sizes,
+                              int total, int num_threads) {
+    memset(index, 0, sizeof(SketchIndex));
+    size_t entries = offsets[total];
+    if (entries > (size_t)INT_MAX) {
+        fprintf(stderr, "Error: Too many minimizers to index (%zu)\n", entries);
+        return -1;
+    }
+    
+    int n = (int)entries;
+    uint64_t* keys = (uint64_t*)safe_malloc((n > 0 ? n : 1) * sizeof(uint64_t));
+    int* order = (int*)safe_malloc((n > 0 ? n : 1) * sizeof(int));
+    for (int e = 0; e < n; e++) {
+        keys[e] = sketches[e];
+        order[e] = e;
+    }
+    radix_sort_pairs(keys, order, n, num_threads);
+    
+    // 条目 -> 转座子编号，先写在slots中，随后被哈希下标覆盖
+    index->slots = (int*)safe_malloc((n > 0 ? n : 1) * sizeof(int));
+    for (int node = 0; node < total; node++) {
+        for (size_t e = offsets[node]; e < offsets[node + 1]; e++) index->slots[e] = node;
+    }
+    index->nodes = (int*)safe_malloc((n > 0 ? n : 1) * sizeof(int));
+    index->starts = (int*)safe_malloc((n + 1) * sizeof(int));
+    int postings = 0;
+    for (int p = 0; p < n; p++) {
+        int node = index->slots[order[p]];
+        if (p == 0 || keys[p] != keys[p - 1]) {
+            index->starts[index->count++] = postings;
+        } else if (index->nodes[postings - 1] == node) {
+            index->slots[order[p]] = -1;
+            sizes[node]--;
+            continue;
+        }
+        index->nodes[postings++] = node;
+        index->slots[order[p]] = index->count - 1;
+    }
+    index->starts[index->count] = postings;
+    free(keys);
+    free(order);
+    return 0;
+}
+
+static void free_sketch_index(SketchIndex* index) {
+    free(index->starts);
+    free(index->nodes);
+    free(index->slots);
+    memset(index, 0, sizeof(SketchIndex));
+}
+
+static void add_match(MatchTask* task, const SketchMatch* match) {
+    if (task->count >= task->capacity) {
+        task->capacity = task->capacity == 0 ? 64 : task->capacity * 2;
+        task->matches = (SketchMatch*)safe_realloc(task->matches, task->capacity * sizeof(SketchMatch));
+    }
+    task->matches[task->count++] = *match;
+}
+
+static int compare_match_node2(const void* a, const void* b) {
+    const SketchMatch* x = (const SketchMatch*)a;
+    const SketchMatch* y = (const SketchMatch*)b;
+    return x->node2 < y->node2 ? -1 : (x->node2 > y->node2 ? 1 : 0);
+}
+
+// 用基因组1的一段转座子查询索引：共有最小化子数由计数数组累加，只访问被命中的基因组2转座子
+static void run_match_task(void* ctx, int task_index) {
+    MatchJob* job = (MatchJob*)ctx;
+    MatchTask* task = &job->tasks[task_index];
+    const SketchIndex* index = job->index;
+    int begin = task_index * MATCH_TASK_SIZE;
+    int end = begin + MATCH_TASK_SIZE < job->n1 ? begin + MATCH_TASK_SIZE : job->n1;
+    
+    size_t n2 = job->n2 > 0 ? (size_t)job->n2 : 1;
+    int* shared = (int*)safe_malloc(n2 * sizeof(int));
+    int* touched = (int*)safe_malloc(n2 * sizeof(int));
+    memset(shared, 0, n2 * sizeof(int));
+    
+    for (int node = begin; node < end; node++) {
+        if (job->sizes[node] <= 0) continue;
+        
+        int touched_count = 0;
+        for (size_t e = job->offsets[node]; e < job->offsets[node + 1]; e++) {
+            int u = index->slots[e];
+            if (u < 0 || index->starts[u + 1] - index->starts[u] > SKETCH_MAX_OCCURRENCE) continue;
+            
+            // 同一哈希的转座子按编号升序，基因组2的在最后
+            int p = index->starts[u + 1];
+            while (p > index->starts[u] && index->nodes[p - 1] >= job->n1) p--;
+            for (; p < index->starts[u + 1]; p++) {
+                int other = index->nodes[p] - job->n1;
+                if (shared[other]++ == 0) touched[touched_count++] = other;
+            }
+        }
+        
+        int first = task->count;
+        for (int t = 0; t < touched_count; t++) {
+            int other = touched[t];
+            int count = shared[other];
+            shared[other] = 0;
+            
+            int size1 = job->sizes[node];
+            int size2 = job->sizes[job->n1 + other];
+            if (count < SKETCH_MIN_SHARED || size2 <= 0) continue;
+            
+            SketchMatch match;
+            match.node1 = node;
+            match.node2 = job->n1 + other;
+            match.shared = count;
+            match.jaccard = (double)count / (size1 + size2 - count);
+            match.containment = (double)count / (size1 < size2 ? size1 : size2);
+            if (match.jaccard >= job->min_jaccard && match.containment >= job->min_containment) {
+                add_match(task, &match);
+            }
+        }
+        qsort(task->matches + first, task->count - first, sizeof(SketchMatch), compare_match_node2);
+    }
+    
+    free(shared);
+    free(touched);
+}
+
+static int find_root(int* parents, int node) {
+    while (parents[node] != node) {
+        parents[node] = parents[parents[node]];
+        node = parents[node];
+    }
+    return node;
+}
+
+static void put_te_columns(OutputWriter* writer, const TEList* list, int index) {
+    const char* chr = string_table_get(list->strings, list->chrs[index]);
+    const char* strand = string_table_get(list->strings, list->strands[index]);
+    const char* family = string_table_get(list->strings, list->families[index]);
+    output_writer_puts(writer, list->ids[index] ? list->ids[index] : "N/A");
+    output_writer_putc(writer, '\t');
+    output_writer_puts(writer, chr ? chr : "N/A");
+    output_writer_putc(writer, '\t');
+    output_writer_put_int(writer, list->starts[index]);
+    output_writer_putc(writer, '\t');
+    output_writer_put_int(writer, list->ends[index]);
+    output_writer_putc(writer, '\t');
+    output_writer_puts(writer, strand ? strand : ".");
+    output_writer_putc(writer, '\t');
+    output_writer_puts(writer, family ? family : "N/A");
+}
+
+static void put_fraction(OutputWriter* writer, double value) {
+    char text[32];
+    int len = snprintf(text, sizeof(text), "%.4f", value);
+    output_writer_write(writer, text, (size_t)len);
+}
+
+static void cluster_output_name(char* filename, size_t size, const char* output_prefix, const char* suffix) {
+    if (strcmp(output_prefix, "-") == 0) {
+        snprintf(filename, size, "-");
+    } else {
+        snprintf(filename, size, "%s_%s", output_prefix, suffix);
+    }
+}
+
+// 写出<prefix>_te_matches.txt和<prefix>_te_clusters.txt，前缀为"-"时写到标准输出
+static int write_cluster_results(const SketchJob* sketch, const SketchMatch* matches, int match_count,
+                                 const int* clusters, int cluster_count, const char* output_prefix) {
+    char filename[512];
+    cluster_output_name(filename, sizeof(filename), output_prefix, "te_matches.txt");
+    
+    OutputWriter writer;
+    if (output_writer_open(&writer, filename) != 0) {
+        fprintf(stderr, "Error: Cannot create output file %s\n", filename);
+        return -1;
+    }
+    output_writer_puts(&writer, "# Cross-genome matches between unique transposons\n"
+                                "# ID1\tChr1\tStart1\tEnd1\tStrand1\tFamily1\tID2\tChr2\tStart2\tEnd2\tStrand2\t"
+                                "Family2\tShared\tJaccard\tContainment\tCluster\n");
+    for (int m = 0; m < match_count; m++) {
+        const SketchMatch* match = &matches[m];
+        put_te_columns(&writer, sketch->selections[0]->source, sketch->selections[0]->indices[match->node1]);
+        output_writer_putc(&writer, '\t');
+        put_te_columns(&writer, sketch->selections[1]->source,
+                       sketch->selections[1]->indices[match->node2 - sketch->n1]);
+        output_writer_putc(&writer, '\t');
+        output_writer_put_int(&writer, match->shared);
+        output_writer_putc(&writer, '\t');
+        put_fraction(&writer, match->jaccard);
+        output_writer_putc(&writer, '\t');
+        put_fraction(&writer, match->containment);
+        output_writer_putc(&writer, '\t');
+        output_writer_put_int(&writer, clusters[match->node1]);
+        output_writer_putc(&writer, '\n');
+    }
+    if (output_writer_close(&writer) != 0) {
+        fprintf(stderr, "Error: Failed to write output file %s\n", filename);
+        return -1;
+    }
+    printf("Cross-genome matches written to: %s\n", strcmp(filename, "-") == 0 ? "standard output" : filename);
+    
+    // 按簇编号分桶，簇内先基因组1后基因组2，各自保持输出顺序
+    int* bucket_starts = (int*)safe_malloc((cluster_count + 2) * sizeof(int));
+    memset(bucket_starts, 0, (cluster_count + 2) * sizeof(int));
+    int members = 0;
+    for (int node = 0; node < sketch->total; node++) {
+        if (clusters[node] > 0) {
+            bucket_starts[clusters[node] + 1]++;
+            members++;
+        }
+    }
+    for (int c = 1; c <= cluster_count + 1; c++) bucket_starts[c] += bucket_starts[c - 1];
+    int* ordered = (int*)safe_malloc((members > 0 ? members : 1) * sizeof(int));
+    for (int node = 0; node < sketch->total; node++) {
+        if (clusters[node] > 0) ordered[bucket_starts[clusters[node]]++] = node;
+    }
+    free(bucket_starts);
+    
+    cluster_output_name(filename, sizeof(filename), output_prefix, "te_clusters.txt");
+    if (output_writer_open(&writer, filename) != 0) {
+        fprintf(stderr, "Error: Cannot create output file %s\n", filename);
+        free(ordered);
+        return -1;
+    }
+    output_writer_puts(&writer, "# Clusters of unique transposons with similar sequences\n"
+                                "# Cluster\tGenome\tID\tChr\tStart\tEnd\tStrand\tFamily\n");
+    for (int k = 0; k < members; k++) {
+        int node = ordered[k];
+        int g = node < sketch->n1 ? 0 : 1;
+        output_writer_put_int(&writer, clusters[node]);
+        output_writer_putc(&writer, '\t');
+        output_writer_put_int(&writer, g + 1);
+        output_writer_putc(&writer, '\t');
+        put_te_columns(&writer, sketch->selections[g]->source,
+                       sketch->selections[g]->indices[g == 0 ? node : node - sketch->n1]);
+        output_writer_putc(&writer, '\n');
+    }
+    free(ordered);
+    if (output_writer_close(&writer) != 0) {
+        fprintf(stderr, "Error: Failed to write output file %s\n", filename);
+        return -1;
+    }
+    printf("TE clusters written to: %s\n", strcmp(filename, "-") == 0 ? "standard output" : filename);
+    return 0;
+}
+
+// 用最小化子草图比较两个基因组的独有转座子：共有最小化子占两者并集的比例（Jaccard）和
+// 占较小草图的比例（containment）都达到阈值的跨基因组转座子对记为匹配，
+// 匹配的转座子用并查集合并为簇。转座子序列从两个基因组FASTA中提取
+int cluster_unique_sequences(const TESelection* unique_te1, const TESelection* unique_te2,
+                             const char* genome1_file, const char* genome2_file,
+                             double min_jaccard, double min_containment,
+                             const char* output_prefix, int num_threads) {
+    if (!unique_te1 || !unique_te2 || !genome1_file || !genome2_file || !output_prefix) return -1;
+    
+    FastaFile fastas[2];
+    if (fasta_open(&fastas[0], genome1_file) != 0) return -1;
+    if (fasta_open(&fastas[1], genome2_file) != 0) {
+        fasta_close(&fastas[0]);
+        return -1;
+    }
+    
+    SketchJob sketch;
+    sketch.selections[0] = unique_te1;
+    sketch.selections[1] = unique_te2;
+    sketch.n1 = unique_te1->count;
+    sketch.total = unique_te1->count + unique_te2->count;
+    for (int g = 0; g < 2; g++) {
+        sketch.fastas[g] = &fastas[g];
+        sketch.chr_entries[g] = fasta_chr_entries(&fastas[g], sketch.selections[g]->source->strings);
+    }
+    
+    // 草图化：各任务的结果按转座子编号顺序拼接
+    int sketch_tasks = (sketch.total + SKETCH_TASK_SIZE - 1) / SKETCH_TASK_SIZE;
+    sketch.sizes = (int*)safe_malloc((sketch.total > 0 ? sketch.total : 1) * sizeof(int));
+    sketch.tasks = (SketchTask*)safe_malloc((sketch_tasks > 0 ? sketch_tasks : 1) * sizeof(SketchTask));
+    memset(sketch.tasks, 0, (sketch_tasks > 0 ? sketch_tasks : 1) * sizeof(SketchTask));
+    parallel_for(sketch_tasks, num_threads, run_sketch_task, &sketch);
+    
+    size_t* offsets = (size_t*)safe_malloc((sketch.total + 1) * sizeof(size_t));
+    int skipped[2] = { 0, 0 };
+    offsets[0] = 0;
+    for (int node = 0; node < sketch.total; node++) {
+        if (sketch.sizes[node] < 0) skipped[node < sketch.n1 ? 0 : 1]++;
+        offsets[node + 1] = offsets[node] + (size_t)(sketch.sizes[node] > 0 ? sketch.sizes[node] : 0);
+    }
+    uint32_t* sketches = (uint32_t*)safe_malloc((offsets[sketch.total] > 0 ? offsets[sketch.total] : 1) *
+                                                sizeof(uint32_t));
+    for (int t = 0; t < sketch_tasks; t++) {
+        int first = t * SKETCH_TASK_SIZE;
+        if (sketch.tasks[t].count > 0) {
+            memcpy(sketches + offsets[first], sketch.tasks[t].hashes, sketch.tasks[t].count * sizeof(uint32_t));
+        }
+        free(sketch.tasks[t].hashes);
+    }
+    free(sketch.tasks);
+    sketch.tasks = NULL;
+    
+    const char* genome_files[2] = { genome1_file, genome2_file };
+    for (int g = 0; g < 2; g++) {
+        if (skipped[g] > 0) {
+            fprintf(stderr, "Warning: %d TEs of genome %d not sketched: chromosome missing from %s "
+                            "or TE beyond its end\n", skipped[g], g + 1, genome_files[g]);
+        }
+    }
+    
+    SketchIndex index;
+    int status = build_sketch_index(&index, sketches, offsets, sketch.sizes, sketch.total, num_threads);
+    free(sketches);
+    
+    // 屏蔽高频最小化子：从两侧的草图大小中扣除，相似度只在其余最小化子上计算
+    int* sizes = (int*)safe_malloc((sketch.total > 0 ? sketch.total : 1) * sizeof(int));
+    int masked = 0;
+    for (int node = 0; node < sketch.total; node++) sizes[node] = sketch.sizes[node];
+    for (int u = 0; status == 0 && u < index.count; u++) {
+        if (index.starts[u + 1] - index.starts[u] <= SKETCH_MAX_OCCURRENCE) continue;
+        masked++;
+        for (int p = index.starts[u]; p < index.starts[u + 1]; p++) sizes[index.nodes[p]]--;
+    }
+    
+    // 查询：基因组1的转座子依次查找共有最小化子的基因组2转座子
+    MatchJob match_job;
+    int match_tasks = (sketch.n1 + MATCH_TASK_SIZE - 1) / MATCH_TASK_SIZE;
+    match_job.index = &index;
+    match_job.offsets = offsets;
+    match_job.sizes = sizes;
+    match_job.n1 = sketch.n1;
+    match_job.n2 = unique_te2->count;
+    match_job.min_jaccard = min_jaccard;
+    match_job.min_containment = min_containment;
+    match_job.tasks = (MatchTask*)safe_malloc((match_tasks > 0 ? match_tasks : 1) * sizeof(MatchTask));
+    memset(match_job.tasks, 0, (match_tasks > 0 ? match_tasks : 1) * sizeof(MatchTask));
+    if (status == 0) parallel_for(match_tasks, num_threads, run_match_task, &match_job);
+    
+    int match_count = 0;
+    for (int t = 0; t < match_tasks; t++) match_count += match_job.tasks[t].count;
+    SketchMatch* matches = (SketchMatch*)safe_malloc((match_count > 0 ? match_count : 1) * sizeof(SketchMatch));
+    match_count = 0;
+    for (int t = 0; t < match_tasks; t++) {
+        if (match_job.tasks[t].count > 0) {
+            memcpy(matches + match_count, match_job.tasks[t].matches,
+                   match_job.tasks[t].count * sizeof(SketchMatch));
+        }
+        match_count += match_job.tasks[t].count;
+        free(match_job.tasks[t].matches);
+    }
+    free(match_job.tasks);
+    
+    // 并查集合并匹配的转座子，簇按其中第一个基因组1转座子的顺序编号（从1开始）
+    int* clusters = (int*)safe_malloc((sketch.total > 0 ? sketch.total : 1) * sizeof(int));
+    int* parents = (int*)safe_malloc((sketch.total > 0 ? sketch.total : 1) * sizeof(int));
+    for (int node = 0; node < sketch.total; node++) {
+        parents[node] = node;
+        clusters[node] = 0;
+    }
+    for (int m = 0; m < match_count; m++) {
+        int a = find_root(parents, matches[m].node1);
+        int b = find_root(parents, matches[m].node2);
+        if (a != b) parents[a < b ? b : a] = a < b ? a : b;
+        clusters[matches[m].node1] = -1;
+        clusters[matches[m].node2] = -1;
+    }
+    int cluster_count = 0;
+    int clustered[2] = { 0, 0 };
+    for (int node = 0; node < sketch.total; node++) {
+        if (clusters[node] == 0) continue;
+        int root = find_root(parents, node);
+        if (root == node) clusters[node] = ++cluster_count;
+        else clusters[node] = clusters[root];
+        clustered[node < sketch.n1 ? 0 : 1]++;
+    }
+    free(parents);
+    
+    if (status == 0) {
+        printf("\n=== TE Sequence Clusters ===\n");
+        printf("Sketched TEs: %d in genome 1, %d in genome 2 (k=%d, w=%d, %d minimizers)\n",
+               sketch.n1 - skipped[0], unique_te2->count - skipped[1], SKETCH_K, SKETCH_W,
+               index.starts[index.count]);
+        if (masked > 0) {
+            printf("Masked minimizers: %d (in more than %d TEs)\n", masked, SKETCH_MAX_OCCURRENCE);
+        }
+        printf("Cross-genome matches: %d (Jaccard >= %g, containment >= %g)\n", match_count, min_jaccard,
+               min_containment);
+        printf("Clusters: %d (%d genome 1 TEs, %d genome 2 TEs)\n", cluster_count, clustered[0], clustered[1]);
+        status = write_cluster_results(&sketch, matches, match_count, clusters, cluster_count, output_prefix);
+    }
+    
+    free(clusters);
+    free(matches);
+    free(sizes);
+    free_sketch_index(&index);
+    free(offsets);
+    free(sketch.sizes);
+    for (int g = 0; g < 2; g++) {
+        free(sketch.chr_entries[g]);
+        fasta_close(&fastas[g]);
+    }
+    return status;
+}
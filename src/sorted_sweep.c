@@ -0,0 +1,225 @@
+#include "te_comparator.h"
+#include <unistd.h>
+
+// 流式模式下暂存记录字符串的内存池超过该大小时整体释放
+#define SWEEP_ARENA_LIMIT (4 << 20)
+
+// 单个基因组的扫描结果
+typedef struct {
+    int total;
+    int unique;
+    CountTable types;       // 以字符串ID+1为键，与count_te_types一致
+    CountTable families;
+} SweepResult;
+
+// 按染色体和起点排序的注释与共线性区间做归并扫描：每条染色体上的区间游标只前进不后退，
+// 独有转座子直接写入输出文件，内存只保存共线性区间和当前记录
+static int sweep_genome(const char* te_file, FileType type, SyntenyList* synteny, int genome_id,
+                        const char* output_file, OutputFormat out_format, const CompareOptions* options,
+                        SweepResult* result) {
+    const char* format = type == FILE_GFF3 ? "GFF3" : "BED";
+    
+    result->total = 0;
+    result->unique = 0;
+    init_count_table(&result->types);
+    init_count_table(&result->families);
+    
+    LineReader reader;
+    if (line_reader_open(&reader, te_file, options->num_threads) != 0) {
+        fprintf(stderr, "Error: Cannot open %s file %s\n", format, te_file);
+        return -1;
+    }
+    
+    OutputWriter output;
+    if (output_writer_open(&output, output_file) != 0) {
+        fprintf(stderr, "Error: Cannot create output file %s\n", output_file);
+        line_reader_close(&reader);
+        return -1;
+    }
+    bool with_coverage = options->min_overlap > 0.0;
+    write_unique_header(&output, out_format, genome_id, with_coverage);
+    
+    // 单条记录的临时列表，处理完即清空
+    TEList current;
+    init_te_list(&current);
+    StringTable* strings = current.strings;
+    
+    // 缺失的类型和家族计入"unknown"
+    int unknown_id = string_table_intern(strings, "unknown");
+    
+    const IntervalSet* intervals = synteny && synteny->index ? &synteny->index->genome[genome_id - 1] : NULL;
+    
+    // 已经结束的染色体，再次出现说明未排序
+    bool* finished = NULL;
+    int finished_capacity = 0;
+    int current_chr = STR_NONE;
+    int64_t previous_start = 0;
+    int cursor = 0;
+    int status = 0;
+    
+    StrSlice line;
+    while (line_reader_next(&reader, &line)) {
+        int added = type == FILE_GFF3 ? parse_gff3_line(line, reader.line_num, &current)
+                                      : parse_bed_line(line, reader.line_num, &current);
+        if (!added) continue;
+        
+        Transposon record;
+        te_list_get(&current, 0, &record);
+        const Transposon* te = &record;
+        if (te->chr != current_chr) {
+            if (current_chr != STR_NONE) {
+                if (current_chr >= finished_capacity) {
+                    int new_capacity = finished_capacity == 0 ? 64 : finished_capacity;
+                    while (new_capacity <= current_chr) new_capacity *= 2;
+                    finished = (bool*)safe_realloc(finished, new_capacity * sizeof(bool));
+                    memset(finished + finished_capacity, 0, (new_capacity - finished_capacity) * sizeof(bool));
+                    finished_capacity = new_capacity;
+                }
+                finished[current_chr] = true;
+            }
+            if (te->chr < finished_capacity && finished[te->chr]) {
+                fprintf(stderr, "Error: %s is not sorted by chromosome: %s reappears at line %d\n",
+                        te_file, string_table_get(strings, te->chr), reader.line_num);
+                status = -1;
+                break;
+            }
+            current_chr = te->chr;
+            cursor = 0;
+        } else if (te->start < previous_start) {
+            fprintf(stderr, "Error: %s is not sorted by start: %s:%lld follows %s:%lld at line %d\n",
+                    te_file, string_table_get(strings, te->chr), (long long)te->start,
+                    string_table_get(strings, te->chr), (long long)previous_start, reader.line_num);
+            status = -1;
+            break;
+        }
+        previous_start = te->start;
+        
+        // 跳过已经完全位于当前起点之前的区间
+        bool in_synteny = false;
+        double coverage = 0.0;
+        if (with_coverage) {
+            in_synteny = is_syntenic(te->chr, te->start, te->end, synteny, genome_id, options, &coverage);
+        } else if (intervals && te->chr >= 0 && te->chr < intervals->chrom_count) {
+            const ChromIntervals* chrom = &intervals->chroms[te->chr];
+            while (cursor < chrom->count && chrom->ends[cursor] < te->start) cursor++;
+            in_synteny = cursor < chrom->count && chrom->starts[cursor] <= te->end;
+        }
+        
+        result->total++;
+        if (!in_synteny) {
+            result->unique++;
+            write_te_record(&output, out_format, strings, te, with_coverage ? coverage : -1.0);
+            count_table_add(&result->types, (uint64_t)((te->type != STR_NONE ? te->type : unknown_id) + 1), 1);
+            count_table_add(&result->families, (uint64_t)((te->family != STR_NONE ? te->family : unknown_id) + 1), 1);
+        }
+        
+        current.count = 0;
+        if (current.arena.bytes_used > SWEEP_ARENA_LIMIT) {
+            free_arena(&current.arena);
+            init_arena(&current.arena);
+        }
+    }
+    
+    if (status == 0 && line_reader_failed(&reader)) {
+        fprintf(stderr, "Error: Corrupt or truncated compressed %s file %s\n", format, te_file);
+        status = -1;
+    }
+    
+    free(finished);
+    free_te_list(&current);
+    line_reader_close(&reader);
+    
+    if (output_writer_close(&output) != 0 && status == 0) {
+        fprintf(stderr, "Error: Failed to write output file %s\n", output_file);
+        status = -1;
+    }
+    if (status != 0) {
+        // 不保留不完整的结果
+        if (strcmp(output_file, "-") != 0) unlink(output_file);
+        free_count_table(&result->types);
+        free_count_table(&result->families);
+        return -1;
+    }
+    
+    printf("Streamed %d transposons from %s file %s\n", result->total, format, te_file);
+    return result->unique;
+}
+
+// 按首次出现顺序打印计数，与analyze_te_types/analyze_te_families的输出一致
+static void print_sweep_counts(const CountTable* counts) {
+    for (int i = 0; i < counts->count; i++) {
+        const char* name = string_table_get(default_string_table(), (int)counts->entries[i].key - 1);
+        printf("  %s: %d\n", name ? name : "unknown", counts->entries[i].count);
+    }
+}
+
+// --sorted：两个注释都按染色体和起点排序时，逐条流式比较并直接写出独有转座子，
+// 不在内存中保存转座子列表。共线性区间索引仍在内存中（可为任意顺序）
+int compare_sorted_streaming(const char* te_file1, FileType type1, const char* te_file2, FileType type2,
+                             SyntenyList* synteny, const char* output_prefix, OutputFormat format,
+                             const CompareOptions* options) {
+    if (!te_file1 || !te_file2 || !output_prefix) {
+        fprintf(stderr, "Error: Invalid parameters for compare_sorted_streaming\n");
+        return -1;
+    }
+    
+    if (synteny && synteny->count > 0 && !synteny->index) {
+        build_synteny_index(synteny);
+    }
+    
+    CompareOptions default_options;
+    if (!options) {
+        init_compare_options(&default_options);
+        options = &default_options;
+    }
+    
+    printf("Comparing sorted inputs in streaming mode...\n");
+    
+    const char* te_files[2] = { te_file1, te_file2 };
+    FileType types[2] = { type1, type2 };
+    SweepResult results[2];
+    char filenames[2][512];
+    
+    for (int g = 0; g < 2; g++) {
+        output_file_name(filenames[g], sizeof(filenames[g]), output_prefix, g + 1, format);
+        if (sweep_genome(te_files[g], types[g], synteny, g + 1, filenames[g], format, options, &results[g]) < 0) {
+            if (g == 1) {
+                if (strcmp(filenames[0], "-") != 0) unlink(filenames[0]);
+                free_count_table(&results[0].types);
+                free_count_table(&results[0].families);
+            }
+            return -1;
+        }
+    }
+    
+    printf("Genome 1: %d transposons\n", results[0].total);
+    printf("Genome 2: %d transposons\n", results[1].total);
+    printf("Synteny blocks: %d\n", synteny ? synteny->count : 0);
+    
+    printf("\n=== TE Difference Analysis Results ===\n");
+    for (int g = 0; g < 2; g++) {
+        printf("Genome %d unique transposons: %d (%.1f%% of total)\n", g + 1, results[g].unique,
+               results[g].total > 0 ? (100.0 * results[g].unique / results[g].total) : 0.0);
+    }
+    
+    printf("\n=== Transposon Type Analysis ===\n");
+    for (int g = 0; g < 2; g++) {
+        printf("Genome %d unique TE types:\n", g + 1);
+        print_sweep_counts(&results[g].types);
+    }
+    
+    printf("\n=== Transposon Family Analysis ===\n");
+    for (int g = 0; g < 2; g++) {
+        printf("Genome %d unique TE families:\n", g + 1);
+        print_sweep_counts(&results[g].families);
+    }
+    
+    for (int g = 0; g < 2; g++) {
+        printf("Genome %d unique TEs written to: %s\n", g + 1,
+               strcmp(filenames[g], "-") == 0 ? "standard output" : filenames[g]);
+        free_count_table(&results[g].types);
+        free_count_table(&results[g].families);
+    }
+    
+    return results[0].unique + results[1].unique;
+}
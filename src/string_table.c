@@ -0,0 +1,129 @@
+#include "te_comparator.h"
+
+// 进程内共享的默认字符串表：全零即为空表（与init_string_table的结果相同），
+// 无需在运行时延迟初始化，多个线程或库上下文同时获取时不存在初始化竞争
+static StringTable g_default_table;
+
+// FNV-1a哈希
+static uint32_t hash_string(const char* str, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)str[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// 初始化字符串表
+void init_string_table(StringTable* table) {
+    if (!table) return;
+    table->strings = NULL;
+    table->lengths = NULL;
+    table->count = 0;
+    table->capacity = 0;
+    table->slots = NULL;
+    table->slot_capacity = 0;
+    init_arena(&table->arena);
+}
+
+// 扩大哈希槽并重新插入所有已有字符串
+static void grow_slots(StringTable* table) {
+    int new_capacity = table->slot_capacity == 0 ? 64 : table->slot_capacity * 2;
+    int* new_slots = (int*)safe_malloc(new_capacity * sizeof(int));
+    for (int i = 0; i < new_capacity; i++) new_slots[i] = STR_NONE;
+    
+    uint32_t mask = (uint32_t)new_capacity - 1;
+    for (int id = 0; id < table->count; id++) {
+        uint32_t slot = hash_string(table->strings[id], table->lengths[id]) & mask;
+        while (new_slots[slot] != STR_NONE) slot = (slot + 1) & mask;
+        new_slots[slot] = id;
+    }
+    
+    free(table->slots);
+    table->slots = new_slots;
+    table->slot_capacity = new_capacity;
+}
+
+// 查找长度为len的字符串所在的哈希槽（找不到时返回空槽）
+static uint32_t find_slot(const StringTable* table, const char* str, size_t len, uint32_t hash) {
+    uint32_t mask = (uint32_t)table->slot_capacity - 1;
+    uint32_t slot = hash & mask;
+    while (table->slots[slot] != STR_NONE) {
+        int id = table->slots[slot];
+        if (table->lengths[id] == len && memcmp(table->strings[id], str, len) == 0) {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+// 驻留字符串，返回其整数ID（相同字符串总是得到相同ID）
+int string_table_intern(StringTable* table, const char* str) {
+    if (!table || !str) return STR_NONE;
+    return string_table_intern_len(table, str, strlen(str));
+}
+
+// 驻留长度为len的字符串（str不需要以'\0'结尾）
+int string_table_intern_len(StringTable* table, const char* str, size_t len) {
+    if (!table || !str) return STR_NONE;
+    
+    // 负载因子保持在0.5以下
+    if ((table->count + 1) * 2 > table->slot_capacity) {
+        grow_slots(table);
+    }
+    
+    uint32_t hash = hash_string(str, len);
+    uint32_t slot = find_slot(table, str, len, hash);
+    if (table->slots[slot] != STR_NONE) {
+        return table->slots[slot];
+    }
+    
+    if (table->count >= table->capacity) {
+        int new_capacity = table->capacity == 0 ? 64 : table->capacity * 2;
+        table->strings = (char**)safe_realloc(table->strings, new_capacity * sizeof(char*));
+        table->lengths = (size_t*)safe_realloc(table->lengths, new_capacity * sizeof(size_t));
+        table->capacity = new_capacity;
+    }
+    
+    int id = table->count++;
+    table->strings[id] = arena_strndup(&table->arena, str, len);
+    table->lengths[id] = len;
+    table->slots[slot] = id;
+    return id;
+}
+
+// 查找字符串的ID，不存在时返回STR_NONE
+int string_table_find(const StringTable* table, const char* str) {
+    if (!table || !str || table->count == 0) return STR_NONE;
+    
+    size_t len = strlen(str);
+    return table->slots[find_slot(table, str, len, hash_string(str, len))];
+}
+
+// 根据ID获取字符串，STR_NONE或非法ID返回NULL
+const char* string_table_get(const StringTable* table, int id) {
+    if (!table || id < 0 || id >= table->count) return NULL;
+    return table->strings[id];
+}
+
+// 释放字符串表
+void free_string_table(StringTable* table) {
+    if (!table) return;
+    
+    free_arena(&table->arena);
+    free(table->strings);
+    free(table->lengths);
+    free(table->slots);
+    init_string_table(table);
+}
+
+// 获取默认字符串表，所有列表默认共享该表，ID可直接比较
+StringTable* default_string_table(void) {
+    return &g_default_table;
+}
+
+// 释放默认字符串表（程序结束时调用），释放后恢复为空表
+void free_default_string_table(void) {
+    free_string_table(&g_default_table);
+}
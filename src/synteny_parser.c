@@ -1,113 +1,326 @@
 #include "te_comparator.h"
 
+// 解析一行共线性区块，成功时追加到synteny_list并返回1，否则返回0
+int parse_synteny_line(StrSlice line, int line_num, SyntenyList* synteny_list) {
+    // 跳过注释行和空行
+    if (line.len == 0 || line.ptr[0] == '#') {
+        return 0;
+    }
+    
+    // 解析共线性区块
+    // 假设格式为: chr1    start1    end1    chr2    start2    end2    [score]
+    StrSlice tokens[10];
+    int token_count = split_fields(line, '\t', tokens, 10);
+    
+    if (token_count < 6) {
+        fprintf(stderr, "Warning: Line %d has insufficient columns (%d), skipping\n", 
+                line_num, token_count);
+        return 0;
+    }
+    
+    SyntenyBlock block;
+    block.chr1 = string_table_intern_len(synteny_list->strings, tokens[0].ptr, tokens[0].len);
+    block.start1 = slice_to_position(tokens[1]);
+    block.end1 = slice_to_position(tokens[2]);
+    block.chr2 = string_table_intern_len(synteny_list->strings, tokens[3].ptr, tokens[3].len);
+    block.start2 = slice_to_position(tokens[4]);
+    block.end2 = slice_to_position(tokens[5]);
+    
+    // 可选的score字段
+    if (token_count > 6) {
+        block.score = slice_to_double(tokens[6]);
+    } else {
+        block.score = 1.0;
+    }
+    
+    // 验证坐标的合理性
+    if (block.start1 > block.end1) {
+        int64_t temp = block.start1;
+        block.start1 = block.end1;
+        block.end1 = temp;
+    }
+    
+    if (block.start2 > block.end2) {
+        int64_t temp = block.start2;
+        block.start2 = block.end2;
+        block.end2 = temp;
+    }
+    
+    add_synteny_block(synteny_list, &block);
+    return 1;
+}
+
 // 解析共线性文件
 int parse_synteny(const char* filename, SyntenyList* synteny_list) {
-    if (!filename || !synteny_list) {
+    ParseOptions options = { NULL, 1, false };
+    return parse_synteny_ex(filename, synteny_list, &options);
+}
+
+// 按选项解析共线性文件：字符串写入options->strings，quiet时不打印进度
+int parse_synteny_ex(const char* filename, SyntenyList* synteny_list, const ParseOptions* options) {
+    if (!filename || !synteny_list || !options) {
         fprintf(stderr, "Error: Invalid parameters for parse_synteny\n");
         return -1;
     }
     
     init_synteny_list(synteny_list);
+    if (options->strings) synteny_list->strings = options->strings;
     
-    FILE* file = fopen(filename, "r");
-    if (!file) {
+    LineReader reader;
+    if (line_reader_open(&reader, filename, options->num_threads) != 0) {
         fprintf(stderr, "Error: Cannot open synteny file %s\n", filename);
         return -1;
     }
     
-    char line[2048];
-    int line_num = 0;
-    
-    while (fgets(line, sizeof(line), file)) {
-        line_num++;
-        
-        // 跳过注释行和空行
-        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') {
-            continue;
-        }
-        
-        // 移除行尾的换行符
-        line[strcspn(line, "\r\n")] = '\0';
-        
-        // 解析共线性区块
-        // 假设格式为: chr1    start1    end1    chr2    start2    end2    [score]
-        char* token;
-        char* tokens[10];
-        int token_count = 0;
-        
-        token = strtok(line, "\t");
-        while (token != NULL && token_count < 10) {
-            tokens[token_count++] = token;
-            token = strtok(NULL, "\t");
-        }
-        
-        if (token_count < 6) {
-            fprintf(stderr, "Warning: Line %d has insufficient columns (%d), skipping\n", 
-                    line_num, token_count);
-            continue;
+    // 库调用内存不足时关闭文件并释放已读入的区块，再交给调用方的陷阱
+    jmp_buf trap;
+    jmp_buf* previous = NULL;
+    bool trapped = oom_trap_active();
+    if (trapped) {
+        previous = set_oom_trap(&trap);
+        if (setjmp(trap)) {
+            set_oom_trap(previous);
+            line_reader_close(&reader);
+            free_synteny_list(synteny_list);
+            out_of_memory(0);
         }
+    }
+    
+    StrSlice line;
+    while (line_reader_next(&reader, &line)) {
+        parse_synteny_line(line, reader.line_num, synteny_list);
+    }
+    if (trapped) set_oom_trap(previous);
+    
+    if (line_reader_failed(&reader)) {
+        fprintf(stderr, "Error: Corrupt or truncated compressed synteny file %s\n", filename);
+        line_reader_close(&reader);
+        free_synteny_list(synteny_list);
+        return -1;
+    }
+    
+    line_reader_close(&reader);
+    
+    // 构建查询索引，之后每次查询为O(log n)
+    build_synteny_index(synteny_list);
+    
+    if (!options->quiet) printf("Parsed %d synteny blocks from %s\n", synteny_list->count, filename);
+    return synteny_list->count;
+}
+
+// 将某一侧的区块按染色体分组、排序并合并为不相交区间
+static void build_interval_set(IntervalSet* set, SyntenyList* synteny_list, int side) {
+    set->chroms = NULL;
+    set->chrom_count = 0;
+    
+    int n = synteny_list->count;
+    if (n == 0) return;
+    
+    // 该侧的区块坐标按(染色体, 起点, 终点)基数排序，染色体缺失的区块排除在外
+    int* chrs = (int*)safe_malloc(n * sizeof(int));
+    int64_t* starts = (int64_t*)safe_malloc(n * sizeof(int64_t));
+    int64_t* ends = (int64_t*)safe_malloc(n * sizeof(int64_t));
+    int max_chr = STR_NONE;
+    for (int i = 0; i < n; i++) {
+        SyntenyBlock* block = &synteny_list->blocks[i];
+        chrs[i] = side == 0 ? block->chr1 : block->chr2;
+        starts[i] = side == 0 ? block->start1 : block->start2;
+        ends[i] = side == 0 ? block->end1 : block->end2;
+        if (chrs[i] > max_chr) max_chr = chrs[i];
+    }
+    int* order = sort_order_by_position(chrs, starts, ends, n, 1);
+    int first = 0;
+    while (first < n && chrs[order[first]] == STR_NONE) first++;
+    
+    // 按染色体ID直接索引，没有区块的染色体count为0
+    set->chrom_count = max_chr + 1;
+    if (set->chrom_count > 0) {
+        set->chroms = (ChromIntervals*)safe_malloc(set->chrom_count * sizeof(ChromIntervals));
+        memset(set->chroms, 0, set->chrom_count * sizeof(ChromIntervals));
+    }
+    
+    int i = first;
+    while (i < n) {
+        // 找出同一染色体的区块范围[i, j)
+        int j = i + 1;
+        while (j < n && chrs[order[j]] == chrs[order[i]]) j++;
         
-        SyntenyBlock block;
-        block.chr1 = strdup_safe(tokens[0]);
-        block.start1 = atoi(tokens[1]);
-        block.end1 = atoi(tokens[2]);
-        block.chr2 = strdup_safe(tokens[3]);
-        block.start2 = atoi(tokens[4]);
-        block.end2 = atoi(tokens[5]);
+        ChromIntervals* chrom = &set->chroms[chrs[order[i]]];
+        chrom->starts = (int64_t*)safe_malloc((j - i) * sizeof(int64_t));
+        chrom->ends = (int64_t*)safe_malloc((j - i) * sizeof(int64_t));
+        chrom->covered = (long long*)safe_malloc((j - i + 1) * sizeof(long long));
+        chrom->count = 0;
         
-        // 可选的score字段
-        if (token_count > 6) {
-            block.score = atof(tokens[6]);
-        } else {
-            block.score = 1.0;
+        // 合并重叠或相邻的区间（坐标为闭区间）
+        for (int k = i; k < j; k++) {
+            int64_t start = starts[order[k]];
+            int64_t end = ends[order[k]];
+            if (chrom->count > 0 && start <= chrom->ends[chrom->count - 1] + 1) {
+                if (end > chrom->ends[chrom->count - 1]) {
+                    chrom->ends[chrom->count - 1] = end;
+                }
+            } else {
+                chrom->starts[chrom->count] = start;
+                chrom->ends[chrom->count] = end;
+                chrom->count++;
+            }
         }
         
-        // 验证坐标的合理性
-        if (block.start1 > block.end1) {
-            int temp = block.start1;
-            block.start1 = block.end1;
-            block.end1 = temp;
+        // 区间长度的前缀和，用于统计任意区间被覆盖的碱基数
+        chrom->covered[0] = 0;
+        for (int k = 0; k < chrom->count; k++) {
+            chrom->covered[k + 1] = chrom->covered[k] + (chrom->ends[k] - chrom->starts[k] + 1);
         }
         
-        if (block.start2 > block.end2) {
-            int temp = block.start2;
-            block.start2 = block.end2;
-            block.end2 = temp;
+        i = j;
+    }
+    
+    free(order);
+    free(chrs);
+    free(starts);
+    free(ends);
+}
+
+// 构建共线性查询索引
+void build_synteny_index(SyntenyList* synteny_list) {
+    if (!synteny_list) return;
+    
+    free_synteny_index(synteny_list->index);
+    
+    SyntenyIndex* index = (SyntenyIndex*)safe_malloc(sizeof(SyntenyIndex));
+    build_interval_set(&index->genome[0], synteny_list, 0);
+    build_interval_set(&index->genome[1], synteny_list, 1);
+    synteny_list->index = index;
+}
+
+// 释放共线性查询索引
+void free_synteny_index(SyntenyIndex* index) {
+    if (!index) return;
+    
+    for (int g = 0; g < 2; g++) {
+        IntervalSet* set = &index->genome[g];
+        for (int i = 0; i < set->chrom_count; i++) {
+            free(set->chroms[i].starts);
+            free(set->chroms[i].ends);
+            free(set->chroms[i].covered);
         }
-        
-        add_synteny_block(synteny_list, &block);
+        free(set->chroms);
+    }
+    free(index);
+}
+
+// 按染色体ID取区间集合，没有区块时返回NULL
+static const ChromIntervals* find_chrom_intervals(const IntervalSet* set, int chr) {
+    if (chr < 0 || chr >= set->chrom_count || set->chroms[chr].count == 0) return NULL;
+    return &set->chroms[chr];
+}
+
+// 判断区间[start, end]是否与合并后的区间有重叠
+static bool intervals_overlap(const ChromIntervals* chrom, int64_t start, int64_t end) {
+    // 找到第一个终点 >= start 的区间
+    int lo = 0, hi = chrom->count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (chrom->ends[mid] < start) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo < chrom->count && chrom->starts[lo] <= end;
+}
+
+// 统计[start, end]被合并区间覆盖的碱基数，touched返回所接触区间的总长度。
+// 两次二分查找定位接触的区间[lo, hi)，再由前缀和扣除首尾区间超出的部分
+static long long covered_bases(const ChromIntervals* chrom, int64_t start, int64_t end, long long* touched) {
+    int lo = 0, hi = chrom->count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (chrom->ends[mid] < start) lo = mid + 1;
+        else hi = mid;
     }
+    int first = lo;
     
-    fclose(file);
+    // 第一个起点 > end 的区间
+    hi = chrom->count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (chrom->starts[mid] <= end) lo = mid + 1;
+        else hi = mid;
+    }
+    int last = lo;
     
-    printf("Parsed %d synteny blocks from %s\n", synteny_list->count, filename);
-    return synteny_list->count;
+    if (first >= last) {
+        *touched = 0;
+        return 0;
+    }
+    
+    *touched = chrom->covered[last] - chrom->covered[first];
+    long long covered = *touched;
+    if (chrom->starts[first] < start) covered -= start - chrom->starts[first];
+    if (chrom->ends[last - 1] > end) covered -= chrom->ends[last - 1] - end;
+    return covered;
+}
+
+// 区间[start, end]（如一个转座子）被共线性区间覆盖的比例；reciprocal非NULL时返回覆盖碱基
+// 占所接触区间总长度的比例。需要已构建的共线性索引
+double synteny_coverage(int chr, int64_t start, int64_t end, const SyntenyList* synteny, int genome_id,
+                        double* reciprocal) {
+    if (reciprocal) *reciprocal = 0.0;
+    if (!synteny || !synteny->index || chr == STR_NONE || end < start || (genome_id != 1 && genome_id != 2)) {
+        return 0.0;
+    }
+    
+    const ChromIntervals* chrom = find_chrom_intervals(&synteny->index->genome[genome_id - 1], chr);
+    if (!chrom) return 0.0;
+    
+    long long touched = 0;
+    long long covered = covered_bases(chrom, start, end, &touched);
+    if (reciprocal && touched > 0) *reciprocal = (double)covered / touched;
+    return (double)covered / (end - start + 1);
 }
 
-// 检查转座子是否在共线性区域内
-bool is_in_synteny_region(Transposon* te, SyntenyList* synteny, int genome_id) {
-    if (!te || !synteny || synteny->count == 0) {
+// 按比较选项判断区间是否属于共线性区域：未设置min_overlap时只要求重叠1bp。
+// coverage非NULL时返回覆盖比例（此时需要已构建的索引）
+bool is_syntenic(int chr, int64_t start, int64_t end, const SyntenyList* synteny, int genome_id,
+                 const CompareOptions* options, double* coverage) {
+    if ((!options || options->min_overlap <= 0.0) && !coverage) {
+        return is_in_synteny_region(chr, start, end, synteny, genome_id);
+    }
+    
+    double reciprocal = 0.0;
+    bool reciprocal_rule = options && options->reciprocal;
+    double fraction = synteny_coverage(chr, start, end, synteny, genome_id, reciprocal_rule ? &reciprocal : NULL);
+    if (coverage) *coverage = fraction;
+    
+    double min_overlap = options ? options->min_overlap : 0.0;
+    return fraction > 0.0 && fraction >= min_overlap && (!reciprocal_rule || reciprocal >= min_overlap);
+}
+
+// 检查区间是否与共线性区域重叠（染色体ID须来自synteny使用的字符串表）
+bool is_in_synteny_region(int chr, int64_t start, int64_t end, const SyntenyList* synteny, int genome_id) {
+    if (!synteny || synteny->count == 0 || chr == STR_NONE) {
+        return false;
+    }
+    
+    if (genome_id != 1 && genome_id != 2) {
         return false;
     }
     
+    // 有索引时按染色体ID定位后二分查找
+    if (synteny->index) {
+        const ChromIntervals* chrom = find_chrom_intervals(&synteny->index->genome[genome_id - 1], chr);
+        return chrom && intervals_overlap(chrom, start, end);
+    }
+    
+    // 没有索引时线性扫描所有区块
     for (int i = 0; i < synteny->count; i++) {
         SyntenyBlock* block = &synteny->blocks[i];
+        int block_chr = genome_id == 1 ? block->chr1 : block->chr2;
+        int64_t block_start = genome_id == 1 ? block->start1 : block->start2;
+        int64_t block_end = genome_id == 1 ? block->end1 : block->end2;
         
-        if (genome_id == 1) {
-            // 检查基因组1的转座子
-            if (strcmp(te->chr, block->chr1) == 0) {
-                // 检查是否有重叠
-                if (!(te->end < block->start1 || te->start > block->end1)) {
-                    return true;
-                }
-            }
-        } else if (genome_id == 2) {
-            // 检查基因组2的转座子
-            if (strcmp(te->chr, block->chr2) == 0) {
-                // 检查是否有重叠
-                if (!(te->end < block->start2 || te->start > block->end2)) {
-                    return true;
-                }
+        if (chr == block_chr) {
+            // 检查是否有重叠
+            if (!(end < block_start || start > block_end)) {
+                return true;
             }
         }
     }
@@ -115,6 +328,25 @@ bool is_in_synteny_region(Transposon* te, SyntenyList* synteny, int genome_id) {
     return false;
 }
 
+// 按区块内的线性插值把genome_id一侧的坐标映射到另一侧，区块外的坐标按同一比例外推
+int64_t map_through_synteny_block(const SyntenyBlock* block, int genome_id, int64_t pos) {
+    int64_t from_start = genome_id == 1 ? block->start1 : block->start2;
+    int64_t from_end = genome_id == 1 ? block->end1 : block->end2;
+    int64_t to_start = genome_id == 1 ? block->start2 : block->start1;
+    int64_t to_end = genome_id == 1 ? block->end2 : block->end1;
+    
+    int64_t from_len = from_end - from_start;
+    if (from_len == 0) return to_start;
+    int64_t to_len = to_end - to_start;
+    
+    // 偏移与区块长度的乘积超过64位时（两侧都是数Gb的区块）改用长双精度计算，同样向零取整
+    int64_t scaled;
+    if (__builtin_mul_overflow(pos - from_start, to_len, &scaled)) {
+        return to_start + (int64_t)((long double)(pos - from_start) * to_len / from_len);
+    }
+    return to_start + scaled / from_len;
+}
+
 // 打印共线性信息（用于调试）
 void print_synteny_list(SyntenyList* synteny_list, const char* title) {
     if (!synteny_list || !title) return;
@@ -129,9 +361,11 @@ void print_synteny_list(SyntenyList* synteny_list, const char* title) {
         
         for (int i = 0; i < max_print; i++) {
             SyntenyBlock* block = &synteny_list->blocks[i];
-            printf("%s\t%d\t%d\t%s\t%d\t%d\t%.2f\n",
-                   block->chr1, block->start1, block->end1,
-                   block->chr2, block->start2, block->end2,
+            const char* chr1 = string_table_get(synteny_list->strings, block->chr1);
+            const char* chr2 = string_table_get(synteny_list->strings, block->chr2);
+            printf("%s\t%lld\t%lld\t%s\t%lld\t%lld\t%.2f\n",
+                   chr1 ? chr1 : "N/A", (long long)block->start1, (long long)block->end1,
+                   chr2 ? chr2 : "N/A", (long long)block->start2, (long long)block->end2,
                    block->score);
         }
     }
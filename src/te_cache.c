@@ -0,0 +1,588 @@
+#include "te_comparator.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+// .tevx缓存文件格式
+#define TEVX_MAGIC "TEVX"
+#define TEVX_VERSION 4
+#define TEVX_BYTE_ORDER 0x01020304u
+// 计算CRC时每次处理的字节数（zlib的长度参数为uInt）
+#define TEVX_CRC_STEP (1u << 30)
+
+// 文件各段，按顺序存放，每段8字节对齐
+enum {
+    TEVX_STRING_OFFSETS,   // uint64[string_count + 1]：字符串在STRING_DATA中的偏移
+    TEVX_STRING_DATA,      // 驻留字符串（染色体、链、类型、家族），以'\0'结尾
+    TEVX_COL_START,        // int64[record_count]：1-based闭区间，与TEList的列相同
+    TEVX_COL_END,
+    TEVX_COL_CHR,          // int32[record_count]，以下各列为缓存内的字符串ID，缺失为-1
+    TEVX_COL_STRAND,
+    TEVX_COL_TYPE,
+    TEVX_COL_FAMILY,
+    TEVX_COL_SOURCE,
+    TEVX_COL_ID,           // uint64[record_count]：ID在TEXT_DATA中的偏移
+    TEVX_COL_NAME,
+    TEVX_COL_ATTRIBUTES,   // 没有保留原始属性时为UINT64_MAX
+    TEVX_TEXT_DATA,        // ID、名称和GFF3原始属性，以'\0'结尾
+    TEVX_SECTION_COUNT
+};
+
+// 文件头：记录源文件的大小、修改时间和CRC32，任一变化时缓存失效
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t file_type;
+    uint64_t source_size;
+    int64_t source_mtime_sec;
+    int64_t source_mtime_nsec;
+    uint32_t source_crc;
+    uint32_t payload_crc;      // 头部之后全部数据的CRC32，只在tevox index --verify时检查
+    uint32_t record_count;
+    uint32_t string_count;
+    uint32_t reserved[2];
+    uint64_t section_offsets[TEVX_SECTION_COUNT + 1];   // 最后一项为文件长度
+    uint32_t header_crc;       // 本字段之前头部的CRC32
+    uint32_t padding;
+} TevxHeader;
+
+// 字符串ID列（int32）的个数：COL_CHR到COL_SOURCE
+#define TEVX_ID_COLUMNS (TEVX_COL_SOURCE - TEVX_COL_CHR + 1)
+#define TEVX_NO_TEXT UINT64_MAX
+
+static uint32_t crc32_buffer(uint32_t crc, const void* data, size_t size) {
+    const unsigned char* p = (const unsigned char*)data;
+    while (size > 0) {
+        uInt n = size > TEVX_CRC_STEP ? TEVX_CRC_STEP : (uInt)size;
+        crc = (uint32_t)crc32(crc, p, n);
+        p += n;
+        size -= n;
+    }
+    return crc;
+}
+
+// 计算源文件内容的CRC32
+static int hash_source_file(int fd, size_t size, uint32_t* crc) {
+    *crc = (uint32_t)crc32(0L, Z_NULL, 0);
+    if (size == 0) return 0;
+    
+    void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) return -1;
+    madvise(map, size, MADV_SEQUENTIAL);
+    *crc = crc32_buffer(*crc, map, size);
+    munmap(map, size);
+    return 0;
+}
+
+// 缓存文件的默认路径：<源文件>.tevx
+char* te_cache_path(const char* source_file) {
+    size_t len = strlen(source_file);
+    char* path = (char*)safe_malloc(len + 6);
+    memcpy(path, source_file, len);
+    memcpy(path + len, ".tevx", 6);
+    return path;
+}
+
+// 写缓存时使用的临时文件：<缓存>.tmp.<pid>，写完后改名，读取方不会看到写了一半的文件
+static char* cache_temp_path(const char* cache_file) {
+    size_t len = strlen(cache_file) + 32;
+    char* path = (char*)safe_malloc(len);
+    snprintf(path, len, "%s.tmp.%ld", cache_file, (long)getpid());
+    return path;
+}
+
+// 写入缓冲：各段依次追加，同时累计CRC
+typedef struct {
+    OutputWriter out;
+    uint64_t offset;
+    uint32_t crc;
+    bool failed;
+} TevxWriter;
+
+static void tevx_write(TevxWriter* writer, const void* data, size_t size) {
+    writer->crc = crc32_buffer(writer->crc, data, size);
+    writer->offset += size;
+    output_writer_write(&writer->out, (const char*)data, size);
+}
+
+// 开始新的一段：补齐到8字节边界并记录段的起点
+static void tevx_begin_section(TevxWriter* writer, TevxHeader* header, int section) {
+    static const char zeros[8] = { 0 };
+    size_t pad = (size_t)((8 - writer->offset % 8) % 8);
+    if (pad > 0) tevx_write(writer, zeros, pad);
+    header->section_offsets[section] = writer->offset;
+}
+
+// 把转座子列表写成.tevx缓存；先写临时文件再改名，避免留下不完整的缓存
+int write_te_cache(const char* cache_file, const char* source_file, FileType type,
+                   const TEList* te_list) {
+    if (!cache_file || !source_file || !te_list) {
+        fprintf(stderr, "Error: Invalid parameters for write_te_cache\n");
+        return -1;
+    }
+    
+    // 记录源文件的状态和内容CRC
+    int source_fd = open(source_file, O_RDONLY);
+    struct stat st;
+    if (source_fd < 0 || fstat(source_fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        fprintf(stderr, "Error: Cannot cache non-regular file %s\n", source_file);
+        if (source_fd >= 0) close(source_fd);
+        return -1;
+    }
+    
+    TevxHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TEVX_MAGIC, 4);
+    header.version = TEVX_VERSION;
+    header.byte_order = TEVX_BYTE_ORDER;
+    header.file_type = (uint32_t)type;
+    header.source_size = (uint64_t)st.st_size;
+    header.source_mtime_sec = (int64_t)st.st_mtim.tv_sec;
+    header.source_mtime_nsec = (int64_t)st.st_mtim.tv_nsec;
+    int hashed = hash_source_file(source_fd, (size_t)st.st_size, &header.source_crc);
+    close(source_fd);
+    if (hashed != 0) {
+        fprintf(stderr, "Error: Cannot read %s\n", source_file);
+        return -1;
+    }
+    
+    // 只保存列表实际用到的字符串，重新编号
+    int n = te_list->count;
+    StringTable local;
+    init_string_table(&local);
+    // 字符串ID列按COL_CHR到COL_SOURCE的顺序重新编号，坐标列直接写出
+    const int* id_columns[TEVX_ID_COLUMNS] = {
+        te_list->chrs, te_list->strands, te_list->types, te_list->families, te_list->sources
+    };
+    int32_t* columns[TEVX_ID_COLUMNS];
+    for (int c = 0; c < TEVX_ID_COLUMNS; c++) {
+        columns[c] = (int32_t*)safe_malloc((n > 0 ? n : 1) * sizeof(int32_t));
+    }
+    for (int i = 0; i < n; i++) {
+        for (int c = 0; c < TEVX_ID_COLUMNS; c++) {
+            const char* str = string_table_get(te_list->strings, id_columns[c][i]);
+            columns[c][i] = str ? string_table_intern(&local, str) : STR_NONE;
+        }
+    }
+    
+    char* tmp_file = cache_temp_path(cache_file);
+    
+    TevxWriter writer;
+    memset(&writer, 0, sizeof(writer));
+    if (output_writer_open(&writer.out, tmp_file) != 0) {
+        fprintf(stderr, "Error: Cannot create cache file %s\n", cache_file);
+        writer.failed = true;
+    } else {
+        // 头部最后回填，这里先占位
+        tevx_write(&writer, &header, sizeof(header));
+        writer.crc = (uint32_t)crc32(0L, Z_NULL, 0);
+        
+        tevx_begin_section(&writer, &header, TEVX_STRING_OFFSETS);
+        uint64_t offset = 0;
+        for (int i = 0; i <= local.count; i++) {
+            tevx_write(&writer, &offset, sizeof(offset));
+            if (i < local.count) offset += local.lengths[i] + 1;
+        }
+        tevx_begin_section(&writer, &header, TEVX_STRING_DATA);
+        for (int i = 0; i < local.count; i++) {
+            tevx_write(&writer, local.strings[i], local.lengths[i] + 1);
+        }
+        
+        tevx_begin_section(&writer, &header, TEVX_COL_START);
+        tevx_write(&writer, te_list->starts, (size_t)n * sizeof(int64_t));
+        tevx_begin_section(&writer, &header, TEVX_COL_END);
+        tevx_write(&writer, te_list->ends, (size_t)n * sizeof(int64_t));
+        for (int c = 0; c < TEVX_ID_COLUMNS; c++) {
+            tevx_begin_section(&writer, &header, TEVX_COL_CHR + c);
+            tevx_write(&writer, columns[c], (size_t)n * sizeof(int32_t));
+        }
+        
+        // ID和名称偏移；名称与ID共用同一字符串时只保存一份
+        tevx_begin_section(&writer, &header, TEVX_COL_ID);
+        offset = 0;
+        char* const* ids = te_list->ids;
+        char* const* names = te_list->names;
+        char* const* attributes = te_list->attributes;
+        for (int i = 0; i < n; i++) {
+            tevx_write(&writer, &offset, sizeof(offset));
+            offset += strlen(ids[i]) + 1;
+        }
+        tevx_begin_section(&writer, &header, TEVX_COL_NAME);
+        uint64_t id_offset = 0;
+        for (int i = 0; i < n; i++) {
+            uint64_t name_offset = id_offset;
+            if (names[i] != ids[i]) {
+                name_offset = offset;
+                offset += strlen(names[i]) + 1;
+            }
+            tevx_write(&writer, &name_offset, sizeof(name_offset));
+            id_offset += strlen(ids[i]) + 1;
+        }
+        tevx_begin_section(&writer, &header, TEVX_COL_ATTRIBUTES);
+        for (int i = 0; i < n; i++) {
+            uint64_t attributes_offset = TEVX_NO_TEXT;
+            if (attributes[i]) {
+                attributes_offset = offset;
+                offset += strlen(attributes[i]) + 1;
+            }
+            tevx_write(&writer, &attributes_offset, sizeof(attributes_offset));
+        }
+        tevx_begin_section(&writer, &header, TEVX_TEXT_DATA);
+        for (int i = 0; i < n; i++) {
+            tevx_write(&writer, ids[i], strlen(ids[i]) + 1);
+        }
+        for (int i = 0; i < n; i++) {
+            if (names[i] != ids[i]) tevx_write(&writer, names[i], strlen(names[i]) + 1);
+        }
+        for (int i = 0; i < n; i++) {
+            if (attributes[i]) tevx_write(&writer, attributes[i], strlen(attributes[i]) + 1);
+        }
+        header.section_offsets[TEVX_SECTION_COUNT] = writer.offset;
+        
+        header.payload_crc = writer.crc;
+        header.record_count = (uint32_t)n;
+        header.string_count = (uint32_t)local.count;
+        header.header_crc = crc32_buffer((uint32_t)crc32(0L, Z_NULL, 0), &header,
+                                         offsetof(TevxHeader, header_crc));
+        
+        if (!output_writer_flush(&writer.out) ||
+            pwrite(writer.out.fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)) {
+            writer.failed = true;
+        }
+        if (output_writer_close(&writer.out) != 0) writer.failed = true;
+        
+        if (writer.failed || rename(tmp_file, cache_file) != 0) {
+            fprintf(stderr, "Error: Failed to write cache file %s\n", cache_file);
+            unlink(tmp_file);
+            writer.failed = true;
+        }
+    }
+    
+    free(tmp_file);
+    for (int c = 0; c < TEVX_ID_COLUMNS; c++) free(columns[c]);
+    free_string_table(&local);
+    
+    return writer.failed ? -1 : n;
+}
+
+// 检查头部和各段的长度是否与计数一致
+static bool validate_cache_layout(const TevxHeader* header, size_t file_size) {
+    if (memcmp(header->magic, TEVX_MAGIC, 4) != 0 || header->version != TEVX_VERSION ||
+        header->byte_order != TEVX_BYTE_ORDER) {
+        return false;
+    }
+    if (header->header_crc != crc32_buffer((uint32_t)crc32(0L, Z_NULL, 0), header,
+                                           offsetof(TevxHeader, header_crc))) {
+        return false;
+    }
+    if (header->record_count > INT32_MAX || header->string_count > INT32_MAX ||
+        header->section_offsets[TEVX_SECTION_COUNT] != file_size) {
+        return false;
+    }
+    
+    uint64_t previous = sizeof(TevxHeader);
+    for (int i = 0; i <= TEVX_SECTION_COUNT; i++) {
+        if (header->section_offsets[i] < previous || header->section_offsets[i] > file_size) return false;
+        if (i < TEVX_SECTION_COUNT && header->section_offsets[i] % 8 != 0) return false;
+        previous = header->section_offsets[i];
+    }
+    
+    // 段的长度包含下一段之前的对齐填充
+    uint64_t n = header->record_count;
+    const uint64_t* off = header->section_offsets;
+#define SECTION_SIZE(s) (off[(s) + 1] - off[(s)])
+    if (SECTION_SIZE(TEVX_STRING_OFFSETS) < (header->string_count + 1) * sizeof(uint64_t)) return false;
+    if (SECTION_SIZE(TEVX_COL_START) < n * sizeof(int64_t) || SECTION_SIZE(TEVX_COL_END) < n * sizeof(int64_t)) {
+        return false;
+    }
+    for (int c = TEVX_COL_CHR; c <= TEVX_COL_SOURCE; c++) {
+        if (SECTION_SIZE(c) < n * sizeof(int32_t)) return false;
+    }
+    if (SECTION_SIZE(TEVX_COL_ID) < n * sizeof(uint64_t) ||
+        SECTION_SIZE(TEVX_COL_NAME) < n * sizeof(uint64_t) ||
+        SECTION_SIZE(TEVX_COL_ATTRIBUTES) < n * sizeof(uint64_t)) {
+        return false;
+    }
+#undef SECTION_SIZE
+    return true;
+}
+
+// 字符串段（含对齐填充）以'\0'结尾且偏移在段内时，从偏移处开始的字符串必然在段内结束
+static bool valid_string_offset(uint64_t offset, const char* data, uint64_t size) {
+    return offset < size && data[size - 1] == '\0';
+}
+
+// 字符串ID列的取值范围为STR_NONE到string_count-1；加1后按无符号比较，循环没有分支
+static bool valid_id_column(const int32_t* column, int n, int string_count) {
+    uint32_t bad = 0;
+    for (int i = 0; i < n; i++) {
+        bad |= (uint32_t)column[i] + 1u > (uint32_t)string_count;
+    }
+    return bad == 0;
+}
+
+// 归还映射中[begin, end)范围内完整的页
+static void release_mapped_range(void* map, uint64_t begin, uint64_t end) {
+    uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+    begin = (begin + page - 1) / page * page;
+    end = end / page * page;
+    if (end > begin) madvise((char*)map + begin, (size_t)(end - begin), MADV_DONTNEED);
+}
+
+// 打开缓存的结果
+typedef enum {
+    CACHE_OK,
+    CACHE_MISSING,    // 缓存不存在或无法映射
+    CACHE_INVALID,    // 格式、版本、头部校验或文件类型不符
+    CACHE_STALE       // 源文件已经改变
+} CacheStatus;
+
+// 源文件只有修改时间变了（内容CRC相同，例如被touch或重新复制）：把新的大小和修改时间
+// 写入头部，之后的加载不必再计算源文件的CRC。与写缓存一样写临时文件后改名；
+// 失败时（例如目录只读）保持原缓存不变，只是下次加载仍要计算CRC
+static void refresh_cache_header(const char* cache_file, const void* map, size_t size,
+                                 const struct stat* source_st) {
+    TevxHeader header;
+    memcpy(&header, map, sizeof(header));
+    header.source_size = (uint64_t)source_st->st_size;
+    header.source_mtime_sec = (int64_t)source_st->st_mtim.tv_sec;
+    header.source_mtime_nsec = (int64_t)source_st->st_mtim.tv_nsec;
+    header.header_crc = crc32_buffer((uint32_t)crc32(0L, Z_NULL, 0), &header,
+                                     offsetof(TevxHeader, header_crc));
+    
+    char* tmp_file = cache_temp_path(cache_file);
+    OutputWriter out;
+    if (output_writer_open(&out, tmp_file) == 0) {
+        output_writer_write(&out, (const char*)&header, sizeof(header));
+        output_writer_write(&out, (const char*)map + sizeof(header), size - sizeof(header));
+        bool failed = !output_writer_flush(&out);
+        if (output_writer_close(&out) != 0) failed = true;
+        if (failed || rename(tmp_file, cache_file) != 0) unlink(tmp_file);
+    }
+    free(tmp_file);
+}
+
+// 映射缓存文件，检查头部、各段布局、文件类型以及源文件是否改变（不计算数据段的CRC）
+static CacheStatus map_te_cache(const char* cache_file, const char* source_file, FileType type,
+                                void** map_out, size_t* size_out) {
+    int fd = open(cache_file, O_RDONLY);
+    if (fd < 0) return CACHE_MISSING;
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(TevxHeader)) {
+        close(fd);
+        return CACHE_INVALID;
+    }
+    
+    // 私有映射：列表直接使用映射中的列，即使之后原地修改也只复制被写的页，不影响文件
+    size_t size = (size_t)st.st_size;
+    void* map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return CACHE_MISSING;
+    
+    const TevxHeader* header = (const TevxHeader*)map;
+    if (!validate_cache_layout(header, size) || header->file_type != (uint32_t)type) {
+        munmap(map, size);
+        return CACHE_INVALID;
+    }
+    
+    // 源文件大小不同则过期；修改时间不同时再比较内容CRC
+    bool fresh = false;
+    int source_fd = open(source_file, O_RDONLY);
+    struct stat source_st;
+    if (source_fd >= 0 && fstat(source_fd, &source_st) == 0 &&
+        (uint64_t)source_st.st_size == header->source_size) {
+        if ((int64_t)source_st.st_mtim.tv_sec == header->source_mtime_sec &&
+            (int64_t)source_st.st_mtim.tv_nsec == header->source_mtime_nsec) {
+            fresh = true;
+        } else {
+            uint32_t crc;
+            fresh = hash_source_file(source_fd, (size_t)source_st.st_size, &crc) == 0 &&
+                    crc == header->source_crc;
+            if (fresh) refresh_cache_header(cache_file, map, size, &source_st);
+        }
+    }
+    if (source_fd >= 0) close(source_fd);
+    
+    if (!fresh) {
+        munmap(map, size);
+        return CACHE_STALE;
+    }
+    
+    *map_out = map;
+    *size_out = size;
+    return CACHE_OK;
+}
+
+// 从.tevx缓存加载转座子列表。缓存不存在返回-1（不提示）；缓存过期或损坏时提示并返回-1。
+// 坐标列直接使用映射，字符串ID列在编号与列表的字符串表一致时也直接使用，否则换算到堆上；
+// ID/名称/属性指向映射中的字符串。映射随free_te_list释放。
+// 加载时不计算数据段的CRC，完整校验由verify_te_cache（tevox index --verify）完成
+int load_te_cache(const char* cache_file, const char* source_file, FileType type, TEList* te_list) {
+    if (!cache_file || !source_file || !te_list) return -1;
+    
+    void* map = NULL;
+    size_t size = 0;
+    CacheStatus status = map_te_cache(cache_file, source_file, type, &map, &size);
+    if (status == CACHE_INVALID) {
+        fprintf(stderr, "Warning: Ignoring invalid cache file %s\n", cache_file);
+    } else if (status == CACHE_STALE) {
+        printf("Cache %s is out of date, re-parsing %s\n", cache_file, source_file);
+    }
+    if (status != CACHE_OK) return -1;
+    
+    const char* base = (const char*)map;
+    const TevxHeader* header = (const TevxHeader*)map;
+    const uint64_t* off = header->section_offsets;
+    int n = (int)header->record_count;
+    int string_count = (int)header->string_count;
+    const uint64_t* string_offsets = (const uint64_t*)(base + off[TEVX_STRING_OFFSETS]);
+    const char* string_data = base + off[TEVX_STRING_DATA];
+    uint64_t string_data_size = off[TEVX_STRING_DATA + 1] - off[TEVX_STRING_DATA];
+    const char* text = base + off[TEVX_TEXT_DATA];
+    uint64_t text_size = off[TEVX_TEXT_DATA + 1] - off[TEVX_TEXT_DATA];
+    
+    // 映射交给列表，之后出错时由free_te_list一并释放
+    init_te_list(te_list);
+    te_list->mapping = map;
+    te_list->mapping_size = size;
+    
+    // 缓存内的字符串ID映射到列表的字符串表；编号不变时字符串ID列无需换算
+    int* id_map = (int*)safe_malloc((string_count > 0 ? string_count : 1) * sizeof(int));
+    bool valid = true;
+    bool identity = true;
+    for (int i = 0; i < string_count; i++) {
+        if (!valid_string_offset(string_offsets[i], string_data, string_data_size)) {
+            valid = false;
+            break;
+        }
+        id_map[i] = string_table_intern(te_list->strings, string_data + string_offsets[i]);
+        if (id_map[i] != i) identity = false;
+    }
+    
+    // 坐标列与列表的布局相同，直接使用映射
+    te_list->starts = (int64_t*)(base + off[TEVX_COL_START]);
+    te_list->ends = (int64_t*)(base + off[TEVX_COL_END]);
+    
+    int** id_columns[TEVX_ID_COLUMNS] = {
+        &te_list->chrs, &te_list->strands, &te_list->types, &te_list->families, &te_list->sources
+    };
+    for (int c = 0; c < TEVX_ID_COLUMNS && valid; c++) {
+        int32_t* column = (int32_t*)(base + off[TEVX_COL_CHR + c]);
+        if (!valid_id_column(column, n, string_count)) {
+            valid = false;
+            break;
+        }
+        if (identity) {
+            *id_columns[c] = column;
+        } else {
+            int* remapped = (int*)safe_malloc((n > 0 ? n : 1) * sizeof(int));
+            for (int i = 0; i < n; i++) {
+                remapped[i] = column[i] != STR_NONE ? id_map[column[i]] : STR_NONE;
+            }
+            *id_columns[c] = remapped;
+        }
+    }
+    free(id_map);
+    
+    // 字符串指针列：偏移换算为映射中的地址
+    const uint64_t* id_offsets = (const uint64_t*)(base + off[TEVX_COL_ID]);
+    const uint64_t* name_offsets = (const uint64_t*)(base + off[TEVX_COL_NAME]);
+    const uint64_t* attributes_offsets = (const uint64_t*)(base + off[TEVX_COL_ATTRIBUTES]);
+    if (valid) {
+        size_t pointers_size = (size_t)(n > 0 ? n : 1) * sizeof(char*);
+        te_list->ids = (char**)safe_malloc(pointers_size);
+        te_list->names = (char**)safe_malloc(pointers_size);
+        te_list->attributes = (char**)safe_malloc(pointers_size);
+    }
+    for (int i = 0; i < n && valid; i++) {
+        if (!valid_string_offset(id_offsets[i], text, text_size) ||
+            !valid_string_offset(name_offsets[i], text, text_size) ||
+            (attributes_offsets[i] != TEVX_NO_TEXT &&
+             !valid_string_offset(attributes_offsets[i], text, text_size))) {
+            valid = false;
+            break;
+        }
+        te_list->ids[i] = (char*)(text + id_offsets[i]);
+        te_list->names[i] = name_offsets[i] == id_offsets[i] ? te_list->ids[i] : (char*)(text + name_offsets[i]);
+        te_list->attributes[i] = attributes_offsets[i] != TEVX_NO_TEXT ? (char*)(text + attributes_offsets[i]) : NULL;
+    }
+    
+    if (!valid) {
+        fprintf(stderr, "Warning: Ignoring invalid cache file %s\n", cache_file);
+        free_te_list(te_list);
+        return -1;
+    }
+    
+    // 偏移列换算成指针后不再读取，归还其中的整页（私有映射未写过的页，需要时会从文件重新读入）
+    release_mapped_range(map, off[TEVX_COL_ID], off[TEVX_TEXT_DATA]);
+    if (!identity) release_mapped_range(map, off[TEVX_COL_CHR], off[TEVX_COL_SOURCE + 1]);
+    
+    te_list->count = n;
+    te_list->capacity = n;
+    return te_list->count;
+}
+
+// 完整检查缓存：除加载时的检查外还计算数据段的CRC32。成功时返回记录数，否则打印原因并返回-1
+int verify_te_cache(const char* cache_file, const char* source_file, FileType type) {
+    if (!cache_file || !source_file) return -1;
+    
+    void* map = NULL;
+    size_t size = 0;
+    CacheStatus status = map_te_cache(cache_file, source_file, type, &map, &size);
+    if (status == CACHE_MISSING) {
+        fprintf(stderr, "Error: Cannot open cache file %s\n", cache_file);
+        return -1;
+    }
+    if (status == CACHE_INVALID) {
+        fprintf(stderr, "Error: Invalid cache file %s\n", cache_file);
+        return -1;
+    }
+    if (status == CACHE_STALE) {
+        fprintf(stderr, "Error: Cache %s is out of date for %s\n", cache_file, source_file);
+        return -1;
+    }
+    
+    const TevxHeader* header = (const TevxHeader*)map;
+    madvise(map, size, MADV_SEQUENTIAL);
+    bool matched = crc32_buffer((uint32_t)crc32(0L, Z_NULL, 0), (const char*)map + sizeof(TevxHeader),
+                                size - sizeof(TevxHeader)) == header->payload_crc;
+    int count = (int)header->record_count;
+    munmap(map, size);
+    
+    if (!matched) {
+        fprintf(stderr, "Error: Checksum mismatch in cache file %s\n", cache_file);
+        return -1;
+    }
+    return count;
+}
+
+// 带缓存的解析：缓存有效时直接加载，否则解析源文件，write_cache为真时同时重建缓存
+int parse_te_file_cached(const char* filename, FileType type, TEList* te_list, int num_threads,
+                         bool write_cache) {
+    // 标准输入和管道没有可以校验的源文件，直接解析
+    struct stat st;
+    if (strcmp(filename, "-") == 0 || stat(filename, &st) != 0 || !S_ISREG(st.st_mode)) {
+        return parse_te_file_mt(filename, type, te_list, num_threads);
+    }
+    
+    char* cache_file = te_cache_path(filename);
+    int result = load_te_cache(cache_file, filename, type, te_list);
+    
+    if (result >= 0) {
+        printf("Loaded %d transposons from cache %s\n", result, cache_file);
+    } else {
+        result = parse_te_file_mt(filename, type, te_list, num_threads);
+        if (result >= 0 && write_cache && write_te_cache(cache_file, filename, type, te_list) >= 0) {
+            printf("Wrote cache %s\n", cache_file);
+        }
+    }
+    
+    free(cache_file);
+    return result;
+}
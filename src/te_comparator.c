@@ -1,55 +1,164 @@
 #include "te_comparator.h"
 
-// 比较两个基因组间的TE差异
-int compare_te_differences(TEList* te1, TEList* te2, SyntenyList* synteny, 
-                           TEList* unique_te1, TEList* unique_te2) {
-    if (!te1 || !te2 || !unique_te1 || !unique_te2) {
-        fprintf(stderr, "Error: Invalid parameters for compare_te_differences\n");
-        return -1;
-    }
+// 每个比较任务处理的转座子数
+#define COMPARE_CHUNK_SIZE 65536
+
+// 比较任务：某个基因组中[begin, end)范围内的转座子
+typedef struct {
+    const TEList* te_list;
+    int genome_id;
+    int begin;
+    int end;
+    TESelection unique;     // 该范围内的独有转座子，下标相对整个列表
+} CompareTask;
+
+typedef struct {
+    CompareTask* tasks;
+    const SyntenyList* synteny;
+    const CompareOptions* options;
+} CompareJob;
+
+// 初始化比较选项
+void init_compare_options(CompareOptions* options) {
+    if (!options) return;
+    options->num_threads = 1;
+    options->min_overlap = 0.0;
+    options->reciprocal = false;
+}
+
+// 执行一个比较任务（只读访问TE列表和共线性索引，可并发执行）
+static void run_compare_task(void* ctx, int task_index) {
+    CompareJob* job = (CompareJob*)ctx;
+    CompareTask* task = &job->tasks[task_index];
+    const SyntenyList* synteny = job->synteny;
     
-    init_te_list(unique_te1);
-    init_te_list(unique_te2);
+    init_te_selection(&task->unique, task->te_list);
     
-    printf("Comparing TE differences between two genomes...\n");
-    printf("Genome 1: %d transposons\n", te1->count);
-    printf("Genome 2: %d transposons\n", te2->count);
-    printf("Synteny blocks: %d\n", synteny ? synteny->count : 0);
+    // 只顺序读取染色体和起止坐标三列
+    const int* chrs = task->te_list->chrs;
+    const int64_t* starts = task->te_list->starts;
+    const int64_t* ends = task->te_list->ends;
     
-    // 查找基因组1中独有的转座子
-    int unique_count_1 = 0;
-    for (int i = 0; i < te1->count; i++) {
-        Transposon* te = &te1->transposons[i];
-        
+    for (int i = task->begin; i < task->end; i++) {
         // 如果没有共线性信息，或者转座子不在共线性区域内，则认为是独有的
         bool in_synteny = false;
         if (synteny && synteny->count > 0) {
-            in_synteny = is_in_synteny_region(te, synteny, 1);
+            in_synteny = is_syntenic(chrs[i], starts[i], ends[i], synteny, task->genome_id, job->options, NULL);
         }
         
         if (!in_synteny) {
-            add_transposon(unique_te1, te);
-            unique_count_1++;
+            te_selection_add(&task->unique, i);
         }
     }
+}
+
+// 把一个基因组切分为比较任务，返回任务数
+static int split_compare_tasks(CompareTask* tasks, const TEList* te_list, int genome_id) {
+    int count = 0;
+    for (int begin = 0; begin < te_list->count; begin += COMPARE_CHUNK_SIZE) {
+        tasks[count].te_list = te_list;
+        tasks[count].genome_id = genome_id;
+        tasks[count].begin = begin;
+        tasks[count].end = begin + COMPARE_CHUNK_SIZE < te_list->count ? 
+                           begin + COMPARE_CHUNK_SIZE : te_list->count;
+        count++;
+    }
+    return count;
+}
+
+// 按任务顺序把各任务的结果拼接到selection
+static void merge_compare_tasks(TESelection* selection, CompareTask* tasks, int task_count) {
+    int total = 0;
+    for (int i = 0; i < task_count; i++) total += tasks[i].unique.count;
     
-    // 查找基因组2中独有的转座子
-    int unique_count_2 = 0;
-    for (int i = 0; i < te2->count; i++) {
-        Transposon* te = &te2->transposons[i];
-        
-        // 如果没有共线性信息，或者转座子不在共线性区域内，则认为是独有的
-        bool in_synteny = false;
-        if (synteny && synteny->count > 0) {
-            in_synteny = is_in_synteny_region(te, synteny, 2);
-        }
-        
-        if (!in_synteny) {
-            add_transposon(unique_te2, te);
-            unique_count_2++;
+    if (total > 0) {
+        selection->indices = (int*)safe_malloc(total * sizeof(int));
+        selection->capacity = total;
+    }
+    
+    for (int i = 0; i < task_count; i++) {
+        if (tasks[i].unique.count > 0) {
+            memcpy(selection->indices + selection->count, tasks[i].unique.indices,
+                   tasks[i].unique.count * sizeof(int));
+            selection->count += tasks[i].unique.count;
         }
+        free_te_selection(&tasks[i].unique);
+    }
+}
+
+// 找出两个基因组的独有转座子，不输出任何信息，返回独有转座子总数。
+// 只读访问转座子列表和共线性列表，可在多个线程中对同一份数据同时调用；
+// 设置了min_overlap时共线性索引须事先由build_synteny_index构建
+int collect_unique_transposons(const TEList* te1, const TEList* te2, const SyntenyList* synteny,
+                               TESelection* unique_te1, TESelection* unique_te2,
+                               const CompareOptions* options) {
+    if (!te1 || !te2 || !unique_te1 || !unique_te2) {
+        fprintf(stderr, "Error: Invalid parameters for collect_unique_transposons\n");
+        return -1;
     }
     
+    // 染色体ID只有在同一字符串表内才可比较
+    if (synteny && (te1->strings != synteny->strings || te2->strings != synteny->strings)) {
+        fprintf(stderr, "Error: TE lists and synteny list must share a string table\n");
+        return -1;
+    }
+    
+    CompareOptions default_options;
+    if (!options) {
+        init_compare_options(&default_options);
+        options = &default_options;
+    }
+    
+    init_te_selection(unique_te1, te1);
+    init_te_selection(unique_te2, te2);
+    
+    // 两个基因组的转座子按固定大小切分成任务，由线程池并行处理
+    int max_tasks = (te1->count + COMPARE_CHUNK_SIZE - 1) / COMPARE_CHUNK_SIZE +
+                    (te2->count + COMPARE_CHUNK_SIZE - 1) / COMPARE_CHUNK_SIZE;
+    CompareTask* tasks = (CompareTask*)safe_malloc((max_tasks > 0 ? max_tasks : 1) * sizeof(CompareTask));
+    int task_count_1 = split_compare_tasks(tasks, te1, 1);
+    int task_count_2 = split_compare_tasks(tasks + task_count_1, te2, 2);
+    
+    CompareJob job;
+    job.tasks = tasks;
+    job.synteny = synteny;
+    job.options = options;
+    parallel_for(task_count_1 + task_count_2, options->num_threads, run_compare_task, &job);
+    
+    // 按原始顺序合并，结果与单线程完全一致
+    merge_compare_tasks(unique_te1, tasks, task_count_1);
+    merge_compare_tasks(unique_te2, tasks + task_count_1, task_count_2);
+    free(tasks);
+    
+    return unique_te1->count + unique_te2->count;
+}
+
+// 比较两个基因组间的TE差异并输出统计；options为NULL时使用默认选项（单线程）
+int compare_te_differences(TEList* te1, TEList* te2, SyntenyList* synteny, 
+                           TESelection* unique_te1, TESelection* unique_te2,
+                           const CompareOptions* options) {
+    if (!te1 || !te2 || !unique_te1 || !unique_te2) {
+        fprintf(stderr, "Error: Invalid parameters for compare_te_differences\n");
+        return -1;
+    }
+    
+    // 覆盖比例需要合并区间的前缀和
+    if (synteny && synteny->count > 0 && !synteny->index && options && options->min_overlap > 0.0) {
+        build_synteny_index(synteny);
+    }
+    
+    printf("Comparing TE differences between two genomes...\n");
+    printf("Genome 1: %d transposons\n", te1->count);
+    printf("Genome 2: %d transposons\n", te2->count);
+    printf("Synteny blocks: %d\n", synteny ? synteny->count : 0);
+    
+    if (collect_unique_transposons(te1, te2, synteny, unique_te1, unique_te2, options) < 0) {
+        return -1;
+    }
+    
+    int unique_count_1 = unique_te1->count;
+    int unique_count_2 = unique_te2->count;
+    
     printf("\n=== TE Difference Analysis Results ===\n");
     printf("Genome 1 unique transposons: %d (%.1f%% of total)\n", 
            unique_count_1, te1->count > 0 ? (100.0 * unique_count_1 / te1->count) : 0.0);
@@ -66,7 +175,7 @@ int compare_te_differences(TEList* te1, TEList* te2, SyntenyList* synteny,
 }
 
 // 按类型分析转座子
-void analyze_te_types(TEList* unique_te1, TEList* unique_te2) {
+void analyze_te_types(TESelection* unique_te1, TESelection* unique_te2) {
     printf("\n=== Transposon Type Analysis ===\n");
     
     // 统计基因组1的转座子类型
@@ -91,7 +200,7 @@ void analyze_te_types(TEList* unique_te1, TEList* unique_te2) {
 }
 
 // 按家族分析转座子
-void analyze_te_families(TEList* unique_te1, TEList* unique_te2) {
+void analyze_te_families(TESelection* unique_te1, TESelection* unique_te2) {
     printf("\n=== Transposon Family Analysis ===\n");
     
     // 统计基因组1的转座子家族
@@ -115,44 +224,160 @@ void analyze_te_families(TEList* unique_te1, TEList* unique_te2) {
     }
 }
 
-// 统计转座子类型
-TypeCount* count_te_types(TEList* te_list) {
-    if (!te_list || te_list->count == 0) {
-        return NULL;
+// 分组字段的固定顺序，决定分组键中各字段的位置
+static const int group_field_order[4] = { GROUP_TYPE, GROUP_FAMILY, GROUP_CHR, GROUP_STRAND };
+static const char* group_field_names[4] = { "type", "family", "chr", "strand" };
+
+// 计算分组包含的字段数
+static int group_field_count(int fields) {
+    int n = 0;
+    for (int f = 0; f < 4; f++) {
+        if (fields & group_field_order[f]) n++;
     }
+    return n;
+}
+
+// 解析逗号分隔的分组字段，如"type,family"，非法时返回-1
+int parse_group_fields(const char* spec) {
+    if (!spec || !*spec) return -1;
     
-    // 首先统计有多少种不同的类型
-    int type_capacity = 10;
-    TypeCount* types = (TypeCount*)safe_malloc((type_capacity + 1) * sizeof(TypeCount));
-    int type_count = 0;
-    
-    for (int i = 0; i < te_list->count; i++) {
-        Transposon* te = &te_list->transposons[i];
-        char* type = te->type ? te->type : "unknown";
-        
-        // 查找是否已经存在这个类型
-        int found = 0;
-        for (int j = 0; j < type_count; j++) {
-            if (strcmp(types[j].type, type) == 0) {
-                types[j].count++;
-                found = 1;
+    int fields = 0;
+    const char* p = spec;
+    while (*p) {
+        size_t len = strcspn(p, ",");
+        int matched = 0;
+        for (int f = 0; f < 4; f++) {
+            if (strlen(group_field_names[f]) == len && strncmp(p, group_field_names[f], len) == 0) {
+                fields |= group_field_order[f];
+                matched = 1;
                 break;
             }
         }
+        if (!matched) return -1;
+        p += len;
+        if (*p == ',') p++;
+    }
+    return fields;
+}
+
+// 将各字段的字符串ID打包为分组键：每个字段占64/字段数位，ID+1存放（0表示缺失）
+static bool pack_group_key(int fields, const int ids[4], uint64_t* key) {
+    int bits = 64 / group_field_count(fields);
+    uint64_t limit = bits >= 64 ? UINT64_MAX : ((uint64_t)1 << bits) - 1;
+    
+    uint64_t packed = 0;
+    for (int f = 0; f < 4; f++) {
+        if (!(fields & group_field_order[f])) continue;
+        uint64_t value = (uint64_t)(ids[f] + 1);
+        if (value > limit) return false;
+        packed = bits >= 64 ? value : (packed << bits) | value;
+    }
+    *key = packed;
+    return true;
+}
+
+// 将分组键还原为各字段的字符串ID（未参与分组的字段为STR_NONE）
+void decode_group_key(int fields, uint64_t key, int ids[4]) {
+    int n = group_field_count(fields);
+    int bits = n > 0 ? 64 / n : 64;
+    uint64_t mask = bits >= 64 ? UINT64_MAX : ((uint64_t)1 << bits) - 1;
+    
+    for (int f = 3; f >= 0; f--) {
+        ids[f] = STR_NONE;
+        if (!(fields & group_field_order[f])) continue;
+        ids[f] = (int)(key & mask) - 1;
+        key = bits >= 64 ? 0 : key >> bits;
+    }
+}
+
+// 把分组键格式化为可读文本，多个字段以'/'分隔
+void format_group_key(const StringTable* strings, int fields, uint64_t key, 
+                      char* buffer, size_t size) {
+    if (!buffer || size == 0) return;
+    
+    int ids[4];
+    decode_group_key(fields, key, ids);
+    
+    size_t used = 0;
+    buffer[0] = '\0';
+    for (int f = 0; f < 4 && used < size; f++) {
+        if (!(fields & group_field_order[f])) continue;
+        const char* value = string_table_get(strings, ids[f]);
+        int written = snprintf(buffer + used, size - used, "%s%s", 
+                               used > 0 ? "/" : "", value ? value : "unknown");
+        if (written < 0) break;
+        used += (size_t)written;
+    }
+}
+
+// 按指定字段对选择集分组计数，返回分组数；字段ID超出分组键范围时返回-1
+int count_te_groups(TESelection* selection, int fields, CountTable* counts) {
+    if (!counts) return -1;
+    init_count_table(counts);
+    
+    if (!selection || !selection->source || fields <= 0 || group_field_count(fields) == 0) {
+        return -1;
+    }
+    
+    const TEList* te_list = selection->source;
+    
+    // 缺失的类型和家族与名为"unknown"的条目归为一组
+    int unknown_id = string_table_find(te_list->strings, "unknown");
+    
+    // 只读取参与分组的列
+    const int* types = (fields & GROUP_TYPE) ? te_list->types : NULL;
+    const int* families = (fields & GROUP_FAMILY) ? te_list->families : NULL;
+    const int* chrs = (fields & GROUP_CHR) ? te_list->chrs : NULL;
+    const int* strands = (fields & GROUP_STRAND) ? te_list->strands : NULL;
+    
+    for (int i = 0; i < selection->count; i++) {
+        int k = selection->indices[i];
+        int ids[4] = { STR_NONE, STR_NONE, STR_NONE, STR_NONE };
+        if (types) ids[0] = types[k] != STR_NONE ? types[k] : unknown_id;
+        if (families) ids[1] = families[k] != STR_NONE ? families[k] : unknown_id;
+        if (chrs) ids[2] = chrs[k];
+        if (strands) ids[3] = strands[k];
         
-        // 如果没找到，添加新类型
-        if (!found) {
-            if (type_count >= type_capacity) {
-                type_capacity *= 2;
-                types = (TypeCount*)safe_realloc(types, (type_capacity + 1) * sizeof(TypeCount));
-            }
-            
-            types[type_count].type = strdup_safe(type);
-            types[type_count].count = 1;
-            type_count++;
+        uint64_t key;
+        if (!pack_group_key(fields, ids, &key)) {
+            fprintf(stderr, "Error: Too many distinct strings to group by this field combination\n");
+            free_count_table(counts);
+            return -1;
         }
+        count_table_add(counts, key, 1);
     }
     
+    return counts->count;
+}
+
+// 按单个字段统计，结果以NULL名称结尾
+static CountEntry* count_single_field(TESelection* selection, int field, int* group_count) {
+    CountTable counts;
+    if (count_te_groups(selection, field, &counts) <= 0) {
+        free_count_table(&counts);
+        return NULL;
+    }
+    
+    CountEntry* entries = counts.entries;
+    *group_count = counts.count;
+    free(counts.slots);
+    return entries;
+}
+
+// 统计选择集中转座子的类型
+TypeCount* count_te_types(TESelection* selection) {
+    int type_count = 0;
+    CountEntry* entries = count_single_field(selection, GROUP_TYPE, &type_count);
+    if (!entries) return NULL;
+    
+    TypeCount* types = (TypeCount*)safe_malloc((type_count + 1) * sizeof(TypeCount));
+    for (int i = 0; i < type_count; i++) {
+        const char* type = string_table_get(selection->source->strings, (int)entries[i].key - 1);
+        types[i].type = type ? type : "unknown";
+        types[i].count = entries[i].count;
+    }
+    free(entries);
+    
     // 添加结束标记
     types[type_count].type = NULL;
     types[type_count].count = 0;
@@ -160,43 +385,19 @@ TypeCount* count_te_types(TEList* te_list) {
     return types;
 }
 
-// 统计转座子家族
-FamilyCount* count_te_families(TEList* te_list) {
-    if (!te_list || te_list->count == 0) {
-        return NULL;
-    }
-    
-    // 首先统计有多少种不同的家族
-    int family_capacity = 10;
-    FamilyCount* families = (FamilyCount*)safe_malloc((family_capacity + 1) * sizeof(FamilyCount));
+// 统计选择集中转座子的家族
+FamilyCount* count_te_families(TESelection* selection) {
     int family_count = 0;
+    CountEntry* entries = count_single_field(selection, GROUP_FAMILY, &family_count);
+    if (!entries) return NULL;
     
-    for (int i = 0; i < te_list->count; i++) {
-        Transposon* te = &te_list->transposons[i];
-        char* family = te->family ? te->family : "unknown";
-        
-        // 查找是否已经存在这个家族
-        int found = 0;
-        for (int j = 0; j < family_count; j++) {
-            if (strcmp(families[j].family, family) == 0) {
-                families[j].count++;
-                found = 1;
-                break;
-            }
-        }
-        
-        // 如果没找到，添加新家族
-        if (!found) {
-            if (family_count >= family_capacity) {
-                family_capacity *= 2;
-                families = (FamilyCount*)safe_realloc(families, (family_capacity + 1) * sizeof(FamilyCount));
-            }
-            
-            families[family_count].family = strdup_safe(family);
-            families[family_count].count = 1;
-            family_count++;
-        }
+    FamilyCount* families = (FamilyCount*)safe_malloc((family_count + 1) * sizeof(FamilyCount));
+    for (int i = 0; i < family_count; i++) {
+        const char* family = string_table_get(selection->source->strings, (int)entries[i].key - 1);
+        families[i].family = family ? family : "unknown";
+        families[i].count = entries[i].count;
     }
+    free(entries);
     
     // 添加结束标记
     families[family_count].family = NULL;
@@ -205,60 +406,76 @@ FamilyCount* count_te_families(TEList* te_list) {
     return families;
 }
 
-// 将结果写入文件
-void write_results_to_file(TEList* unique_te1, TEList* unique_te2, 
-                           const char* output_prefix) {
-    if (!unique_te1 || !unique_te2 || !output_prefix) {
+// 打印按字段分组的计数（按数量降序）
+void print_te_group_counts(TESelection* selection, int fields, const char* title) {
+    if (!selection || !selection->source || !title) return;
+    
+    CountTable counts;
+    if (count_te_groups(selection, fields, &counts) < 0) {
+        free_count_table(&counts);
         return;
     }
+    count_table_sort_by_count(&counts);
     
-    // 写入基因组1的独有转座子
-    char filename1[512];
-    snprintf(filename1, sizeof(filename1), "%s_genome1_unique.txt", output_prefix);
+    printf("\n=== %s ===\n", title);
+    printf("Groups: %d\n", counts.count);
     
-    FILE* file1 = fopen(filename1, "w");
-    if (file1) {
-        fprintf(file1, "# Unique transposons in Genome 1\n");
-        fprintf(file1, "# ID\tChr\tStart\tEnd\tStrand\tType\tFamily\tName\n");
-        
-        for (int i = 0; i < unique_te1->count; i++) {
-            Transposon* te = &unique_te1->transposons[i];
-            fprintf(file1, "%s\t%s\t%d\t%d\t%s\t%s\t%s\t%s\n",
-                   te->id ? te->id : "N/A",
-                   te->chr ? te->chr : "N/A",
-                   te->start,
-                   te->end,
-                   te->strand ? te->strand : ".",
-                   te->type ? te->type : "N/A",
-                   te->family ? te->family : "N/A",
-                   te->name ? te->name : "N/A");
-        }
-        fclose(file1);
-        printf("Genome 1 unique TEs written to: %s\n", filename1);
+    char label[1024];
+    for (int i = 0; i < counts.count; i++) {
+        format_group_key(selection->source->strings, fields, counts.entries[i].key, 
+                         label, sizeof(label));
+        printf("  %s: %d (%.1f%%)\n", label, counts.entries[i].count,
+               selection->count > 0 ? 100.0 * counts.entries[i].count / selection->count : 0.0);
     }
     
-    // 写入基因组2的独有转座子
-    char filename2[512];
-    snprintf(filename2, sizeof(filename2), "%s_genome2_unique.txt", output_prefix);
+    free_count_table(&counts);
+}
+
+// 将结果写入文件
+// coverage_synteny非NULL时每行附带被共线性区间覆盖的比例
+int write_results_to_file(TESelection* unique_te1, TESelection* unique_te2, const char* output_prefix,
+                          OutputFormat format, const SyntenyList* coverage_synteny) {
+    if (!unique_te1 || !unique_te2 || !output_prefix || 
+        !unique_te1->source || !unique_te2->source) {
+        return -1;
+    }
     
-    FILE* file2 = fopen(filename2, "w");
-    if (file2) {
-        fprintf(file2, "# Unique transposons in Genome 2\n");
-        fprintf(file2, "# ID\tChr\tStart\tEnd\tStrand\tType\tFamily\tName\n");
-        
-        for (int i = 0; i < unique_te2->count; i++) {
-            Transposon* te = &unique_te2->transposons[i];
-            fprintf(file2, "%s\t%s\t%d\t%d\t%s\t%s\t%s\t%s\n",
-                   te->id ? te->id : "N/A",
-                   te->chr ? te->chr : "N/A",
-                   te->start,
-                   te->end,
-                   te->strand ? te->strand : ".",
-                   te->type ? te->type : "N/A",
-                   te->family ? te->family : "N/A",
-                   te->name ? te->name : "N/A");
+    TESelection* selections[2] = { unique_te1, unique_te2 };
+    for (int g = 0; g < 2; g++) {
+        char filename[512];
+        output_file_name(filename, sizeof(filename), output_prefix, g + 1, format);
+        if (write_unique_file(selections[g], filename, format, g + 1, coverage_synteny) != 0) {
+            return -1;
         }
-        fclose(file2);
-        printf("Genome 2 unique TEs written to: %s\n", filename2);
+        printf("Genome %d unique TEs written to: %s\n", g + 1,
+               strcmp(filename, "-") == 0 ? "standard output" : filename);
+    }
+    return 0;
+}
+
+// 把一个基因组的独有转座子写到filename（"-"为标准输出），不输出运行信息，可在多个线程中
+// 同时写不同的文件
+int write_unique_file(const TESelection* selection, const char* filename, OutputFormat format,
+                      int genome_id, const SyntenyList* coverage_synteny) {
+    if (!selection || !selection->source || !filename) return -1;
+    
+    OutputWriter writer;
+    if (output_writer_open(&writer, filename) != 0) {
+        fprintf(stderr, "Error: Cannot create output file %s\n", filename);
+        return -1;
+    }
+    
+    write_unique_header(&writer, format, genome_id, coverage_synteny != NULL);
+    for (int i = 0; i < selection->count; i++) {
+        Transposon te;
+        te_selection_get(selection, i, &te);
+        double coverage = coverage_synteny ? synteny_coverage(te.chr, te.start, te.end, coverage_synteny,
+                                                              genome_id, NULL) : -1.0;
+        write_te_record(&writer, format, selection->source->strings, &te, coverage);
+    }
+    if (output_writer_close(&writer) != 0) {
+        fprintf(stderr, "Error: Failed to write output file %s\n", filename);
+        return -1;
     }
-}
\ No newline at end of file
+    return 0;
+}
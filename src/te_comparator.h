@@ -10,59 +10,334 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <ctype.h>
+#include <setjmp.h>
+
+// 字符串ID缺失时的取值
+#define STR_NONE (-1)
+
+// 坐标的上限（2^62）：超过的值按上限处理，坐标加减1或容差时不会溢出
+#define MAX_POSITION ((int64_t)1 << 62)
 
 // 数据结构定义
+
+// 内存池：字符串等小对象顺序分配在大块内存中，整体一次释放
+typedef struct ArenaSlab {
+    struct ArenaSlab* next;
+    size_t used;
+    size_t size;
+    char data[];
+} ArenaSlab;
+
+typedef struct {
+    ArenaSlab* head;
+    size_t bytes_used;
+} Arena;
+
+// 内存池的分配位置，arena_reset回到这里并释放之后的分配
+typedef struct {
+    ArenaSlab* head;
+    ArenaSlab* next;
+    size_t used;
+    size_t bytes_used;
+} ArenaMark;
+
+// 字符串驻留表：把重复出现的字符串（染色体、链、类型、家族）编码为小整数ID
+typedef struct {
+    char** strings;      // ID -> 字符串
+    size_t* lengths;
+    int count;
+    int capacity;
+    int* slots;          // 开放寻址哈希槽，存放ID，空槽为STR_NONE
+    int slot_capacity;
+    Arena arena;         // 字符串内容的存储
+} StringTable;
+
 typedef struct {
     char* chr;
-    int start;
-    int end;
+    int64_t start;
+    int64_t end;
     char* strand;
 } GenomicRegion;
 
+// 区间列表（--region），坐标为1-based闭区间
+typedef struct {
+    GenomicRegion* regions;
+    int count;
+    int capacity;
+} RegionList;
+
+// 单条转座子记录：解析时逐条填写后由te_list_push追加，读取时由te_list_get从各列取出。
+// chr/strand/type/family/source为所属列表字符串表中的ID，缺失时为STR_NONE
+// id/name/attributes存放在所属列表的内存池中，随列表一起释放
 typedef struct {
     char* id;
-    char* chr;
-    int start;
-    int end;
-    char* strand;
-    char* type;
-    char* family;
+    int chr;
+    int64_t start;          // 1-based闭区间
+    int64_t end;
+    int strand;
+    int type;
+    int family;
     char* name;
+    int source;          // GFF3第2列，仅在保留原始属性时记录
+    char* attributes;    // GFF3第9列原文，仅在保留原始属性时记录，否则为NULL
 } Transposon;
 
 typedef struct {
-    char* chr1;
-    int start1;
-    int end1;
-    char* chr2;
-    int start2;
-    int end2;
+    int chr1;
+    int64_t start1;
+    int64_t end1;
+    int chr2;
+    int64_t start2;
+    int64_t end2;
     double score;
 } SyntenyBlock;
 
+// 转座子列表按列存储：每个字段一个连续数组，下标为记录在注释中的顺序。
+// 重叠判断只读取chrs/starts/ends，分组计数只读取参与分组的列
 typedef struct {
-    Transposon* transposons;
+    int* chrs;
+    int64_t* starts;
+    int64_t* ends;
+    int* strands;
+    int* types;
+    int* families;
+    int* sources;
+    char** ids;
+    char** names;
+    char** attributes;
     int count;
     int capacity;
+    StringTable* strings;  // 字符串ID所属的表，默认为共享表
+    Arena arena;           // id/name字符串的存储
+    void* mapping;         // 从.tevx缓存加载时的映射（坐标列、id/name等可直接位于其中），随列表一起释放
+    size_t mapping_size;
+    int* input_order;      // sort_te_list之后每条记录在原注释中的下标，未排序时为NULL
 } TEList;
 
+// 单条染色体上合并后的共线性区间（互不重叠，按起点升序）
+typedef struct {
+    int64_t* starts;
+    int64_t* ends;
+    long long* covered;     // 前缀和：covered[i]为前i个区间的总长度，共count+1项
+    int count;
+} ChromIntervals;
+
+// 一个基因组一侧的共线性区间集合（按染色体ID直接索引）
+typedef struct {
+    ChromIntervals* chroms;
+    int chrom_count;
+} IntervalSet;
+
+// 共线性查询索引：genome[0]对应chr1侧，genome[1]对应chr2侧
+typedef struct {
+    IntervalSet genome[2];
+} SyntenyIndex;
+
+// 转座子选择集：源列表中被选中记录的下标（升序），不复制记录本身
+typedef struct {
+    const TEList* source;
+    int* indices;
+    int count;
+    int capacity;
+} TESelection;
+
 typedef struct {
     SyntenyBlock* blocks;
     int count;
     int capacity;
+    StringTable* strings;  // 字符串ID所属的表，默认为共享表
+    SyntenyIndex* index;   // 由build_synteny_index构建，NULL时退化为线性扫描
+    int* input_order;      // sort_synteny_list之后每个区块在原文件中的下标，未排序时为NULL
 } SyntenyList;
 
+// 名称指向源列表的字符串表，调用方只需释放数组本身
 typedef struct {
-    char* type;
+    const char* type;
     int count;
 } TypeCount;
 
 typedef struct {
-    char* family;
+    const char* family;
     int count;
 } FamilyCount;
 
+// 分组计数表：以64位键为键的开放寻址哈希表，条目按首次出现顺序保存
+typedef struct {
+    uint64_t key;
+    int count;
+} CountEntry;
+
+typedef struct {
+    CountEntry* entries;
+    int count;
+    int capacity;
+    int* slots;          // 哈希槽 -> entries下标，空槽为-1
+    int slot_capacity;
+} CountTable;
+
+// 转座子分组字段，可按位组合
+typedef enum {
+    GROUP_TYPE = 1 << 0,
+    GROUP_FAMILY = 1 << 1,
+    GROUP_CHR = 1 << 2,
+    GROUP_STRAND = 1 << 3
+} TEGroupField;
+
+// 字段切片：指向输入缓冲区中的一段文本，不以'\0'结尾
+typedef struct {
+    const char* ptr;
+    size_t len;
+} StrSlice;
+
+// gzip/BGZF解压流（在gzip_reader.c中定义）
+typedef struct InflateStream InflateStream;
+
+// 可随机访问的BGZF读取器（在gzip_reader.c中定义）
+typedef struct BgzfReader BgzfReader;
+
+// 按行读取输入：普通文件mmap后零拷贝，管道等退化为流式缓冲读取，
+// gzip/BGZF压缩输入（按魔数识别）由后台线程解压后流式读取
+typedef struct {
+    int fd;
+    const char* data;        // 映射区或流式缓冲区
+    size_t size;             // data中有效数据的字节数
+    size_t pos;              // 下一行的起点
+    size_t scan;             // 流式模式下已查找过换行符的位置
+    bool mapped;             // data为完整的内存数据（mmap或外部缓冲区）
+    bool owns_mapping;       // 关闭时需要munmap
+    bool eof;
+    char* buffer;            // 流式模式的缓冲区
+    size_t buffer_capacity;
+    size_t bytes_read;       // 流式模式已读取的总字节数
+    int line_num;            // 已返回的行数
+    InflateStream* inflate;  // 压缩输入的解压流，未压缩时为NULL
+    bool keep_all;           // 流式模式下保留已读过的行，以便line_reader_unread回到开头
+} LineReader;
+
+// 比较选项
+typedef struct {
+    int num_threads;        // 比较使用的线程数，0表示使用所有CPU
+    double min_overlap;     // 转座子被共线性区间覆盖的最小比例，0表示至少重叠1bp
+    bool reciprocal;        // 同时要求转座子占所接触区间总长度的比例不低于min_overlap
+} CompareOptions;
+
+// 结果输出格式
+typedef enum {
+    OUTPUT_TSV,
+    OUTPUT_BED,
+    OUTPUT_GFF3
+} OutputFormat;
+
+// 带缓冲的输出：绕过stdio直接write(2)，大块写出
+typedef struct {
+    int fd;
+    bool owns_fd;
+    char* buffer;
+    size_t size;
+    size_t capacity;
+    bool failed;
+} OutputWriter;
+
+// 隐式区间树：一条染色体上按起点排序的区间，max_ends为各节点子树的最大终点
+typedef struct {
+    int64_t* starts;
+    int64_t* ends;
+    int64_t* max_ends;
+    int* ids;               // 区间对应的原始记录下标
+    int count;
+    int max_level;          // 根节点所在的层，空树为-1
+} IntervalTree;
+
+// 按染色体ID直接索引的区间树
+typedef struct {
+    IntervalTree* trees;
+    int chrom_count;
+} IntervalTrees;
+
+// 直系同源分类
+typedef enum {
+    ORTHOLOGY_SHARED,       // 映射位置的容差内有同家族转座子
+    ORTHOLOGY_PAV,          // 在共线性区域内但另一基因组没有对应转座子
+    ORTHOLOGY_OUTSIDE,      // 不在共线性区域内
+    ORTHOLOGY_CLASS_COUNT
+} OrthologyClass;
+
+// 一个基因组的分类结果，下标与TEList一致
+typedef struct {
+    unsigned char* classes;     // OrthologyClass
+    int* partners;              // 另一基因组中对应转座子的下标，没有时为-1
+    int* mapped_chr;            // 映射到另一基因组的位置，不在共线性区域内时为STR_NONE
+    int64_t* mapped_start;
+    int64_t* mapped_end;
+    int count;
+    int class_counts[ORTHOLOGY_CLASS_COUNT];
+} OrthologyResult;
+
+// 多基因组manifest中的一个基因组
+typedef struct {
+    char* name;
+    char* te_file;
+    TEList te_list;         // load_manifest之后有效，比较期间只读共享
+    bool loaded;
+} ManifestGenome;
+
+// 一对基因组的共线性文件，chr1一侧对应genome1
+typedef struct {
+    int genome1;            // 在genomes中的下标
+    int genome2;
+    char* synteny_file;
+    SyntenyList synteny;
+    bool loaded;
+} ManifestPair;
+
+typedef struct {
+    ManifestGenome* genomes;
+    int genome_count;
+    int genome_capacity;
+    ManifestPair* pairs;
+    int pair_count;
+    int pair_capacity;
+} Manifest;
+
+// tevox serve的配置
+typedef struct {
+    const char* synteny_file;
+    const char* te_file1;
+    const char* te_file2;
+    const char* socket_path;
+    int num_threads;            // 解析和计算独有转座子使用的线程数
+    int reload_interval;        // 检查输入文件变化的间隔（秒），0表示不重新加载
+    CompareOptions options;
+} ServeConfig;
+
+// 解析选项（parse_te_file_ex / parse_synteny_ex）
+typedef struct {
+    StringTable* strings;       // 字符串ID所属的表，NULL表示共享的默认表
+    int num_threads;            // 0表示使用所有CPU
+    bool quiet;                 // 不打印"Parsed ..."进度信息
+} ParseOptions;
+
+// .fai索引中的一条序列（与samtools faidx的格式相同）
+typedef struct {
+    char* name;
+    int64_t length;             // 碱基数
+    int64_t offset;             // 第一个碱基在文件中的字节偏移
+    int64_t line_bases;         // 每行碱基数，序列的最后一行可以更短
+    int64_t line_bytes;         // 每行字节数（含换行符）
+} FaiEntry;
+
+// 按.fai索引随机访问的FASTA文件：整个文件只读映射，读取序列时只访问用到的页
+typedef struct {
+    FaiEntry* entries;
+    int count;
+    int capacity;
+    const char* data;
+    size_t size;
+    Arena names;                // 序列名的存储
+} FastaFile;
+
 // 文件类型枚举
 typedef enum {
     FILE_GFF3,
@@ -72,30 +347,245 @@ typedef enum {
 } FileType;
 
 // 主要函数声明
-FileType detect_file_type(const char* filename);
+FileType detect_file_type(const char* filename, int num_threads);
 int parse_gff3(const char* filename, TEList* te_list);
 int parse_bed(const char* filename, TEList* te_list);
 int parse_synteny(const char* filename, SyntenyList* synteny_list);
+int parse_te_file_mt(const char* filename, FileType type, TEList* te_list, int num_threads);
+int parse_te_file_ex(const char* filename, FileType type, TEList* te_list, const ParseOptions* options);
+int parse_synteny_ex(const char* filename, SyntenyList* synteny_list, const ParseOptions* options);
+int resolve_thread_count(int num_threads);
+void parallel_for(int num_tasks, int num_threads, void (*fn)(void* ctx, int task), void* ctx);
+int parse_te_file_serial(const char* filename, FileType type, TEList* te_list, StringTable* strings,
+                         int num_threads);
+int parse_gff3_line(StrSlice line, int line_num, TEList* te_list);
+int parse_bed_line(StrSlice line, int line_num, TEList* te_list);
+int parse_synteny_line(StrSlice line, int line_num, SyntenyList* synteny_list);
+void init_compare_options(CompareOptions* options);
 int compare_te_differences(TEList* te1, TEList* te2, SyntenyList* synteny, 
-                           TEList* unique_te1, TEList* unique_te2);
+                           TESelection* unique_te1, TESelection* unique_te2,
+                           const CompareOptions* options);
+int collect_unique_transposons(const TEList* te1, const TEList* te2, const SyntenyList* synteny,
+                               TESelection* unique_te1, TESelection* unique_te2,
+                               const CompareOptions* options);
 void print_te_list(TEList* te_list, const char* title);
+void print_te_selection(TESelection* selection, const char* title);
 void print_synteny_list(SyntenyList* synteny_list, const char* title);
 void free_te_list(TEList* te_list);
 void free_synteny_list(SyntenyList* synteny_list);
-bool is_in_synteny_region(Transposon* te, SyntenyList* synteny, int genome_id);
-void analyze_te_types(TEList* unique_te1, TEList* unique_te2);
-void analyze_te_families(TEList* unique_te1, TEList* unique_te2);
-TypeCount* count_te_types(TEList* te_list);
-FamilyCount* count_te_families(TEList* te_list);
-void write_results_to_file(TEList* unique_te1, TEList* unique_te2, const char* output_prefix);
+bool is_in_synteny_region(int chr, int64_t start, int64_t end, const SyntenyList* synteny, int genome_id);
+double synteny_coverage(int chr, int64_t start, int64_t end, const SyntenyList* synteny, int genome_id,
+                        double* reciprocal);
+bool is_syntenic(int chr, int64_t start, int64_t end, const SyntenyList* synteny, int genome_id,
+                 const CompareOptions* options, double* coverage);
+void build_synteny_index(SyntenyList* synteny_list);
+int64_t map_through_synteny_block(const SyntenyBlock* block, int genome_id, int64_t pos);
+void free_synteny_index(SyntenyIndex* index);
+void analyze_te_types(TESelection* unique_te1, TESelection* unique_te2);
+void analyze_te_families(TESelection* unique_te1, TESelection* unique_te2);
+TypeCount* count_te_types(TESelection* selection);
+FamilyCount* count_te_families(TESelection* selection);
+int parse_group_fields(const char* spec);
+int count_te_groups(TESelection* selection, int fields, CountTable* counts);
+void decode_group_key(int fields, uint64_t key, int ids[4]);
+void format_group_key(const StringTable* strings, int fields, uint64_t key, char* buffer, size_t size);
+void print_te_group_counts(TESelection* selection, int fields, const char* title);
+int write_results_to_file(TESelection* unique_te1, TESelection* unique_te2, const char* output_prefix,
+                          OutputFormat format, const SyntenyList* coverage_synteny);
+int write_unique_file(const TESelection* selection, const char* filename, OutputFormat format,
+                      int genome_id, const SyntenyList* coverage_synteny);
+int compare_sorted_streaming(const char* te_file1, FileType type1, const char* te_file2, FileType type2,
+                             SyntenyList* synteny, const char* output_prefix, OutputFormat format,
+                             const CompareOptions* options);
+void set_keep_gff3_attributes(bool keep);
 void init_te_list(TEList* te_list);
 void init_synteny_list(SyntenyList* synteny_list);
+void init_transposon(Transposon* te);
+void te_list_reserve(TEList* te_list, int capacity);
+bool te_list_column_mapped(const TEList* te_list, const void* column);
+int te_list_push(TEList* te_list, const Transposon* te);
+void te_list_get(const TEList* te_list, int index, Transposon* te);
 void add_transposon(TEList* te_list, Transposon* te);
 void add_synteny_block(SyntenyList* synteny_list, SyntenyBlock* block);
 
+// 转座子选择集
+void init_te_selection(TESelection* selection, const TEList* source);
+void te_selection_add(TESelection* selection, int index);
+void te_selection_select_all(TESelection* selection, const TEList* source);
+bool te_selection_get(const TESelection* selection, int i, Transposon* te);
+int te_selection_intersect(const TESelection* a, const TESelection* b, TESelection* result);
+int te_selection_union(const TESelection* a, const TESelection* b, TESelection* result);
+void free_te_selection(TESelection* selection);
+
+// 分组计数表
+void init_count_table(CountTable* table);
+void count_table_add(CountTable* table, uint64_t key, int n);
+int count_table_get(const CountTable* table, uint64_t key);
+void count_table_sort_by_count(CountTable* table);
+void free_count_table(CountTable* table);
+
+// 输入读取
+int line_reader_open(LineReader* reader, const char* filename, int num_threads);
+int line_reader_open_peek(LineReader* reader, const char* filename, int num_threads);
+void line_reader_unread(LineReader* reader, const char* filename);
+bool line_reader_next(LineReader* reader, StrSlice* line);
+void line_reader_init_buffer(LineReader* reader, const char* data, size_t size);
+void line_reader_close(LineReader* reader);
+bool line_reader_failed(LineReader* reader);
+bool is_gzip_magic(const unsigned char* data, size_t size);
+InflateStream* inflate_stream_open(int fd, const unsigned char* prefix, size_t prefix_size,
+                                   int num_threads);
+size_t inflate_stream_read(InflateStream* stream, char* dest, size_t max);
+bool inflate_stream_failed(InflateStream* stream);
+void inflate_stream_close(InflateStream* stream);
+BgzfReader* bgzf_reader_open(const char* filename);
+bool bgzf_reader_seek(BgzfReader* reader, uint64_t voffset);
+bool bgzf_reader_next_line(BgzfReader* reader, StrSlice* line, uint64_t* voffset);
+long long bgzf_reader_lines_before(BgzfReader* reader, uint64_t voffset);
+bool bgzf_reader_failed(BgzfReader* reader);
+void bgzf_reader_close(BgzfReader* reader);
+int split_fields(StrSlice line, char sep, StrSlice* fields, int max_fields);
+int split_whitespace(StrSlice line, StrSlice* fields, int max_fields);
+int find_bytes(const char* data, size_t len, char a, char b, uint32_t* positions, int max_positions);
+const char* simd_scan_level(void);
+void hash_kmer_codes(uint32_t* codes, int n);
+void window_minima(const uint32_t* values, int n, int w, uint32_t* minima);
+int slice_to_int(StrSlice slice);
+int64_t slice_to_position(StrSlice slice);
+double slice_to_double(StrSlice slice);
+bool slice_equals(StrSlice slice, const char* str);
+bool slice_contains(StrSlice slice, const char* str);
+
+// 区间查询（tabix/CSI索引）
+void init_region_list(RegionList* list);
+void add_region(RegionList* list, const char* chr, int64_t start, int64_t end);
+int parse_region_list(const char* spec, RegionList* list);
+void normalize_region_list(RegionList* list);
+int region_list_find(const RegionList* list, const char* chr, int64_t start, int64_t end);
+int project_regions_through_synteny(const RegionList* regions, SyntenyList* synteny,
+                                    int genome_id, RegionList* projected);
+int parse_te_file_regions(const char* filename, FileType type, const RegionList* regions,
+                          TEList* te_list, int num_threads);
+void free_region_list(RegionList* list);
+
+// 按位置排序（基数排序）
+void radix_sort_pairs(uint64_t* keys, int* values, int n, int num_threads);
+bool is_sorted_by_position(const int* chrs, const int64_t* starts, const int64_t* ends, int n);
+int* sort_order_by_position(const int* chrs, const int64_t* starts, const int64_t* ends, int n,
+                            int num_threads);
+void sort_te_list(TEList* te_list, int num_threads);
+void restore_te_list_order(TEList* te_list, TESelection* selection, int num_threads);
+void sort_synteny_list(SyntenyList* synteny_list, int num_threads);
+void restore_synteny_list_order(SyntenyList* synteny_list);
+
+// 区间树
+void build_interval_trees(IntervalTrees* trees, const int* chrs, const int64_t* starts, const int64_t* ends,
+                          int n);
+void build_te_interval_trees(IntervalTrees* trees, const TEList* te_list);
+int interval_tree_query(const IntervalTrees* trees, int chr, int64_t start, int64_t end,
+                        int** results, int* capacity);
+void free_interval_trees(IntervalTrees* trees);
+
+// 直系同源分类（--orthology）
+int classify_orthology(TEList* te1, TEList* te2, SyntenyList* synteny, int tolerance,
+                       const CompareOptions* options, OrthologyResult* result1, OrthologyResult* result2);
+const char* orthology_class_name(OrthologyClass cls);
+void print_orthology_summary(const OrthologyResult* result1, const OrthologyResult* result2, int tolerance);
+int write_orthology_results(const TEList* te1, const TEList* te2, const OrthologyResult* result1,
+                            const OrthologyResult* result2, const char* output_prefix);
+void free_orthology_result(OrthologyResult* result);
+
+// 序列提取（基因组FASTA）
+int fasta_open(FastaFile* fasta, const char* filename);
+int64_t fasta_fetch(const FastaFile* fasta, int entry, int64_t start, int64_t end, char* out);
+int* fasta_chr_entries(const FastaFile* fasta, const StringTable* strings);
+void fasta_close(FastaFile* fasta);
+int write_unique_sequences(const TESelection* selection, const FastaFile* fasta, const char* filename,
+                           int num_threads);
+int write_unique_sequence_files(const TESelection* unique_te1, const TESelection* unique_te2,
+                                const char* genome1_file, const char* genome2_file,
+                                const char* output_prefix, int num_threads);
+
+// 独有转座子的序列聚类（--cluster，最小化子草图）
+int cluster_unique_sequences(const TESelection* unique_te1, const TESelection* unique_te2,
+                             const char* genome1_file, const char* genome2_file,
+                             double min_jaccard, double min_containment,
+                             const char* output_prefix, int num_threads);
+
+// 多基因组比较（tevox multi）
+void init_manifest(Manifest* manifest);
+int parse_manifest(const char* filename, Manifest* manifest);
+int load_manifest(Manifest* manifest, int num_threads);
+int compare_multi_genomes(Manifest* manifest, const char* output_prefix, OutputFormat format,
+                          int tolerance, const CompareOptions* options);
+void free_manifest(Manifest* manifest);
+
+// 查询服务（tevox serve / tevox query）
+int run_query_server(const ServeConfig* config);
+int run_query_client(const char* socket_path, char** queries, int query_count);
+
+// 结果输出
+int output_writer_open(OutputWriter* writer, const char* filename);
+void output_writer_write(OutputWriter* writer, const char* data, size_t len);
+void output_writer_puts(OutputWriter* writer, const char* str);
+void output_writer_putc(OutputWriter* writer, char c);
+void output_writer_put_int(OutputWriter* writer, long long value);
+void output_writer_open_fd(OutputWriter* writer, int fd, size_t capacity);
+bool output_writer_flush(OutputWriter* writer);
+int output_writer_close(OutputWriter* writer);
+void redirect_stdout_for_output(void);
+int parse_output_format(const char* name);
+const char* output_format_extension(OutputFormat format);
+void output_file_name(char* buffer, size_t size, const char* output_prefix, int genome_id,
+                      OutputFormat format);
+void write_unique_header(OutputWriter* writer, OutputFormat format, int genome_id, bool with_coverage);
+void write_te_record(OutputWriter* writer, OutputFormat format, const StringTable* strings,
+                     const Transposon* te, double coverage);
+
+// 分阶段计时（--profile）
+void profile_enable(void);
+bool profile_enabled(void);
+int profile_begin(const char* name);
+void profile_end(int phase_id, long long records, long long bytes);
+long long profile_file_size(const char* filename);
+void profile_print_summary(void);
+int profile_write_json(const char* filename);
+
+// 预解析缓存（.tevx）
+char* te_cache_path(const char* source_file);
+int write_te_cache(const char* cache_file, const char* source_file, FileType type,
+                   const TEList* te_list);
+int load_te_cache(const char* cache_file, const char* source_file, FileType type, TEList* te_list);
+int verify_te_cache(const char* cache_file, const char* source_file, FileType type);
+int parse_te_file_cached(const char* filename, FileType type, TEList* te_list, int num_threads,
+                         bool write_cache);
+
+// 字符串驻留表
+void init_string_table(StringTable* table);
+int string_table_intern(StringTable* table, const char* str);
+int string_table_intern_len(StringTable* table, const char* str, size_t len);
+int string_table_find(const StringTable* table, const char* str);
+const char* string_table_get(const StringTable* table, int id);
+void free_string_table(StringTable* table);
+StringTable* default_string_table(void);
+void free_default_string_table(void);
+
 // 工具函数
 char* strdup_safe(const char* str);
 void* safe_malloc(size_t size);
 void* safe_realloc(void* ptr, size_t size);
+jmp_buf* set_oom_trap(jmp_buf* trap);
+bool oom_trap_active(void);
+void out_of_memory(size_t size);
+
+// 内存池
+void init_arena(Arena* arena);
+void* arena_alloc(Arena* arena, size_t size);
+char* arena_strdup(Arena* arena, const char* str);
+char* arena_strndup(Arena* arena, const char* str, size_t len);
+void arena_adopt(Arena* dest, Arena* src);
+ArenaMark arena_mark(const Arena* arena);
+void arena_reset(Arena* arena, const ArenaMark* mark);
+void free_arena(Arena* arena);
 
 #endif // TE_COMPARATOR_H
\ No newline at end of file
@@ -1,230 +1,315 @@
 #include "te_comparator.h"
 
-// 解析GFF3文件的属性字段
-void parse_gff3_attributes(const char* attributes_str, Transposon* te) {
-    if (!attributes_str || !te) return;
-    
-    char* attrs = strdup_safe(attributes_str);
-    char* attr = strtok(attrs, ";");
-    
-    while (attr != NULL) {
-        // 跳过空格
-        while (*attr == ' ') attr++;
+// 常见的转座子特征类型
+static const char* te_feature_types[] = {
+    "transposable_element", "TE", "retrotransposon", "DNA_transposon",
+    "LINE", "SINE", "LTR", "TIR", "MITE", "helitron"
+};
+
+// 上表各类型的首字母，扫描类型列时只在这些字符处比较
+static const bool te_type_first_chars[256] = {
+    ['t'] = true, ['T'] = true, ['r'] = true, ['D'] = true,
+    ['L'] = true, ['S'] = true, ['M'] = true, ['h'] = true
+};
+
+// 类型列是否包含任一转座子类型（单次扫描，代替逐个子串查找）
+static bool is_te_feature_type(StrSlice type) {
+    for (size_t i = 0; i < type.len; i++) {
+        unsigned char c = (unsigned char)type.ptr[i];
+        if (!te_type_first_chars[c]) continue;
         
-        char* equal = strchr(attr, '=');
-        if (equal != NULL) {
-            *equal = '\0';
-            char* key = attr;
-            char* value = equal + 1;
+        for (size_t k = 0; k < sizeof(te_feature_types) / sizeof(te_feature_types[0]); k++) {
+            const char* pattern = te_feature_types[k];
+            if (pattern[0] != (char)c) continue;
+            size_t len = strlen(pattern);
+            if (len <= type.len - i && memcmp(type.ptr + i, pattern, len) == 0) return true;
+        }
+    }
+    return false;
+}
+
+// 是否保留GFF3的来源列和原始属性列（--out-format gff3和缓存需要）
+static bool keep_gff3_attributes = false;
+
+void set_keep_gff3_attributes(bool keep) {
+    keep_gff3_attributes = keep;
+}
+
+// 一次find_bytes调用最多返回的分隔符个数
+#define ATTRIBUTE_BATCH 64
+
+// 按键识别一个属性（key=value中key在前导空格之后）
+static void match_gff3_attribute(StrSlice key, StrSlice value, StrSlice* id, StrSlice* name, StrSlice* family) {
+    switch (key.len) {
+        case 2:
+            if (memcmp(key.ptr, "ID", 2) == 0) *id = value;
+            break;
+        case 4:
+            if (memcmp(key.ptr, "Name", 4) == 0) *name = value;
+            break;
+        case 6:
+            if (memcmp(key.ptr, "family", 6) == 0) *family = value;
+            break;
+        case 9:
+            if (memcmp(key.ptr, "TE_family", 9) == 0) *family = value;
+            break;
+    }
+}
+
+// 解析GFF3文件的属性字段，id/name/family指向属性列内部（未出现时ptr为NULL）。
+// ';'和'='的位置由find_bytes一次批量查找，不复制属性列
+void parse_gff3_attributes(StrSlice attributes, StrSlice* id, StrSlice* name, StrSlice* family) {
+    uint32_t positions[ATTRIBUTE_BATCH];
+    size_t attr_start = 0;      // 当前属性的起点
+    size_t equal = SIZE_MAX;    // 当前属性中第一个'='的位置
+    size_t scanned = 0;
+    
+    for (;;) {
+        int found = find_bytes(attributes.ptr + scanned, attributes.len - scanned, ';', '=',
+                               positions, ATTRIBUTE_BATCH);
+        bool done = found < ATTRIBUTE_BATCH;
+        for (int i = 0; i <= found; i++) {
+            size_t stop;
+            if (i < found) {
+                stop = scanned + positions[i];
+                if (attributes.ptr[stop] == '=') {
+                    if (equal == SIZE_MAX) equal = stop;
+                    continue;
+                }
+            } else if (done) {
+                stop = attributes.len;
+            } else {
+                break;
+            }
             
-            if (strcmp(key, "ID") == 0) {
-                te->id = strdup_safe(value);
-            } else if (strcmp(key, "Name") == 0) {
-                te->name = strdup_safe(value);
-            } else if (strcmp(key, "family") == 0) {
-                te->family = strdup_safe(value);
-            } else if (strcmp(key, "TE_family") == 0) {
-                te->family = strdup_safe(value);
+            // [attr_start, stop)是一个完整属性，跳过前导空格
+            size_t key_start = attr_start;
+            while (key_start < stop && attributes.ptr[key_start] == ' ') key_start++;
+            if (equal != SIZE_MAX) {
+                StrSlice key = { attributes.ptr + key_start, equal - key_start };
+                StrSlice value = { attributes.ptr + equal + 1, stop - equal - 1 };
+                match_gff3_attribute(key, value, id, name, family);
             }
+            attr_start = stop + 1;
+            equal = SIZE_MAX;
         }
-        
-        attr = strtok(NULL, ";");
+        if (done) break;
+        scanned = scanned + positions[found - 1] + 1;
     }
-    
-    free(attrs);
 }
 
-// 解析GFF3文件
-int parse_gff3(const char* filename, TEList* te_list) {
-    if (!filename || !te_list) {
-        fprintf(stderr, "Error: Invalid parameters for parse_gff3\n");
-        return -1;
+// 解析一行GFF3记录，是转座子时追加到te_list并返回1，否则返回0
+int parse_gff3_line(StrSlice line, int line_num, TEList* te_list) {
+    // 跳过注释行和空行
+    if (line.len == 0 || line.ptr[0] == '#') {
+        return 0;
+    }
+    
+    // 解析GFF3行（9列）
+    StrSlice tokens[10];
+    int token_count = split_fields(line, '\t', tokens, 10);
+    
+    if (token_count < 9) {
+        fprintf(stderr, "Warning: Line %d has insufficient columns (%d), skipping\n", 
+                line_num, token_count);
+        return 0;
+    }
+    
+    // 检查是否为转座子相关特征，不是则跳过
+    if (!is_te_feature_type(tokens[2])) {
+        return 0;
+    }
+    
+    // 解析属性字段
+    StrSlice id = { NULL, 0 }, name = { NULL, 0 }, family = { NULL, 0 };
+    parse_gff3_attributes(tokens[8], &id, &name, &family);
+    
+    StringTable* strings = te_list->strings;
+    Transposon te;
+    init_transposon(&te);
+    
+    te.chr = string_table_intern_len(strings, tokens[0].ptr, tokens[0].len);
+    te.start = slice_to_position(tokens[3]);
+    te.end = slice_to_position(tokens[4]);
+    te.strand = string_table_intern_len(strings, tokens[6].ptr, tokens[6].len);
+    te.type = string_table_intern_len(strings, tokens[2].ptr, tokens[2].len);
+    if (family.ptr) {
+        te.family = string_table_intern_len(strings, family.ptr, family.len);
+    }
+    
+    // 如果没有ID，生成一个
+    if (id.ptr) {
+        te.id = arena_strndup(&te_list->arena, id.ptr, id.len);
+    } else {
+        char temp_id[100];
+        snprintf(temp_id, sizeof(temp_id), "TE_%d_%lld_%lld", line_num, (long long)te.start, (long long)te.end);
+        te.id = arena_strdup(&te_list->arena, temp_id);
     }
     
+    // 如果没有name，与ID共享同一份字符串
+    if (name.ptr) {
+        te.name = arena_strndup(&te_list->arena, name.ptr, name.len);
+    } else {
+        te.name = te.id;
+    }
+    
+    if (keep_gff3_attributes) {
+        te.source = string_table_intern_len(strings, tokens[1].ptr, tokens[1].len);
+        te.attributes = arena_strndup(&te_list->arena, tokens[8].ptr, tokens[8].len);
+    }
+    
+    te_list_push(te_list, &te);
+    return 1;
+}
+
+// 串行解析GFF3/BED文件，不打印进度；strings为NULL时使用共享的默认表，
+// num_threads只用于压缩输入的解压
+int parse_te_file_serial(const char* filename, FileType type, TEList* te_list, StringTable* strings,
+                         int num_threads) {
+    const char* format = type == FILE_GFF3 ? "GFF3" : "BED";
+    
     init_te_list(te_list);
+    if (strings) te_list->strings = strings;
     
-    FILE* file = fopen(filename, "r");
-    if (!file) {
-        fprintf(stderr, "Error: Cannot open GFF3 file %s\n", filename);
+    LineReader reader;
+    if (line_reader_open(&reader, filename, num_threads) != 0) {
+        fprintf(stderr, "Error: Cannot open %s file %s\n", format, filename);
         return -1;
     }
     
-    char line[2048];
-    int line_num = 0;
-    
-    while (fgets(line, sizeof(line), file)) {
-        line_num++;
-        
-        // 跳过注释行和空行
-        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') {
-            continue;
+    // 调用方设置了内存不足陷阱（库接口）时，先关闭文件、释放已解析的记录，再跳回调用方
+    jmp_buf trap;
+    jmp_buf* previous = NULL;
+    bool trapped = oom_trap_active();
+    if (trapped) {
+        previous = set_oom_trap(&trap);
+        if (setjmp(trap)) {
+            set_oom_trap(previous);
+            line_reader_close(&reader);
+            free_te_list(te_list);
+            out_of_memory(0);
         }
-        
-        // 移除行尾的换行符
-        line[strcspn(line, "\r\n")] = '\0';
-        
-        // 解析GFF3行（9列）
-        char* token;
-        char* tokens[10];
-        int token_count = 0;
-        
-        token = strtok(line, "\t");
-        while (token != NULL && token_count < 10) {
-            tokens[token_count++] = token;
-            token = strtok(NULL, "\t");
-        }
-        
-        if (token_count < 9) {
-            fprintf(stderr, "Warning: Line %d has insufficient columns (%d), skipping\n", 
-                    line_num, token_count);
-            continue;
-        }
-        
-        // 检查是否为转座子相关特征
-        char* feature_type = tokens[2];
-        bool is_te = false;
-        
-        // 常见的转座子特征类型
-        const char* te_types[] = {
-            "transposable_element", "TE", "retrotransposon", "DNA_transposon",
-            "LINE", "SINE", "LTR", "TIR", "MITE", "helitron"
-        };
-        
-        for (int i = 0; i < 10; i++) {
-            if (strstr(feature_type, te_types[i]) != NULL) {
-                is_te = true;
-                break;
-            }
-        }
-        
-        // 如果不是转座子特征，跳过
-        if (!is_te) {
-            continue;
-        }
-        
-        Transposon te;
-        memset(&te, 0, sizeof(te));
-        
-        te.chr = strdup_safe(tokens[0]);
-        te.start = atoi(tokens[3]);
-        te.end = atoi(tokens[4]);
-        te.strand = strdup_safe(tokens[6]);
-        te.type = strdup_safe(tokens[2]);
-        
-        // 解析属性字段
-        parse_gff3_attributes(tokens[8], &te);
-        
-        // 如果没有ID，生成一个
-        if (!te.id) {
-            char temp_id[100];
-            snprintf(temp_id, sizeof(temp_id), "TE_%d_%d_%d", line_num, te.start, te.end);
-            te.id = strdup_safe(temp_id);
-        }
-        
-        // 如果没有name，使用ID
-        if (!te.name) {
-            te.name = strdup_safe(te.id);
+    }
+    
+    StrSlice line;
+    while (line_reader_next(&reader, &line)) {
+        if (type == FILE_GFF3) {
+            parse_gff3_line(line, reader.line_num, te_list);
+        } else {
+            parse_bed_line(line, reader.line_num, te_list);
         }
-        
-        add_transposon(te_list, &te);
     }
+    if (trapped) set_oom_trap(previous);
     
-    fclose(file);
+    if (line_reader_failed(&reader)) {
+        fprintf(stderr, "Error: Corrupt or truncated compressed %s file %s\n", format, filename);
+        line_reader_close(&reader);
+        free_te_list(te_list);
+        return -1;
+    }
     
-    printf("Parsed %d transposons from GFF3 file %s\n", te_list->count, filename);
+    line_reader_close(&reader);
     return te_list->count;
 }
 
-// 解析BED文件
-int parse_bed(const char* filename, TEList* te_list) {
+// 解析GFF3文件
+int parse_gff3(const char* filename, TEList* te_list) {
     if (!filename || !te_list) {
-        fprintf(stderr, "Error: Invalid parameters for parse_bed\n");
+        fprintf(stderr, "Error: Invalid parameters for parse_gff3\n");
         return -1;
     }
     
-    init_te_list(te_list);
+    if (parse_te_file_serial(filename, FILE_GFF3, te_list, NULL, 1) < 0) return -1;
     
-    FILE* file = fopen(filename, "r");
-    if (!file) {
-        fprintf(stderr, "Error: Cannot open BED file %s\n", filename);
-        return -1;
+    printf("Parsed %d transposons from GFF3 file %s\n", te_list->count, filename);
+    return te_list->count;
+}
+
+// 解析一行BED记录，成功时追加到te_list并返回1，否则返回0
+int parse_bed_line(StrSlice line, int line_num, TEList* te_list) {
+    // 跳过注释行、空行和track行
+    if (line.len == 0 || line.ptr[0] == '#' || 
+        (line.len >= 5 && memcmp(line.ptr, "track", 5) == 0)) {
+        return 0;
     }
     
-    char line[2048];
-    int line_num = 0;
+    // 解析BED行（至少3列）
+    StrSlice tokens[15];
+    int token_count = split_fields(line, '\t', tokens, 15);
     
-    while (fgets(line, sizeof(line), file)) {
-        line_num++;
-        
-        // 跳过注释行和空行
-        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r' || 
-            (line[0] == 't' && line[1] == 'r' && line[2] == 'a' && line[3] == 'c' && line[4] == 'k')) {
-            continue;
-        }
-        
-        // 移除行尾的换行符
-        line[strcspn(line, "\r\n")] = '\0';
-        
-        // 解析BED行（至少3列）
-        char* token;
-        char* tokens[15];
-        int token_count = 0;
-        
-        token = strtok(line, "\t");
-        while (token != NULL && token_count < 15) {
-            tokens[token_count++] = token;
-            token = strtok(NULL, "\t");
-        }
-        
-        if (token_count < 3) {
-            fprintf(stderr, "Warning: Line %d has insufficient columns (%d), skipping\n", 
-                    line_num, token_count);
-            continue;
-        }
-        
-        Transposon te;
-        memset(&te, 0, sizeof(te));
-        
-        te.chr = strdup_safe(tokens[0]);
-        te.start = atoi(tokens[1]) + 1; // BED是0-based，转换为1-based
-        te.end = atoi(tokens[2]);
-        
-        // 可选字段
-        if (token_count > 3) {
-            te.name = strdup_safe(tokens[3]);
-        } else {
-            // 生成默认名称
-            char temp_name[100];
-            snprintf(temp_name, sizeof(temp_name), "TE_%d_%d_%d", line_num, te.start, te.end);
-            te.name = strdup_safe(temp_name);
-        }
-        
-        if (token_count > 5) {
-            te.strand = strdup_safe(tokens[5]);
-        } else {
-            te.strand = strdup_safe(".");
-        }
-        
-        if (token_count > 6) {
-            te.type = strdup_safe(tokens[6]);
-        } else {
-            te.type = strdup_safe("transposable_element");
-        }
-        
-        // 生成ID
-        char temp_id[100];
-        snprintf(temp_id, sizeof(temp_id), "TE_%d_%d_%d", line_num, te.start, te.end);
-        te.id = strdup_safe(temp_id);
-        
-        add_transposon(te_list, &te);
+    if (token_count < 3) {
+        fprintf(stderr, "Warning: Line %d has insufficient columns (%d), skipping\n", 
+                line_num, token_count);
+        return 0;
+    }
+    
+    StringTable* strings = te_list->strings;
+    Transposon te;
+    init_transposon(&te);
+    
+    te.chr = string_table_intern_len(strings, tokens[0].ptr, tokens[0].len);
+    te.start = slice_to_position(tokens[1]) + 1; // BED是0-based，转换为1-based
+    te.end = slice_to_position(tokens[2]);
+    
+    // 生成ID
+    char temp_id[100];
+    snprintf(temp_id, sizeof(temp_id), "TE_%d_%lld_%lld", line_num, (long long)te.start, (long long)te.end);
+    te.id = arena_strdup(&te_list->arena, temp_id);
+    
+    // 可选字段，没有名称时使用生成的ID
+    if (token_count > 3) {
+        te.name = arena_strndup(&te_list->arena, tokens[3].ptr, tokens[3].len);
+    } else {
+        te.name = te.id;
+    }
+    
+    if (token_count > 5) {
+        te.strand = string_table_intern_len(strings, tokens[5].ptr, tokens[5].len);
+    } else {
+        te.strand = string_table_intern(strings, ".");
     }
     
-    fclose(file);
+    if (token_count > 6) {
+        te.type = string_table_intern_len(strings, tokens[6].ptr, tokens[6].len);
+    } else {
+        te.type = string_table_intern(strings, "transposable_element");
+    }
+    
+    te_list_push(te_list, &te);
+    return 1;
+}
+
+// 解析BED文件
+int parse_bed(const char* filename, TEList* te_list) {
+    if (!filename || !te_list) {
+        fprintf(stderr, "Error: Invalid parameters for parse_bed\n");
+        return -1;
+    }
+    
+    if (parse_te_file_serial(filename, FILE_BED, te_list, NULL, 1) < 0) return -1;
     
     printf("Parsed %d transposons from BED file %s\n", te_list->count, filename);
     return te_list->count;
 }
 
+// 打印一行转座子信息
+static void print_te_row(const TEList* te_list, int index) {
+    Transposon te;
+    te_list_get(te_list, index, &te);
+    const char* chr = string_table_get(te_list->strings, te.chr);
+    const char* strand = string_table_get(te_list->strings, te.strand);
+    const char* type = string_table_get(te_list->strings, te.type);
+    const char* family = string_table_get(te_list->strings, te.family);
+    printf("%s\t%s\t%lld\t%lld\t%s\t%s\t%s\n",
+           te.id ? te.id : "N/A",
+           chr ? chr : "N/A",
+           (long long)te.start,
+           (long long)te.end,
+           strand ? strand : ".",
+           type ? type : "N/A",
+           family ? family : "N/A");
+}
+
 // 打印转座子列表（用于调试）
 void print_te_list(TEList* te_list, const char* title) {
     if (!te_list || !title) return;
@@ -238,16 +323,27 @@ void print_te_list(TEList* te_list, const char* title) {
         int max_print = te_list->count < 10 ? te_list->count : 10;
         
         for (int i = 0; i < max_print; i++) {
-            Transposon* te = &te_list->transposons[i];
-            printf("%s\t%s\t%d\t%d\t%s\t%s\t%s\n",
-                   te->id ? te->id : "N/A",
-                   te->chr ? te->chr : "N/A",
-                   te->start,
-                   te->end,
-                   te->strand ? te->strand : ".",
-                   te->type ? te->type : "N/A",
-                   te->family ? te->family : "N/A");
+            print_te_row(te_list, i);
         }
     }
     printf("\n");
-}
\ No newline at end of file
+}
+
+// 打印转座子选择集（用于调试）
+void print_te_selection(TESelection* selection, const char* title) {
+    if (!selection || !selection->source || !title) return;
+    
+    printf("\n=== %s ===\n", title);
+    printf("Total transposons: %d\n", selection->count);
+    
+    if (selection->count > 0) {
+        printf("First 10 transposons:\n");
+        printf("ID\tChr\tStart\tEnd\tStrand\tType\tFamily\n");
+        int max_print = selection->count < 10 ? selection->count : 10;
+        
+        for (int i = 0; i < max_print; i++) {
+            print_te_row(selection->source, selection->indices[i]);
+        }
+    }
+    printf("\n");
+}
@@ -0,0 +1,104 @@
+#include "te_comparator.h"
+
+// 初始化选择集，记录所引用的源列表
+void init_te_selection(TESelection* selection, const TEList* source) {
+    if (!selection) return;
+    selection->source = source;
+    selection->indices = NULL;
+    selection->count = 0;
+    selection->capacity = 0;
+}
+
+// 追加一个源列表下标（调用方保证升序追加）
+void te_selection_add(TESelection* selection, int index) {
+    if (!selection) return;
+    
+    if (selection->count >= selection->capacity) {
+        int new_capacity = selection->capacity == 0 ? 100 : selection->capacity * 2;
+        selection->indices = (int*)safe_realloc(selection->indices, new_capacity * sizeof(int));
+        selection->capacity = new_capacity;
+    }
+    
+    selection->indices[selection->count++] = index;
+}
+
+// 选中源列表中的全部转座子
+void te_selection_select_all(TESelection* selection, const TEList* source) {
+    if (!selection || !source) return;
+    
+    init_te_selection(selection, source);
+    if (source->count == 0) return;
+    
+    selection->indices = (int*)safe_malloc(source->count * sizeof(int));
+    selection->capacity = source->count;
+    for (int i = 0; i < source->count; i++) {
+        selection->indices[i] = i;
+    }
+    selection->count = source->count;
+}
+
+// 取出选择集中第i个转座子，下标越界时返回false
+bool te_selection_get(const TESelection* selection, int i, Transposon* te) {
+    if (!selection || !selection->source || i < 0 || i >= selection->count) return false;
+    te_list_get(selection->source, selection->indices[i], te);
+    return true;
+}
+
+// 求两个选择集的交集（须引用同一源列表）
+int te_selection_intersect(const TESelection* a, const TESelection* b, TESelection* result) {
+    if (!a || !b || !result || a->source != b->source) {
+        fprintf(stderr, "Error: Selections must refer to the same TE list\n");
+        return -1;
+    }
+    
+    init_te_selection(result, a->source);
+    
+    int i = 0, j = 0;
+    while (i < a->count && j < b->count) {
+        if (a->indices[i] < b->indices[j]) {
+            i++;
+        } else if (a->indices[i] > b->indices[j]) {
+            j++;
+        } else {
+            te_selection_add(result, a->indices[i]);
+            i++;
+            j++;
+        }
+    }
+    
+    return result->count;
+}
+
+// 求两个选择集的并集（须引用同一源列表）
+int te_selection_union(const TESelection* a, const TESelection* b, TESelection* result) {
+    if (!a || !b || !result || a->source != b->source) {
+        fprintf(stderr, "Error: Selections must refer to the same TE list\n");
+        return -1;
+    }
+    
+    init_te_selection(result, a->source);
+    
+    int i = 0, j = 0;
+    while (i < a->count || j < b->count) {
+        if (j >= b->count || (i < a->count && a->indices[i] < b->indices[j])) {
+            te_selection_add(result, a->indices[i++]);
+        } else if (i >= a->count || b->indices[j] < a->indices[i]) {
+            te_selection_add(result, b->indices[j++]);
+        } else {
+            te_selection_add(result, a->indices[i]);
+            i++;
+            j++;
+        }
+    }
+    
+    return result->count;
+}
+
+// 释放选择集（不影响源列表）
+void free_te_selection(TESelection* selection) {
+    if (!selection) return;
+    free(selection->indices);
+    selection->indices = NULL;
+    selection->count = 0;
+    selection->capacity = 0;
+}
@@ -0,0 +1,280 @@
+#include "te_comparator.h"
+#include "tevox.h"
+#include <errno.h>
+#include <stdarg.h>
+#include <unistd.h>
+
+// 每轮并行分类的转座子数，结果按顺序交给回调后再处理下一轮
+#define CLASSIFY_ROUND_SIZE (64 * 1024)
+// 每个并行任务处理的转座子数
+#define CLASSIFY_TASK_SIZE 4096
+
+struct TevoxContext {
+    StringTable strings;        // 上下文私有的字符串表，不使用共享的默认表
+    SyntenyList synteny;
+    TEList te[2];
+    bool has_synteny;
+    bool has_te[2];
+    CompareOptions options;
+    char error[512];
+};
+
+// 一轮并行分类的共享状态
+typedef struct {
+    const TEList* te_list;
+    const SyntenyList* synteny;
+    const CompareOptions* options;
+    int genome;
+    int begin;
+    int end;
+    unsigned char* syntenic;    // 下标相对begin
+    double* coverage;
+} ClassifyJob;
+
+// 记录错误信息并返回错误码
+static int set_error(TevoxContext* ctx, int status, const char* format, ...) {
+    if (ctx) {
+        va_list args;
+        va_start(args, format);
+        vsnprintf(ctx->error, sizeof(ctx->error), format, args);
+        va_end(args);
+    }
+    return status;
+}
+
+// 解析前检查文件可读，区分IO错误和格式错误；不打开文件，命名管道的数据留给解析器
+static int check_readable(TevoxContext* ctx, const char* filename) {
+    if (strcmp(filename, "-") == 0) return TEVOX_OK;
+    if (access(filename, R_OK) != 0) {
+        return set_error(ctx, TEVOX_ERR_IO, "Cannot open %s: %s", filename, strerror(errno));
+    }
+    return TEVOX_OK;
+}
+
+TevoxContext* tevox_context_new(void) {
+    TevoxContext* ctx = (TevoxContext*)calloc(1, sizeof(TevoxContext));
+    if (!ctx) return NULL;
+    
+    init_string_table(&ctx->strings);
+    init_compare_options(&ctx->options);
+    return ctx;
+}
+
+void tevox_context_free(TevoxContext* ctx) {
+    if (!ctx) return;
+    
+    for (int g = 0; g < 2; g++) {
+        if (ctx->has_te[g]) free_te_list(&ctx->te[g]);
+    }
+    if (ctx->has_synteny) free_synteny_list(&ctx->synteny);
+    free_string_table(&ctx->strings);
+    free(ctx);
+}
+
+int tevox_set_threads(TevoxContext* ctx, int num_threads) {
+    if (!ctx) return TEVOX_ERR_ARGUMENT;
+    if (num_threads < 0 || num_threads > 1024) {
+        return set_error(ctx, TEVOX_ERR_ARGUMENT, "Invalid thread count: %d", num_threads);
+    }
+    ctx->options.num_threads = num_threads;
+    return TEVOX_OK;
+}
+
+int tevox_set_min_overlap(TevoxContext* ctx, double fraction, int reciprocal) {
+    if (!ctx) return TEVOX_ERR_ARGUMENT;
+    if (!(fraction >= 0.0 && fraction <= 1.0)) {
+        return set_error(ctx, TEVOX_ERR_ARGUMENT, "Invalid overlap fraction: %g", fraction);
+    }
+    if (reciprocal && fraction <= 0.0) {
+        return set_error(ctx, TEVOX_ERR_ARGUMENT, "Reciprocal overlap requires a minimum overlap");
+    }
+    ctx->options.min_overlap = fraction;
+    ctx->options.reciprocal = reciprocal != 0;
+    return TEVOX_OK;
+}
+
+// 内存不足时跳回各接口函数中的setjmp：已分配的部分数据不再释放，上下文保持之前的状态
+int tevox_load_synteny(TevoxContext* ctx, const char* filename) {
+    if (!ctx || !filename) return set_error(ctx, TEVOX_ERR_ARGUMENT, "Missing synteny file name");
+    
+    int status = check_readable(ctx, filename);
+    if (status != TEVOX_OK) return status;
+    
+    ParseOptions parse_options = { &ctx->strings, ctx->options.num_threads, true };
+    SyntenyList parsed;
+    jmp_buf trap;
+    jmp_buf* previous = set_oom_trap(&trap);
+    if (setjmp(trap)) {
+        set_oom_trap(previous);
+        return set_error(ctx, TEVOX_ERR_NOMEM, "Out of memory while parsing %s", filename);
+    }
+    int result = parse_synteny_ex(filename, &parsed, &parse_options);
+    set_oom_trap(previous);
+    
+    if (result < 0) return set_error(ctx, TEVOX_ERR_FORMAT, "Corrupt or truncated synteny file %s", filename);
+    if (ctx->has_synteny) free_synteny_list(&ctx->synteny);
+    ctx->synteny = parsed;
+    ctx->has_synteny = true;
+    return TEVOX_OK;
+}
+
+int tevox_load_te(TevoxContext* ctx, int genome, const char* filename) {
+    if (!ctx || !filename) return set_error(ctx, TEVOX_ERR_ARGUMENT, "Missing TE file name");
+    if (genome != 1 && genome != 2) return set_error(ctx, TEVOX_ERR_ARGUMENT, "Genome must be 1 or 2");
+    
+    int status = check_readable(ctx, filename);
+    if (status != TEVOX_OK) return status;
+    
+    ParseOptions parse_options = { &ctx->strings, ctx->options.num_threads, true };
+    TEList parsed;
+    jmp_buf trap;
+    jmp_buf* previous = set_oom_trap(&trap);
+    if (setjmp(trap)) {
+        set_oom_trap(previous);
+        return set_error(ctx, TEVOX_ERR_NOMEM, "Out of memory while parsing %s", filename);
+    }
+    FileType type = detect_file_type(filename, ctx->options.num_threads);
+    int result = -1;
+    if (type == FILE_GFF3 || type == FILE_BED) {
+        result = parse_te_file_ex(filename, type, &parsed, &parse_options);
+    }
+    set_oom_trap(previous);
+    
+    if (type != FILE_GFF3 && type != FILE_BED) {
+        return set_error(ctx, TEVOX_ERR_FORMAT, "Unsupported file format for TE file: %s", filename);
+    }
+    if (result < 0) return set_error(ctx, TEVOX_ERR_FORMAT, "Corrupt or truncated TE file %s", filename);
+    
+    if (ctx->has_te[genome - 1]) free_te_list(&ctx->te[genome - 1]);
+    ctx->te[genome - 1] = parsed;
+    ctx->has_te[genome - 1] = true;
+    return TEVOX_OK;
+}
+
+long tevox_te_count(const TevoxContext* ctx, int genome) {
+    if (!ctx || (genome != 1 && genome != 2) || !ctx->has_te[genome - 1]) return 0;
+    return ctx->te[genome - 1].count;
+}
+
+long tevox_synteny_count(const TevoxContext* ctx) {
+    return ctx && ctx->has_synteny ? ctx->synteny.count : 0;
+}
+
+// 分类一个任务范围内的转座子（只读访问，可并发执行）
+static void run_classify_task(void* arg, int task) {
+    ClassifyJob* job = (ClassifyJob*)arg;
+    int begin = job->begin + task * CLASSIFY_TASK_SIZE;
+    int end = begin + CLASSIFY_TASK_SIZE < job->end ? begin + CLASSIFY_TASK_SIZE : job->end;
+    
+    const TEList* te_list = job->te_list;
+    for (int i = begin; i < end; i++) {
+        double coverage = 0.0;
+        bool syntenic = false;
+        if (job->synteny->count > 0) {
+            syntenic = is_syntenic(te_list->chrs[i], te_list->starts[i], te_list->ends[i], job->synteny,
+                                   job->genome, job->options, &coverage);
+        }
+        job->syntenic[i - job->begin] = syntenic;
+        job->coverage[i - job->begin] = coverage;
+    }
+}
+
+// 分类一个基因组：每轮并行计算一段转座子，再在调用线程中按顺序回调
+static int classify_genome(TevoxContext* ctx, int genome, TevoxRecordCallback callback, void* user_data,
+                           unsigned char* syntenic, double* coverage) {
+    const TEList* te_list = &ctx->te[genome - 1];
+    const StringTable* strings = te_list->strings;
+    
+    ClassifyJob job;
+    job.te_list = te_list;
+    job.synteny = &ctx->synteny;
+    job.options = &ctx->options;
+    job.genome = genome;
+    job.syntenic = syntenic;
+    job.coverage = coverage;
+    
+    for (int begin = 0; begin < te_list->count; begin += CLASSIFY_ROUND_SIZE) {
+        job.begin = begin;
+        job.end = begin + CLASSIFY_ROUND_SIZE < te_list->count ? begin + CLASSIFY_ROUND_SIZE : te_list->count;
+        int tasks = (job.end - job.begin + CLASSIFY_TASK_SIZE - 1) / CLASSIFY_TASK_SIZE;
+        parallel_for(tasks, ctx->options.num_threads, run_classify_task, &job);
+        
+        for (int i = job.begin; i < job.end; i++) {
+            TevoxRecord record;
+            record.genome = genome;
+            record.index = i;
+            record.id = te_list->ids[i];
+            record.name = te_list->names[i];
+            record.chr = string_table_get(strings, te_list->chrs[i]);
+            record.start = te_list->starts[i];
+            record.end = te_list->ends[i];
+            record.strand = string_table_get(strings, te_list->strands[i]);
+            record.type = string_table_get(strings, te_list->types[i]);
+            record.family = string_table_get(strings, te_list->families[i]);
+            record.unique = !syntenic[i - job.begin];
+            record.coverage = coverage[i - job.begin];
+            if (callback(&record, user_data) != 0) {
+                return set_error(ctx, TEVOX_ERR_ABORTED, "Stopped by callback at genome %d record %d",
+                                 genome, i);
+            }
+        }
+    }
+    return TEVOX_OK;
+}
+
+int tevox_classify(TevoxContext* ctx, int genome, TevoxRecordCallback callback, void* user_data) {
+    if (!ctx || !callback) return set_error(ctx, TEVOX_ERR_ARGUMENT, "Missing callback");
+    if (genome < 0 || genome > 2) return set_error(ctx, TEVOX_ERR_ARGUMENT, "Genome must be 0, 1 or 2");
+    if (!ctx->has_synteny) return set_error(ctx, TEVOX_ERR_ARGUMENT, "No synteny file loaded");
+    for (int g = 1; g <= 2; g++) {
+        if ((genome == 0 || genome == g) && !ctx->has_te[g - 1]) {
+            return set_error(ctx, TEVOX_ERR_ARGUMENT, "No TE file loaded for genome %d", g);
+        }
+    }
+    
+    // 结果缓冲区只保存一轮，与注释大小无关
+    unsigned char* syntenic = (unsigned char*)malloc(CLASSIFY_ROUND_SIZE);
+    double* coverage = (double*)malloc(CLASSIFY_ROUND_SIZE * sizeof(double));
+    if (!syntenic || !coverage) {
+        free(syntenic);
+        free(coverage);
+        return set_error(ctx, TEVOX_ERR_NOMEM, "Out of memory");
+    }
+    
+    // 回调中调用本库的其他函数时，它们设置自己的陷阱并在返回前恢复这一个
+    int status = TEVOX_OK;
+    jmp_buf trap;
+    jmp_buf* previous = set_oom_trap(&trap);
+    if (setjmp(trap)) {
+        set_oom_trap(previous);
+        free(syntenic);
+        free(coverage);
+        return set_error(ctx, TEVOX_ERR_NOMEM, "Out of memory while classifying");
+    }
+    for (int g = 1; g <= 2 && status == TEVOX_OK; g++) {
+        if (genome == 0 || genome == g) {
+            status = classify_genome(ctx, g, callback, user_data, syntenic, coverage);
+        }
+    }
+    set_oom_trap(previous);
+    
+    free(syntenic);
+    free(coverage);
+    return status;
+}
+
+const char* tevox_last_error(const TevoxContext* ctx) {
+    return ctx ? ctx->error : "No context";
+}
+
+const char* tevox_strerror(int status) {
+    switch (status) {
+        case TEVOX_OK: return "Success";
+        case TEVOX_ERR_ARGUMENT: return "Invalid argument";
+        case TEVOX_ERR_IO: return "Cannot read file";
+        case TEVOX_ERR_FORMAT: return "Unsupported or corrupt file";
+        case TEVOX_ERR_NOMEM: return "Out of memory";
+        case TEVOX_ERR_ABORTED: return "Stopped by callback";
+        default: return "Unknown error";
+    }
+}
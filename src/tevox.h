@@ -0,0 +1,77 @@
+#ifndef TEVOX_H
+#define TEVOX_H
+
+// libtevox：在其他程序中比较两个基因组的转座子差异。
+//
+// 所有状态都保存在TevoxContext中，不同上下文之间互不影响，可以在不同线程中同时使用；
+// 同一个上下文同一时间只能由一个线程调用。函数不向标准输出打印任何内容，也不会因为
+// 内存不足而退出进程，失败时返回负的TevoxStatus，详细信息由tevox_last_error给出。
+// 输入文件中格式有问题的行仍会在标准错误输出警告。
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define TEVOX_API __attribute__((visibility("default")))
+#else
+#define TEVOX_API
+#endif
+
+typedef enum {
+    TEVOX_OK = 0,
+    TEVOX_ERR_ARGUMENT = -1,    // 参数无效，或缺少需要先加载的数据
+    TEVOX_ERR_IO = -2,          // 文件无法打开或读取
+    TEVOX_ERR_FORMAT = -3,      // 文件格式无法识别或内容损坏
+    TEVOX_ERR_NOMEM = -4,       // 内存不足
+    TEVOX_ERR_ABORTED = -5      // 回调函数要求停止
+} TevoxStatus;
+
+typedef struct TevoxContext TevoxContext;
+
+// 一个转座子的分类结果，字符串指针只在回调期间有效
+typedef struct {
+    int genome;                 // 1或2
+    long index;                 // 在该基因组注释中的顺序（从0开始）
+    const char* id;
+    const char* name;
+    const char* chr;
+    long long start;            // 1-based闭区间
+    long long end;
+    const char* strand;         // 缺失时为NULL
+    const char* type;
+    const char* family;
+    int unique;                 // 1表示独有（不在共线性区域内）
+    double coverage;            // 被共线性区块覆盖的比例（0到1）
+} TevoxRecord;
+
+// 返回0继续，返回非0时tevox_classify停止并返回TEVOX_ERR_ABORTED
+typedef int (*TevoxRecordCallback)(const TevoxRecord* record, void* user_data);
+
+// 上下文
+TEVOX_API TevoxContext* tevox_context_new(void);
+TEVOX_API void tevox_context_free(TevoxContext* ctx);
+
+// 选项：线程数（0表示使用所有CPU，默认1）；最小覆盖比例（0表示重叠1 bp即可，默认0）
+TEVOX_API int tevox_set_threads(TevoxContext* ctx, int num_threads);
+TEVOX_API int tevox_set_min_overlap(TevoxContext* ctx, double fraction, int reciprocal);
+
+// 加载输入（可为gzip/BGZF压缩），再次加载时替换之前的数据
+TEVOX_API int tevox_load_synteny(TevoxContext* ctx, const char* filename);
+TEVOX_API int tevox_load_te(TevoxContext* ctx, int genome, const char* filename);
+TEVOX_API long tevox_te_count(const TevoxContext* ctx, int genome);
+TEVOX_API long tevox_synteny_count(const TevoxContext* ctx);
+
+// 按注释顺序对genome（1、2，或0表示两个基因组依次）的每个转座子调用callback。
+// 回调总在调用线程中执行；分类按块并行计算，不保存独有转座子列表
+TEVOX_API int tevox_classify(TevoxContext* ctx, int genome, TevoxRecordCallback callback, void* user_data);
+
+// 错误信息
+TEVOX_API const char* tevox_last_error(const TevoxContext* ctx);
+TEVOX_API const char* tevox_strerror(int status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TEVOX_H
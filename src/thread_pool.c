@@ -0,0 +1,92 @@
+#include "te_comparator.h"
+#include <pthread.h>
+#include <unistd.h>
+
+// 解析线程数：0表示使用所有在线CPU
+int resolve_thread_count(int num_threads) {
+    if (num_threads > 0) return num_threads;
+    
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (int)cpus : 1;
+}
+
+// parallel_for的共享状态：工作线程从next_task依次领取任务
+typedef struct {
+    void (*fn)(void* ctx, int task);
+    void* ctx;
+    int num_tasks;
+    int next_task;
+    bool trap_oom;          // 调用线程设置了内存不足陷阱
+    bool failed;            // 有任务内存不足
+    pthread_mutex_t lock;
+} ParallelJob;
+
+static void* parallel_worker(void* arg) {
+    ParallelJob* job = (ParallelJob*)arg;
+    
+    // 调用线程设置了陷阱时，工作线程内存不足只停止领取任务，由parallel_for转交给调用线程
+    jmp_buf trap;
+    jmp_buf* previous = NULL;
+    if (job->trap_oom) {
+        previous = set_oom_trap(&trap);
+        if (setjmp(trap)) {
+            pthread_mutex_lock(&job->lock);
+            job->failed = true;
+            job->next_task = job->num_tasks;
+            pthread_mutex_unlock(&job->lock);
+            set_oom_trap(previous);
+            return NULL;
+        }
+    }
+    
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        int task = job->next_task < job->num_tasks ? job->next_task++ : -1;
+        pthread_mutex_unlock(&job->lock);
+        
+        if (task < 0) break;
+        job->fn(job->ctx, task);
+    }
+    
+    if (job->trap_oom) set_oom_trap(previous);
+    return NULL;
+}
+
+// 用最多num_threads个线程执行fn(ctx, 0..num_tasks-1)，全部完成后返回；
+// 任务间的执行顺序不确定，结果应写入各任务自己的槽位。
+// 任务内存不足时按调用线程的方式处理（退出或跳回其陷阱），任务不应在持有锁时分配内存
+void parallel_for(int num_tasks, int num_threads, void (*fn)(void* ctx, int task), void* ctx) {
+    if (num_tasks <= 0 || !fn) return;
+    
+    num_threads = resolve_thread_count(num_threads);
+    if (num_threads > num_tasks) num_threads = num_tasks;
+    
+    ParallelJob job;
+    job.fn = fn;
+    job.ctx = ctx;
+    job.num_tasks = num_tasks;
+    job.next_task = 0;
+    job.trap_oom = oom_trap_active();
+    job.failed = false;
+    pthread_mutex_init(&job.lock, NULL);
+    
+    // 当前线程也参与执行，只需另外创建num_threads-1个线程
+    int extra = num_threads - 1;
+    pthread_t* threads = extra > 0 ? (pthread_t*)safe_malloc(extra * sizeof(pthread_t)) : NULL;
+    int started = 0;
+    for (int i = 0; i < extra; i++) {
+        if (pthread_create(&threads[started], NULL, parallel_worker, &job) == 0) {
+            started++;
+        }
+    }
+    
+    parallel_worker(&job);
+    
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    
+    free(threads);
+    pthread_mutex_destroy(&job.lock);
+    if (job.failed) out_of_memory(0);
+}
@@ -1,5 +1,7 @@
 #include "te_comparator.h"
 #include <ctype.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 // 简单的strcasecmp替代函数
 int strcasecmp_safe(const char* s1, const char* s2) {
@@ -15,23 +17,38 @@ int strcasecmp_safe(const char* s1, const char* s2) {
     return tolower((unsigned char)*s1) - tolower((unsigned char)*s2);
 }
 
+// 当前线程的内存不足陷阱，库接口在调用内部函数前设置
+static __thread jmp_buf* oom_trap = NULL;
+
+// 设置当前线程的内存不足陷阱，返回之前的陷阱（NULL表示直接退出进程）
+jmp_buf* set_oom_trap(jmp_buf* trap) {
+    jmp_buf* previous = oom_trap;
+    oom_trap = trap;
+    return previous;
+}
+
+bool oom_trap_active(void) {
+    return oom_trap != NULL;
+}
+
+// 内存不足：设置了陷阱时跳回陷阱，由调用方返回错误码；否则退出
+void out_of_memory(size_t size) {
+    if (oom_trap) longjmp(*oom_trap, 1);
+    fprintf(stderr, "Error: Memory allocation failed for %zu bytes\n", size);
+    exit(EXIT_FAILURE);
+}
+
 // 安全内存分配函数
 void* safe_malloc(size_t size) {
     void* ptr = malloc(size);
-    if (!ptr) {
-        fprintf(stderr, "Error: Memory allocation failed for %zu bytes\n", size);
-        exit(EXIT_FAILURE);
-    }
+    if (!ptr) out_of_memory(size);
     return ptr;
 }
 
 // 安全内存重新分配函数
 void* safe_realloc(void* ptr, size_t size) {
     void* new_ptr = realloc(ptr, size);
-    if (!new_ptr) {
-        fprintf(stderr, "Error: Memory reallocation failed for %zu bytes\n", size);
-        exit(EXIT_FAILURE);
-    }
+    if (!new_ptr) out_of_memory(size);
     return new_ptr;
 }
 
@@ -39,30 +56,141 @@ void* safe_realloc(void* ptr, size_t size) {
 char* strdup_safe(const char* str) {
     if (!str) return NULL;
     char* new_str = strdup(str);
-    if (!new_str) {
-        fprintf(stderr, "Error: String duplication failed\n");
-        exit(EXIT_FAILURE);
-    }
+    if (!new_str) out_of_memory(strlen(str) + 1);
     return new_str;
 }
 
-// 检测文件类型
-FileType detect_file_type(const char* filename) {
-    if (!filename) return FILE_UNKNOWN;
+// 内存池单块的默认大小
+#define ARENA_SLAB_SIZE (256 * 1024)
+
+// 初始化内存池
+void init_arena(Arena* arena) {
+    if (!arena) return;
+    arena->head = NULL;
+    arena->bytes_used = 0;
+}
+
+// 从内存池分配size字节（8字节对齐），不能单独释放
+void* arena_alloc(Arena* arena, size_t size) {
+    if (!arena) return NULL;
+    
+    size = (size + 7) & ~(size_t)7;
     
-    FILE* file = fopen(filename, "r");
-    if (!file) return FILE_UNKNOWN;
+    ArenaSlab* slab = arena->head;
+    if (!slab || slab->size - slab->used < size) {
+        size_t slab_size = size > ARENA_SLAB_SIZE ? size : ARENA_SLAB_SIZE;
+        ArenaSlab* new_slab = (ArenaSlab*)safe_malloc(sizeof(ArenaSlab) + slab_size);
+        new_slab->used = 0;
+        new_slab->size = slab_size;
+        
+        // 超大分配单独成块，挂在当前块之后，避免浪费当前块的剩余空间
+        if (slab && size > ARENA_SLAB_SIZE) {
+            new_slab->next = slab->next;
+            slab->next = new_slab;
+        } else {
+            new_slab->next = slab;
+            arena->head = new_slab;
+        }
+        slab = new_slab;
+    }
+    
+    void* ptr = slab->data + slab->used;
+    slab->used += size;
+    arena->bytes_used += size;
+    return ptr;
+}
+
+// 复制长度为len的字符串到内存池
+char* arena_strndup(Arena* arena, const char* str, size_t len) {
+    if (!str) return NULL;
+    char* new_str = (char*)arena_alloc(arena, len + 1);
+    memcpy(new_str, str, len);
+    new_str[len] = '\0';
+    return new_str;
+}
+
+// 复制字符串到内存池
+char* arena_strdup(Arena* arena, const char* str) {
+    if (!str) return NULL;
+    return arena_strndup(arena, str, strlen(str));
+}
+
+// 记录内存池当前的分配位置
+ArenaMark arena_mark(const Arena* arena) {
+    ArenaMark mark = { arena->head, arena->head ? arena->head->next : NULL,
+                       arena->head ? arena->head->used : 0, arena->bytes_used };
+    return mark;
+}
+
+// 撤销arena_mark之后的所有分配：释放之后新建的块（包括挂在当前块之后的超大块），
+// 当前块回到记录时的位置
+void arena_reset(Arena* arena, const ArenaMark* mark) {
+    while (arena->head != mark->head) {
+        ArenaSlab* slab = arena->head;
+        arena->head = slab->next;
+        free(slab);
+    }
+    if (arena->head) {
+        while (arena->head->next != mark->next) {
+            ArenaSlab* slab = arena->head->next;
+            arena->head->next = slab->next;
+            free(slab);
+        }
+        arena->head->used = mark->used;
+    }
+    arena->bytes_used = mark->bytes_used;
+}
+
+// 把src中的所有内存块转移给dest，之后src为空；已分配的指针保持有效
+void arena_adopt(Arena* dest, Arena* src) {
+    if (!dest || !src || !src->head) return;
     
-    char line[1024];
-    if (fgets(line, sizeof(line), file) == NULL) {
-        fclose(file);
-        return FILE_UNKNOWN;
+    if (!dest->head) {
+        dest->head = src->head;
+    } else {
+        // 挂在dest当前块之后，dest继续在当前块中分配
+        ArenaSlab* tail = src->head;
+        while (tail->next) tail = tail->next;
+        tail->next = dest->head->next;
+        dest->head->next = src->head;
     }
     
-    fclose(file);
+    dest->bytes_used += src->bytes_used;
+    init_arena(src);
+}
+
+// 释放内存池中的所有内存
+void free_arena(Arena* arena) {
+    if (!arena) return;
     
-    // 检查文件扩展名
-    const char* ext = strrchr(filename, '.');
+    ArenaSlab* slab = arena->head;
+    while (slab) {
+        ArenaSlab* next = slab->next;
+        free(slab);
+        slab = next;
+    }
+    init_arena(arena);
+}
+
+// 判断字段是否为非负整数
+static bool slice_is_integer(StrSlice slice) {
+    if (slice.len == 0) return false;
+    for (size_t i = 0; i < slice.len; i++) {
+        if (slice.ptr[i] < '0' || slice.ptr[i] > '9') return false;
+    }
+    return true;
+}
+
+// 根据扩展名判断文件类型，忽略压缩后缀（.gz/.bgz）
+static FileType detect_type_by_extension(const char* filename) {
+    char name[1024];
+    snprintf(name, sizeof(name), "%s", filename);
+    
+    char* ext = strrchr(name, '.');
+    if (ext && (strcasecmp_safe(ext, ".gz") == 0 || strcasecmp_safe(ext, ".bgz") == 0)) {
+        *ext = '\0';
+        ext = strrchr(name, '.');
+    }
     if (!ext) return FILE_UNKNOWN;
     
     if (strcasecmp_safe(ext, ".gff3") == 0 || strcasecmp_safe(ext, ".gff") == 0) {
@@ -70,45 +198,93 @@ FileType detect_file_type(const char* filename) {
     } else if (strcasecmp_safe(ext, ".bed") == 0) {
         return FILE_BED;
     }
+    return FILE_UNKNOWN;
+}
+
+// 检测文件类型：先按内容判断（压缩文件按魔数识别后读取解压内容），
+// 无法判断时再看扩展名。标准输入（"-"）和管道等只能读取一次的输入预读开头的行，
+// 读过的内容留给之后打开同一输入的解析器
+FileType detect_file_type(const char* filename, int num_threads) {
+    if (!filename) return FILE_UNKNOWN;
     
-    // 检查文件内容
-    file = fopen(filename, "r");
-    if (!file) return FILE_UNKNOWN;
+    struct stat st;
+    if (strcmp(filename, "-") != 0 && stat(filename, &st) != 0) return FILE_UNKNOWN;
+    
+    LineReader reader;
+    if (line_reader_open_peek(&reader, filename, num_threads) != 0) return FILE_UNKNOWN;
+    
+    // 库调用内存不足（例如解压线程）时先关闭文件再跳回调用方
+    jmp_buf trap;
+    jmp_buf* previous = NULL;
+    bool trapped = oom_trap_active();
+    if (trapped) {
+        previous = set_oom_trap(&trap);
+        if (setjmp(trap)) {
+            set_oom_trap(previous);
+            line_reader_close(&reader);
+            out_of_memory(0);
+        }
+    }
     
     FileType type = FILE_UNKNOWN;
     int line_count = 0;
+    StrSlice line;
     
-    while (fgets(line, sizeof(line), file) && line_count < 10) {
+    while (type == FILE_UNKNOWN && line_count < 10 && line_reader_next(&reader, &line)) {
         line_count++;
         
-        // 跳过注释行
-        if (line[0] == '#') continue;
+        // GFF3文件头
+        if (line.len >= 13 && memcmp(line.ptr, "##gff-version", 13) == 0) {
+            type = FILE_GFF3;
+            break;
+        }
         
-        // 计算制表符数量
-        int tabs = 0;
-        for (int i = 0; line[i] != '\0'; i++) {
-            if (line[i] == '\t') tabs++;
+        // 跳过注释行、空行和BED的track/browser行
+        if (line.len == 0 || line.ptr[0] == '#' ||
+            (line.len >= 5 && memcmp(line.ptr, "track", 5) == 0) ||
+            (line.len >= 7 && memcmp(line.ptr, "browser", 7) == 0)) {
+            continue;
         }
         
-        if (tabs >= 8) {
-            type = FILE_GFF3;
-            break;
-        } else if (tabs >= 2) {
+        // BED的第2、3列是坐标；GFF3的第2、3列是来源和类型，第4、5列才是坐标
+        StrSlice fields[10];
+        int field_count = split_fields(line, '\t', fields, 10);
+        if (field_count >= 3 && slice_is_integer(fields[1]) && slice_is_integer(fields[2])) {
             type = FILE_BED;
-            break;
+        } else if (field_count >= 9 && slice_is_integer(fields[3]) && slice_is_integer(fields[4])) {
+            type = FILE_GFF3;
         }
     }
+    if (trapped) set_oom_trap(previous);
+    
+    line_reader_unread(&reader, filename);
     
-    fclose(file);
+    if (type == FILE_UNKNOWN) {
+        type = detect_type_by_extension(filename);
+    }
     return type;
 }
 
 // 初始化TE列表
 void init_te_list(TEList* te_list) {
     if (!te_list) return;
-    te_list->transposons = NULL;
+    te_list->chrs = NULL;
+    te_list->starts = NULL;
+    te_list->ends = NULL;
+    te_list->strands = NULL;
+    te_list->types = NULL;
+    te_list->families = NULL;
+    te_list->sources = NULL;
+    te_list->ids = NULL;
+    te_list->names = NULL;
+    te_list->attributes = NULL;
     te_list->count = 0;
     te_list->capacity = 0;
+    te_list->strings = default_string_table();
+    init_arena(&te_list->arena);
+    te_list->mapping = NULL;
+    te_list->mapping_size = 0;
+    te_list->input_order = NULL;
 }
 
 // 初始化共线性列表
@@ -117,33 +293,109 @@ void init_synteny_list(SyntenyList* synteny_list) {
     synteny_list->blocks = NULL;
     synteny_list->count = 0;
     synteny_list->capacity = 0;
+    synteny_list->strings = default_string_table();
+    synteny_list->index = NULL;
+    synteny_list->input_order = NULL;
 }
 
-// 添加转座子到列表
-void add_transposon(TEList* te_list, Transposon* te) {
-    if (!te_list || !te) return;
+// 初始化一条空记录：字符串ID字段为STR_NONE，坐标为0
+void init_transposon(Transposon* te) {
+    if (!te) return;
+    memset(te, 0, sizeof(Transposon));
+    te->chr = STR_NONE;
+    te->strand = STR_NONE;
+    te->type = STR_NONE;
+    te->family = STR_NONE;
+    te->source = STR_NONE;
+}
+
+// 判断某一列是否直接位于.tevx缓存的映射中（这样的列不能realloc或free）
+bool te_list_column_mapped(const TEList* te_list, const void* column) {
+    if (!te_list || !te_list->mapping || !column) return false;
+    const char* begin = (const char*)te_list->mapping;
+    return (const char*)column >= begin && (const char*)column < begin + te_list->mapping_size;
+}
+
+// 扩大一列；映射中的列复制到新分配的内存，之后与解析得到的列相同
+static void* grow_column(const TEList* te_list, void* column, size_t element_size, size_t capacity) {
+    if (!te_list_column_mapped(te_list, column)) return safe_realloc(column, capacity * element_size);
     
+    void* copy = safe_malloc(capacity * element_size);
+    memcpy(copy, column, (size_t)te_list->count * element_size);
+    return copy;
+}
+
+// 保证各列至少能容纳capacity条记录
+void te_list_reserve(TEList* te_list, int capacity) {
+    if (!te_list || capacity <= te_list->capacity) return;
+    
+    size_t n = (size_t)capacity;
+    te_list->chrs = (int*)grow_column(te_list, te_list->chrs, sizeof(int), n);
+    te_list->starts = (int64_t*)grow_column(te_list, te_list->starts, sizeof(int64_t), n);
+    te_list->ends = (int64_t*)grow_column(te_list, te_list->ends, sizeof(int64_t), n);
+    te_list->strands = (int*)grow_column(te_list, te_list->strands, sizeof(int), n);
+    te_list->types = (int*)grow_column(te_list, te_list->types, sizeof(int), n);
+    te_list->families = (int*)grow_column(te_list, te_list->families, sizeof(int), n);
+    te_list->sources = (int*)grow_column(te_list, te_list->sources, sizeof(int), n);
+    te_list->ids = (char**)safe_realloc(te_list->ids, n * sizeof(char*));
+    te_list->names = (char**)safe_realloc(te_list->names, n * sizeof(char*));
+    te_list->attributes = (char**)safe_realloc(te_list->attributes, n * sizeof(char*));
+    if (te_list->input_order) te_list->input_order = (int*)safe_realloc(te_list->input_order, n * sizeof(int));
+    te_list->capacity = capacity;
+}
+
+// 把一条记录追加到各列，返回其下标。字符串不复制，应已分配在te_list->arena中
+int te_list_push(TEList* te_list, const Transposon* te) {
     if (te_list->count >= te_list->capacity) {
-        int new_capacity = te_list->capacity == 0 ? 100 : te_list->capacity * 2;
-        te_list->transposons = (Transposon*)safe_realloc(te_list->transposons, 
-                                                         new_capacity * sizeof(Transposon));
-        te_list->capacity = new_capacity;
+        te_list_reserve(te_list, te_list->capacity == 0 ? 100 : te_list->capacity * 2);
     }
     
-    // 深拷贝转座子数据，避免浅拷贝导致的内存问题
-    Transposon* new_te = &te_list->transposons[te_list->count];
-    memset(new_te, 0, sizeof(Transposon));
-    
-    new_te->id = te->id ? strdup_safe(te->id) : NULL;
-    new_te->chr = te->chr ? strdup_safe(te->chr) : NULL;
-    new_te->start = te->start;
-    new_te->end = te->end;
-    new_te->strand = te->strand ? strdup_safe(te->strand) : NULL;
-    new_te->type = te->type ? strdup_safe(te->type) : NULL;
-    new_te->family = te->family ? strdup_safe(te->family) : NULL;
-    new_te->name = te->name ? strdup_safe(te->name) : NULL;
+    int i = te_list->count++;
+    te_list->chrs[i] = te->chr;
+    te_list->starts[i] = te->start;
+    te_list->ends[i] = te->end;
+    te_list->strands[i] = te->strand;
+    te_list->types[i] = te->type;
+    te_list->families[i] = te->family;
+    te_list->sources[i] = te->source;
+    te_list->ids[i] = te->id;
+    te_list->names[i] = te->name;
+    te_list->attributes[i] = te->attributes;
+    // 排序后追加的记录排在原有记录之后
+    if (te_list->input_order) te_list->input_order[i] = i;
+    return i;
+}
+
+// 从各列取出第index条记录（字符串指针仍指向列表的存储）
+void te_list_get(const TEList* te_list, int index, Transposon* te) {
+    te->chr = te_list->chrs[index];
+    te->start = te_list->starts[index];
+    te->end = te_list->ends[index];
+    te->strand = te_list->strands[index];
+    te->type = te_list->types[index];
+    te->family = te_list->families[index];
+    te->source = te_list->sources[index];
+    te->id = te_list->ids[index];
+    te->name = te_list->names[index];
+    te->attributes = te_list->attributes[index];
+}
+
+// 添加转座子到列表
+void add_transposon(TEList* te_list, Transposon* te) {
+    if (!te_list || !te) return;
     
-    te_list->count++;
+    // 字符串ID字段直接复制（要求te与te_list使用同一字符串表），
+    // id/name复制到列表的内存池中，避免引用调用方的字符串
+    Transposon copy = *te;
+    copy.id = arena_strdup(&te_list->arena, te->id);
+    copy.attributes = arena_strdup(&te_list->arena, te->attributes);
+    // name与id相同（GFF3缺少Name时）共享同一份拷贝
+    if (te->name && te->name == te->id) {
+        copy.name = copy.id;
+    } else {
+        copy.name = arena_strdup(&te_list->arena, te->name);
+    }
+    te_list_push(te_list, &copy);
 }
 
 // 添加共线性区块到列表
@@ -154,56 +406,71 @@ void add_synteny_block(SyntenyList* synteny_list, SyntenyBlock* block) {
         int new_capacity = synteny_list->capacity == 0 ? 100 : synteny_list->capacity * 2;
         synteny_list->blocks = (SyntenyBlock*)safe_realloc(synteny_list->blocks, 
                                                            new_capacity * sizeof(SyntenyBlock));
+        if (synteny_list->input_order) {
+            synteny_list->input_order = (int*)safe_realloc(synteny_list->input_order, new_capacity * sizeof(int));
+        }
         synteny_list->capacity = new_capacity;
     }
     
-    // 深拷贝共线性区块数据，避免浅拷贝导致的内存问题
     SyntenyBlock* new_block = &synteny_list->blocks[synteny_list->count];
     memset(new_block, 0, sizeof(SyntenyBlock));
     
-    new_block->chr1 = block->chr1 ? strdup_safe(block->chr1) : NULL;
-    new_block->chr2 = block->chr2 ? strdup_safe(block->chr2) : NULL;
+    new_block->chr1 = block->chr1;
+    new_block->chr2 = block->chr2;
     new_block->start1 = block->start1;
     new_block->end1 = block->end1;
     new_block->start2 = block->start2;
     new_block->end2 = block->end2;
     new_block->score = block->score;
+    if (synteny_list->input_order) synteny_list->input_order[synteny_list->count] = synteny_list->count;
     
     synteny_list->count++;
+    
+    // 区块变化后旧索引失效，需要重新调用build_synteny_index
+    free_synteny_index(synteny_list->index);
+    synteny_list->index = NULL;
 }
 
 // 释放TE列表内存
 void free_te_list(TEList* te_list) {
     if (!te_list) return;
     
-    for (int i = 0; i < te_list->count; i++) {
-        Transposon* te = &te_list->transposons[i];
-        free(te->id);
-        free(te->chr);
-        free(te->strand);
-        free(te->type);
-        free(te->family);
-        free(te->name);
-    }
+    // 字符串都在内存池中，整体释放
+    free_arena(&te_list->arena);
     
-    free(te_list->transposons);
-    te_list->transposons = NULL;
-    te_list->count = 0;
-    te_list->capacity = 0;
+    // 直接位于缓存映射中的列随映射一起释放
+    void* columns[] = {
+        te_list->chrs, te_list->starts, te_list->ends, te_list->strands,
+        te_list->types, te_list->families, te_list->sources
+    };
+    for (size_t c = 0; c < sizeof(columns) / sizeof(columns[0]); c++) {
+        if (!te_list_column_mapped(te_list, columns[c])) free(columns[c]);
+    }
+    if (te_list->mapping) {
+        munmap(te_list->mapping, te_list->mapping_size);
+        te_list->mapping = NULL;
+        te_list->mapping_size = 0;
+    }
+    free(te_list->ids);
+    free(te_list->names);
+    free(te_list->attributes);
+    free(te_list->input_order);
+    StringTable* strings = te_list->strings;
+    init_te_list(te_list);
+    te_list->strings = strings;
 }
 
 // 释放共线性列表内存
 void free_synteny_list(SyntenyList* synteny_list) {
     if (!synteny_list) return;
     
-    for (int i = 0; i < synteny_list->count; i++) {
-        SyntenyBlock* block = &synteny_list->blocks[i];
-        free(block->chr1);
-        free(block->chr2);
-    }
+    free_synteny_index(synteny_list->index);
+    synteny_list->index = NULL;
     
     free(synteny_list->blocks);
     synteny_list->blocks = NULL;
+    free(synteny_list->input_order);
+    synteny_list->input_order = NULL;
     synteny_list->count = 0;
     synteny_list->capacity = 0;
 }
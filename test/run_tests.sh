@@ -84,6 +84,544 @@ else
     echo "✗ Test 4 failed (should have failed)"
 fi
 
+echo
+echo "====================================="
+echo
+
+# Test 5: Grouped breakdown test
+echo "Test 5: Grouped breakdown test"
+echo "Running: ./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_data/genome2_te.bed --group-by type,family -o test_output"
+echo
+
+./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_data/genome2_te.bed --group-by type,family -o test_output | grep -q "LINE/L1: 2"
+
+if [ $? -eq 0 ]; then
+    echo "✓ Test 5 passed"
+else
+    echo "✗ Test 5 failed"
+fi
+
+echo
+echo "====================================="
+echo
+
+# Test 6: Multi-threaded parsing test
+echo "Test 6: Multi-threaded parsing test"
+echo "Running: ./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_data/genome2_te.bed -t 4 -o test_output_mt"
+echo
+
+./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_data/genome2_te.bed -t 4 -o test_output_mt
+
+if [ $? -eq 0 ] && cmp -s test_output_genome1_unique.txt test_output_mt_genome1_unique.txt && \
+   cmp -s test_output_genome2_unique.txt test_output_mt_genome2_unique.txt; then
+    echo "✓ Test 6 passed (output identical to single-threaded run)"
+else
+    echo "✗ Test 6 failed"
+fi
+
+echo
+echo "====================================="
+echo
+
+# Test 7: Compressed input test
+echo "Test 7: Compressed input test"
+echo "Running: ./tevox <gzipped synteny> <gzipped GFF3> test_data/genome2_te.bed -o test_output_gz"
+echo
+
+gzip -c test_data/synteny_example.txt > test_output_synteny.gz
+gzip -c test_data/genome1_te.gff3 > test_output_genome1.gz
+./tevox test_output_synteny.gz test_output_genome1.gz test_data/genome2_te.bed -o test_output_gz
+
+if [ $? -eq 0 ] && cmp -s test_output_genome1_unique.txt test_output_gz_genome1_unique.txt && \
+   cmp -s test_output_genome2_unique.txt test_output_gz_genome2_unique.txt; then
+    echo "✓ Test 7 passed (output identical to uncompressed input)"
+else
+    echo "✗ Test 7 failed"
+fi
+
+echo
+echo "====================================="
+echo
+
+# Test 8: Region-restricted test (tabix/CSI indexed input)
+echo "Test 8: Region-restricted test"
+echo "Running: ./tevox test_data/synteny_example.txt test_data/genome1_te.sorted.gff3.gz test_data/genome2_te.sorted.bed.gz --region chr1:1-16000 -o test_output_region_idx"
+echo
+
+./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_data/genome2_te.bed --region chr1:1-16000 -o test_output_region
+./tevox test_data/synteny_example.txt test_data/genome1_te.sorted.gff3.gz test_data/genome2_te.sorted.bed.gz --region chr1:1-16000 -o test_output_region_idx
+region_status=$?
+
+# 生成的BED记录ID含整个文件中的行号，按索引读取、过滤整个文件和完整解析三者一致
+zcat test_data/genome2_te.sorted.bed.gz > test_output_region_sorted.bed
+./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_data/genome2_te.sorted.bed.gz \
+    -o test_output_region_full > /dev/null
+./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_data/genome2_te.sorted.bed.gz \
+    --region chr1:1-30000 --region2 chr2:1-30000,chr5:10000-30000 -o test_output_region_ids_idx > /dev/null
+./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_output_region_sorted.bed \
+    --region chr1:1-30000 --region2 chr2:1-30000,chr5:10000-30000 -o test_output_region_ids > /dev/null 2>&1
+
+if [ $region_status -eq 0 ] && cmp -s test_output_region_genome1_unique.txt test_output_region_idx_genome1_unique.txt && \
+   cmp -s test_output_region_genome2_unique.txt test_output_region_idx_genome2_unique.txt && \
+   [ "$(grep -vc '^#' test_output_region_idx_genome1_unique.txt)" -eq 2 ] && \
+   cmp -s test_output_region_ids_genome2_unique.txt test_output_region_ids_idx_genome2_unique.txt && \
+   [ "$(grep -v '^#' test_output_region_ids_idx_genome2_unique.txt)" = \
+     "$(grep -v '^#' test_output_region_full_genome2_unique.txt | awk -F '\t' '$2 == "chr2" || ($2 == "chr5" && $4 >= 10000)')" ]; then
+    echo "✓ Test 8 passed (indexed output identical to filtered full scan)"
+else
+    echo "✗ Test 8 failed"
+fi
+
+echo
+echo "====================================="
+echo
+
+# Test 9: Pre-parsed cache test
+echo "Test 9: Pre-parsed cache test"
+echo "Running: ./tevox index <GFF3 copy> && ./tevox test_data/synteny_example.txt <GFF3 copy> <BED copy> --cache -o test_output_cache"
+echo
+
+cp test_data/genome1_te.gff3 test_output_genome1.gff3
+cp test_data/genome2_te.bed test_output_genome2.bed
+./tevox index test_output_genome1.gff3 && \
+./tevox test_data/synteny_example.txt test_output_genome1.gff3 test_output_genome2.bed --cache -o test_output_cache | grep -q "Loaded 13 transposons from cache" && \
+./tevox index --verify test_output_genome1.gff3 test_output_genome2.bed > /dev/null && \
+! ./tevox test_data/synteny_example.txt test_output_genome1.gff3 test_output_genome2.bed --cache --region chr1 \
+    -o test_output_cache_region > /dev/null 2>&1
+cache_status=$?
+
+# 只改修改时间：按内容CRC判断仍然有效，第一次加载把新的修改时间写入头部（改名换成新文件），
+# 之后的加载直接命中，不再改写
+touch -d '2001-01-01 00:00:00' test_output_genome1.gff3
+cache_inode=$(stat -c %i test_output_genome1.gff3.tevx)
+./tevox test_data/synteny_example.txt test_output_genome1.gff3 test_output_genome2.bed --cache \
+    -o test_output_cache_touched | grep -q "Loaded 13 transposons from cache" || cache_status=1
+refreshed_inode=$(stat -c %i test_output_genome1.gff3.tevx)
+./tevox test_data/synteny_example.txt test_output_genome1.gff3 test_output_genome2.bed --cache \
+    -o test_output_cache_touched | grep -q "Loaded 13 transposons from cache" || cache_status=1
+[ "$cache_inode" != "$refreshed_inode" ] && [ "$(stat -c %i test_output_genome1.gff3.tevx)" = "$refreshed_inode" ] && \
+./tevox index --verify test_output_genome1.gff3 > /dev/null || cache_status=1
+
+if [ $cache_status -eq 0 ] && cmp -s test_output_genome1_unique.txt test_output_cache_genome1_unique.txt && \
+   cmp -s test_output_genome2_unique.txt test_output_cache_genome2_unique.txt; then
+    echo "✓ Test 9 passed (cached output identical to parsed input, caches verified and refreshed after touch)"
+else
+    echo "✗ Test 9 failed"
+fi
+
+echo
+echo "====================================="
+echo
+
+# Test 10: Sorted streaming test
+echo "Test 10: Sorted streaming test"
+echo "Running: ./tevox test_data/synteny_example.txt test_data/genome1_te.sorted.gff3.gz test_data/genome2_te.sorted.bed.gz --sorted -o test_output_sorted"
+echo
+
+./tevox test_data/synteny_example.txt test_data/genome1_te.sorted.gff3.gz test_data/genome2_te.sorted.bed.gz -o test_output_presorted > /dev/null
+./tevox test_data/synteny_example.txt test_data/genome1_te.sorted.gff3.gz test_data/genome2_te.sorted.bed.gz --sorted -o test_output_sorted
+
+if [ $? -eq 0 ] && cmp -s test_output_presorted_genome1_unique.txt test_output_sorted_genome1_unique.txt && \
+   cmp -s test_output_presorted_genome2_unique.txt test_output_sorted_genome2_unique.txt && \
+   ! ./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_data/genome2_te.bed --sorted -o test_output_unsorted > /dev/null 2>&1; then
+    echo "✓ Test 10 passed (streamed output identical, unsorted input rejected)"
+else
+    echo "✗ Test 10 failed"
+fi
+
+# Test 11: BED output to standard output
+echo "Test 11: BED output to standard output"
+echo "Running: ./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_data/genome2_te.bed -o - --out-format bed"
+echo
+
+./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_data/genome2_te.bed -o test_output_tsv > /dev/null
+./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_data/genome2_te.bed -o - --out-format bed > test_output_stdout.bed
+
+# BED起点为TSV起点减1，其余坐标一致，且标准输出中没有运行信息
+if [ $? -eq 0 ] && ! grep -q "TE Comparator" test_output_stdout.bed && \
+   diff <(grep -hv "^#" test_output_tsv_genome1_unique.txt test_output_tsv_genome2_unique.txt | awk -F'\t' '{print $2, $3 - 1, $4}') \
+        <(grep -v "^#" test_output_stdout.bed | awk -F'\t' '{print $1, $2, $3}') > /dev/null; then
+    echo "✓ Test 11 passed (BED coordinates are 0-based, progress kept off stdout)"
+else
+    echo "✗ Test 11 failed"
+fi
+
+# Test 12: Profile test
+echo "Test 12: Profile test"
+echo "Running: ./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_data/genome2_te.bed -o test_output_profile --profile-json test_output_profile.json"
+echo
+
+./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_data/genome2_te.bed -o test_output_profile --profile-json test_output_profile.json > test_output_profile.log
+
+if [ $? -eq 0 ] && grep -q "^parse genome 1 .* 13 " test_output_profile.log && \
+   grep -q '"name": "write"' test_output_profile.json && \
+   cmp -s test_output_profile_genome1_unique.txt test_output_tsv_genome1_unique.txt; then
+    echo "✓ Test 12 passed (phase table and JSON written, output unchanged)"
+else
+    echo "✗ Test 12 failed"
+fi
+
+# Test 13: Minimum overlap test
+echo "Test 13: Minimum overlap test"
+echo "Running: ./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_data/genome2_te.bed -o test_output_overlap --min-overlap 0.9"
+echo
+
+./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_data/genome2_te.bed -o test_output_overlap --min-overlap 0.9 > /dev/null
+
+# TE002（chr1:5500-6200）只有6000-6200被区块覆盖：201/701
+if [ $? -eq 0 ] && [ "$(grep -vc '^#' test_output_overlap_genome1_unique.txt)" -eq 8 ] && \
+   grep -q "^TE002	.*	0.2867$" test_output_overlap_genome1_unique.txt && \
+   ! ./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_data/genome2_te.bed --reciprocal > /dev/null 2>&1; then
+    echo "✓ Test 13 passed (partially covered TEs reported with their coverage)"
+else
+    echo "✗ Test 13 failed"
+fi
+
+echo
+
+# Test 14: Orthology test
+echo "Test 14: Orthology test"
+echo "Running: ./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_data/genome2_te.bed -o test_output_orthology --orthology"
+echo
+
+./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_data/genome2_te.bed -o test_output_orthology --orthology > /dev/null
+
+# TE002映射到chr1:5700-6400，与基因组2的TE002（5701-6400）对应；TE005映射后找不到对应转座子
+if [ $? -eq 0 ] && grep -q "^TE002	.*	shared	chr1	5700	6400	TE_4_5701_6400$" test_output_orthology_genome1_orthology.txt && \
+   grep -q "^TE005	.*	PAV	chr3	12500	13000	\.$" test_output_orthology_genome1_orthology.txt && \
+   [ "$(grep -c '	outside	' test_output_orthology_genome1_orthology.txt)" -eq 6 ] && \
+   [ "$(grep -c '	shared	' test_output_orthology_genome2_orthology.txt)" -eq 6 ]; then
+    echo "✓ Test 14 passed (TEs classified as shared, PAV or outside synteny)"
+else
+    echo "✗ Test 14 failed"
+fi
+
+echo
+
+# Test 15: Multi-genome test
+echo "Test 15: Multi-genome test"
+echo "Running: ./tevox multi test_output_manifest.txt -o test_output_multi -t 2"
+echo
+
+cat > test_output_manifest.txt << 'EOF'
+genome  g1  test_data/genome1_te.gff3
+genome  g2  test_data/genome2_te.bed
+genome  g3  test_data/genome2_te.bed
+synteny g1  g2  test_data/synteny_example.txt
+synteny g1  g3  test_data/synteny_example.txt
+EOF
+./tevox multi test_output_manifest.txt -o test_output_multi -t 2 > /dev/null
+
+# 每对的结果与单独比较相同；TE002在三个基因组中都存在，TE005在g2和g3中缺失
+if [ $? -eq 0 ] && cmp -s test_output_multi_g1_g2_genome1_unique.txt test_output_genome1_unique.txt && \
+   cmp -s test_output_multi_g1_g3_genome2_unique.txt test_output_genome2_unique.txt && \
+   grep -q "	TE002	.*	1	1	1$" test_output_multi_pav_matrix.txt && \
+   grep -q "	TE005	.*	1	0	0$" test_output_multi_pav_matrix.txt; then
+    echo "✓ Test 15 passed (pairs match single runs, presence/absence matrix written)"
+else
+    echo "✗ Test 15 failed"
+fi
+
+# Test 16: Query server test
+echo "Test 16: Query server test"
+echo "Running: ./tevox serve test_data/synteny_example.txt test_data/genome1_te.gff3 test_data/genome2_te.bed --socket test_output.sock"
+echo
+
+rm -f test_output.sock
+./tevox serve test_data/synteny_example.txt test_data/genome1_te.gff3 test_data/genome2_te.bed \
+    --socket test_output.sock > /dev/null 2>&1 &
+server_pid=$!
+for ((i = 0; i < 50; i++)); do
+    [ -S test_output.sock ] && break
+    sleep 0.1
+done
+./tevox query --socket test_output.sock "POINT 1 chr1 5600" "SYNTENY 2 chr1 20000 21000" > test_output_query.txt
+query_status=$?
+kill $server_pid 2>/dev/null
+wait $server_pid 2>/dev/null
+
+# TE002覆盖chr1:5600且在共线性区域内；genome2的chr1:20000-21000不在共线性区域内
+if [ $query_status -eq 0 ] && grep -q "^syntenic	.*	TE002	chr1	5500	6200	" test_output_query.txt && \
+   grep -q "^chr1	20000	21000	unique	" test_output_query.txt && [ ! -e test_output.sock ]; then
+    echo "✓ Test 16 passed (server answered point and synteny queries)"
+else
+    echo "✗ Test 16 failed"
+fi
+
+# Test 17: Library test
+echo "Test 17: Library test"
+echo "Running: a program linked against libtevox.a, two contexts on two threads"
+echo
+
+cat > test_output_lib.c << 'EOF'
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include "tevox.h"
+
+typedef struct { char ids[2][4096]; int status; } Result;
+
+static int collect(const TevoxRecord* record, void* user_data) {
+    Result* result = (Result*)user_data;
+    if (record->unique) {
+        strcat(result->ids[record->genome - 1], record->id);
+        strcat(result->ids[record->genome - 1], "\n");
+    }
+    return 0;
+}
+
+static int stop(const TevoxRecord* record, void* user_data) {
+    (void)record;
+    (void)user_data;
+    return 1;
+}
+
+static void* run(void* arg) {
+    Result* result = (Result*)arg;
+    TevoxContext* ctx = tevox_context_new();
+    result->status = tevox_load_synteny(ctx, "test_data/synteny_example.txt");
+    if (result->status == TEVOX_OK) result->status = tevox_load_te(ctx, 1, "test_data/genome1_te.gff3");
+    if (result->status == TEVOX_OK) result->status = tevox_load_te(ctx, 2, "test_data/genome2_te.bed");
+    if (result->status == TEVOX_OK) result->status = tevox_classify(ctx, 0, collect, result);
+    if (result->status == TEVOX_OK && tevox_classify(ctx, 1, stop, NULL) != TEVOX_ERR_ABORTED) result->status = -99;
+    if (result->status == TEVOX_OK && tevox_load_te(ctx, 1, "test_output_missing.gff3") != TEVOX_ERR_IO) result->status = -99;
+    tevox_context_free(ctx);
+    return NULL;
+}
+
+int main(void) {
+    static Result results[2];
+    pthread_t threads[2];
+    for (int i = 0; i < 2; i++) pthread_create(&threads[i], NULL, run, &results[i]);
+    for (int i = 0; i < 2; i++) pthread_join(threads[i], NULL);
+    if (results[0].status != TEVOX_OK || results[1].status != TEVOX_OK ||
+        memcmp(&results[0], &results[1], sizeof(Result)) != 0) {
+        return 1;
+    }
+    printf("%s#\n%s", results[0].ids[0], results[0].ids[1]);
+    return 0;
+}
+EOF
+gcc -std=c99 -Isrc test_output_lib.c libtevox.a -o test_output_lib -lm -lz -pthread && \
+    ./test_output_lib > test_output_lib.txt
+lib_status=$?
+{ grep -v "^#" test_output_genome1_unique.txt | grep -v "^ID" | cut -f1; echo "#"; \
+  grep -v "^#" test_output_genome2_unique.txt | grep -v "^ID" | cut -f1; } > test_output_lib_expected.txt
+
+# 库的结果与命令行一致，且库函数没有向标准输出打印
+if [ $lib_status -eq 0 ] && cmp -s test_output_lib.txt test_output_lib_expected.txt; then
+    echo "✓ Test 17 passed (library results match the CLI, contexts are independent)"
+else
+    echo "✗ Test 17 failed"
+fi
+
+# Test 18: Field scanner test
+echo "Test 18: Field scanner test"
+echo "Running: TEVOX_SIMD=scalar ./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_data/genome2_te.bed -o test_output_scalar"
+echo
+
+TEVOX_SIMD=scalar ./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_data/genome2_te.bed \
+    -o test_output_scalar --profile > test_output_scalar.log
+
+# 标量实现与按CPU选择的实现结果相同
+if [ $? -eq 0 ] && grep -q "^Field scanner: scalar$" test_output_scalar.log && \
+   cmp -s test_output_genome1_unique.txt test_output_scalar_genome1_unique.txt && \
+   cmp -s test_output_genome2_unique.txt test_output_scalar_genome2_unique.txt; then
+    echo "✓ Test 18 passed (scalar fallback matches the vectorized field scanner)"
+else
+    echo "✗ Test 18 failed"
+fi
+
+# Test 19: Coordinates beyond 2^31 test
+echo "Test 19: Coordinates beyond 2^31 test"
+echo "Running: ./tevox test_output_giga_synteny.txt test_output_giga.gff3 test_output_giga.bed -o test_output_giga --orthology"
+echo
+
+# 针叶树和小麦的染色体超过2^31 bp：坐标按64位解析、比较、映射和输出
+printf 'chrA\t3000000000\t3100000000\tchrB\t4000000000\t4100000000\n' > test_output_giga_synteny.txt
+printf 'chrA\tRM\tLTR\t3050000001\t3050001000\t.\t+\t.\tID=big1;family=Gypsy\n' > test_output_giga.gff3
+printf 'chrA\tRM\tLTR\t2147483000\t2147484500\t.\t-\t.\tID=big2;family=Gypsy\n' >> test_output_giga.gff3
+printf 'chrB\t4050000000\t4050001000\tbig3\t0\t+\tLTR\n' > test_output_giga.bed
+printf 'chrB\t5000000000\t5000000500\tbig4\t0\t+\tLTR\n' >> test_output_giga.bed
+./tevox test_output_giga_synteny.txt test_output_giga.gff3 test_output_giga.bed -o test_output_giga --orthology > /dev/null
+
+if [ $? -eq 0 ] && [ "$(grep -v '^#' test_output_giga_genome1_unique.txt | cut -f1-4)" = "big2	chrA	2147483000	2147484500" ] && \
+   [ "$(grep -v '^#' test_output_giga_genome2_unique.txt | cut -f2-4)" = "chrB	5000000001	5000000500" ] && \
+   grep -q "^big1	.*	shared	chrB	4050000001	4050001000	TE_1_4050000001_4050001000$" test_output_giga_genome1_orthology.txt; then
+    echo "✓ Test 19 passed (giga-base coordinates compared and mapped without overflow)"
+else
+    echo "✗ Test 19 failed"
+fi
+
+# Test 20: Sort test
+echo "Test 20: Sort test"
+echo "Running: ./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_data/genome2_te.bed --sort --orthology -o test_output_sort"
+echo
+
+./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_data/genome2_te.bed \
+    --sort --orthology -o test_output_sort > /dev/null
+sort_status=$?
+./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_data/genome2_te.bed \
+    --sort --input-order --orthology -o test_output_input_order > /dev/null
+input_order_status=$?
+
+# 超过单个缓存内排序区段的注释走先分桶再排序的路径
+awk 'BEGIN {
+    srand(11);
+    for (i = 0; i < 200000; i++) {
+        start = int(rand() * 30000000);
+        printf "chr%d\t%d\t%d\tbig%d\t0\t+\tLTR\n", int(rand() * 5) + 1, start, start + int(rand() * 5000) + 1, i;
+    }
+}' > test_output_sort_large.bed
+./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_output_sort_large.bed \
+    -o test_output_sort_large_plain > /dev/null
+./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_output_sort_large.bed \
+    --sort -o test_output_sort_large > /dev/null
+large_status=$?
+./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_output_sort_large.bed \
+    --sort --input-order -t 4 -o test_output_sort_large_input > /dev/null
+large_input_status=$?
+
+# 排序只改变输出顺序：记录集合与未排序的运行相同，并按染色体和起点排列
+# （示例中染色体的ID顺序与名称顺序一致）
+sort_ok=true
+for f in genome1_unique genome2_unique genome1_orthology genome2_orthology; do
+    if [ "$(grep -v '^#' test_output_sort_$f.txt | sort)" != "$(grep -v '^#' test_output_orthology_$f.txt | sort)" ] || \
+       ! grep -v '^#' test_output_sort_$f.txt | cut -f2,3 | LC_ALL=C sort -c -k1,1 -k2,2n 2> /dev/null; then
+        sort_ok=false
+    fi
+    # --input-order：排序后比较，输出与未排序的运行逐字节相同
+    cmp -s test_output_input_order_$f.txt test_output_orthology_$f.txt || sort_ok=false
+done
+# 同一位置的记录保持输入顺序，因此按染色体、起点和终点稳定排序未排序的输出即得到排序后的输出
+[ "$(grep -v '^#' test_output_sort_large_genome2_unique.txt)" = \
+  "$(grep -v '^#' test_output_sort_large_plain_genome2_unique.txt | LC_ALL=C sort -s -t '	' -k2,2 -k3,3n -k4,4n)" ] || sort_ok=false
+cmp -s test_output_sort_large_input_genome2_unique.txt test_output_sort_large_plain_genome2_unique.txt || sort_ok=false
+if [ $sort_status -eq 0 ] && [ $input_order_status -eq 0 ] && [ $large_status -eq 0 ] && \
+   [ $large_input_status -eq 0 ] && $sort_ok && \
+   ! cmp -s test_output_sort_genome2_unique.txt test_output_orthology_genome2_unique.txt; then
+    echo "✓ Test 20 passed (sorted output holds the same records in position order, --input-order restores it)"
+else
+    echo "✗ Test 20 failed"
+fi
+
+# Test 21: Genome sequence extraction test
+echo "Test 21: Genome sequence extraction test"
+echo "Running: ./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_data/genome2_te.bed test_output_genome.fa test_output_genome.fa -o test_output_fasta"
+echo
+
+# 生成一个每行50 bp的合成基因组，两个基因组共用同一个FASTA
+awk 'BEGIN {
+    srand(7);
+    for (c = 1; c <= 5; c++) {
+        print ">chr" c " synthetic";
+        line = "";
+        for (i = 1; i <= 30000; i++) {
+            line = line substr("ACGT", int(rand() * 4) + 1, 1);
+            if (i % 50 == 0) { print line; line = ""; }
+        }
+    }
+}' > test_output_genome.fa
+
+./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_data/genome2_te.bed \
+    test_output_genome.fa test_output_genome.fa -o test_output_fasta > /dev/null
+fasta_status=$?
+
+# 取出染色体的第start到end个碱基
+genome_bases() {
+    awk -v name=">$1" '/^>/ { p = ($1 == name); next } p' test_output_genome.fa | tr -d '\n' | cut -c"$2-$3"
+}
+fasta_record() {
+    awk -v id=">$2" '/^>/ { p = ($1 == id); next } p' "$1" | tr -d '\n'
+}
+
+fasta_ok=true
+grep -q "^chr1	30000	16	50	51$" test_output_genome.fa.fai || fasta_ok=false
+for g in 1 2; do
+    if [ "$(grep -c '^>' test_output_fasta_genome${g}_unique.fa)" != \
+         "$(grep -vc '^#' test_output_fasta_genome${g}_unique.txt)" ]; then
+        fasta_ok=false
+    fi
+done
+# 正链原样输出，负链输出反向互补序列
+te_line=$(grep -v '^#' test_output_fasta_genome1_unique.txt | awk -F'\t' '$5 == "+"' | head -1)
+te_id=$(echo "$te_line" | cut -f1)
+[ "$(fasta_record test_output_fasta_genome1_unique.fa "$te_id")" = \
+  "$(genome_bases $(echo "$te_line" | cut -f2-4 | tr '\t' ' '))" ] || fasta_ok=false
+te_line=$(grep -v '^#' test_output_fasta_genome1_unique.txt | awk -F'\t' '$5 == "-"' | head -1)
+te_id=$(echo "$te_line" | cut -f1)
+[ "$(fasta_record test_output_fasta_genome1_unique.fa "$te_id")" = \
+  "$(genome_bases $(echo "$te_line" | cut -f2-4 | tr '\t' ' ') | rev | tr ACGT TGCA)" ] || fasta_ok=false
+
+if [ $fasta_status -eq 0 ] && $fasta_ok; then
+    echo "✓ Test 21 passed (unique TE sequences extracted with strand-aware orientation)"
+else
+    echo "✗ Test 21 failed"
+fi
+
+# Test 22: Sequence cluster test
+echo "Test 22: Sequence cluster test"
+echo "Running: ./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_data/genome2_te.bed test_output_genome.fa test_output_genome.fa --cluster -o test_output_cluster"
+echo
+
+# 两个基因组共用Test 21的FASTA，坐标重叠的独有转座子序列相同
+./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_data/genome2_te.bed \
+    test_output_genome.fa test_output_genome.fa --cluster -o test_output_cluster > /dev/null
+cluster_status=$?
+./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_data/genome2_te.bed \
+    test_output_genome.fa test_output_genome.fa --cluster --min-containment 0.9 -o test_output_cluster_strict > /dev/null
+strict_status=$?
+./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_data/genome2_te.bed \
+    test_output_genome.fa --cluster -o test_output_cluster_missing > /dev/null 2>&1
+missing_status=$?
+
+cluster_pairs=$(grep -v '^#' test_output_cluster_te_matches.txt | cut -f1,7,16 | tr '\t\n' ' ;')
+cluster_members=$(grep -v '^#' test_output_cluster_te_clusters.txt | cut -f1-3 | tr '\t\n' ' ;')
+if [ $cluster_status -eq 0 ] && [ $strict_status -eq 0 ] && [ $missing_status -ne 0 ] && \
+   [ "$cluster_pairs" = "TE004 TE_6_8701_9400 1;TE010 TE_12_14301_14800 2;" ] && \
+   [ "$cluster_members" = "1 1 TE004;1 2 TE_6_8701_9400;2 1 TE010;2 2 TE_12_14301_14800;" ] && \
+   [ "$(grep -vc '^#' test_output_cluster_strict_te_matches.txt)" = "0" ]; then
+    echo "✓ Test 22 passed (overlapping unique TEs matched and clustered across genomes)"
+else
+    echo "✗ Test 22 failed"
+fi
+
+echo
+echo "====================================="
+echo
+
+# Test 23: Stdin and pipe input test
+echo "Test 23: Stdin and pipe input test"
+echo "Running: cat test_data/genome2_te.bed | ./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 - -o test_output_stdin"
+echo
+
+# 管道输入没有扩展名，格式由预读的开头几行判断，预读的数据交还给解析器
+cat test_data/genome2_te.bed | ./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 - \
+    -t 2 -o test_output_stdin > /dev/null
+stdin_status=$?
+./tevox test_data/synteny_example.txt <(cat test_data/genome1_te.gff3) <(cat test_data/genome2_te.bed) \
+    -o test_output_procsub > /dev/null
+procsub_status=$?
+rm -f test_output_fifo
+mkfifo test_output_fifo
+cat test_data/genome2_te.bed > test_output_fifo &
+timeout 10 ./tevox test_data/synteny_example.txt test_data/genome1_te.gff3 test_output_fifo \
+    -o test_output_fifo > /dev/null
+fifo_status=$?
+wait
+rm -f test_output_fifo
+
+if [ $stdin_status -eq 0 ] && [ $procsub_status -eq 0 ] && [ $fifo_status -eq 0 ] && \
+   cmp -s test_output_genome1_unique.txt test_output_stdin_genome1_unique.txt && \
+   cmp -s test_output_genome2_unique.txt test_output_stdin_genome2_unique.txt && \
+   cmp -s test_output_genome1_unique.txt test_output_procsub_genome1_unique.txt && \
+   cmp -s test_output_genome2_unique.txt test_output_procsub_genome2_unique.txt && \
+   cmp -s test_output_genome2_unique.txt test_output_fifo_genome2_unique.txt; then
+    echo "✓ Test 23 passed (stdin, process substitution and FIFO input match file input)"
+else
+    echo "✗ Test 23 failed"
+fi
+
 echo
 echo "=== Test Summary ==="
 echo "All tests completed. Check the output above for any failures."